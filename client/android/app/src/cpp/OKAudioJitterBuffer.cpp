@@ -0,0 +1,261 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKAudioJitterBuffer.h"
+
+#if ENABLE_CLOUDXR
+
+#include <algorithm>
+#include <string.h>
+
+namespace BVR
+{
+
+OKAudioJitterBuffer::OKAudioJitterBuffer()
+{
+    memset(samples_, 0, sizeof(samples_));
+    reset(AUDIO_JITTER_TARGET_MS);
+}
+
+void OKAudioJitterBuffer::reset(const float target_ms)
+{
+    // Skips what's buffered rather than rewinding, the producer owns write_index_
+    read_index_.store(write_index_.load(std::memory_order_acquire), std::memory_order_release);
+
+    target_frames_ = std::clamp(target_ms, AUDIO_JITTER_MIN_MS, AUDIO_JITTER_MAX_MS) * frames_per_ms_;
+    level_frames_ = 0.0f;
+    is_buffering_ = true;
+    is_fading_in_ = false;
+    window_frame_count_ = 0;
+    window_min_slack_frames_ = UINT32_MAX;
+
+    frames_written_.store(0, std::memory_order_relaxed);
+    frames_read_.store(0, std::memory_order_relaxed);
+    overflow_frames_.store(0, std::memory_order_relaxed);
+    underrun_count_.store(0, std::memory_order_relaxed);
+    dropped_frames_.store(0, std::memory_order_relaxed);
+    inserted_frames_.store(0, std::memory_order_relaxed);
+    level_ms_.store(0.0f, std::memory_order_relaxed);
+    target_ms_.store(target_frames_ / frames_per_ms_, std::memory_order_relaxed);
+}
+
+uint32_t OKAudioJitterBuffer::write(const int16_t* samples, const uint32_t frame_count)
+{
+    if (!samples || (frame_count == 0))
+    {
+        return 0;
+    }
+
+    const uint32_t write_index = write_index_.load(std::memory_order_relaxed);
+    const uint32_t read_index = read_index_.load(std::memory_order_acquire);
+
+    const uint32_t free_frame_count = AUDIO_JITTER_BUFFER_FRAMES - (write_index - read_index);
+    const uint32_t written_frame_count = std::min(frame_count, free_frame_count);
+
+    // At most two spans, the second one after wrapping around
+    const uint32_t first_frame_id = write_index & FRAME_MASK;
+    const uint32_t first_frame_count = std::min(written_frame_count, AUDIO_JITTER_BUFFER_FRAMES - first_frame_id);
+
+    memcpy(&samples_[first_frame_id * CHANNEL_COUNT], samples, first_frame_count * CHANNEL_COUNT * sizeof(int16_t));
+    memcpy(&samples_[0], &samples[first_frame_count * CHANNEL_COUNT], (written_frame_count - first_frame_count) * CHANNEL_COUNT * sizeof(int16_t));
+
+    write_index_.store(write_index + written_frame_count, std::memory_order_release);
+
+    frames_written_.fetch_add(written_frame_count, std::memory_order_relaxed);
+
+    if (written_frame_count < frame_count)
+    {
+        overflow_frames_.fetch_add(frame_count - written_frame_count, std::memory_order_relaxed);
+    }
+
+    return written_frame_count;
+}
+
+void OKAudioJitterBuffer::read(int16_t* samples, const uint32_t frame_count)
+{
+    if (!samples || (frame_count == 0))
+    {
+        return;
+    }
+
+    frames_read_.fetch_add(frame_count, std::memory_order_relaxed);
+
+    const uint32_t available_frame_count = write_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_relaxed);
+
+    if (is_buffering_)
+    {
+        if ((float)available_frame_count < std::max(target_frames_, (float)frame_count))
+        {
+            memset(samples, 0, frame_count * CHANNEL_COUNT * sizeof(int16_t));
+            return;
+        }
+
+        is_buffering_ = false;
+        is_fading_in_ = true;
+        level_frames_ = (float)available_frame_count;
+    }
+
+    // Level smoothed over AUDIO_JITTER_SMOOTHING_MS of output, whatever the burst size
+    const float alpha = std::min((float)frame_count / (AUDIO_JITTER_SMOOTHING_MS * frames_per_ms_), 1.0f);
+    level_frames_ += alpha * ((float)available_frame_count - level_frames_);
+
+    const float hysteresis_frames = AUDIO_JITTER_HYSTERESIS_MS * frames_per_ms_;
+    uint32_t consumed_frame_count = frame_count;
+
+    if ((frame_count > 1) && (level_frames_ > (target_frames_ + hysteresis_frames)))
+    {
+        consumed_frame_count = frame_count + 1;
+    }
+    else if ((frame_count > 1) && (level_frames_ < (target_frames_ - hysteresis_frames)))
+    {
+        consumed_frame_count = frame_count - 1;
+    }
+
+    if (available_frame_count < consumed_frame_count)
+    {
+        // Play out what's left, fading so the gap doesn't click, then rebuffer with more margin
+        copy_frames(samples, available_frame_count);
+        apply_fade(samples, available_frame_count, false);
+        memset(&samples[available_frame_count * CHANNEL_COUNT], 0, (frame_count - available_frame_count) * CHANNEL_COUNT * sizeof(int16_t));
+
+        read_index_.store(read_index_.load(std::memory_order_relaxed) + available_frame_count, std::memory_order_release);
+
+        underrun_count_.fetch_add(1, std::memory_order_relaxed);
+        is_buffering_ = true;
+        update_target(available_frame_count, frame_count, true);
+        return;
+    }
+
+    if (consumed_frame_count == frame_count)
+    {
+        copy_frames(samples, frame_count);
+    }
+    else
+    {
+        resample_frames(samples, frame_count, consumed_frame_count);
+
+        if (consumed_frame_count > frame_count)
+        {
+            dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            inserted_frames_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (is_fading_in_)
+    {
+        apply_fade(samples, frame_count, true);
+        is_fading_in_ = false;
+    }
+
+    read_index_.store(read_index_.load(std::memory_order_relaxed) + consumed_frame_count, std::memory_order_release);
+
+    update_target(available_frame_count, consumed_frame_count, false);
+}
+
+OKAudioJitterStats OKAudioJitterBuffer::get_stats() const
+{
+    OKAudioJitterStats stats;
+    stats.frames_written_ = frames_written_.load(std::memory_order_relaxed);
+    stats.frames_read_ = frames_read_.load(std::memory_order_relaxed);
+    stats.overflow_frames_ = overflow_frames_.load(std::memory_order_relaxed);
+    stats.underrun_count_ = underrun_count_.load(std::memory_order_relaxed);
+    stats.dropped_frames_ = dropped_frames_.load(std::memory_order_relaxed);
+    stats.inserted_frames_ = inserted_frames_.load(std::memory_order_relaxed);
+    stats.level_ms_ = level_ms_.load(std::memory_order_relaxed);
+    stats.target_ms_ = target_ms_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void OKAudioJitterBuffer::copy_frames(int16_t* samples, const uint32_t frame_count)
+{
+    const uint32_t read_index = read_index_.load(std::memory_order_relaxed);
+
+    const uint32_t first_frame_id = read_index & FRAME_MASK;
+    const uint32_t first_frame_count = std::min(frame_count, AUDIO_JITTER_BUFFER_FRAMES - first_frame_id);
+
+    memcpy(samples, &samples_[first_frame_id * CHANNEL_COUNT], first_frame_count * CHANNEL_COUNT * sizeof(int16_t));
+    memcpy(&samples[first_frame_count * CHANNEL_COUNT], &samples_[0], (frame_count - first_frame_count) * CHANNEL_COUNT * sizeof(int16_t));
+}
+
+void OKAudioJitterBuffer::resample_frames(int16_t* samples, const uint32_t frame_count, const uint32_t consumed_frame_count)
+{
+    // First and last output frames land on the first and last consumed ones
+    const uint32_t read_index = read_index_.load(std::memory_order_relaxed);
+    const float step = (float)(consumed_frame_count - 1) / (float)(frame_count - 1);
+
+    for (uint32_t frame_id = 0; frame_id < frame_count; frame_id++)
+    {
+        const float position = (float)frame_id * step;
+        const uint32_t source_frame_id = std::min((uint32_t)position, consumed_frame_count - 1);
+        const uint32_t next_frame_id = std::min(source_frame_id + 1, consumed_frame_count - 1);
+        const float weight = position - (float)source_frame_id;
+
+        for (uint32_t channel_id = 0; channel_id < CHANNEL_COUNT; channel_id++)
+        {
+            const float sample = (float)get_sample(read_index + source_frame_id, channel_id);
+            const float next_sample = (float)get_sample(read_index + next_frame_id, channel_id);
+
+            samples[(frame_id * CHANNEL_COUNT) + channel_id] = (int16_t)(sample + weight * (next_sample - sample));
+        }
+    }
+}
+
+void OKAudioJitterBuffer::apply_fade(int16_t* samples, const uint32_t frame_count, const bool fade_in) const
+{
+    const uint32_t fade_frame_count = std::min(frame_count, (uint32_t)AUDIO_FADE_FRAMES);
+    const uint32_t first_frame_id = fade_in ? 0 : (frame_count - fade_frame_count);
+
+    for (uint32_t fade_frame_id = 0; fade_frame_id < fade_frame_count; fade_frame_id++)
+    {
+        const float ramp = (float)(fade_frame_id + 1) / (float)(fade_frame_count + 1);
+        const float gain = fade_in ? ramp : (1.0f - ramp);
+
+        for (uint32_t channel_id = 0; channel_id < CHANNEL_COUNT; channel_id++)
+        {
+            int16_t& sample = samples[((first_frame_id + fade_frame_id) * CHANNEL_COUNT) + channel_id];
+            sample = (int16_t)((float)sample * gain);
+        }
+    }
+}
+
+void OKAudioJitterBuffer::update_target(const uint32_t available_frame_count, const uint32_t frame_count, const bool has_underrun)
+{
+    const float step_frames = AUDIO_JITTER_STEP_MS * frames_per_ms_;
+    const float min_target_frames = AUDIO_JITTER_MIN_MS * frames_per_ms_;
+    const float max_target_frames = AUDIO_JITTER_MAX_MS * frames_per_ms_;
+
+    if (has_underrun)
+    {
+        target_frames_ = std::min(target_frames_ + step_frames, max_target_frames);
+        window_frame_count_ = 0;
+        window_min_slack_frames_ = UINT32_MAX;
+    }
+    else
+    {
+        // Slack = what was still buffered after this callback, the margin the network had left
+        window_min_slack_frames_ = std::min(window_min_slack_frames_, available_frame_count - frame_count);
+        window_frame_count_ += frame_count;
+
+        if ((float)window_frame_count_ >= ((float)AUDIO_JITTER_WINDOW_MS * frames_per_ms_))
+        {
+            if ((float)window_min_slack_frames_ > step_frames)
+            {
+                target_frames_ = std::max(target_frames_ - frames_per_ms_, min_target_frames);
+            }
+
+            window_frame_count_ = 0;
+            window_min_slack_frames_ = UINT32_MAX;
+        }
+    }
+
+    level_ms_.store(level_frames_ / frames_per_ms_, std::memory_order_relaxed);
+    target_ms_.store(target_frames_ / frames_per_ms_, std::memory_order_relaxed);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
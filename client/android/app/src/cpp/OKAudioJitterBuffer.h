@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_AUDIO_JITTER_BUFFER_H
+#define OK_AUDIO_JITTER_BUFFER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <CloudXRCommon.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace BVR
+{
+
+struct OKAudioJitterStats
+{
+    uint64_t frames_written_ = 0;
+    uint64_t frames_read_ = 0;     // by the output, silence included
+    uint64_t overflow_frames_ = 0; // written while the ring was full, never played
+    uint64_t underrun_count_ = 0;
+    uint64_t dropped_frames_ = 0;  // squeezed out to bring the level down to the target
+    uint64_t inserted_frames_ = 0; // stretched in to bring it up
+    float level_ms_ = 0.0f;        // smoothed buffered audio, the latency the buffer adds
+    float target_ms_ = 0.0f;
+};
+
+// Stereo int16 audio between CloudXR's RenderAudio callback and the output's data callback.
+// Both sides are wait-free and allocation-free: write() copies whatever fits into the ring,
+// read() always fills the callback, with silence while (re)buffering.
+//
+// The consumer holds the smoothed level at a target latency. Each callback consumes one frame
+// more or less than it outputs (linearly resampled, ~0.5% at 4 ms bursts) while the level is off
+// by more than AUDIO_JITTER_HYSTERESIS_MS, which absorbs server / DAC clock drift without pitch
+// jumps or gaps. An underrun fades out, raises the target by AUDIO_JITTER_STEP_MS and rebuffers;
+// each AUDIO_JITTER_WINDOW_MS without one, that never ran below a step of slack, lowers it by 1 ms.
+class OKAudioJitterBuffer
+{
+public:
+    static const uint32_t CHANNEL_COUNT = CXR_AUDIO_CHANNEL_COUNT;
+
+    OKAudioJitterBuffer();
+
+    // Consumer side, while the output is stopped: drops what's buffered and rebuffers to target_ms.
+    // The producer may keep writing.
+    void reset(const float target_ms);
+
+    // Producer thread only, returns the frames accepted
+    uint32_t write(const int16_t* samples, const uint32_t frame_count);
+
+    // Consumer thread only
+    void read(int16_t* samples, const uint32_t frame_count);
+
+    // Any thread
+    OKAudioJitterStats get_stats() const;
+
+private:
+    static const uint32_t FRAME_MASK = AUDIO_JITTER_BUFFER_FRAMES - 1;
+    static_assert((AUDIO_JITTER_BUFFER_FRAMES & FRAME_MASK) == 0, "AUDIO_JITTER_BUFFER_FRAMES must be a power of two");
+
+    int16_t get_sample(const uint32_t frame_id, const uint32_t channel_id) const
+    {
+        return samples_[((frame_id & FRAME_MASK) * CHANNEL_COUNT) + channel_id];
+    }
+
+    void copy_frames(int16_t* samples, const uint32_t frame_count);
+    void resample_frames(int16_t* samples, const uint32_t frame_count, const uint32_t consumed_frame_count);
+    void apply_fade(int16_t* samples, const uint32_t frame_count, const bool fade_in) const;
+    void update_target(const uint32_t available_frame_count, const uint32_t frame_count, const bool has_underrun);
+
+    alignas(64) std::atomic<uint32_t> write_index_ = {0};
+    alignas(64) std::atomic<uint32_t> read_index_ = {0};
+
+    int16_t samples_[AUDIO_JITTER_BUFFER_FRAMES * CHANNEL_COUNT];
+
+    // Consumer thread only
+    float frames_per_ms_ = (float)CXR_AUDIO_SAMPLING_RATE / 1000.0f;
+    float target_frames_ = 0.0f;
+    float level_frames_ = 0.0f;
+    bool is_buffering_ = true;
+    bool is_fading_in_ = false;
+    uint32_t window_frame_count_ = 0;
+    uint32_t window_min_slack_frames_ = UINT32_MAX;
+
+    std::atomic<uint64_t> frames_written_ = {0};
+    std::atomic<uint64_t> frames_read_ = {0};
+    std::atomic<uint64_t> overflow_frames_ = {0};
+    std::atomic<uint64_t> underrun_count_ = {0};
+    std::atomic<uint64_t> dropped_frames_ = {0};
+    std::atomic<uint64_t> inserted_frames_ = {0};
+    std::atomic<float> level_ms_ = {0.0f};
+    std::atomic<float> target_ms_ = {0.0f};
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_AUDIO_JITTER_BUFFER_H
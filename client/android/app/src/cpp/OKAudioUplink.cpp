@@ -0,0 +1,257 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKAudioUplink.h"
+
+#if ENABLE_CLOUDXR
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+namespace BVR
+{
+
+void OKVoiceActivityDetector::reset()
+{
+    // The threshold starts at AUDIO_VAD_MIN_DB, so talking from the first packet still counts as voice
+    level_db_ = -100.0f;
+    noise_floor_db_ = AUDIO_VAD_MIN_DB - AUDIO_VAD_MARGIN_DB;
+}
+
+bool OKVoiceActivityDetector::update(const OKAudioUplinkPacket& packet)
+{
+    // Mean square of the mono mix, relative to full scale
+    float sum_squares = 0.0f;
+
+    for (uint32_t frame_id = 0; frame_id < AUDIO_UPLINK_FRAME_COUNT; frame_id++)
+    {
+        float mono = 0.0f;
+
+        for (uint32_t channel_id = 0; channel_id < CXR_AUDIO_CHANNEL_COUNT; channel_id++)
+        {
+            mono += (float)packet.samples_[(frame_id * CXR_AUDIO_CHANNEL_COUNT) + channel_id];
+        }
+
+        mono *= (1.0f / (32768.0f * (float)CXR_AUDIO_CHANNEL_COUNT));
+        sum_squares += mono * mono;
+    }
+
+    level_db_ = 10.0f * log10f((sum_squares / (float)AUDIO_UPLINK_FRAME_COUNT) + 1e-10f);
+
+    const bool is_voice = (level_db_ > std::max(noise_floor_db_ + AUDIO_VAD_MARGIN_DB, AUDIO_VAD_MIN_DB));
+
+    if (level_db_ < noise_floor_db_)
+    {
+        noise_floor_db_ = level_db_;
+    }
+    else
+    {
+        const float rise_db_per_s = is_voice ? AUDIO_VAD_VOICE_RISE_DB_PER_S : AUDIO_VAD_NOISE_RISE_DB_PER_S;
+        noise_floor_db_ = std::min(noise_floor_db_ + rise_db_per_s * ((float)CXR_AUDIO_FRAME_LENGTH_MS / 1000.0f), level_db_);
+    }
+
+    return is_voice;
+}
+
+OKAudioUplink::OKAudioUplink()
+{
+    memset(&staging_packet_, 0, sizeof(staging_packet_));
+}
+
+OKAudioUplink::~OKAudioUplink()
+{
+    stop();
+}
+
+void OKAudioUplink::configure(OKAudioSendFunction send_function, void* context, const bool enable_vad)
+{
+    send_function_ = send_function;
+    send_context_ = context;
+    is_vad_enabled_ = enable_vad;
+
+    vad_.reset();
+    hangover_packet_count_ = 0;
+    preroll_packet_count_ = 0;
+    preroll_next_id_ = 0;
+    is_voice_active_ = false;
+
+    is_accepting_.store(send_function != nullptr, std::memory_order_release);
+}
+
+bool OKAudioUplink::start()
+{
+    if (is_running())
+    {
+        return true;
+    }
+
+    if (!send_function_)
+    {
+        return false;
+    }
+
+    should_stop_.store(false, std::memory_order_release);
+    is_running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&OKAudioUplink::run, this);
+    return true;
+}
+
+void OKAudioUplink::stop()
+{
+    is_accepting_.store(false, std::memory_order_release);
+
+    if (thread_.joinable())
+    {
+        should_stop_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+
+    is_running_.store(false, std::memory_order_release);
+
+    // Whatever is left would be stale by the next start
+    OKAudioUplinkPacket packet;
+
+    while (queue_.pop(packet))
+    {
+    }
+}
+
+void OKAudioUplink::write(const int16_t* samples, const uint32_t frame_count)
+{
+    if (!samples || !is_accepting_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    uint32_t frame_id = 0;
+
+    while (frame_id < frame_count)
+    {
+        const uint32_t copy_frame_count = std::min(frame_count - frame_id, AUDIO_UPLINK_FRAME_COUNT - staging_frame_count_);
+
+        memcpy(&staging_packet_.samples_[staging_frame_count_ * CXR_AUDIO_CHANNEL_COUNT], &samples[frame_id * CXR_AUDIO_CHANNEL_COUNT],
+               copy_frame_count * CXR_AUDIO_CHANNEL_COUNT * sizeof(int16_t));
+
+        staging_frame_count_ += copy_frame_count;
+        frame_id += copy_frame_count;
+
+        if (staging_frame_count_ == AUDIO_UPLINK_FRAME_COUNT)
+        {
+            packets_captured_.fetch_add(1, std::memory_order_relaxed);
+
+            if (!queue_.push(staging_packet_))
+            {
+                packets_dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            staging_frame_count_ = 0;
+        }
+    }
+}
+
+uint32_t OKAudioUplink::process()
+{
+    if (!send_function_)
+    {
+        return 0;
+    }
+
+    uint32_t sent_packet_count = 0;
+    OKAudioUplinkPacket packet;
+
+    while (queue_.pop(packet))
+    {
+        if (!is_vad_enabled_)
+        {
+            sent_packet_count += send_packet(packet) ? 1 : 0;
+            continue;
+        }
+
+        const bool is_voice = vad_.update(packet);
+
+        level_db_.store(vad_.get_level_db(), std::memory_order_relaxed);
+        noise_floor_db_.store(vad_.get_noise_floor_db(), std::memory_order_relaxed);
+
+        if (is_voice)
+        {
+            // Onset: what was held back just before goes out first, oldest first
+            const uint32_t first_preroll_id = (preroll_next_id_ + AUDIO_VAD_PREROLL_PACKETS - preroll_packet_count_) % AUDIO_VAD_PREROLL_PACKETS;
+
+            for (uint32_t preroll_id = 0; preroll_id < preroll_packet_count_; preroll_id++)
+            {
+                sent_packet_count += send_packet(preroll_packets_[(first_preroll_id + preroll_id) % AUDIO_VAD_PREROLL_PACKETS]) ? 1 : 0;
+                packets_suppressed_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            preroll_packet_count_ = 0;
+            hangover_packet_count_ = AUDIO_VAD_HANGOVER_MS / CXR_AUDIO_FRAME_LENGTH_MS;
+            is_voice_active_.store(true, std::memory_order_relaxed);
+
+            sent_packet_count += send_packet(packet) ? 1 : 0;
+        }
+        else if (hangover_packet_count_ > 0)
+        {
+            hangover_packet_count_--;
+            sent_packet_count += send_packet(packet) ? 1 : 0;
+        }
+        else
+        {
+            is_voice_active_.store(false, std::memory_order_relaxed);
+
+            preroll_packets_[preroll_next_id_] = packet;
+            preroll_next_id_ = (preroll_next_id_ + 1) % AUDIO_VAD_PREROLL_PACKETS;
+            preroll_packet_count_ = std::min(preroll_packet_count_ + 1, AUDIO_VAD_PREROLL_PACKETS);
+
+            packets_suppressed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    return sent_packet_count;
+}
+
+OKAudioUplinkStats OKAudioUplink::get_stats() const
+{
+    OKAudioUplinkStats stats;
+    stats.packets_captured_ = packets_captured_.load(std::memory_order_relaxed);
+    stats.packets_sent_ = packets_sent_.load(std::memory_order_relaxed);
+    stats.packets_suppressed_ = packets_suppressed_.load(std::memory_order_relaxed);
+    stats.packets_dropped_ = packets_dropped_.load(std::memory_order_relaxed);
+    stats.send_errors_ = send_errors_.load(std::memory_order_relaxed);
+    stats.level_db_ = level_db_.load(std::memory_order_relaxed);
+    stats.noise_floor_db_ = noise_floor_db_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void OKAudioUplink::run()
+{
+    const std::chrono::milliseconds drain_period(AUDIO_UPLINK_DRAIN_PERIOD_MS);
+
+    while (!should_stop_.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(drain_period);
+        process();
+    }
+}
+
+bool OKAudioUplink::send_packet(const OKAudioUplinkPacket& packet)
+{
+    cxrAudioFrame audio_frame = {};
+    audio_frame.streamBuffer = const_cast<int16_t*>(packet.samples_);
+    audio_frame.streamSizeBytes = AUDIO_UPLINK_FRAME_COUNT * CXR_AUDIO_CHANNEL_COUNT * CXR_AUDIO_SAMPLE_SIZE;
+
+    if (!send_function_(send_context_, &audio_frame))
+    {
+        send_errors_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    packets_sent_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
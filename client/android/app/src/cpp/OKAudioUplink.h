@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_AUDIO_UPLINK_H
+#define OK_AUDIO_UPLINK_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKSPSCQueue.h"
+
+#include <CloudXRCommon.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace BVR
+{
+
+const uint32_t AUDIO_UPLINK_FRAME_COUNT = CXR_AUDIO_SAMPLING_RATE * CXR_AUDIO_FRAME_LENGTH_MS / 1000; // per packet
+const uint32_t AUDIO_VAD_PREROLL_PACKETS = (AUDIO_VAD_PREROLL_MS + CXR_AUDIO_FRAME_LENGTH_MS - 1) / CXR_AUDIO_FRAME_LENGTH_MS;
+
+// One CXR_AUDIO_FRAME_LENGTH_MS stereo int16 packet, what cxrSendAudio gets
+struct OKAudioUplinkPacket
+{
+    int16_t samples_[AUDIO_UPLINK_FRAME_COUNT * CXR_AUDIO_CHANNEL_COUNT];
+};
+
+struct OKAudioUplinkStats
+{
+    uint64_t packets_captured_ = 0;
+    uint64_t packets_sent_ = 0;
+    uint64_t packets_suppressed_ = 0; // quiet, never sent
+    uint64_t packets_dropped_ = 0;    // the sender fell behind and the queue was full
+    uint64_t send_errors_ = 0;
+    float level_db_ = -100.0f;        // last packet, dBFS
+    float noise_floor_db_ = -100.0f;
+};
+
+// Energy based voice activity: a packet is voice when it's AUDIO_VAD_MARGIN_DB above a noise
+// floor that follows quiet packets down at once and creeps back up at AUDIO_VAD_NOISE_RISE_DB_PER_S,
+// AUDIO_VAD_VOICE_RISE_DB_PER_S under voice.
+class OKVoiceActivityDetector
+{
+public:
+    void reset();
+
+    bool update(const OKAudioUplinkPacket& packet);
+
+    float get_level_db() const
+    {
+        return level_db_;
+    }
+
+    float get_noise_floor_db() const
+    {
+        return noise_floor_db_;
+    }
+
+private:
+    float level_db_ = -100.0f;
+    float noise_floor_db_ = AUDIO_VAD_MIN_DB - AUDIO_VAD_MARGIN_DB;
+};
+
+// Returns true when the packet was sent
+typedef bool (*OKAudioSendFunction)(void* context, const cxrAudioFrame* audio_frame);
+
+// Microphone to server. The capture callback only slices what Oboe hands it into exact
+// CXR_AUDIO_FRAME_LENGTH_MS packets and pushes them into a preallocated queue, so it takes the
+// same time whatever the burst size and never blocks. A sender thread drains the queue every
+// AUDIO_UPLINK_DRAIN_PERIOD_MS and passes the packets on, minus the quiet ones when VAD is on:
+// sending resumes AUDIO_VAD_PREROLL_MS ahead of voice and stops AUDIO_VAD_HANGOVER_MS after it.
+class OKAudioUplink
+{
+public:
+    OKAudioUplink();
+    ~OKAudioUplink();
+
+    // Accept audio and send it through send_function, process() sends nothing before this
+    void configure(OKAudioSendFunction send_function, void* context, const bool enable_vad);
+
+    // The sender thread, or call process() by hand without it
+    bool start();
+    void stop();
+
+    bool is_running() const
+    {
+        return is_running_.load(std::memory_order_acquire);
+    }
+
+    // Capture thread only, dropped unless configured
+    void write(const int16_t* samples, const uint32_t frame_count);
+
+    // Sender side only, returns the packets sent
+    uint32_t process();
+
+    bool is_voice_active() const
+    {
+        return is_voice_active_.load(std::memory_order_relaxed);
+    }
+
+    OKAudioUplinkStats get_stats() const;
+
+private:
+    void run();
+    bool send_packet(const OKAudioUplinkPacket& packet);
+
+    // Capture side
+    OKAudioUplinkPacket staging_packet_;
+    uint32_t staging_frame_count_ = 0;
+
+    OKSPSCQueue<OKAudioUplinkPacket, AUDIO_UPLINK_QUEUE_SIZE> queue_;
+
+    // Sender side
+    OKAudioSendFunction send_function_ = nullptr;
+    void* send_context_ = nullptr;
+    bool is_vad_enabled_ = ENABLE_AUDIO_VAD;
+    OKVoiceActivityDetector vad_;
+    uint32_t hangover_packet_count_ = 0;
+    OKAudioUplinkPacket preroll_packets_[AUDIO_VAD_PREROLL_PACKETS];
+    uint32_t preroll_packet_count_ = 0;
+    uint32_t preroll_next_id_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> is_accepting_ = {false};
+    std::atomic<bool> is_running_ = {false};
+    std::atomic<bool> should_stop_ = {false};
+    std::atomic<bool> is_voice_active_ = {false};
+
+    std::atomic<uint64_t> packets_captured_ = {0};
+    std::atomic<uint64_t> packets_sent_ = {0};
+    std::atomic<uint64_t> packets_suppressed_ = {0};
+    std::atomic<uint64_t> packets_dropped_ = {0};
+    std::atomic<uint64_t> send_errors_ = {0};
+    std::atomic<float> level_db_ = {-100.0f};
+    std::atomic<float> noise_floor_db_ = {-100.0f};
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_AUDIO_UPLINK_H
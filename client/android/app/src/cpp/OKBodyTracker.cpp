@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_BODY_TRACKING
+
+#include "OKBodyTracker.h"
+
+namespace BVR
+{
+
+OKBodyTracker::OKBodyTracker()
+{
+}
+
+OKBodyTracker::~OKBodyTracker()
+{
+    shutdown();
+}
+
+bool OKBodyTracker::init(XrInstance instance, XrSession session)
+{
+    if (is_initialized_)
+    {
+        return true;
+    }
+
+    if ((instance == XR_NULL_HANDLE) || (session == XR_NULL_HANDLE))
+    {
+        return false;
+    }
+
+    XrResult result = xrGetInstanceProcAddr(instance, "xrCreateBodyTrackerFB", (PFN_xrVoidFunction*)&xrCreateBodyTrackerFB_);
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrDestroyBodyTrackerFB", (PFN_xrVoidFunction*)&xrDestroyBodyTrackerFB_);
+    }
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrLocateBodyJointsFB", (PFN_xrVoidFunction*)&xrLocateBodyJointsFB_);
+    }
+
+    if (XR_FAILED(result) || !xrCreateBodyTrackerFB_ || !xrDestroyBodyTrackerFB_ || !xrLocateBodyJointsFB_)
+    {
+        //IGLLog(IGLLogLevel::LOG_INFO, "OKBodyTracker: XR_FB_body_tracking not enabled\n");
+        xrCreateBodyTrackerFB_ = nullptr;
+        xrDestroyBodyTrackerFB_ = nullptr;
+        xrLocateBodyJointsFB_ = nullptr;
+        return false;
+    }
+
+    XrBodyTrackerCreateInfoFB create_info = {};
+    create_info.type = XR_TYPE_BODY_TRACKER_CREATE_INFO_FB;
+    create_info.bodyJointSet = XR_BODY_JOINT_SET_DEFAULT_FB;
+
+    result = xrCreateBodyTrackerFB_(session, &create_info, &body_tracker_);
+
+    if (XR_FAILED(result))
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "xrCreateBodyTrackerFB error = %d\n", result);
+        body_tracker_ = XR_NULL_HANDLE;
+        return false;
+    }
+
+    is_initialized_ = true;
+    return is_initialized_;
+}
+
+void OKBodyTracker::shutdown()
+{
+    if (!is_initialized_)
+    {
+        return;
+    }
+
+    if (body_tracker_ != XR_NULL_HANDLE)
+    {
+        xrDestroyBodyTrackerFB_(body_tracker_);
+        body_tracker_ = XR_NULL_HANDLE;
+    }
+
+    is_initialized_ = false;
+}
+
+bool OKBodyTracker::locate_joints(const XrSpace base_space, const XrTime time, XrBodyJointLocationFB* joint_locations) const
+{
+    if (!is_initialized_ || !joint_locations)
+    {
+        return false;
+    }
+
+    XrBodyJointsLocateInfoFB locate_info = {};
+    locate_info.type = XR_TYPE_BODY_JOINTS_LOCATE_INFO_FB;
+    locate_info.baseSpace = base_space;
+    locate_info.time = time;
+
+    XrBodyJointLocationsFB locations = {};
+    locations.type = XR_TYPE_BODY_JOINT_LOCATIONS_FB;
+    locations.jointCount = XR_BODY_JOINT_COUNT_FB;
+    locations.jointLocations = joint_locations;
+
+    const XrResult result = xrLocateBodyJointsFB_(body_tracker_, &locate_info, &locations);
+
+    if (XR_FAILED(result) || !locations.isActive)
+    {
+        return false;
+    }
+
+    const XrSpaceLocationFlags hips_valid_flags = (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT);
+    return ((joint_locations[XR_BODY_JOINT_HIPS_FB].locationFlags & hips_valid_flags) == hips_valid_flags);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_BODY_TRACKING
@@ -0,0 +1,52 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_BODY_TRACKER_H
+#define OK_BODY_TRACKER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_BODY_TRACKING
+
+#include <openxr/openxr.h>
+
+namespace BVR
+{
+
+// The XR_FB_body_tracking tracker (upper body, XR_BODY_JOINT_COUNT_FB joints). Entry points are
+// fetched with xrGetInstanceProcAddr like OKHandTracker's, init() returns false when XrApp didn't
+// enable the extension and the waist simply never becomes valid.
+class OKBodyTracker
+{
+public:
+    OKBodyTracker();
+    ~OKBodyTracker();
+
+    bool init(XrInstance instance, XrSession session);
+    void shutdown();
+
+    bool is_initialized() const
+    {
+        return is_initialized_;
+    }
+
+    // Fills XR_BODY_JOINT_COUNT_FB joint locations in base_space. False when the body isn't
+    // tracked right now, or its hips pose isn't valid.
+    bool locate_joints(const XrSpace base_space, const XrTime time, XrBodyJointLocationFB* joint_locations) const;
+
+private:
+    bool is_initialized_ = false;
+
+    PFN_xrCreateBodyTrackerFB xrCreateBodyTrackerFB_ = nullptr;
+    PFN_xrDestroyBodyTrackerFB xrDestroyBodyTrackerFB_ = nullptr;
+    PFN_xrLocateBodyJointsFB xrLocateBodyJointsFB_ = nullptr;
+
+    XrBodyTrackerFB body_tracker_ = XR_NULL_HANDLE;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_BODY_TRACKING
+
+#endif // OK_BODY_TRACKER_H
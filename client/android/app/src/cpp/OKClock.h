@@ -0,0 +1,25 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_CLOCK_H
+#define OK_CLOCK_H
+
+#include <cstdint>
+#include <time.h>
+
+namespace BVR
+{
+
+// Same clock and epoch as XrTime on Android (XR_KHR_convert_timespec_time)
+inline uint64_t get_monotonic_time_ns()
+{
+    struct timespec now_ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &now_ts);
+    return ((uint64_t)now_ts.tv_sec * 1000000000ULL) + (uint64_t)now_ts.tv_nsec;
+}
+
+} // namespace BVR
+
+#endif // OK_CLOCK_H
+
@@ -7,6 +7,10 @@
 #if ENABLE_CLOUDXR
 
 #include "OKCloudClient.h"
+#include "OKClock.h"
+#include "OKInputBindings.h"
+
+#include <algorithm>
 
 #if ENABLE_CLOUDXR_LOGGING_STUB
 extern "C" void dispatchLogMsg(cxrLogLevel level, cxrMessageCategory category, void *extra, const char *tag, const char *fmt, ...)
@@ -89,7 +93,7 @@ XrQuaternionf convert_cxr_to_xr(const cxrQuaternion &cxr_quat)
 
     cxrQuaternion convert_xr_to_cxr_quat(const XrQuaternionf &input)
     {
-        cxrQuaternion output = {0};
+        cxrQuaternion output = {};
 
         output.w = input.w;
         output.x = input.x;
@@ -129,92 +133,30 @@ XrQuaternionf convert_cxr_to_xr(const cxrQuaternion &cxr_quat)
         return cxr_pose;
     }
 
+    OKPoseState convert_cxr_to_pose_state(const cxrTrackedDevicePose &cxr_pose, const uint64_t timestamp_ns)
+    {
+        OKPoseState pose_state;
+        pose_state.pose_ = GLMPose(convert_to_glm(convert_cxr_to_xr(cxr_pose.position)), convert_to_glm(convert_cxr_to_xr(cxr_pose.rotation)));
+        pose_state.pose_.is_valid_ = cxr_pose.poseIsValid;
+        pose_state.linear_velocity_ = convert_to_glm(convert_cxr_to_xr(cxr_pose.velocity));
+        pose_state.angular_velocity_ = convert_to_glm(convert_cxr_to_xr(cxr_pose.angularVelocity));
+        pose_state.has_linear_velocity_ = true;
+        pose_state.has_angular_velocity_ = true;
+        pose_state.timestamp_ns_ = timestamp_ns;
+        return pose_state;
+    }
 
-static DigitalButtonToCloudXR_Map digital_button_maps[][NUM_CONTROLLERS] = {{{DigitalButton_ApplicationMenu, 0},
-                                                                                    { DigitalButton_System,INVALID_INDEX }},
-                                                                            {{DigitalButton_Trigger_Click, 2},
-                                                                                    { DigitalButton_Trigger_Click,2 }},
-                                                                            {{DigitalButton_Trigger_Touch, 3},
-                                                                                    { DigitalButton_Trigger_Touch,3 }},
-                                                                            {{DigitalButton_Grip_Click, 5},
-                                                                                    { DigitalButton_Grip_Click,5 }},
-                                                                            {{DigitalButton_Grip_Touch, 6},
-                                                                                    { DigitalButton_Grip_Touch,6 }},
-                                                                            {{DigitalButton_Joystick_Click, 8},
-                                                                                    { DigitalButton_Joystick_Click,8 }},
-                                                                            {{DigitalButton_Joystick_Touch, 9},
-                                                                                    { DigitalButton_Joystick_Touch,9 }},
-                                                                            {{DigitalButton_A_Click, 14},
-                                                                                    { DigitalButton_A_Click,12 }},
-                                                                            {{DigitalButton_B_Click, 15},
-                                                                                    { DigitalButton_B_Click,13 }},
-                                                                            {{DigitalButton_A_Touch, 18},
-                                                                                    { DigitalButton_A_Touch,16 }},
-                                                                            { {DigitalButton_B_Touch, 19},
-                                                                                    { DigitalButton_B_Touch,17 }},
-                                                                            { {DigitalButton_Touchpad_Touch, 20},
-                                                                                    { DigitalButton_Touchpad_Touch, 20 }}
-};
-
-static AnalogAxisToCloudXRMap analog_axis_maps[] = {{AnalogAxis_Trigger, 4},
-                                                    {AnalogAxis_Grip, 7},
-                                                    {AnalogAxis_JoystickX, 10},
-                                                    {AnalogAxis_JoystickY,11 }};
-
-
-const char *cxr_input_paths[] =
-{
-        "/input/system/click",
-        "/input/application_menu/click",
-        "/input/trigger/click",
-        "/input/trigger/touch",
-        "/input/trigger/value",
-        "/input/grip/click",
-        "/input/grip/touch",
-        "/input/grip/value",
-        "/input/joystick/click",
-        "/input/joystick/touch",
-        "/input/joystick/x",
-        "/input/joystick/y",
-        "/input/a/click",
-        "/input/b/click",
-        "/input/x/click",
-        "/input/y/click",
-        "/input/a/touch",
-        "/input/b/touch",
-        "/input/x/touch",
-        "/input/y/touch",
-        "/input/thumb_rest/touch",
-};
-
-cxrInputValueType cxr_input_value_types[] =
-{
-        cxrInputValueType_boolean,  // input/system/click
-        cxrInputValueType_boolean,  // input/application_menu/click
-        cxrInputValueType_boolean,  // input/trigger/click
-        cxrInputValueType_boolean,  // input/trigger/touch
-        cxrInputValueType_float32,  // input/trigger/value
-        cxrInputValueType_boolean,  // input/grip/click
-        cxrInputValueType_boolean,  // input/grip/touch
-        cxrInputValueType_float32,  // input/grip/value
-        cxrInputValueType_boolean,  // input/joystick/click
-        cxrInputValueType_boolean,  // input/joystick/touch
-        cxrInputValueType_float32,  // input/joystick/x
-        cxrInputValueType_float32,  // input/joystick/y
-        cxrInputValueType_boolean,  // input/a/click
-        cxrInputValueType_boolean,  // input/b/click
-        cxrInputValueType_boolean,  // input/x/click
-        cxrInputValueType_boolean,  // input/y/click
-        cxrInputValueType_boolean,  // input/a/touch
-        cxrInputValueType_boolean,  // input/b/touch
-        cxrInputValueType_boolean,  // input/x/touch
-        cxrInputValueType_boolean,  // input/y/touch
-        cxrInputValueType_boolean,  // input/thumb_rest/touch
-};
+    void apply_pose_state(const OKPoseState &pose_state, cxrTrackedDevicePose &cxr_pose)
+    {
+        cxr_pose.position = convert_xr_to_cxr(convert_to_xr(pose_state.pose_.translation_));
+        cxr_pose.rotation = convert_xr_to_cxr(convert_to_xr(pose_state.pose_.rotation_));
+    }
 
 
 OKCloudClient::OKCloudClient()
 {
+    // As close to the app's start as the client gets, the startup trace counts from here
+    startup_trace_.reset(get_monotonic_time_ns());
 }
 
 OKCloudClient::~OKCloudClient()
@@ -233,24 +175,100 @@ bool OKCloudClient::init_android_gles(OKOpenXRInterface* xr_interface, EGLDispla
         return true;
     }
 
-    ok_config_.load();
+    OKStartupScope init_scope(startup_trace_, StartupPhase_Init);
+
+    // Everything below depends on the config, the rest can then overlap
+    {
+        OKStartupScope config_scope(startup_trace_, StartupPhase_ConfigLoad);
+        ok_config_.load();
+        pose_predictor_.configure(ok_config_.enable_client_prediction_, ok_config_.client_prediction_damping_, ok_config_.client_prediction_max_ms_);
+        ok_player_state_.waist_smoothing_ms_ = ok_config_.waist_smoothing_ms_;
+
+#if ENABLE_QOS
+        OKQosSettings qos_settings;
+        qos_settings.target_delivery_ms_ = ok_config_.qos_target_delivery_ms_;
+        qos_settings.max_bitrate_kbps_ = ok_config_.max_bitrate_kbps_;
+        qos_settings.max_res_factor_ = ok_config_.max_res_factor_;
+        qos_settings.foveation_ = ok_config_.foveation_;
+        qos_settings.enable_reconnect_ = ok_config_.enable_qos_reconnect_;
+        qos_controller_.configure(qos_settings);
+#endif
+    }
+
+#if ENABLE_OBOE
+    // Opening the streams is the slowest part, it runs while the receiver desc is built and the server picked
+    start_audio_init();
+#endif
+
+#if ENABLE_CLOUDXR_CONTROLLERS
+    {
+        OKStartupScope input_profile_scope(startup_trace_, StartupPhase_InputProfile);
+        input_profile_.compile_default(COMBINE_GRIP_FORCE_WITH_GRIP, SIMULATE_GRIP_TOUCH, SIMULATE_THUMB_REST, ok_config_.enable_swap_thumbsticks_);
+
+        if (!ok_config_.input_profile_.empty())
+        {
+            input_profile_.load(ok_config_.app_directory_ + OK_INPUT_PROFILES_FILENAME, ok_config_.input_profile_);
+        }
+    }
+#endif
 
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::init_android_gles\n");
 
     xr_interface_ = xr_interface;
 
+    // Seeds the retry jitter, clients started together must not retry together
+    connection_manager_ = OKConnectionManager((uint32_t)get_monotonic_time_ns());
+
     graphics_context_.type = cxrGraphicsContext_GLES;
     graphics_context_.egl.display = (void *)egl_display;
     graphics_context_.egl.context = (void *)egl_context;
 
-#if ENABLE_OBOE
-    init_audio();
-#endif
+    // Now rather than on the first attempt, the session is running so the views and refresh rate are known
+    {
+        OKStartupScope receiver_desc_scope(startup_trace_, StartupPhase_ReceiverDesc);
+        prepare_receiver_desc();
+    }
 
     is_cxr_initialized_ = true;
     return is_cxr_initialized_;
 }
 
+bool OKCloudClient::pre_render_update()
+{
+    if (!is_cxr_initialized_)
+    {
+        return false;
+    }
+
+    frame_start_time_ns_ = get_monotonic_time_ns();
+
+    const uint64_t frame_display_time_ns = xr_interface_->get_frame_display_time_ns();
+    frame_display_lead_ns_.store((frame_display_time_ns > frame_start_time_ns_) ? (frame_display_time_ns - frame_start_time_ns_) : 0,
+                                 std::memory_order_relaxed);
+
+    const float refresh_rate = xr_interface_->get_current_refresh_rate();
+    const float frame_rate = (refresh_rate > 0.0f) ? refresh_rate : stream_fps_.load(std::memory_order_relaxed);
+    frame_period_ns_ = (frame_rate > 0.0f) ? (uint64_t)(1000000000.0 / frame_rate) : 0;
+
+    update_refresh_rate(refresh_rate);
+
+    publish_views();
+
+    update_connection(frame_start_time_ns_);
+
+#if ENABLE_HAPTICS
+    update_haptics();
+#endif
+
+#if ENABLE_OBOE
+    update_audio();
+#endif
+
+    update_connection_stats();
+
+    return true;
+}
+
 void OKCloudClient::update_cxr_state(cxrClientState state, cxrError error)
 {
     switch (state)
@@ -262,26 +280,22 @@ void OKCloudClient::update_cxr_state(cxrClientState state, cxrError error)
             //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_ConnectionAttemptInProgress");
             break;
         case cxrClientState_ConnectionAttemptFailed:
-        {
-            const char* error_str = cxrErrorString(error);
-            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_ConnectionAttemptFailed = %s\n", error_str);
+            (void)error;
+            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_ConnectionAttemptFailed = %s\n", cxrErrorString(error));
             break;
-        }
         case cxrClientState_StreamingSessionInProgress:
             //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_StreamingSessionInProgress");
             xr_interface_->handle_stream_connected();
             break;
         case cxrClientState_Disconnected:
         {
-            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_Disconnected, setting back to cxrClientState_ReadyToConnect");
-            cxr_client_state_ = cxrClientState_ReadyToConnect;
+            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_Disconnected");
             xr_interface_->handle_stream_disconnected();
             break;
         }
         case cxrClientState_Exiting:
         {
-            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_Exiting, setting back to cxrClientState_ReadyToConnect");
-            cxr_client_state_ = cxrClientState_ReadyToConnect;
+            //IGLLog(IGLLogLevel::LOG_INFO, "CloudXR State = cxrClientState_Exiting");
             xr_interface_->handle_stream_disconnected();
             break;
         }
@@ -300,21 +314,131 @@ void OKCloudClient::shutdown_cxr()
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::shutdown_cxr\n");
 
     disconnect();
+    server_selector_.stop();
 
 #if ENABLE_OBOE
     shutdown_audio();
 #endif
 
+#if ENABLE_LAST_FRAME_RETENTION
+    frame_cache_.destroy();
+#endif
+
     is_cxr_initialized_ = false;
 }
 
 bool OKCloudClient::connect()
 {
-    if (!is_cxr_initialized_ || !is_ready_to_connect() || ok_config_.server_ip_address_.empty())
+    if (!is_cxr_initialized_ || ok_config_.server_ip_address_.empty())
     {
         return false;
     }
 
+    // Picked at once with a single server or a fresh cache, else once the probe is done
+    const std::vector<std::string> server_ip_addresses = ok_config_.server_ip_addresses_.empty() ?
+        std::vector<std::string>{ok_config_.server_ip_address_} : ok_config_.server_ip_addresses_;
+
+    startup_trace_.begin(StartupPhase_ServerSelect);
+    server_selector_.start(server_ip_addresses, (uint16_t)ok_config_.server_probe_port_,
+                           ok_config_.app_directory_ + SERVER_CACHE_FILENAME, ok_config_.server_cache_ttl_s_);
+
+    // First attempt right away, update_connection keeps it up from then on
+    const uint64_t now_time_ns = get_monotonic_time_ns();
+    connection_manager_.request_connect(now_time_ns);
+    update_connection(now_time_ns);
+    return true;
+}
+
+void OKCloudClient::disconnect()
+{
+    if (!is_cxr_initialized_)
+    {
+        return;
+    }
+
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::disconnect\n");
+    connection_manager_.request_disconnect();
+    destroy_receiver();
+}
+
+void OKCloudClient::update_connection(const uint64_t now_time_ns)
+{
+    switch (connection_manager_.get_state())
+    {
+        case ConnectionState_Idle:
+            break;
+        case ConnectionState_Waiting:
+        {
+            if (!server_selector_.is_ready())
+            {
+                break;
+            }
+
+            startup_trace_.end(StartupPhase_ServerSelect);
+
+            if (connection_manager_.should_attempt(now_time_ns))
+            {
+                connection_manager_.on_attempt(now_time_ns);
+
+                if (!attempt_connect())
+                {
+                    fail_attempt(now_time_ns);
+                }
+            }
+            break;
+        }
+        case ConnectionState_Connecting:
+        {
+            const cxrClientState cxr_client_state = cxr_client_state_;
+
+            if (cxr_client_state == cxrClientState_StreamingSessionInProgress)
+            {
+                connection_manager_.on_streaming(now_time_ns);
+                startup_trace_.end(StartupPhase_Connect);
+            }
+            else if ((cxr_client_state == cxrClientState_ConnectionAttemptFailed) || (cxr_client_state == cxrClientState_Disconnected) ||
+                     (cxr_client_state == cxrClientState_Exiting) || connection_manager_.has_attempt_timed_out(now_time_ns))
+            {
+                //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::update_connection attempt failed, retrying\n");
+                fail_attempt(now_time_ns);
+            }
+            break;
+        }
+        case ConnectionState_Streaming:
+        {
+            if (!is_connected())
+            {
+                //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::update_connection session lost, reconnecting\n");
+                destroy_receiver();
+                connection_manager_.on_session_lost(now_time_ns);
+            }
+#if ENABLE_QOS
+            else if (ok_config_.enable_qos_ && qos_controller_.should_reconnect(now_time_ns))
+            {
+                //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::update_connection reconnecting at QoS level %u\n", qos_controller_.get_decision().level_);
+                destroy_receiver();
+                connection_manager_.on_renegotiate(now_time_ns);
+            }
+#endif
+            break;
+        }
+    }
+}
+
+void OKCloudClient::fail_attempt(const uint64_t now_time_ns)
+{
+    destroy_receiver();
+    connection_manager_.on_attempt_failed(now_time_ns);
+
+    // A server that keeps failing is likely down or full, try the next best one
+    if ((connection_manager_.get_stats().consecutive_failure_count_ % SERVER_FAILOVER_FAILURES) == 0)
+    {
+        server_selector_.fail_over();
+    }
+}
+
+bool OKCloudClient::attempt_connect()
+{
     if (!cxr_receiver_)
     {
         create_receiver();
@@ -325,15 +449,67 @@ bool OKCloudClient::connect()
         }
     }
 
-    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::connect to IP = %s\n", ok_config_.server_ip_address_.c_str());
+    const std::string server_ip_address = server_selector_.get_server();
+
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::connect to IP = %s\n", server_ip_address.c_str());
 
-    cxrConnectionDesc connection_desc = {0};
+    cxrConnectionDesc connection_desc = {};
     connection_desc.async = true;
     connection_desc.useL4S = false;
     connection_desc.clientNetwork = cxrNetworkInterface_Unknown;
     connection_desc.topology = cxrNetworkTopology_LAN;
 
-    cxrError error = cxrConnect(cxr_receiver_, ok_config_.server_ip_address_.c_str(), &connection_desc);
+    // Everything the tracking callback samples is set up before it can first run
+#if ENABLE_HAND_TRACKING
+    if (ok_config_.enable_hand_tracking_)
+    {
+        hand_tracker_.init(xr_interface_->get_instance(), xr_interface_->get_session());
+        hand_joint_encoder_.reset();
+    }
+#endif
+
+#if ENABLE_FACE_TRACKING
+    if (ok_config_.enable_face_tracking_)
+    {
+        face_tracker_.init(xr_interface_->get_instance(), xr_interface_->get_session());
+        face_expression_encoder_.set_threshold((uint8_t)ok_config_.face_expression_threshold_);
+
+        // Blinks are brief, every step of them counts
+        face_expression_encoder_.set_threshold(XR_FACE_EXPRESSION2_EYES_CLOSED_L_FB, 1);
+        face_expression_encoder_.set_threshold(XR_FACE_EXPRESSION2_EYES_CLOSED_R_FB, 1);
+        face_expression_encoder_.reset();
+        last_face_sample_time_ns_ = 0;
+    }
+#endif
+
+#if ENABLE_BODY_TRACKING
+    if (ok_config_.enable_body_tracking_)
+    {
+        body_tracker_.init(xr_interface_->get_instance(), xr_interface_->get_session());
+        ok_player_state_.init();
+    }
+#endif
+
+#if ENABLE_EYE_TRACKING
+    eye_gaze_encoder_.reset();
+#endif
+
+#if ENABLE_POSE_SAMPLER_THREAD
+    // Decided before cxrConnect and fixed until the receiver is gone, so the tracking snapshot has one
+    // writer: the sampler when it runs, else the CloudXR callback. It idles until the stream is up.
+    pose_sampler_.start(get_polling_rate_hz(), [this](OKPoseSample& pose_sample)
+    {
+        sample_tracking_state(pose_sample.tracking_state_);
+    });
+
+    is_pose_sampler_writer_.store(pose_sampler_.is_running(), std::memory_order_release);
+#endif
+
+    // The receiver reports its states asynchronously, until the first one lands this attempt is in progress
+    cxr_client_state_ = cxrClientState_ConnectionAttemptInProgress;
+
+    startup_trace_.begin(StartupPhase_Connect);
+    cxrError error = cxrConnect(cxr_receiver_, server_ip_address.c_str(), &connection_desc);
 
     if (error)
     {
@@ -341,28 +517,33 @@ bool OKCloudClient::connect()
         return false;
     }
 
-    return true;
-}
+#if ENABLE_TELEMETRY
+    start_telemetry();
+#endif
 
-void OKCloudClient::disconnect()
-{
-    if (!is_cxr_initialized_ || !is_connected() || !is_connecting())
+#if ENABLE_OBOE
+    // destroy_receiver closed the streams if this is a reconnect, they reopen off the render thread
+    start_audio_init();
+
+    if (ok_config_.enable_audio_recording_)
     {
-        return;
+        audio_uplink_.configure([](void* context, const cxrAudioFrame* audio_frame)
+        {
+            return (cxrSendAudio((cxrReceiverHandle)context, audio_frame) == cxrError_Success);
+        }, cxr_receiver_, ok_config_.enable_audio_vad_);
+
+        audio_uplink_.start();
     }
+#endif
 
-    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::disconnect\n");
-    destroy_receiver();
+    return true;
 }
 
-bool OKCloudClient::create_receiver()
+void OKCloudClient::prepare_receiver_desc()
 {
-    if (cxr_receiver_  || !xr_interface_)
-    {
-        return false;
-    }
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::prepare_receiver_desc\n");
 
-    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::create_receiver\n");
+    receiver_desc_ = {};
 
     // Set parameters here...
     receiver_desc_.requestedVersion = CLOUDXR_VERSION_DWORD;
@@ -389,39 +570,23 @@ bool OKCloudClient::create_receiver()
 #endif
 
     cxrDeviceDesc& device_desc = receiver_desc_.deviceDesc;
-    device_desc.maxResFactor = 1.0f;// ok_config_.max_res_factor_;
+    device_desc.maxResFactor = ok_config_.max_res_factor_;
 
-    compute_ipd();
+    publish_views();
+    ipd_meters_ = compute_ipd();
     device_desc.ipd = ipd_meters_;
     device_desc.foveationModeCaps = cxrFoveation_PiecewiseQuadratic;
 
     const uint32_t number_of_streams = 2;
     device_desc.numVideoStreamDescs = number_of_streams;
 
-    uint32_t per_eye_width = DEFAULT_CLOUDXR_PER_EYE_WIDTH;
-    uint32_t per_eye_height = DEFAULT_CLOUDXR_PER_EYE_HEIGHT;
-
-    float fps = DEFAULT_CLOUDXR_FRAMERATE;
-
-#if 0
-    float current_refresh_rate = xr_interface_->get_current_refresh_rate();
-    bool should_update_refresh_rate = ((current_refresh_rate > 0.0f) && (current_refresh_rate != (float)ok_config_.desired_refresh_rate_));
-
-    if (should_update_refresh_rate)
-    {
-        xr_interface_->query_refresh_rates();
-        xr_interface_->set_refresh_rate((float)ok_config_.desired_refresh_rate_);
-        fps = xr_interface_->get_current_refresh_rate();
-    }
-
-    const uint32_t integer_fps = (uint32_t)roundf(fps);
+    const float fps = negotiate_refresh_rate();
 
 #if ENABLE_CLOUDXR_LINK_SHARPENING
     if (ok_config_.enable_sharpening_)
     {
         xr_interface_->set_sharpening_enabled(true);
     }
-#endif
 #endif
 
     for (uint32_t stream_index = 0; stream_index < number_of_streams; stream_index++)
@@ -431,25 +596,24 @@ bool OKCloudClient::create_receiver()
         device_desc.videoStreamDescs[stream_index].width = ok_config_.per_eye_width_;
         device_desc.videoStreamDescs[stream_index].height = ok_config_.per_eye_height_;
         
-        device_desc.videoStreamDescs[stream_index].fps = fps;// (float)integer_fps;
-        device_desc.videoStreamDescs[stream_index].maxBitrate = 0.0f;//ok_config_.max_bitrate_kbps_;
+        device_desc.videoStreamDescs[stream_index].fps = fps;
+        device_desc.videoStreamDescs[stream_index].maxBitrate = ok_config_.max_bitrate_kbps_;
     }
 
     device_desc.disableVVSync = false;
     device_desc.embedInfoInVideo = false;
-    device_desc.foveatedScaleFactor = 0.0f;//ok_config_.foveation_;
+    device_desc.foveatedScaleFactor = compute_foveated_scale_factor();
     device_desc.stereoDisplay = true;
 
 #if USE_FRAME_PERIOD_AS_POSE_PREDICTION_OFFSET
-    const float prediction_offset_sec = (1.0f / fps);
+    [[maybe_unused]] const float prediction_offset_sec = (1.0f / fps);
 #else
-    const float prediction_offset_sec = DEFAULT_CLOUDXR_PREDICTION_OFFSET_NS * NS_TO_SEC;
+    [[maybe_unused]] const float prediction_offset_sec = DEFAULT_CLOUDXR_PREDICTION_OFFSET_NS * NS_TO_SEC;
 #endif
 
     device_desc.predOffset = 0;//prediction_offset_sec;
 
-    //const uint32_t polling_rate_hz = clamp<uint32_t>(ok_config_.polling_rate_mult_ * integer_fps, (uint32_t)MIN_CLOUDXR_POSE_POLLING_HZ, (uint32_t)MAX_CLOUDXR_POSE_POLLING_HZ);
-    device_desc.posePollFreq = 0;// polling_rate_hz;
+    device_desc.posePollFreq = get_polling_rate_hz();
 
 #if ENABLE_OBOE
     device_desc.receiveAudio = ok_config_.enable_audio_playback_;
@@ -525,6 +689,86 @@ bool OKCloudClient::create_receiver()
         }
     }
 
+    is_receiver_desc_prepared_ = true;
+}
+
+float OKCloudClient::negotiate_refresh_rate()
+{
+    const float current_rate = xr_interface_->get_current_refresh_rate();
+
+    xr_interface_->query_refresh_rates();
+    const float display_rate = choose_display_refresh_rate(xr_interface_->get_supported_refresh_rates(), (float)ok_config_.desired_refresh_rate_, current_rate);
+
+    // The switch can land a few frames later, update_refresh_rate() sees it when it does
+    observed_refresh_rate_ = current_rate;
+
+    float stream_display_rate = current_rate;
+
+    if ((display_rate > 0.0f) && !is_same_refresh_rate(display_rate, current_rate) && xr_interface_->set_refresh_rate(display_rate))
+    {
+        stream_display_rate = display_rate;
+    }
+
+    if (stream_display_rate <= 0.0f)
+    {
+        stream_display_rate = (ok_config_.desired_refresh_rate_ > 0) ? (float)ok_config_.desired_refresh_rate_ : DEFAULT_CLOUDXR_FRAMERATE;
+    }
+
+    const float fps = choose_stream_fps(stream_display_rate, (float)ok_config_.max_stream_fps_);
+    stream_fps_.store(fps, std::memory_order_release);
+    has_refresh_changed_.store(false, std::memory_order_release);
+
+    return fps;
+}
+
+void OKCloudClient::update_refresh_rate(const float refresh_rate)
+{
+    if ((refresh_rate <= 0.0f) || is_same_refresh_rate(refresh_rate, observed_refresh_rate_))
+    {
+        return;
+    }
+
+    observed_refresh_rate_ = refresh_rate;
+
+    const float fps = choose_stream_fps(refresh_rate, (float)ok_config_.max_stream_fps_);
+
+    if (is_same_refresh_rate(fps, stream_fps_.load(std::memory_order_relaxed)))
+    {
+        return;
+    }
+
+    // The next receiver is created at the new rate, the current one is told through the tracking state
+    cxrDeviceDesc& device_desc = receiver_desc_.deviceDesc;
+
+    for (uint32_t stream_index = 0; stream_index < device_desc.numVideoStreamDescs; stream_index++)
+    {
+        device_desc.videoStreamDescs[stream_index].fps = fps;
+    }
+
+    stream_fps_.store(fps, std::memory_order_release);
+    has_refresh_changed_.store(cxr_receiver_ != nullptr, std::memory_order_release);
+}
+
+bool OKCloudClient::create_receiver()
+{
+    if (cxr_receiver_  || !xr_interface_)
+    {
+        return false;
+    }
+
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::create_receiver\n");
+
+    // Derived once, reconnects reuse it
+    if (!is_receiver_desc_prepared_)
+    {
+        prepare_receiver_desc();
+    }
+
+#if ENABLE_QOS
+    apply_qos_decision();
+#endif
+
+    OKStartupScope create_receiver_scope(startup_trace_, StartupPhase_CreateReceiver);
     cxrError error = cxrCreateReceiver(&receiver_desc_, &cxr_receiver_);
 
     if (error)
@@ -533,6 +777,14 @@ bool OKCloudClient::create_receiver()
         return false;
     }
 
+    // Created at stream_fps_ already
+    has_refresh_changed_.store(false, std::memory_order_release);
+
+#if ENABLE_QOS
+    qos_controller_.on_applied(get_monotonic_time_ns());
+    qos_controller_.reset_session();
+#endif
+
     return true;
 }
 
@@ -545,7 +797,17 @@ void OKCloudClient::destroy_receiver()
     
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudSession::destroy_receiver\n");
 
+#if ENABLE_POSE_SAMPLER_THREAD
+    pose_sampler_.stop();
+#endif
+
+#if ENABLE_TELEMETRY
+    stop_telemetry();
+#endif
+
 #if ENABLE_OBOE
+    // Before the receiver goes, nothing may call cxrSendAudio on it after this
+    audio_uplink_.stop();
     shutdown_audio();
 #endif
 
@@ -553,38 +815,109 @@ void OKCloudClient::destroy_receiver()
     remove_controllers();
 #endif
 
+    // release_frame skips a frame latched when the session dropped, it belongs to this receiver
+    if (is_latched_)
+    {
+        cxrReleaseFrame(cxr_receiver_, &latched_frames_);
+        is_latched_ = false;
+    }
+
+    latched_frames_ = {};
+
     cxrDestroyReceiver(cxr_receiver_);
     cxr_receiver_ = nullptr;
-    receiver_desc_ = {0};
+
+#if ENABLE_POSE_SAMPLER_THREAD
+    // No more GetTrackingState callbacks, the next receiver picks the writer again
+    is_pose_sampler_writer_.store(false, std::memory_order_release);
+#endif
+
+#if ENABLE_HAPTICS
+    // No more TriggerHaptic callbacks, silence whatever is still playing
+    stop_haptics();
+#endif
+
+#if ENABLE_HAND_TRACKING
+    // After the receiver, whose thread samples inline when there's no pose sampler
+    hand_tracker_.shutdown();
+#endif
+
+#if ENABLE_FACE_TRACKING
+    face_tracker_.shutdown();
+#endif
+
+#if ENABLE_BODY_TRACKING
+    body_tracker_.shutdown();
+    ok_player_state_.shutdown();
+#endif
 
 #if USE_CLOUDXR_POSE_ID
     poseID_ = 0;
+    frame_pose_history_.clear();
+#endif
+
+#if ENABLE_LAST_FRAME_RETENTION
+    frame_cache_.invalidate();
 #endif
 
     update_cxr_state(cxrClientState_Disconnected, cxrError_Success);
+
+    // No more UpdateClientState callbacks, the next receiver starts from scratch. After the
+    // Disconnected notification, or a reconnect would read that as its own attempt failing.
+    cxr_client_state_ = cxrClientState_ReadyToConnect;
+}
+
+uint32_t OKCloudClient::get_polling_rate_hz() const
+{
+    // 0 = let CloudXR use its default rate, and sample inline in the callback
+    const float fps = (receiver_desc_.deviceDesc.numVideoStreamDescs > 0) ? receiver_desc_.deviceDesc.videoStreamDescs[0].fps : DEFAULT_CLOUDXR_FRAMERATE;
+    const uint32_t integer_fps = (uint32_t)roundf(fps);
+
+    return clamp<uint32_t>(ok_config_.polling_rate_mult_ * integer_fps, (uint32_t)MIN_CLOUDXR_POSE_POLLING_HZ, (uint32_t)MAX_CLOUDXR_POSE_POLLING_HZ);
 }
 
-void OKCloudClient::compute_ipd()
+void OKCloudClient::publish_views()
 {
     if (!xr_interface_)
     {
         return;
     }
 
-    const XrView left_view = xr_interface_->get_view(LEFT_EYE);
-    const XrView right_view = xr_interface_->get_view(RIGHT_EYE);
+    // Render thread only: the views belong to the render loop, the tracking thread reads the snapshot
+    OKViewSnapshot view_snapshot;
+
+    for (int view_id = LEFT_EYE; view_id < NUM_EYES; view_id++)
+    {
+        const XrView view = xr_interface_->get_view(view_id);
+        view_snapshot.eye_poses_[view_id] = view.pose;
+        view_snapshot.eye_fovs_[view_id] = view.fov;
+    }
+
+    view_snapshot.is_valid_ = true;
+    view_snapshot_.store(view_snapshot);
+}
+
+float OKCloudClient::compute_ipd() const
+{
+    const OKViewSnapshot view_snapshot = view_snapshot_.load();
+
+    if (!view_snapshot.is_valid_)
+    {
+        return ipd_meters_;
+    }
 
-    const XrPosef& left_eye_pose = left_view.pose;
-    const XrPosef& right_eye_pose = right_view.pose;
+    const XrPosef& left_eye_pose = view_snapshot.eye_poses_[LEFT_EYE];
+    const XrPosef& right_eye_pose = view_snapshot.eye_poses_[RIGHT_EYE];
 
     const XrVector3f delta = {(right_eye_pose.position.x - left_eye_pose.position.x),
                               (right_eye_pose.position.y - left_eye_pose.position.y),
                               (right_eye_pose.position.z - left_eye_pose.position.z)};
 
     float ipd = sqrtf((delta.x * delta.x) + (delta.y * delta.y) + (delta.z * delta.z));
-    ipd_meters_ = roundf(ipd * 10000.0f) / 10000.0f;
+    ipd = roundf(ipd * 10000.0f) / 10000.0f;
 
-    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::compute_ipd IPP =  %.7f meters (%.03f mm)\n", ipd_meters_, ipd_meters_ * MILLIMETERS_PER_METER);
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::compute_ipd IPP =  %.7f meters (%.03f mm)\n", ipd, ipd * MILLIMETERS_PER_METER);
+    return ipd;
 }
 
 #if ENABLE_CLOUDXR_CONTROLLERS
@@ -600,6 +933,8 @@ bool OKCloudClient::add_controllers()
         return true;
     }
 
+    OKStartupScope add_controllers_scope(startup_trace_, StartupPhase_AddControllers);
+
     for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
     {
         //assert(cxr_controller_handles_[controller_id] == nullptr);
@@ -609,10 +944,10 @@ bool OKCloudClient::add_controllers()
             cxrControllerDesc cxr_controller_desc = {};
             cxr_controller_desc.id = controller_id;
             cxr_controller_desc.role = (controller_id == LEFT_CONTROLLER) ? "cxr://input/hand/left" : "cxr://input/hand/right";
-            cxr_controller_desc.controllerName = "Oculus Touch";
-            cxr_controller_desc.inputCount = ARRAY_SIZE(cxr_input_paths);
-            cxr_controller_desc.inputPaths = cxr_input_paths;
-            cxr_controller_desc.inputValueTypes = cxr_input_value_types;
+            cxr_controller_desc.controllerName = input_profile_.get_controller_name();
+            cxr_controller_desc.inputCount = input_profile_.get_input_count();
+            cxr_controller_desc.inputPaths = input_profile_.get_input_paths();
+            cxr_controller_desc.inputValueTypes = input_profile_.get_input_value_types();
 
             cxrError add_controller_error = cxrAddController(cxr_receiver_,
                                                              &cxr_controller_desc,
@@ -628,6 +963,11 @@ bool OKCloudClient::add_controllers()
         }
     }
 
+    for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        controller_event_batches_[controller_id].reset();
+    }
+
     controllers_initialized_ = true;
     return true;
 }
@@ -665,17 +1005,57 @@ void OKCloudClient::remove_controllers()
 }
 #endif
 
-bool OKCloudClient::latch_frame()
+uint32_t OKCloudClient::compute_latch_timeout_ms() const
 {
-    if (!is_cxr_initialized_ || !is_connected() || is_latched_)
+    if (!ok_config_.enable_adaptive_latch_)
     {
-        return false;
+        return ok_config_.latch_timeout_ms_;
     }
 
-    //memset(&latched_frames_, 0, sizeof(latched_frames_));
-    cxrError error = cxrLatchFrame(cxr_receiver_, &latched_frames_, cxrFrameMask_All, ok_config_.latch_timeout_ms_);
+    // Wait at most until the point where blit + submit still make this frame's predicted display
+    // time, which includes the compositor's latency. The frame period is only a fallback for a
+    // runtime that hasn't predicted one yet.
+    const uint64_t display_time_ns = xr_interface_ ? (uint64_t)xr_interface_->get_frame_display_time_ns() : 0;
+    const uint64_t deadline_ns = (display_time_ns > 0) ? display_time_ns : (frame_period_ns_ > 0) ? (frame_start_time_ns_ + frame_period_ns_) : 0;
 
-    if (error)
+    if (deadline_ns == 0)
+    {
+        return ok_config_.latch_timeout_ms_;
+    }
+
+    const uint64_t reserve_ns = (uint64_t)(ok_config_.latch_render_reserve_ms_ * 1000000.0f);
+    const uint64_t now_time_ns = get_monotonic_time_ns();
+
+    if ((now_time_ns + reserve_ns) >= deadline_ns)
+    {
+        return 0;
+    }
+
+    const uint32_t budget_ms = (uint32_t)((deadline_ns - reserve_ns - now_time_ns) / 1000000ULL);
+    return std::min(budget_ms, ok_config_.latch_timeout_ms_);
+}
+
+bool OKCloudClient::latch_frame()
+{
+    if (!is_cxr_initialized_ || !is_connected() || is_latched_)
+    {
+        return false;
+    }
+
+    const uint32_t latch_timeout_ms = compute_latch_timeout_ms();
+
+#if ENABLE_TELEMETRY
+    const uint64_t latch_start_time_ns = get_monotonic_time_ns();
+#endif
+
+    //memset(&latched_frames_, 0, sizeof(latched_frames_));
+    cxrError error = cxrLatchFrame(cxr_receiver_, &latched_frames_, cxrFrameMask_All, latch_timeout_ms);
+
+#if ENABLE_TELEMETRY
+    telemetry_.record_frame_event(TelemetryEvent_LatchFrame, latch_start_time_ns, get_monotonic_time_ns(), error);
+#endif
+
+    if (error)
     {
         const bool is_real_error = (error != cxrError_Frame_Not_Ready);
         const bool log_error = (is_real_error || CLOUDXR_LOG_FRAME_NOT_READY_EVENT);
@@ -685,11 +1065,39 @@ bool OKCloudClient::latch_frame()
             //IGLLog(IGLLogLevel::LOG_ERROR, "OKCloudClient::latch_frame cxrLatchFrame error = %s\n", cxrErrorString(error));
         }
 
+        last_latch_result_ = is_real_error ? LatchResult_Error : LatchResult_Missed;
+
+#if ENABLE_LAST_FRAME_RETENTION
+        frame_cache_.on_latch(true);
+#endif
+
+#if ENABLE_TELEMETRY
+        telemetry_.record_latch_result(last_latch_result_);
+#endif
+
         return false;
     }
 
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::latch_frame SUCCESS\n");
     is_latched_ = true;
+    connection_manager_.on_first_frame(get_monotonic_time_ns());
+
+    // Once per run, startup is over
+    if (startup_trace_.mark(StartupPhase_FirstFrame) && ok_config_.enable_startup_trace_)
+    {
+        startup_trace_.write(ok_config_.app_directory_ + STARTUP_TRACE_FILENAME);
+    }
+
+    last_latch_result_ = (latch_timeout_ms > 0) ? LatchResult_Waited : LatchResult_Polled;
+
+#if ENABLE_LAST_FRAME_RETENTION
+    // A long wait is normal, the latch is paced by the server. No budget left is not.
+    frame_cache_.on_latch(last_latch_result_ == LatchResult_Polled);
+#endif
+
+#if ENABLE_TELEMETRY
+    telemetry_.record_latch_result(last_latch_result_);
+#endif
 
     return true;
 }
@@ -710,8 +1118,17 @@ bool OKCloudClient::blit_frame(const int view_id, GLMPose& eye_pose)
     const bool is_left_eye = (view_id == LEFT_EYE);
 
     uint32_t frame_mask = is_left_eye ? cxrFrameMask_Left : cxrFrameMask_Right;
+
+#if ENABLE_TELEMETRY
+    const uint64_t blit_start_time_ns = get_monotonic_time_ns();
+#endif
+
     cxrError blit_error = cxrBlitFrame(cxr_receiver_, &latched_frames_, frame_mask);
 
+#if ENABLE_TELEMETRY
+    telemetry_.record_frame_event(TelemetryEvent_BlitFrame, blit_start_time_ns, get_monotonic_time_ns(), blit_error);
+#endif
+
     if (blit_error)
     {
         //IGLLog(IGLLogLevel::LOG_ERROR, "OKCloudClient::blit_frame cxrBlitFrame error = %s\n", cxrErrorString(blit_error));
@@ -720,6 +1137,43 @@ bool OKCloudClient::blit_frame(const int view_id, GLMPose& eye_pose)
 
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::blit_frame SUCCESS\n");
 
+
+#if USE_CLOUDXR_POSE_ID
+    OKFramePoseRecord pose_record;
+
+    if (frame_pose_history_.find(latched_frames_.poseID, pose_record))
+    {
+        eye_pose = pose_record.eye_poses_[view_id];
+
+        if (is_left_eye)
+        {
+            // The display time of the frame this blit lands in, not the tracking sample clock
+            const uint64_t display_time_ns = xr_interface_->get_frame_display_time_ns();
+
+            if (display_time_ns > pose_record.send_time_ns_)
+            {
+                last_pose_to_photon_ns_ = display_time_ns - pose_record.send_time_ns_;
+                pose_to_photon_histogram_.record(last_pose_to_photon_ns_);
+
+                const uint64_t estimate_ns = pose_to_photon_estimate_ns_.load(std::memory_order_relaxed);
+                const double smoothed_ns = (estimate_ns == 0) ? (double)last_pose_to_photon_ns_ :
+                                           (double)estimate_ns + POSE_TO_PHOTON_SMOOTHING * ((double)last_pose_to_photon_ns_ - (double)estimate_ns);
+                pose_to_photon_estimate_ns_.store((uint64_t)smoothed_ns, std::memory_order_relaxed);
+            }
+        }
+
+#if ENABLE_LAST_FRAME_RETENTION
+        if (frame_cache_.should_capture(view_id))
+        {
+            frame_cache_.capture(view_id, eye_pose);
+        }
+#endif
+
+        return true;
+    }
+#endif
+
+    // Pose ID unknown (or too old for the history ring), reconstruct from the latched pose matrix
     cxrVector3 cxr_hmd_position = {};
     cxrQuaternion cxr_hmd_rotation = {};
     cxrMatrixToVecQuat(&latched_frames_.poseMatrix, &cxr_hmd_position, &cxr_hmd_rotation);
@@ -730,11 +1184,20 @@ bool OKCloudClient::blit_frame(const int view_id, GLMPose& eye_pose)
     const GLMPose hmd_pose(convert_to_glm(xr_hmd_position), convert_to_glm(xr_hmd_rotation));
     eye_pose = hmd_pose;
 
-    const float half_ipd = ipd_meters_ * 0.5f;
+    const OKTrackingSnapshot tracking_snapshot = tracking_snapshot_.load();
+
+    const float half_ipd = tracking_snapshot.ipd_meters_ * 0.5f;
     const float ipd_offset = is_left_eye ? -half_ipd : half_ipd;
     const glm::vec3 ipd_offset_vec = glm::vec3(ipd_offset, 0.0f, 0.0f);
     eye_pose.translation_ += hmd_pose.rotation_ * ipd_offset_vec;
 
+#if ENABLE_LAST_FRAME_RETENTION
+    if (frame_cache_.should_capture(view_id))
+    {
+        frame_cache_.capture(view_id, eye_pose);
+    }
+#endif
+
     return true;
 }
 
@@ -746,9 +1209,133 @@ void OKCloudClient::release_frame()
     }
 
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::release_frame\n");
-    cxrReleaseFrame(cxr_receiver_, &latched_frames_);
+
+#if ENABLE_TELEMETRY
+    const uint64_t release_start_time_ns = get_monotonic_time_ns();
+#endif
+
+    cxrError error = cxrReleaseFrame(cxr_receiver_, &latched_frames_);
     is_latched_ = false;
+
+#if ENABLE_TELEMETRY
+    telemetry_.record_frame_event(TelemetryEvent_ReleaseFrame, release_start_time_ns, get_monotonic_time_ns(), error);
+#endif
+}
+
+#if ENABLE_LAST_FRAME_RETENTION
+bool OKCloudClient::present_last_frame(const int view_id, GLMPose& eye_pose)
+{
+    if (!is_connected() || !frame_cache_.present(view_id, eye_pose))
+    {
+        return false;
+    }
+
+#if ENABLE_TELEMETRY
+    if (view_id == LEFT_EYE)
+    {
+        telemetry_.record_repeated_frame();
+    }
+#endif
+
+    return true;
+}
+#endif
+
+#if ENABLE_TELEMETRY
+void OKCloudClient::start_telemetry()
+{
+    if (!ok_config_.enable_telemetry_)
+    {
+        return;
+    }
+
+    const std::string trace_path = ok_config_.enable_telemetry_trace_ ? (ok_config_.app_directory_ + TELEMETRY_TRACE_FILENAME) : std::string();
+
+    telemetry_.start(trace_path);
+}
+
+void OKCloudClient::stop_telemetry()
+{
+    telemetry_.stop();
 }
+#endif
+
+void OKCloudClient::update_connection_stats()
+{
+#if ENABLE_TELEMETRY
+    const bool is_telemetry_running = telemetry_.is_running();
+#else
+    const bool is_telemetry_running = false;
+#endif
+
+#if ENABLE_QOS
+    const bool is_qos_enabled = ok_config_.enable_qos_;
+#else
+    const bool is_qos_enabled = false;
+#endif
+
+    if ((!is_telemetry_running && !is_qos_enabled) || !is_connected())
+    {
+        return;
+    }
+
+    // cxrGetConnectionStats is not free, so it is polled on a timer rather than every frame
+    const uint64_t now_time_ns = get_monotonic_time_ns();
+    const uint64_t stats_interval_ns = (uint64_t)ok_config_.telemetry_stats_interval_ms_ * 1000000ULL;
+
+    if ((now_time_ns - last_stats_time_ns_) < stats_interval_ns)
+    {
+        return;
+    }
+
+    last_stats_time_ns_ = now_time_ns;
+
+    cxrConnectionStats stats = {};
+    cxrError error = cxrGetConnectionStats(cxr_receiver_, &stats);
+
+    if (error)
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "OKCloudClient::update_connection_stats cxrGetConnectionStats error = %s\n", cxrErrorString(error));
+        return;
+    }
+
+#if ENABLE_TELEMETRY
+    if (is_telemetry_running)
+    {
+        telemetry_.record_connection_stats(stats, now_time_ns);
+    }
+#endif
+
+#if ENABLE_QOS
+    if (is_qos_enabled)
+    {
+        qos_controller_.update(stats, now_time_ns);
+    }
+#endif
+}
+
+#if ENABLE_QOS
+void OKCloudClient::apply_qos_decision()
+{
+    if (!ok_config_.enable_qos_)
+    {
+        return;
+    }
+
+    // CloudXR takes these from the desc only, hence a new receiver for each change
+    const OKQosDecision& qos_decision = qos_controller_.get_decision();
+    cxrDeviceDesc& device_desc = receiver_desc_.deviceDesc;
+
+    device_desc.maxResFactor = qos_decision.max_res_factor_;
+
+    for (uint32_t stream_index = 0; stream_index < device_desc.numVideoStreamDescs; stream_index++)
+    {
+        device_desc.videoStreamDescs[stream_index].maxBitrate = qos_decision.max_bitrate_kbps_;
+    }
+
+    device_desc.foveatedScaleFactor = compute_foveated_scale_factor();
+}
+#endif
 
 void OKCloudClient::get_tracking_state(cxrVRTrackingState* cxr_tracking_state_ptr)
 {
@@ -757,29 +1344,137 @@ void OKCloudClient::get_tracking_state(cxrVRTrackingState* cxr_tracking_state_pt
         return;
     }
 
-    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
-
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::get_tracking_state\n");
 
-    const uint64_t predicted_display_time_ns = xr_interface_->get_predicted_display_time_ns() + ok_config_.prediction_offset_ns_;
+    const uint64_t callback_start_time_ns = get_monotonic_time_ns();
+
+#if ENABLE_POSE_SAMPLER_THREAD
+    if (is_pose_sampler_writer_.load(std::memory_order_acquire))
+    {
+        // The sampler owns the OpenXR input path and the tracking snapshot for this receiver, even once stopped.
+        // Never sample here, an empty pose is sent until its first sample lands.
+        OKPoseSample pose_sample;
+
+        if (pose_sampler_.get_latest_sample(pose_sample))
+        {
+            *cxr_tracking_state_ptr = pose_sample.tracking_state_;
+        }
+        else
+        {
+            memset(cxr_tracking_state_ptr, 0, sizeof(*cxr_tracking_state_ptr));
+        }
+    }
+    else
+#endif
+    {
+        sample_tracking_state(*cxr_tracking_state_ptr);
+    }
+
+    if (pose_predictor_.is_enabled())
+    {
+        // From each pose's own sample time, so the age of the sampler's newest sample is covered too
+        predict_tracking_state(*cxr_tracking_state_ptr, get_prediction_target_time_ns(get_monotonic_time_ns()));
+    }
 
-    cxrVRTrackingState& cxr_tracking_state = *cxr_tracking_state_ptr;
-    memset(cxr_tracking_state_ptr, 0, sizeof(*cxr_tracking_state_ptr));
+    // Once per change, as the OVR sample's DoTracking does, the server paces the stream to it from then on
+    if (has_refresh_changed_.exchange(false, std::memory_order_acq_rel))
+    {
+        cxr_tracking_state_ptr->hmd.flags |= cxrHmdTrackingFlags_HasRefresh;
+        cxr_tracking_state_ptr->hmd.displayRefresh = stream_fps_.load(std::memory_order_acquire);
+    }
+
+#if USE_CLOUDXR_POSE_ID
+    cxr_tracking_state_ptr->hmd.flags |= cxrHmdTrackingFlags_HasPoseID;
+    cxr_tracking_state_ptr->hmd.poseID = poseID_++;
+
+    record_sent_pose(*cxr_tracking_state_ptr, get_monotonic_time_ns());
+#endif
+
+    tracking_callback_histogram_.record(get_monotonic_time_ns() - callback_start_time_ns);
+}
+
+#if USE_CLOUDXR_POSE_ID
+void OKCloudClient::record_sent_pose(const cxrVRTrackingState& cxr_tracking_state, const uint64_t send_time_ns)
+{
+    const cxrHmdTrackingState& cxr_hmd = cxr_tracking_state.hmd;
+
+    OKFramePoseRecord pose_record;
+    pose_record.is_valid_ = cxr_hmd.pose.poseIsValid;
+    pose_record.pose_id_ = cxr_hmd.poseID;
+    pose_record.pose_time_ns_ = cxr_hmd.clientTimeNS;
+    pose_record.send_time_ns_ = send_time_ns;
+    pose_record.ipd_meters_ = (cxr_hmd.flags & cxrHmdTrackingFlags_HasIPD) ? cxr_hmd.ipd : ipd_meters_;
+
+    pose_record.hmd_pose_ = GLMPose(convert_to_glm(convert_cxr_to_xr(cxr_hmd.pose.position)), convert_to_glm(convert_cxr_to_xr(cxr_hmd.pose.rotation)));
+    pose_record.hmd_pose_.timestamp_ = cxr_hmd.clientTimeNS;
+
+    // The server only knows the head pose and IPD, so this is exactly where it put each eye
+    const float half_ipd = pose_record.ipd_meters_ * 0.5f;
+
+    const OKViewSnapshot view_snapshot = view_snapshot_.load();
+
+    for (int view_id = LEFT_EYE; view_id < NUM_EYES; view_id++)
+    {
+        const float ipd_offset = (view_id == LEFT_EYE) ? -half_ipd : half_ipd;
+
+        GLMPose& eye_pose = pose_record.eye_poses_[view_id];
+        eye_pose = pose_record.hmd_pose_;
+        eye_pose.translation_ += pose_record.hmd_pose_.rotation_ * glm::vec3(ipd_offset, 0.0f, 0.0f);
+
+        pose_record.eye_fovs_[view_id] = view_snapshot.eye_fovs_[view_id];
+    }
+
+    frame_pose_history_.record(pose_record);
+}
+#endif
+
+void OKCloudClient::sample_tracking_state(cxrVRTrackingState& cxr_tracking_state)
+{
+    memset(&cxr_tracking_state, 0, sizeof(cxr_tracking_state));
+
+    if (!is_cxr_initialized_ || !is_connected() || !xr_interface_)
+    {
+        return;
+    }
+
+    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
+
+    const uint64_t predicted_display_time_ns = xr_interface_->get_predicted_display_time_ns() + ok_config_.prediction_offset_ns_;
 
     cxr_tracking_state.poseTimeOffset = ok_config_.pose_time_offset_s_;
 
+    OKTrackingSnapshot tracking_snapshot;
+    tracking_snapshot.predicted_display_time_ns_ = predicted_display_time_ns;
+    tracking_snapshot.ipd_meters_ = ipd_meters_;
+
+#if ENABLE_BODY_TRACKING
+    // Before the controllers, their thumbstick follows the waist
+    if (ok_config_.enable_body_tracking_ && body_tracker_.is_initialized())
+    {
+        update_body_tracking(predicted_display_time_ns);
+    }
+#endif
+
 #if ENABLE_CLOUDXR_CONTROLLERS
     add_controllers();
 
     if (controllers_initialized_)
     {
-        // Poll from async thread, possibly much higher Hz (up to 1 Khz) than main render thread (to reduce latency)
+        // Poll from the pose sampler (or CloudXR) thread, possibly much higher Hz (up to 1 Khz) than main render thread (to reduce latency)
         xr_interface_->poll_actions(false);
 
+        // Locate both controllers first, then convert and offset them in one batch
+        controller_pose_batch_.clear();
+        controller_offset_batch_.clear();
+
+        int batch_indices[CXR_NUM_CONTROLLERS] = {INVALID_INDEX, INVALID_INDEX};
+
         for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
         {
-            XrActionStateGetInfo action_info = {XR_TYPE_ACTION_STATE_GET_INFO};
-            XrActionStatePose pose_state = {XR_TYPE_ACTION_STATE_POSE};
+            XrActionStateGetInfo action_info = {};
+            action_info.type = XR_TYPE_ACTION_STATE_GET_INFO;
+            XrActionStatePose pose_state = {};
+            pose_state.type = XR_TYPE_ACTION_STATE_POSE;
 
             action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
             action_info.action = ok_inputs.aimPoseAction;
@@ -791,12 +1486,16 @@ void OKCloudClient::get_tracking_state(cxrVRTrackingState* cxr_tracking_state_pt
 
             OKController& ok_controller = ok_player_state_.controllers_[controller_id];
             ok_controller.pose_.is_valid_ = false;
+            tracking_snapshot.controller_poses_[controller_id].is_valid_ = false;
 
             if (XR_UNQUALIFIED_SUCCESS(result) && pose_state.isActive)
             {
-                XrSpaceVelocity controller_velocity = {XR_TYPE_SPACE_VELOCITY};
-                XrSpaceLocation controller_location = {XR_TYPE_SPACE_LOCATION,
-                                                       &controller_velocity};
+                XrSpaceVelocity controller_velocity = {};
+                controller_velocity.type = XR_TYPE_SPACE_VELOCITY;
+
+                XrSpaceLocation controller_location = {};
+                controller_location.type = XR_TYPE_SPACE_LOCATION;
+                controller_location.next = &controller_velocity;
 
                 XrResult controller_result =
                         xrLocateSpace(ok_inputs.aimSpace[controller_id], xr_interface_->get_base_space(),
@@ -805,57 +1504,93 @@ void OKCloudClient::get_tracking_state(cxrVRTrackingState* cxr_tracking_state_pt
                 if (controller_result == XR_SUCCESS)
                 {
                     cxr_controller.clientTimeNS = predicted_display_time_ns;
-                    ok_controller.pose_ = convert_to_glm_pose(controller_location.pose);
 
-                    if (ok_config_.enable_remote_controller_offset_)
-                    {
-                        GLMPose cloudxr_controller_offset = ok_config_.remote_controller_offset_;
+                    const int batch_index = controller_pose_batch_.add(controller_location.pose);
+                    batch_indices[controller_id] = batch_index;
 
-                        if (controller_id == LEFT_CONTROLLER)
-                        {
-                            cloudxr_controller_offset.translation_.x *= -1.0f;
-                        }
+                    const XrVector3f zero_velocity = {0.0f, 0.0f, 0.0f};
+                    controller_pose_batch_.set_velocity(batch_index,
+                        (controller_velocity.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) ? controller_velocity.linearVelocity : zero_velocity,
+                        (controller_velocity.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) ? controller_velocity.angularVelocity : zero_velocity);
 
-                        const glm::vec3 offset_ws = ok_controller.pose_.rotation_ * cloudxr_controller_offset.translation_;
-                        ok_controller.pose_.translation_ += offset_ws;
-                        ok_controller.pose_.rotation_ = glm::normalize(ok_controller.pose_.rotation_ * cloudxr_controller_offset.rotation_);
+                    GLMPose cloudxr_controller_offset = ok_config_.remote_controller_offset_;
 
+                    if (controller_id == LEFT_CONTROLLER)
+                    {
+                        cloudxr_controller_offset.translation_.x *= -1.0f;
                     }
 
-                    cxr_controller.pose = convert_glm_to_cxr_pose(ok_controller.pose_);
+                    controller_offset_batch_.add(cloudxr_controller_offset);
+                }
+            }
+        }
 
-                    update_controller_digital_buttons(controller_id);
-                    update_controller_analog_axes(controller_id);
+        if (ok_config_.enable_remote_controller_offset_)
+        {
+            transform_by_offsets(controller_pose_batch_, controller_offset_batch_);
+        }
 
-                    //send_controller_poses(cxr_controller, controller_id, predicted_display_time_ns);
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            const int batch_index = batch_indices[controller_id];
 
-                    fire_controller_events(controller_id, predicted_display_time_ns);
-                }
+            if (batch_index == INVALID_INDEX)
+            {
+                continue;
             }
+
+            cxrControllerTrackingState& cxr_controller = cxr_tracking_state.controller[controller_id];
+            OKController& ok_controller = ok_player_state_.controllers_[controller_id];
+
+            cxr_controller.pose = controller_pose_batch_.get_cxr_pose(batch_index);
+            ok_controller.pose_ = controller_pose_batch_.get_glm_pose(batch_index);
+            tracking_snapshot.controller_poses_[controller_id] = ok_controller.pose_;
+
+            update_controller_digital_buttons(controller_id);
+            update_controller_analog_axes(controller_id);
+
+            //send_controller_poses(cxr_controller, controller_id);
+
+            fire_controller_events(controller_id, predicted_display_time_ns);
         }
     }
 #endif
 
+#if ENABLE_HAND_TRACKING
+    if (ok_config_.enable_hand_tracking_ && hand_tracker_.is_initialized())
+    {
+        send_hand_joints(predicted_display_time_ns);
+    }
+#endif
+
+#if ENABLE_FACE_TRACKING
+    if (ok_config_.enable_face_tracking_ && face_tracker_.is_initialized())
+    {
+        send_face_expressions(predicted_display_time_ns);
+    }
+#endif
+
 #if ENABLE_CLOUDXR_HMD
     {
         cxr_tracking_state.hmd.flags = 0;
 
 #if RECOMPUTE_IPD_EVERY_FRAME
-        compute_ipd();
+        tracking_snapshot.ipd_meters_ = compute_ipd();
         cxr_tracking_state.hmd.flags |= cxrHmdTrackingFlags_HasIPD;
-        cxr_tracking_state.hmd.ipd = ipd_meters_;
-#endif
-
-#if USE_CLOUDXR_POSE_ID
-        cxr_tracking_state.hmd.flags |= cxrHmdTrackingFlags_HasPoseID;
-        cxr_tracking_state.hmd.poseID = poseID_++;
+        cxr_tracking_state.hmd.ipd = tracking_snapshot.ipd_meters_;
 #endif
 
         cxrTrackedDevicePose& cxr_hmd_pose = cxr_tracking_state.hmd.pose;
         cxr_hmd_pose = {};
 
-        XrSpaceVelocity hmd_velocity = {XR_TYPE_SPACE_VELOCITY};
-        XrSpaceLocation hmd_location = {XR_TYPE_SPACE_LOCATION, &hmd_velocity};
+        tracking_snapshot.hmd_pose_.is_valid_ = false;
+
+        XrSpaceVelocity hmd_velocity = {};
+        hmd_velocity.type = XR_TYPE_SPACE_VELOCITY;
+
+        XrSpaceLocation hmd_location = {};
+        hmd_location.type = XR_TYPE_SPACE_LOCATION;
+        hmd_location.next = &hmd_velocity;
 
         XrResult hmd_result = xrLocateSpace(xr_interface_->get_head_space(), xr_interface_->get_base_space(), predicted_display_time_ns, &hmd_location);
 
@@ -864,14 +1599,68 @@ void OKCloudClient::get_tracking_state(cxrVRTrackingState* cxr_tracking_state_pt
             cxr_hmd_pose = convert_xr_to_cxr_pose(hmd_location);
             cxr_tracking_state.hmd.clientTimeNS = predicted_display_time_ns;
             cxr_tracking_state.hmd.activityLevel = cxrDeviceActivityLevel_UserInteraction;
+
+            tracking_snapshot.hmd_pose_ = convert_to_glm_pose(hmd_location.pose);
+            tracking_snapshot.hmd_pose_.timestamp_ = predicted_display_time_ns;
+        }
+
+#if ENABLE_EYE_TRACKING
+        if (ok_config_.enable_eye_tracking_)
+        {
+            send_eye_gaze(predicted_display_time_ns);
+        }
+#endif
+    }
+#endif
+
+    tracking_snapshot_.store(tracking_snapshot);
+
+}
+
+void OKCloudClient::predict_tracking_state(cxrVRTrackingState& cxr_tracking_state, const uint64_t target_time_ns) const
+{
+    cxrHmdTrackingState& cxr_hmd = cxr_tracking_state.hmd;
+
+    if (cxr_hmd.pose.poseIsValid && (cxr_hmd.clientTimeNS > 0))
+    {
+        const OKPoseState predicted_state = pose_predictor_.predict(convert_cxr_to_pose_state(cxr_hmd.pose, cxr_hmd.clientTimeNS), target_time_ns);
+        apply_pose_state(predicted_state, cxr_hmd.pose);
+        cxr_hmd.clientTimeNS = predicted_state.timestamp_ns_;
+    }
+
+    for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        cxrControllerTrackingState& cxr_controller = cxr_tracking_state.controller[controller_id];
+
+        if (cxr_controller.pose.poseIsValid && (cxr_controller.clientTimeNS > 0))
+        {
+            const OKPoseState predicted_state = pose_predictor_.predict(convert_cxr_to_pose_state(cxr_controller.pose, cxr_controller.clientTimeNS), target_time_ns);
+            apply_pose_state(predicted_state, cxr_controller.pose);
+            cxr_controller.clientTimeNS = predicted_state.timestamp_ns_;
         }
     }
+}
+
+// When the frame the server renders from a pose sent now will be on screen: the measured pose to photon
+// time once frames come back with pose IDs, until then the display time of the local frame in flight
+uint64_t OKCloudClient::get_prediction_target_time_ns(const uint64_t now_time_ns) const
+{
+    uint64_t horizon_ns = frame_display_lead_ns_.load(std::memory_order_relaxed);
+
+#if USE_CLOUDXR_POSE_ID
+    const uint64_t pose_to_photon_ns = pose_to_photon_estimate_ns_.load(std::memory_order_relaxed);
+
+    if (pose_to_photon_ns > 0)
+    {
+        horizon_ns = pose_to_photon_ns;
+    }
 #endif
 
+    return now_time_ns + horizon_ns + (uint64_t)(ok_config_.client_prediction_ms_ * 1000000.0f);
 }
 
 #if ENABLE_CLOUDXR_CONTROLLERS
-void OKCloudClient::send_controller_poses(cxrControllerTrackingState& cxr_controller, const int controller_id, const uint64_t predicted_display_time_ns)
+void OKCloudClient::send_controller_poses(cxrControllerTrackingState& cxr_controller, const int controller_id)
 {
     if (!is_cxr_initialized_ || !is_connected() || !controllers_initialized_ || !xr_interface_)
     {
@@ -895,6 +1684,20 @@ void OKCloudClient::send_controller_poses(cxrControllerTrackingState& cxr_contro
     }
 }
 
+void OKCloudClient::apply_remote_controller_offset(const int controller_id, GLMPose& controller_pose) const
+{
+    GLMPose cloudxr_controller_offset = ok_config_.remote_controller_offset_;
+
+    if (controller_id == LEFT_CONTROLLER)
+    {
+        cloudxr_controller_offset.translation_.x *= -1.0f;
+    }
+
+    const glm::vec3 offset_ws = controller_pose.rotation_ * cloudxr_controller_offset.translation_;
+    controller_pose.translation_ += offset_ws;
+    controller_pose.rotation_ = glm::normalize(controller_pose.rotation_ * cloudxr_controller_offset.rotation_);
+}
+
 void OKCloudClient::fire_controller_events(const int controller_id, const uint64_t predicted_display_time_ns)
 {
     if (!is_cxr_initialized_ || !is_connected() || !controllers_initialized_)
@@ -904,219 +1707,388 @@ void OKCloudClient::fire_controller_events(const int controller_id, const uint64
 
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::fire_controller_events\n");
 
-    cxrControllerEvent cxr_events[MAX_CLOUDXR_CONTROLLER_EVENTS] = {};
-    uint32_t cxr_event_count = 0;
+    OKControllerEventBatch& event_batch = controller_event_batches_[controller_id];
+
+    input_profile_.execute(controller_id, ok_player_state_.controllers_, event_batch);
 
-    const OKController& ok_controller = ok_player_state_.controllers_[controller_id];
+    const uint32_t cxr_event_count = event_batch.build(predicted_display_time_ns, get_monotonic_time_ns(), send_all_controller_values_);
 
+    if (cxr_event_count > 0)
     {
-        const uint32_t num_analog_axis_maps = ARRAY_SIZE(analog_axis_maps);
+        cxrError fire_controller_events_result = cxrFireControllerEvents(cxr_receiver_, cxr_controller_handles_[controller_id], event_batch.get_events(), cxr_event_count);
 
-        for (uint32_t map_id = 0; map_id < num_analog_axis_maps; map_id++)
+        if (fire_controller_events_result)
         {
-            const AnalogAxisToCloudXRMap &analog_axis_map = analog_axis_maps[map_id];
+            //IGLLog(IGLLogLevel::LOG_ERROR, "cxrFireControllerEvents error = %s\n",
+//                   cxrErrorString(fire_controller_events_result));
 
-            if (analog_axis_map.cloudxr_path_id_ == INVALID_INDEX)
-            {
-                continue;
-            }
+            // Resend everything next poll rather than lose a state change
+            event_batch.reset();
+        }
+    }
+}
+
+void OKCloudClient::update_controller_digital_buttons(const int controller_id)
+{
+    if (!is_cxr_initialized_ || !is_connected() || !xr_interface_)
+    {
+        return;
+    }
 
-            const OKAnalogAxis& ok_analog_axis = ok_controller.analog_axes_[analog_axis_map.analog_axis_id_];
-            const bool was_changed = send_all_analog_controller_values_ || ok_analog_axis.was_value_changed();
+    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
 
-            if (was_changed)
-            {
-                const float analog_axis_value = ok_analog_axis.get_current_value();
+    OKController& ok_controller = ok_player_state_.controllers_[controller_id];
 
-                cxrControllerEvent &event = cxr_events[cxr_event_count++];
-                event.clientTimeNS = predicted_display_time_ns;
-                event.clientInputIndex = analog_axis_map.cloudxr_path_id_;
-                event.inputValue.valueType = cxrInputValueType_float32;
-                event.inputValue.vF32 = analog_axis_value;
-            }
+    XrActionStateGetInfo action_info = {};
+    action_info.type = XR_TYPE_ACTION_STATE_GET_INFO;
+    action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
+
+    XrActionStateBoolean button_state = {};
+    button_state.type = XR_TYPE_ACTION_STATE_BOOLEAN;
+
+    for (const OKDigitalActionBinding& action_binding : digital_action_bindings)
+    {
+        action_info.action = ok_inputs.*action_binding.action_;
+        XrResult action_result = xrGetActionStateBoolean(xr_interface_->get_session(), &action_info, &button_state);
+
+        if ((action_result != XR_SUCCESS) || !button_state.isActive)
+        {
+            continue;
         }
+
+        OKDigitalButton& ok_digital_button = ok_controller.digital_buttons_[action_binding.digital_button_id_];
+        ok_digital_button.set_state(button_state.currentState);
     }
 
+}
+
+void OKCloudClient::update_controller_analog_axes(const int controller_id)
+{
+    if (!is_cxr_initialized_ || !is_connected() || !xr_interface_)
     {
-        const uint32_t num_digital_button_maps = ARRAY_SIZE(digital_button_maps);
+        return;
+    }
 
-        for (uint32_t map_id = 0; map_id < num_digital_button_maps; map_id++)
-        {
-            const DigitalButtonToCloudXR_Map& digital_button_map = digital_button_maps[map_id][controller_id];
+    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
 
-            if (digital_button_map.cloudxr_path_id_ == INVALID_INDEX)
-            {
-                continue;
-            }
+    OKController& ok_controller = ok_player_state_.controllers_[controller_id];
 
-            const OKDigitalButton& ok_digital_button = ok_controller.digital_buttons_[digital_button_map.digital_button_id_];
+    XrActionStateGetInfo action_info = {};
+    action_info.type = XR_TYPE_ACTION_STATE_GET_INFO;
+    action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
+    XrActionStateFloat axis_state = {};
+    axis_state.type = XR_TYPE_ACTION_STATE_FLOAT;
 
-            const bool is_down = ok_digital_button.is_down();
-            const bool was_changed = send_all_digital_controller_values_ || ok_digital_button.was_changed();
+    // Read everything first, the thumbstick is rewritten as a pair before any axis sees it
+    float axis_values[ANALOG_AXIS_COUNT] = {};
+    bool axis_active[ANALOG_AXIS_COUNT] = {};
 
-            if (was_changed)
-            {
-                cxrControllerEvent& event = cxr_events[cxr_event_count++];
-                event.clientTimeNS = predicted_display_time_ns;
-                event.clientInputIndex = digital_button_map.cloudxr_path_id_;
-                event.inputValue.valueType = cxrInputValueType_boolean;
-                event.inputValue.vBool = is_down;
-            }
+    for (const OKAnalogActionBinding& action_binding : analog_action_bindings)
+    {
+        action_info.action = ok_inputs.*action_binding.action_;
+        XrResult action_result = xrGetActionStateFloat(xr_interface_->get_session(), &action_info, &axis_state);
+
+        if ((action_result != XR_SUCCESS) || !axis_state.isActive)
+        {
+            continue;
         }
+
+        axis_values[action_binding.analog_axis_id_] = axis_state.currentState;
+        axis_active[action_binding.analog_axis_id_] = true;
     }
 
-    if (cxr_event_count > 0)
+#if ENABLE_WAIST_LOCO
+    // The locomotion stick is the server's left one, the physical right when they're swapped
+    const int loco_controller_id = ok_config_.enable_swap_thumbsticks_ ? RIGHT_CONTROLLER : LEFT_CONTROLLER;
+
+    if (ok_config_.enable_waist_loco_ && (controller_id == loco_controller_id) && axis_active[AnalogAxis_JoystickX] && axis_active[AnalogAxis_JoystickY])
     {
-        cxrError fire_controller_events_result = cxrFireControllerEvents(cxr_receiver_, cxr_controller_handles_[controller_id], cxr_events, cxr_event_count);
+        ok_player_state_.apply_waist_locomotion(axis_values[AnalogAxis_JoystickX], axis_values[AnalogAxis_JoystickY]);
+    }
+#endif
 
-        if (fire_controller_events_result)
+    for (int axis_id = 0; axis_id < ANALOG_AXIS_COUNT; axis_id++)
+    {
+        if (axis_active[axis_id])
         {
-            //IGLLog(IGLLogLevel::LOG_ERROR, "cxrFireControllerEvents error = %s\n",
-//                   cxrErrorString(fire_controller_events_result));
+            ok_controller.analog_axes_[axis_id].set_value(axis_values[axis_id]);
         }
     }
 }
 
-void OKCloudClient::update_controller_digital_buttons(const int controller_id)
+#endif
+
+#if ENABLE_FACE_TRACKING
+void OKCloudClient::send_face_expressions(const uint64_t predicted_display_time_ns)
 {
-    if (!is_cxr_initialized_ || !is_connected() || !xr_interface_)
+    const uint64_t now_time_ns = get_monotonic_time_ns();
+    const uint64_t sample_period_ns = (uint64_t)(1000000000.0f / ok_config_.face_tracking_hz_);
+
+    if ((last_face_sample_time_ns_ != 0) && ((now_time_ns - last_face_sample_time_ns_) < sample_period_ns))
     {
         return;
     }
 
-    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
+    last_face_sample_time_ns_ = now_time_ns;
+
+    const bool is_valid = face_tracker_.get_expression_weights(predicted_display_time_ns, face_expression_weights_, face_expression_confidences_);
 
-    struct XRActionToDigitalButtonID_Mapping
+    const uint32_t packet_size = face_expression_encoder_.build(is_valid ? face_expression_weights_ : nullptr,
+                                                                is_valid ? face_expression_confidences_ : nullptr,
+                                                                predicted_display_time_ns, now_time_ns);
+
+    if (packet_size == 0)
     {
-        XrAction action;
-        DigitalButtonID digital_button_id;
-    };
+        return;
+    }
 
-    XRActionToDigitalButtonID_Mapping xr_to_ok_button_mappings[] =
-            {
-                    {ok_inputs.menuClickAction, DigitalButton_ApplicationMenu},
-                    {ok_inputs.triggerTouchAction, DigitalButton_Trigger_Touch},
-                    {ok_inputs.triggerClickAction, DigitalButton_Trigger_Click},
-                    //{ok_inputs.squeezeTouchAction, DigitalButton_Grip_Touch},
-                    {ok_inputs.squeezeClickAction, DigitalButton_Grip_Click},
-                    {ok_inputs.thumbstickTouchAction, DigitalButton_Joystick_Touch},
-                    {ok_inputs.thumbstickClickAction, DigitalButton_Joystick_Click},
-                    //{ok_inputs.thumbRestTouchAction, DigitalButton_Touchpad_Touch},
-                    //{ok_inputs.thumbRestClickAction, DigitalButton_Touchpad_Click},
-                    {ok_inputs.buttonAXTouchAction, DigitalButton_A_Touch},
-                    {ok_inputs.buttonAXClickAction, DigitalButton_A_Click},
-                    {ok_inputs.buttonBYTouchAction, DigitalButton_B_Touch},
-                    {ok_inputs.buttonBYClickAction, DigitalButton_B_Click}
-            };
+    if (!send_generic_input(face_expression_encoder_.get_packet(), packet_size))
+    {
+        // Weights the server never got are resent with the next keyframe
+        face_expression_encoder_.reset();
+    }
+}
+#endif
 
-    OKController& ok_controller = ok_player_state_.controllers_[controller_id];
+#if ENABLE_BODY_TRACKING
+void OKCloudClient::update_body_tracking(const uint64_t predicted_display_time_ns)
+{
+    OKPlayerState& player_state = ok_player_state_;
+    player_state.hips_pose_.is_valid_ = false;
+    player_state.hmd_pose_.is_valid_ = false;
 
-    XrActionStateGetInfo action_info = {XR_TYPE_ACTION_STATE_GET_INFO};
-    action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
+    if (body_tracker_.locate_joints(xr_interface_->get_base_space(), predicted_display_time_ns, body_joint_locations_))
+    {
+        player_state.hips_pose_ = convert_to_glm_pose(body_joint_locations_[XR_BODY_JOINT_HIPS_FB].pose);
+        player_state.hips_pose_.timestamp_ = predicted_display_time_ns;
+
+        // The HMD block locates the head after the controllers, the waist needs its heading now
+        XrSpaceLocation hmd_location = {};
+        hmd_location.type = XR_TYPE_SPACE_LOCATION;
+        const XrResult hmd_result = xrLocateSpace(xr_interface_->get_head_space(), xr_interface_->get_base_space(), predicted_display_time_ns, &hmd_location);
+
+        if (XR_UNQUALIFIED_SUCCESS(hmd_result) && (hmd_location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT))
+        {
+            player_state.hmd_pose_ = convert_to_glm_pose(hmd_location.pose);
+            player_state.hmd_pose_.timestamp_ = predicted_display_time_ns;
+        }
+    }
+
+    player_state.update(predicted_display_time_ns);
+}
+#endif
 
-    XrActionStateBoolean button_state = {XR_TYPE_ACTION_STATE_BOOLEAN};
+#if ENABLE_HAND_TRACKING
+void OKCloudClient::send_hand_joints(const uint64_t predicted_display_time_ns)
+{
+    const OKPoseBatch* hand_joints[NUM_HANDS] = {nullptr, nullptr};
 
-    for (uint32_t j = 0; j < ARRAY_SIZE(xr_to_ok_button_mappings); j++)
+    for (int hand_id = LEFT_HAND; hand_id < NUM_HANDS; hand_id++)
     {
-        action_info.action = xr_to_ok_button_mappings[j].action;
-        XrResult action_result = xrGetActionStateBoolean(xr_interface_->get_session(), &action_info, &button_state);
+        XrHandJointLocationEXT* joint_locations = hand_joint_locations_[hand_id];
 
-        if ((action_result != XR_SUCCESS) || !button_state.isActive)
+        if (!hand_tracker_.locate_joints(hand_id, xr_interface_->get_base_space(), predicted_display_time_ns, joint_locations))
         {
             continue;
         }
 
-        OKDigitalButton& ok_digital_button = ok_controller.digital_buttons_[xr_to_ok_button_mappings[j].digital_button_id];
-        ok_digital_button.set_state(button_state.currentState);
+        // Straight out of the XrHandJointLocationEXT array, the encoder reads the SoA lanes
+        OKPoseBatch& joint_batch = hand_joint_batches_[hand_id];
+        load_xr_poses(joint_batch, &joint_locations[0].pose, XR_HAND_JOINT_COUNT_EXT, sizeof(XrHandJointLocationEXT));
+        normalize_rotations(joint_batch);
+
+        hand_joints[hand_id] = &joint_batch;
     }
 
-    if (simulate_grip_touch_)
+    const uint32_t packet_size = hand_joint_encoder_.build(hand_joints, predicted_display_time_ns, get_monotonic_time_ns(), false);
+
+    if (packet_size == 0)
     {
-        const OKAnalogAxis& grip_analog_axis = ok_controller.analog_axes_[AnalogAxis_Grip];
-        OKDigitalButton& group_touch_button = ok_controller.digital_buttons_[DigitalButton_Grip_Touch];
-        group_touch_button.set_state(grip_analog_axis.get_current_value() > 0.0f);
+        return;
     }
 
-    if (simulate_thumb_rest_)
+    if (!send_generic_input(hand_joint_encoder_.get_packet(), packet_size))
     {
-        const OKAnalogAxis& grip_force_analog_axis = ok_controller.analog_axes_[AnalogAxis_Grip_Force];
-        OKDigitalButton& touchpad_touch_button = ok_controller.digital_buttons_[DigitalButton_Touchpad_Touch];
-        touchpad_touch_button.set_state(grip_force_analog_axis.get_current_value() > 0.0f);
+        // The next packet can't be a delta of one that never left
+        hand_joint_encoder_.reset();
     }
 }
+#endif
 
-void OKCloudClient::update_controller_analog_axes(const int controller_id)
+#if ENABLE_EYE_TRACKING
+bool OKCloudClient::is_eye_gaze_available() const
 {
-    if (!is_cxr_initialized_ || !is_connected() || !xr_interface_)
+    if (!xr_interface_)
     {
-        return;
+        return false;
     }
 
-    OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
+    const OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
+    return (ok_inputs.eyeGazeAction != XR_NULL_HANDLE) && (ok_inputs.eyeGazeSpace != XR_NULL_HANDLE);
+}
 
-    struct XRActionToAnalogAxisID_Mapping
+void OKCloudClient::send_eye_gaze(const uint64_t predicted_display_time_ns)
+{
+    if (!is_eye_gaze_available())
     {
-        XrAction action;
-        AnalogAxisID analog_axis_id;
-    };
+        return;
+    }
 
-    XRActionToAnalogAxisID_Mapping xr_to_ok_analog_mappings[] =
-            {
-                    {ok_inputs.triggerValueAction, AnalogAxis_Trigger},
-                    {ok_inputs.squeezeValueAction, AnalogAxis_Grip},
-                    {ok_inputs.thumbstickXAction, AnalogAxis_JoystickX},
-                    {ok_inputs.thumbstickYAction, AnalogAxis_JoystickY},
-                    {ok_inputs.thumbProximityAction, AnalogAxis_Proximity},
-                    {ok_inputs.thumbRestForceAction, AnalogAxis_Grip_Force},
-                    //{ok_inputs.trackpadXAction, AnalogAxis_JoystickX},
-                    //{ok_inputs.trackpadYAction, AnalogAxis_JoystickY}
-            };
+    const OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
 
-    OKController& ok_controller = ok_player_state_.controllers_[controller_id];
+    OKEyeGazeSample gaze_sample;
+    gaze_sample.time_ns_ = predicted_display_time_ns;
 
-    XrActionStateGetInfo action_info = {XR_TYPE_ACTION_STATE_GET_INFO};
-    action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
-    XrActionStateFloat axis_state = {XR_TYPE_ACTION_STATE_FLOAT};
+    XrActionStateGetInfo action_info = {};
+    action_info.type = XR_TYPE_ACTION_STATE_GET_INFO;
+    XrActionStatePose pose_state = {};
+    pose_state.type = XR_TYPE_ACTION_STATE_POSE;
+    action_info.action = ok_inputs.eyeGazeAction;
+
+    XrResult result = xrGetActionStatePose(xr_interface_->get_session(), &action_info, &pose_state);
 
-    for (uint32_t j = 0; j < ARRAY_SIZE(xr_to_ok_analog_mappings); j++)
+    if (XR_UNQUALIFIED_SUCCESS(result) && pose_state.isActive)
     {
-        action_info.action = xr_to_ok_analog_mappings[j].action;
-        XrResult action_result = xrGetActionStateFloat(xr_interface_->get_session(), &action_info, &axis_state);
+        // Straight into the head space, the server composes it with the HMD pose sent for the same time
+        XrSpaceLocation gaze_location = {};
+        gaze_location.type = XR_TYPE_SPACE_LOCATION;
+        result = xrLocateSpace(ok_inputs.eyeGazeSpace, xr_interface_->get_head_space(), predicted_display_time_ns, &gaze_location);
 
-        if ((action_result != XR_SUCCESS) || !axis_state.isActive)
+        if (XR_UNQUALIFIED_SUCCESS(result) && (gaze_location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT))
         {
-            continue;
+            gaze_sample.flags_ |= EyeGazeFlag_Valid;
+            gaze_sample.flags_ |= (gaze_location.locationFlags & XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT) ? EyeGazeFlag_Tracked : 0;
+            gaze_sample.direction_ = convert_to_glm(gaze_location.pose.orientation) * glm::vec3(0.0f, 0.0f, -1.0f);
         }
+    }
+
+    if (ok_config_.enable_gaze_foveation_)
+    {
+        gaze_sample.flags_ |= EyeGazeFlag_Foveate;
+    }
+
+    const uint32_t packet_size = eye_gaze_encoder_.build(gaze_sample, get_monotonic_time_ns());
 
-        OKAnalogAxis& ok_analog_axis = ok_controller.analog_axes_[xr_to_ok_analog_mappings[j].analog_axis_id];
-        ok_analog_axis.set_value(axis_state.currentState);
+    if ((packet_size > 0) && !send_generic_input(eye_gaze_encoder_.get_packet(), packet_size))
+    {
+        eye_gaze_encoder_.reset();
     }
+}
+#endif
 
-    if (combine_grip_force_with_grip_)
+bool OKCloudClient::send_generic_input(const uint8_t* data, const uint32_t size_in_bytes)
+{
+    if (!cxr_receiver_ || !data || (size_in_bytes == 0))
     {
-        const OKAnalogAxis& grip_force_analog_axis = ok_controller.analog_axes_[AnalogAxis_Grip_Force];
+        return false;
+    }
+
+    cxrInputEvent input_event = {};
+    input_event.type = cxrInputEventType_Generic;
+    input_event.event.genericInputEvent.data = (uint8_t*)data;
+    input_event.event.genericInputEvent.sizeInBytes = size_in_bytes;
+
+    cxrError send_input_event_result = cxrSendInputEvent(cxr_receiver_, &input_event);
 
-        OKAnalogAxis& grip_analog_axis = ok_controller.analog_axes_[AnalogAxis_Grip];
-        grip_analog_axis.combine(grip_force_analog_axis);
+    if (send_input_event_result)
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "cxrSendInputEvent error = %s\n", cxrErrorString(send_input_event_result));
+        return false;
     }
+
+    return true;
 }
 
+uint32_t OKCloudClient::compute_foveated_scale_factor() const
+{
+    // The configured fixed foveation stays on with gaze foveation requested: nothing on the server
+    // foveates around the streamed gaze yet, turning CloudXR's off would only raise the bitrate
+#if ENABLE_QOS
+    const uint32_t foveation = ok_config_.enable_qos_ ? qos_controller_.get_decision().foveation_ : ok_config_.foveation_;
+#else
+    const uint32_t foveation = ok_config_.foveation_;
 #endif
 
+    if (foveation == 0)
+    {
+        return 0;
+    }
+
+    return clamp<uint32_t>(foveation, MIN_CLOUDXR_FOVEATION, 100);
+}
+
 #if ENABLE_HAPTICS
 void OKCloudClient::trigger_haptics(const cxrHapticFeedback* haptics)
 {
-    if (!is_cxr_initialized_ || !is_connected() || !haptics)
+    if (!is_cxr_initialized_ || !haptics)
     {
         return;
     }
 
-    const int controller_id = haptics->deviceID;
-    const float duration_ms = haptics->seconds * 1e9;
-
     //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::trigger_haptics\n");
 
-    //apply_haptics(controller_id, haptics->amplitude, duration_ms, haptics->frequency);
+    haptics_scheduler_.push(*haptics);
+}
+
+void OKCloudClient::update_haptics()
+{
+    OKHapticCommand commands[CXR_NUM_CONTROLLERS];
+    haptics_scheduler_.update(get_monotonic_time_ns(), commands);
+
+    for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        apply_haptics(controller_id, commands[controller_id]);
+    }
+}
+
+void OKCloudClient::stop_haptics()
+{
+    OKHapticCommand commands[CXR_NUM_CONTROLLERS];
+    haptics_scheduler_.reset(get_monotonic_time_ns(), commands);
+
+    for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        apply_haptics(controller_id, commands[controller_id]);
+    }
+}
+
+void OKCloudClient::apply_haptics(const int controller_id, const OKHapticCommand& command)
+{
+    if ((command.type_ == HapticCommand_None) || !xr_interface_)
+    {
+        return;
+    }
+
+    const OKOpenXRControllerActions& ok_inputs = xr_interface_->get_actions();
+
+    if (ok_inputs.vibrateAction == XR_NULL_HANDLE)
+    {
+        return;
+    }
+
+    XrHapticActionInfo action_info = {};
+    action_info.type = XR_TYPE_HAPTIC_ACTION_INFO;
+    action_info.action = ok_inputs.vibrateAction;
+    action_info.subactionPath = ok_inputs.handSubactionPath[controller_id];
+
+    if (command.type_ == HapticCommand_Stop)
+    {
+        xrStopHapticFeedback(xr_interface_->get_session(), &action_info);
+        return;
+    }
+
+    XrHapticVibration vibration = {};
+    vibration.type = XR_TYPE_HAPTIC_VIBRATION;
+    vibration.amplitude = command.pulse_.amplitude_;
+    vibration.duration = (command.pulse_.duration_ns_ > 0) ? (XrDuration)command.pulse_.duration_ns_ : XR_MIN_HAPTIC_DURATION;
+    vibration.frequency = (command.pulse_.frequency_ > 0.0f) ? command.pulse_.frequency_ : XR_FREQUENCY_UNSPECIFIED;
+
+    XrResult result = xrApplyHapticFeedback(xr_interface_->get_session(), &action_info, (const XrHapticBaseHeader*)&vibration);
+
+    if (result != XR_SUCCESS)
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "xrApplyHapticFeedback error = %d\n", result);
+    }
 }
 #endif
 
@@ -1148,29 +2120,37 @@ bool OKCloudClient::init_audio()
         audio_output_stream_builder.setFormat(oboe::AudioFormat::I16);
         audio_output_stream_builder.setChannelCount(oboe::ChannelCount::Stereo);
         audio_output_stream_builder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
+        audio_output_stream_builder.setDataCallback(this);
+        audio_output_stream_builder.setErrorCallback(this);
 
         oboe::Result playback_stream_result = audio_output_stream_builder.openStream(audio_playback_stream_);
 
         if (playback_stream_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "openStream playback error = %s\n", oboe::convertToText(playback_stream_result));
+            close_audio_streams();
             return false;
         }
 
-        int buffer_size = audio_playback_stream_->getFramesPerBurst() * CXR_AUDIO_CHANNEL_COUNT;
+        // The buffer size is in frames, two bursts is the usual low latency double buffering
+        int buffer_size = audio_playback_stream_->getFramesPerBurst() * AUDIO_PLAYBACK_BURSTS;
         oboe::Result set_buffer_size_result = audio_playback_stream_->setBufferSizeInFrames(buffer_size);
 
         if (set_buffer_size_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "setBufferSizeInFrames playback error = %s\n", oboe::convertToText(set_buffer_size_result));
+            close_audio_streams();
             return false;
         }
 
+        audio_jitter_buffer_.reset(ok_config_.audio_target_latency_ms_);
+
         oboe::Result start_playback_result = audio_playback_stream_->start();
 
         if (start_playback_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "start audio playback error = %s\n", oboe::convertToText(start_playback_result));
+            close_audio_streams();
             return false;
         }
     }
@@ -1184,13 +2164,6 @@ bool OKCloudClient::init_audio()
         //audio_capture_stream_builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
         audio_capture_stream_builder.setPerformanceMode(oboe::PerformanceMode::None);
 
-        audio_capture_stream_builder.setSharingMode(oboe::SharingMode::Exclusive);
-        audio_capture_stream_builder.setFormat(oboe::AudioFormat::I16);
-        audio_capture_stream_builder.setChannelCount(oboe::ChannelCount::Stereo);
-        audio_capture_stream_builder.setSampleRate(CXR_AUDIO_SAMPLING_RATE);
-
-        audio_capture_stream_builder.setDirection(oboe::Direction::Input);
-        audio_capture_stream_builder.setPerformanceMode(oboe::PerformanceMode::None);
         audio_capture_stream_builder.setSharingMode(oboe::SharingMode::Exclusive);
         audio_capture_stream_builder.setFormat(oboe::AudioFormat::I16);
         audio_capture_stream_builder.setChannelCount(oboe::ChannelCount::Stereo);
@@ -1203,15 +2176,17 @@ bool OKCloudClient::init_audio()
         if (capture_stream_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "openStream record error = %s\n", oboe::convertToText(capture_stream_result));
+            close_audio_streams();
             return false;
         }
 
-        int buffer_size = audio_playback_stream_->getFramesPerBurst() * 2;
-        oboe::Result set_buffer_size_result = audio_playback_stream_->setBufferSizeInFrames(buffer_size);
+        int buffer_size = audio_record_stream_->getFramesPerBurst() * 2;
+        oboe::Result set_buffer_size_result = audio_record_stream_->setBufferSizeInFrames(buffer_size);
 
         if (set_buffer_size_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "setBufferSizeInFrames record error = %s\n", oboe::convertToText(set_buffer_size_result));
+            close_audio_streams();
             return false;
         }
 
@@ -1220,6 +2195,7 @@ bool OKCloudClient::init_audio()
         if (start_record_result != oboe::Result::OK)
         {
             //IGLLog(IGLLogLevel::LOG_ERROR, "start audio record error = %s\n", oboe::convertToText(start_record_result));
+            close_audio_streams();
             return false;
         }
     }
@@ -1228,25 +2204,68 @@ bool OKCloudClient::init_audio()
     return true;
 }
 
-void OKCloudClient::shutdown_audio()
+void OKCloudClient::close_audio_streams()
 {
-    if (!is_audio_initialized_)
+    if (audio_playback_stream_)
+    {
+        audio_playback_stream_->close();
+        audio_playback_stream_.reset();
+    }
+
+    if (audio_record_stream_)
+    {
+        audio_record_stream_->close();
+        audio_record_stream_.reset();
+    }
+}
+
+void OKCloudClient::start_audio_init()
+{
+    if (audio_init_future_.valid())
+    {
+        // Still opening, or a failed open to collect before retrying
+        if (audio_init_future_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+
+        audio_init_future_.get();
+    }
+
+    if (is_audio_initialized_)
     {
         return;
     }
 
-    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::shutdown_audio\n");
+    audio_init_future_ = std::async(std::launch::async, [this]()
+    {
+        OKStartupScope audio_open_scope(startup_trace_, StartupPhase_AudioOpen);
+        return init_audio();
+    });
+}
 
-    if (audio_playback_stream_)
+void OKCloudClient::wait_for_audio_init()
+{
+    if (audio_init_future_.valid())
     {
-        audio_playback_stream_->close();
+        audio_init_future_.get();
     }
+}
 
-    if (audio_record_stream_)
+void OKCloudClient::shutdown_audio()
+{
+    // Not while the worker may still be opening the streams
+    wait_for_audio_init();
+
+    if (!is_audio_initialized_)
     {
-        audio_record_stream_->close();
+        return;
     }
 
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKCloudClient::shutdown_audio\n");
+
+    close_audio_streams();
+
     is_audio_initialized_ = false;
 }
 
@@ -1257,38 +2276,47 @@ cxrBool OKCloudClient::render_audio(const cxrAudioFrame* audio_frame)
         return cxrFalse;
     }
 
-    uint32_t timeout = audio_frame->streamSizeBytes / CXR_AUDIO_BYTES_PER_MS;
-    uint32_t frame_count = timeout * CXR_AUDIO_SAMPLING_RATE / 1000;
+    // Never waits on the output, a full ring drops the newest audio and counts it as overflow
+    const uint32_t frame_count = audio_frame->streamSizeBytes / (CXR_AUDIO_CHANNEL_COUNT * CXR_AUDIO_SAMPLE_SIZE);
+    audio_jitter_buffer_.write(audio_frame->streamBuffer, frame_count);
 
-    oboe::ResultWithValue write_result =
-            audio_playback_stream_->write(audio_frame->streamBuffer, frame_count, timeout * oboe::kNanosPerMillisecond);
+    return cxrTrue;
+}
 
-    if (!write_result)
+void OKCloudClient::update_audio()
+{
+    if (!is_audio_restart_pending_.exchange(false))
     {
-        //IGLLog(IGLLogLevel::LOG_ERROR, "Error rendering audio: %s", oboe::convertToText(write_result.error()));
-
-        if (write_result.error() == oboe::Result::ErrorDisconnected)
-        {
-            shutdown_audio();
-            init_audio();
-        }
+        return;
     }
 
-    return cxrTrue;
+    shutdown_audio();
+    start_audio_init();
 }
 
 oboe::DataCallbackResult OKCloudClient::onAudioReady(oboe::AudioStream* audio_stream, void *data, int32_t frame_count)
 {
-    if (is_connected())
+    if (audio_stream == audio_playback_stream_.get())
     {
-        cxrAudioFrame audio_frame = {};
-        audio_frame.streamBuffer = (int16_t *)data;
-        audio_frame.streamSizeBytes = frame_count * CXR_AUDIO_CHANNEL_COUNT * CXR_AUDIO_SAMPLE_SIZE;
-        cxrSendAudio(cxr_receiver_, &audio_frame);
+        audio_jitter_buffer_.read((int16_t *)data, (uint32_t)frame_count);
+        return oboe::DataCallbackResult::Continue;
     }
 
+    // Only a copy here, the uplink's sender thread frames it for cxrSendAudio
+    audio_uplink_.write((const int16_t *)data, (uint32_t)frame_count);
+
     return oboe::DataCallbackResult::Continue;
 }
+
+void OKCloudClient::onErrorAfterClose(oboe::AudioStream* audio_stream, oboe::Result error)
+{
+    //IGLLog(IGLLogLevel::LOG_ERROR, "Audio stream closed: %s", oboe::convertToText(error));
+
+    if (error == oboe::Result::ErrorDisconnected)
+    {
+        is_audio_restart_pending_ = true;
+    }
+}
 #endif // ENABLE_OBOE
 
 }  // namespace BVR
@@ -11,6 +11,30 @@
 
 #include "OKConfig.h"
 #include "OKPlayerState.h"
+#include "OKTrackingSnapshot.h"
+#include "OKPoseSampler.h"
+#include "OKLatencyHistogram.h"
+#include "OKPosePredictor.h"
+#include "OKFramePoseHistory.h"
+#include "OKTelemetry.h"
+#include "OKFrameCache.h"
+#include "OKControllerEventBatch.h"
+#include "OKInputProfile.h"
+#include "OKPoseBatch.h"
+#include "OKHandTracker.h"
+#include "OKBodyTracker.h"
+#include "OKHandJointCodec.h"
+#include "OKEyeGazeCodec.h"
+#include "OKFaceTracker.h"
+#include "OKFaceExpressionCodec.h"
+#include "OKHapticsScheduler.h"
+#include "OKAudioJitterBuffer.h"
+#include "OKAudioUplink.h"
+#include "OKConnectionManager.h"
+#include "OKServerSelector.h"
+#include "OKStartupTrace.h"
+#include "OKQosController.h"
+#include "OKRefreshRate.h"
 
 #include <CloudXRClient.h>
 #include <CloudXRMatrixHelpers.h>
@@ -19,6 +43,8 @@
 
 #if ENABLE_OBOE
 #include <oboe/Oboe.h>
+
+#include <future>
 #endif
 
 
@@ -28,6 +54,10 @@
 namespace BVR 
 {
 
+// Per-poll conversions on the tracking callback path
+cxrTrackedDevicePose convert_glm_to_cxr_pose(const GLMPose &glm_pose);
+cxrVector3 convert_xr_to_cxr_vector3(const XrVector3f &input);
+
 class OKOpenXRInterface
 {
 public:
@@ -37,10 +67,15 @@ public:
     virtual OKOpenXRControllerActions& get_actions() = 0;
     virtual const OKOpenXRControllerActions& get_actions() const = 0;
 
+    // The time tracking is sampled at, CLOCK_MONOTONIC "now" on device (see OKCloudSession)
     virtual XrTime get_predicted_display_time_ns() = 0;
 
+    // XrFrameState::predictedDisplayTime of the frame being rendered, on the get_monotonic_time_ns() clock, 0 before the first frame
+    virtual XrTime get_frame_display_time_ns() = 0;
+
     virtual float get_current_refresh_rate() = 0;
     virtual void query_refresh_rates() = 0;
+    virtual const std::vector<float>& get_supported_refresh_rates() = 0; // as of the last query_refresh_rates()
     virtual bool set_refresh_rate(const float refresh_rate) = 0;
 
 #if ENABLE_CLOUDXR_LINK_SHARPENING
@@ -59,7 +94,7 @@ public:
 
 class OKCloudClient
 #if ENABLE_OBOE
-    : public oboe::AudioStreamDataCallback
+    : public oboe::AudioStreamDataCallback, public oboe::AudioStreamErrorCallback
 #endif
 {
 public:
@@ -73,6 +108,7 @@ public:
     void update_cxr_state(cxrClientState state, cxrError error);
     void shutdown_cxr();
 
+    // Keeps a connection up until disconnect(), retrying with backoff from pre_render_update
     bool connect();
     void disconnect();
 
@@ -80,6 +116,11 @@ public:
     bool blit_frame(const int view_id, GLMPose& eye_pose);
     void release_frame();
 
+#if ENABLE_LAST_FRAME_RETENTION
+    // Re-present the last good frame when nothing new could be blitted, eye_pose is its render pose
+    bool present_last_frame(const int view_id, GLMPose& eye_pose);
+#endif
+
     bool is_cxr_initialized() const
     {
         return is_cxr_initialized_;
@@ -107,6 +148,7 @@ public:
 
 #if ENABLE_OBOE
     oboe::DataCallbackResult onAudioReady(oboe::AudioStream* audio_stream, void* data, int32_t frame_count) override;
+    void onErrorAfterClose(oboe::AudioStream* audio_stream, oboe::Result error) override;
 #endif
 
     OKConfig ok_config_;
@@ -127,59 +169,237 @@ public:
         return cxr_receiver_;
     }
 
+    const OKConnectionStats& get_connection_stats() const
+    {
+        return connection_manager_.get_stats();
+    }
+
+    const OKServerSelector& get_server_selector() const
+    {
+        return server_selector_;
+    }
+
+    const OKStartupTrace& get_startup_trace() const
+    {
+        return startup_trace_;
+    }
+
+#if ENABLE_QOS
+    const OKQosController& get_qos_controller() const
+    {
+        return qos_controller_;
+    }
+#endif
+
 //private:
     OKOpenXRInterface* xr_interface_ = nullptr;
     OKOpenXRControllerActions xr_actions_;
     bool is_cxr_initialized_ = false;
 
+    void prepare_receiver_desc();
     bool create_receiver();
+
+    // Switches the headset to the best supported rate, returns the stream fps for it
+    float negotiate_refresh_rate();
+
+    // Called every frame, the runtime or the system can change the display rate mid-stream
+    void update_refresh_rate(const float refresh_rate);
     void destroy_receiver();
 
-    void compute_ipd();
+    bool attempt_connect();
+    void fail_attempt(const uint64_t now_time_ns);
+    void update_connection(const uint64_t now_time_ns);
+
+    OKConnectionManager connection_manager_;
+    OKServerSelector server_selector_;
+    OKStartupTrace startup_trace_;
+    bool is_receiver_desc_prepared_ = false;
+
+    void publish_views();
+    float compute_ipd() const;
 
     void get_tracking_state(cxrVRTrackingState *cxr_tracking_state_ptr);
+    void sample_tracking_state(cxrVRTrackingState& cxr_tracking_state);
+
+    uint32_t get_polling_rate_hz() const;
+
+    void predict_tracking_state(cxrVRTrackingState& cxr_tracking_state, const uint64_t target_time_ns) const;
+    uint64_t get_prediction_target_time_ns(const uint64_t now_time_ns) const;
+
+    // Render thread -> tracking thread, how far ahead of now the frame in flight will be displayed
+    std::atomic<uint64_t> frame_display_lead_ns_ = {0};
+    OKPosePredictor pose_predictor_;
+
+#if ENABLE_POSE_SAMPLER_THREAD
+    OKPoseSampler pose_sampler_;
+    std::atomic<bool> is_pose_sampler_writer_ = {false}; // per receiver, else the CloudXR callback samples
+#endif
+
+    // Time spent inside the CloudXR GetTrackingState callback
+    OKLatencyHistogram tracking_callback_histogram_;
+
+#if ENABLE_TELEMETRY
+    void start_telemetry();
+    void stop_telemetry();
+
+    OKTelemetry telemetry_;
+#endif
+
+#if ENABLE_QOS
+    // The QoS caps over the config's in the receiver desc
+    void apply_qos_decision();
+
+    OKQosController qos_controller_;
+#endif
+
+    // cxrGetConnectionStats for the telemetry and the QoS controller
+    void update_connection_stats();
+    uint64_t last_stats_time_ns_ = 0;
 
 #if ENABLE_CLOUDXR_CONTROLLERS
     bool controllers_initialized_ = false;
     cxrControllerHandle cxr_controller_handles_[CXR_NUM_CONTROLLERS] = {nullptr, nullptr};
     bool add_controllers();
     void remove_controllers();
-    void send_controller_poses(cxrControllerTrackingState& cxr_controller, const int controller_id, const uint64_t predicted_display_time_ns);
+    void send_controller_poses(cxrControllerTrackingState& cxr_controller, const int controller_id);
+    void apply_remote_controller_offset(const int controller_id, GLMPose& controller_pose) const;
     void fire_controller_events(const int controller_id, const uint64_t predicted_display_time_ns);
 
     void update_controller_digital_buttons(const int controller_id);
     void update_controller_analog_axes(const int controller_id);
 
-    bool send_all_analog_controller_values_ = SEND_ALL_DIGITAL_EVENTS_EVERY_FRAME;
-    bool send_all_digital_controller_values_ = SEND_ALL_ANALOG_EVENTS_EVERY_FRAME;
+    // Located controller poses and their remote offsets, transformed together each poll
+    OKPoseBatch controller_pose_batch_;
+    OKPoseBatch controller_offset_batch_;
+
+    OKControllerEventBatch controller_event_batches_[CXR_NUM_CONTROLLERS];
+    bool send_all_controller_values_ = SEND_ALL_CONTROLLER_EVENTS_EVERY_FRAME;
+
+    // Layout + transforms, COMBINE_GRIP_FORCE_WITH_GRIP / SIMULATE_GRIP_TOUCH / SIMULATE_THUMB_REST feed the built-in one.
+    // SIMULATE_THUMB_REST doesn't work, appears "/input/thumb_rest/touch" doesn't work on CXR side
+    OKInputProfile input_profile_;
+#endif
+
+    // Generic input events carry what CloudXR has no tracking fields for (hands, gaze), false if not sent
+    bool send_generic_input(const uint8_t* data, const uint32_t size_in_bytes);
+
+    // foveatedScaleFactor for the device desc, 0 = off
+    uint32_t compute_foveated_scale_factor() const;
+
+#if ENABLE_EYE_TRACKING
+    bool is_eye_gaze_available() const;
+
+    // Head relative gaze for the HMD pose's time, sent right after it
+    void send_eye_gaze(const uint64_t predicted_display_time_ns);
+
+    OKEyeGazeEncoder eye_gaze_encoder_;
+#endif
+
+#if ENABLE_HAND_TRACKING
+    // Located on the sampler path with the controllers, sent as a generic input event blob
+    void send_hand_joints(const uint64_t predicted_display_time_ns);
+
+    OKHandTracker hand_tracker_;
+    XrHandJointLocationEXT hand_joint_locations_[NUM_HANDS][XR_HAND_JOINT_COUNT_EXT] = {};
+    OKPoseBatch hand_joint_batches_[NUM_HANDS];
+    OKHandJointEncoder hand_joint_encoder_;
+#endif
+
+#if ENABLE_FACE_TRACKING
+    // Sampled at face_tracking_hz_ rather than every poll, sent as a generic input event blob
+    void send_face_expressions(const uint64_t predicted_display_time_ns);
+
+    OKFaceTracker face_tracker_;
+    float face_expression_weights_[XR_FACE_EXPRESSION2_COUNT_FB] = {};
+    float face_expression_confidences_[XR_FACE_CONFIDENCE2_COUNT_FB] = {};
+    OKFaceExpressionEncoder face_expression_encoder_;
+    uint64_t last_face_sample_time_ns_ = 0;
+#endif
+
+#if ENABLE_BODY_TRACKING
+    // Hips and head for the waist filter in ok_player_state_, ahead of the controllers' thumbsticks
+    void update_body_tracking(const uint64_t predicted_display_time_ns);
 
-    bool combine_grip_force_with_grip_ = COMBINE_GRIP_FORCE_WITH_GRIP;
-    bool simulate_grip_touch_ = SIMULATE_GRIP_TOUCH;
-    bool simulate_thumb_rest_ = SIMULATE_THUMB_REST; // doesn't work, appears "/input/thumb_rest/touch" doesn't work on CXR side
+    OKBodyTracker body_tracker_;
+    XrBodyJointLocationFB body_joint_locations_[XR_BODY_JOINT_COUNT_FB] = {};
 #endif
 
 #if ENABLE_HAPTICS
+    // CloudXR thread, only queues the pulse
     void trigger_haptics(const cxrHapticFeedback *haptics);
+
+    // Render thread, merges what was queued since the last frame and drives vibrateAction
+    void update_haptics();
+    void stop_haptics();
+    void apply_haptics(const int controller_id, const OKHapticCommand& command);
+
+    OKHapticsScheduler haptics_scheduler_;
 #endif
     cxrGraphicsContext graphics_context_ = {};
     cxrReceiverHandle cxr_receiver_ = nullptr;
-    cxrReceiverDesc receiver_desc_ = {0};
-    cxrClientState cxr_client_state_ = cxrClientState_ReadyToConnect;
+    cxrReceiverDesc receiver_desc_ = {};
+    std::atomic<cxrClientState> cxr_client_state_ = {cxrClientState_ReadyToConnect}; // written by the CloudXR thread
     cxrFramesLatched latched_frames_ = {};
     bool is_latched_ = false;
 
+    uint32_t compute_latch_timeout_ms() const;
+
+    uint64_t frame_start_time_ns_ = 0;
+    uint64_t frame_period_ns_ = 0;
+    OKLatchResult last_latch_result_ = LatchResult_Error;
+
+    float observed_refresh_rate_ = 0.0f;                            // display rate the stream fps was last derived from
+    std::atomic<float> stream_fps_ = {DEFAULT_CLOUDXR_FRAMERATE};   // read by the CloudXR tracking thread
+    std::atomic<bool> has_refresh_changed_ = {false};               // sent once, with the next tracking state
+
+#if ENABLE_LAST_FRAME_RETENTION
+    OKFrameCache frame_cache_;
+#endif
+
     float ipd_meters_ = DEFAULT_CLOUDXR_IPD_M;
 
+    // Lock-free hand-off between the render thread and the CloudXR tracking thread
+    OKTrackingSnapshotLock tracking_snapshot_;
+    OKViewSnapshotLock view_snapshot_;
+
 #if USE_CLOUDXR_POSE_ID
     uint64_t poseID_ = 0;
+
+    void record_sent_pose(const cxrVRTrackingState& cxr_tracking_state, const uint64_t send_time_ns);
+
+    OKFramePoseHistory frame_pose_history_;
+
+    // Time from handing a pose to CloudXR until the frame rendered with it is displayed
+    OKLatencyHistogram pose_to_photon_histogram_;
+    uint64_t last_pose_to_photon_ns_ = 0;
+    std::atomic<uint64_t> pose_to_photon_estimate_ns_ = {0}; // smoothed, the prediction horizon
 #endif
 
 #if ENABLE_OBOE
     bool init_audio();
     void shutdown_audio();
+
+    // Closes and drops whichever streams are open, also undoes a partly failed init_audio
+    void close_audio_streams();
+
+    // init_audio on a worker, opening the streams takes longer than the rest of startup
+    void start_audio_init();
+    void wait_for_audio_init();
+
     cxrBool render_audio(const cxrAudioFrame* audio_frame);
 
-    bool is_audio_initialized_ = false;
+    // Reopen the streams after a device change, on the render thread rather than Oboe's
+    void update_audio();
+
+    // Fed by RenderAudio, drained by the playback stream's data callback
+    OKAudioJitterBuffer audio_jitter_buffer_;
+    std::atomic<bool> is_audio_restart_pending_ = {false};
+
+    // Fed by the capture stream's data callback, sends to the server on its own thread
+    OKAudioUplink audio_uplink_;
+
+    std::atomic<bool> is_audio_initialized_ = {false};
+    std::future<bool> audio_init_future_;
     std::shared_ptr<oboe::AudioStream> audio_playback_stream_;
     std::shared_ptr<oboe::AudioStream> audio_record_stream_;
 #endif
@@ -28,7 +28,6 @@ typedef _jobject*       jobject;
 
 #include <algorithm>
 #include <cmath>
-#include <chrono>
 #include <glm/detail/qualifier.hpp>
 #include <igl/NameHandle.h>
 #include <igl/ShaderCreator.h>
@@ -350,6 +349,10 @@ void OKCloudSession::setVertexParams()
 
 bool OKCloudSession::pre_update() noexcept
 {
+#if ENABLE_CLOUDXR
+    ok_client_.pre_render_update();
+#endif
+
     return true;
 }
 
@@ -384,20 +387,8 @@ void OKCloudSession::update(igl::SurfaceTextures surfaceTextures) noexcept
 
 #if (ENABLE_CLOUDXR && 1)
 
-#if WAIT_TO_CONNECT
-    const float delay_ms = WAIT_TO_CONNECT_MS;
-
-    static std::chrono::time_point<std::chrono::high_resolution_clock> start_time = std::chrono::steady_clock::now();
-    std::chrono::time_point<std::chrono::high_resolution_clock> now_time = std::chrono::steady_clock::now();
-
-    float time_since_begin_ms = (float)(std::chrono::duration<double, std::milli>(now_time - start_time).count());
-
-    const bool try_connecting = (time_since_begin_ms > delay_ms);
-#else
-    const bool try_connecting = true;
-#endif
-
-    if (!ok_client_.is_cxr_initialized() && try_connecting)
+    // update only runs once the session is running, the EGL context and the views are there from the first call
+    if (!ok_client_.is_cxr_initialized())
     {
 #if ENABLE_CLOUDXR_CONTROLLERS
         openxr::XrApp& xr_app = *shellParams().xr_app_ptr_;
@@ -451,6 +442,11 @@ void OKCloudSession::update(igl::SurfaceTextures surfaceTextures) noexcept
 
         ok_inputs_.trackpadXAction = xr_inputs.trackpadXAction;
         ok_inputs_.trackpadYAction = xr_inputs.trackpadYAction;
+
+#if ENABLE_EYE_TRACKING && XR_INPUTS_HAVE_EYE_GAZE
+        ok_inputs_.eyeGazeAction = xr_inputs.eyeGazeAction;
+        ok_inputs_.eyeGazeSpace = xr_inputs.eyeGazeSpace;
+#endif
 #endif
 
         Platform& platform = getPlatform();
@@ -485,6 +481,18 @@ void OKCloudSession::update(igl::SurfaceTextures surfaceTextures) noexcept
 
         return;
     }
+
+#if ENABLE_LAST_FRAME_RETENTION
+    // Missed latch: show the previous frame again with the pose it was rendered at, so the
+    // runtime's timewarp reprojects it. The cube below is only drawn until the first frame.
+    if (ok_client_.present_last_frame(view_id, eye_pose))
+    {
+        openxr::XrApp& xr_app = *shellParams().xr_app_ptr_;
+        xr_app.override_eye_poses_[view_id] = BVR::convert_to_xr_pose(eye_pose);
+
+        return;
+    }
+#endif
 #endif
 
     std::shared_ptr<ICommandBuffer> buffer = commandQueue_->createCommandBuffer(CommandBufferDesc{}, nullptr);
@@ -597,9 +605,15 @@ XrTime OKCloudSession::get_predicted_display_time_ns()
     XrTime now_time = ((uint64_t)(now_ts.tv_sec * 1e9) + now_ts.tv_nsec);
     return now_time;
 #else
+    return get_frame_display_time_ns();
+#endif
+}
+
+XrTime OKCloudSession::get_frame_display_time_ns()
+{
+    // XrTime is CLOCK_MONOTONIC in ns on Android (XR_KHR_convert_timespec_time), no conversion needed
     openxr::XrApp& xr_app = *shellParams().xr_app_ptr_;
     return xr_app.get_predicted_display_time_ns();
-#endif
 }
 
 float OKCloudSession::get_current_refresh_rate()
@@ -612,6 +626,41 @@ void OKCloudSession::query_refresh_rates()
 {
     openxr::XrApp& xr_app = *shellParams().xr_app_ptr_;
     xr_app.querySupportedRefreshRates();
+
+    // XrApp doesn't hand its list out, enumerated here through the session's own XR_FB_display_refresh_rate entry point
+    supported_refresh_rates_.clear();
+
+    PFN_xrEnumerateDisplayRefreshRatesFB xrEnumerateDisplayRefreshRatesFB = nullptr;
+    XrResult result = xrGetInstanceProcAddr(get_instance(), "xrEnumerateDisplayRefreshRatesFB", (PFN_xrVoidFunction*)&xrEnumerateDisplayRefreshRatesFB);
+
+    if (XR_FAILED(result) || !xrEnumerateDisplayRefreshRatesFB)
+    {
+        return;
+    }
+
+    uint32_t refresh_rate_count = 0;
+    result = xrEnumerateDisplayRefreshRatesFB(get_session(), 0, &refresh_rate_count, nullptr);
+
+    if (XR_FAILED(result) || (refresh_rate_count == 0))
+    {
+        return;
+    }
+
+    supported_refresh_rates_.resize(refresh_rate_count);
+    result = xrEnumerateDisplayRefreshRatesFB(get_session(), refresh_rate_count, &refresh_rate_count, supported_refresh_rates_.data());
+
+    if (XR_FAILED(result))
+    {
+        supported_refresh_rates_.clear();
+        return;
+    }
+
+    supported_refresh_rates_.resize(refresh_rate_count);
+}
+
+const std::vector<float>& OKCloudSession::get_supported_refresh_rates()
+{
+    return supported_refresh_rates_;
 }
 
 bool OKCloudSession::set_refresh_rate(const float refresh_rate)
@@ -56,9 +56,11 @@ namespace igl::shell
         virtual const BVR::OKOpenXRControllerActions& get_actions() const override;
 
         virtual XrTime get_predicted_display_time_ns() override;
+        virtual XrTime get_frame_display_time_ns() override;
 
         virtual float get_current_refresh_rate() override;
         virtual void query_refresh_rates() override;
+        virtual const std::vector<float>& get_supported_refresh_rates() override;
         virtual bool set_refresh_rate(const float refresh_rate) override;
 
 #if ENABLE_CLOUDXR_LINK_SHARPENING
@@ -94,6 +96,7 @@ namespace igl::shell
 #if ENABLE_CLOUDXR
         BVR::OKCloudClient ok_client_;
         BVR::OKOpenXRControllerActions ok_inputs_;
+        std::vector<float> supported_refresh_rates_; // as of the last query_refresh_rates()
 #endif
 
     };
@@ -6,6 +6,7 @@
 
 #include "OKConfig.h"
 #include <json/json.h>
+#include <algorithm>
 
 namespace BVR 
 {
@@ -86,6 +87,26 @@ bool OKConfig::load()
         return false;
     }
 
+    if (root.isMember("server_ip_addresses"))
+    {
+        const Json::Value server_ip_addresses_value = root["server_ip_addresses"];
+
+        if (!server_ip_addresses_value.isArray())
+        {
+            return false;
+        }
+
+        server_ip_addresses_.clear();
+
+        for (const Json::Value& address_value : server_ip_addresses_value)
+        {
+            if (address_value.isString() && !address_value.asString().empty())
+            {
+                server_ip_addresses_.push_back(address_value.asString());
+            }
+        }
+    }
+
     if (root.isMember("server_ip_address"))
     {
         const Json::Value server_ip_address_value = root["server_ip_address"];
@@ -100,6 +121,10 @@ bool OKConfig::load()
         }
 
     }
+    else if (!server_ip_addresses_.empty())
+    {
+        server_ip_address_ = server_ip_addresses_[0];
+    }
     else
     {
         return false;
@@ -115,6 +140,26 @@ bool OKConfig::load()
         enable_auto_connect_ = (bool)value.asUInt();
     }
 
+    if (root.isMember("server_probe_port"))
+    {
+        const Json::Value value = root["server_probe_port"];
+
+        if (value.isUInt() && (value.asUInt() > 0) && (value.asUInt() <= 65535))
+        {
+            server_probe_port_ = value.asUInt();
+        }
+    }
+
+    if (root.isMember("server_cache_ttl_s"))
+    {
+        const Json::Value value = root["server_cache_ttl_s"];
+
+        if (value.isUInt())
+        {
+            server_cache_ttl_s_ = value.asUInt();
+        }
+    }
+
     // Res has to be modulo 32 pixels for optimal image quality / scaling
 
     if (root.isMember("per_eye_width"))
@@ -149,6 +194,16 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("max_stream_fps"))
+    {
+        const Json::Value value = root["max_stream_fps"];
+
+        if (value.isUInt())
+        {
+            max_stream_fps_ = value.asUInt();
+        }
+    }
+
     if (root.isMember("polling_rate_mult"))
     {
         const Json::Value value = root["polling_rate_mult"];
@@ -186,7 +241,7 @@ bool OKConfig::load()
 
         if (value.isDouble())
         {
-            max_res_factor_ = value.asFloat();
+            max_res_factor_ = std::clamp(value.asFloat(), MIN_CLOUDXR_RES_FACTOR, MAX_CLOUDXR_RES_FACTOR);
         }
     }
 
@@ -196,7 +251,37 @@ bool OKConfig::load()
 
         if (value.isUInt())
         {
-            //max_bitrate_kbps_ = value.asUInt();
+            max_bitrate_kbps_ = value.asUInt();
+        }
+    }
+
+    if (root.isMember("enable_qos"))
+    {
+        const Json::Value value = root["enable_qos"];
+
+        if (value.isUInt())
+        {
+            enable_qos_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("enable_qos_reconnect"))
+    {
+        const Json::Value value = root["enable_qos_reconnect"];
+
+        if (value.isUInt())
+        {
+            enable_qos_reconnect_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("qos_target_delivery_ms"))
+    {
+        const Json::Value value = root["qos_target_delivery_ms"];
+
+        if (value.isNumeric() && (value.asFloat() > 0.0f))
+        {
+            qos_target_delivery_ms_ = value.asFloat();
         }
     }
 
@@ -220,13 +305,113 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("enable_client_prediction"))
+    {
+        const Json::Value value = root["enable_client_prediction"];
+
+        if (value.isUInt())
+        {
+            enable_client_prediction_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("client_prediction_ms"))
+    {
+        const Json::Value value = root["client_prediction_ms"];
+
+        if (value.isDouble())
+        {
+            client_prediction_ms_ = clamp(value.asFloat(), 0.0f, client_prediction_max_ms_);
+        }
+    }
+
+    if (root.isMember("client_prediction_damping"))
+    {
+        const Json::Value value = root["client_prediction_damping"];
+
+        if (value.isDouble())
+        {
+            client_prediction_damping_ = std::max(value.asFloat(), 0.0f);
+        }
+    }
+
+    if (root.isMember("client_prediction_max_ms"))
+    {
+        const Json::Value value = root["client_prediction_max_ms"];
+
+        if (value.isDouble())
+        {
+            client_prediction_max_ms_ = std::max(value.asFloat(), 0.0f);
+        }
+    }
+
+    if (root.isMember("enable_telemetry"))
+    {
+        const Json::Value value = root["enable_telemetry"];
+
+        if (value.isUInt())
+        {
+            enable_telemetry_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("enable_telemetry_trace"))
+    {
+        const Json::Value value = root["enable_telemetry_trace"];
+
+        if (value.isUInt())
+        {
+            enable_telemetry_trace_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("telemetry_stats_interval_ms"))
+    {
+        const Json::Value value = root["telemetry_stats_interval_ms"];
+
+        if (value.isUInt())
+        {
+            telemetry_stats_interval_ms_ = std::max(value.asUInt(), 1u);
+        }
+    }
+
+    if (root.isMember("enable_startup_trace"))
+    {
+        const Json::Value value = root["enable_startup_trace"];
+
+        if (value.isUInt())
+        {
+            enable_startup_trace_ = (bool)value.asUInt();
+        }
+    }
+
     if (root.isMember("latch_timeout_ms"))
     {
         const Json::Value value = root["latch_timeout_ms"];
 
         if (value.isUInt())
         {
-            //latch_timeout_ms_ = value.asUInt();
+            latch_timeout_ms_ = value.asUInt();
+        }
+    }
+
+    if (root.isMember("enable_adaptive_latch"))
+    {
+        const Json::Value value = root["enable_adaptive_latch"];
+
+        if (value.isUInt())
+        {
+            enable_adaptive_latch_ = (bool)value.asUInt();
+        }
+    }
+
+    if (root.isMember("latch_render_reserve_ms"))
+    {
+        const Json::Value value = root["latch_render_reserve_ms"];
+
+        if (value.isDouble())
+        {
+            latch_render_reserve_ms_ = std::max(value.asFloat(), 0.0f);
         }
     }
 
@@ -250,6 +435,26 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("audio_target_latency_ms"))
+    {
+        const Json::Value value = root["audio_target_latency_ms"];
+
+        if (value.isDouble())
+        {
+            audio_target_latency_ms_ = std::clamp(value.asFloat(), AUDIO_JITTER_MIN_MS, AUDIO_JITTER_MAX_MS);
+        }
+    }
+
+    if (root.isMember("enable_audio_vad"))
+    {
+        const Json::Value value = root["enable_audio_vad"];
+
+        if (value.isUInt())
+        {
+            enable_audio_vad_ = (bool)value.asUInt();
+        }
+    }
+
     if (root.isMember("enable_eye_tracking"))
     {
         const Json::Value value = root["enable_eye_tracking"];
@@ -260,6 +465,16 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("enable_gaze_foveation"))
+    {
+        const Json::Value value = root["enable_gaze_foveation"];
+
+        if (value.isUInt())
+        {
+            enable_gaze_foveation_ = (bool)value.asUInt();
+        }
+    }
+
     if (root.isMember("enable_face_tracking"))
     {
         const Json::Value value = root["enable_face_tracking"];
@@ -270,6 +485,26 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("face_tracking_hz"))
+    {
+        const Json::Value value = root["face_tracking_hz"];
+
+        if (value.isDouble())
+        {
+            face_tracking_hz_ = clamp(value.asFloat(), 1.0f, 1000.0f);
+        }
+    }
+
+    if (root.isMember("face_expression_threshold"))
+    {
+        const Json::Value value = root["face_expression_threshold"];
+
+        if (value.isUInt())
+        {
+            face_expression_threshold_ = clamp(value.asUInt(), 1u, 255u);
+        }
+    }
+
     if (root.isMember("enable_hand_tracking"))
     {
         const Json::Value value = root["enable_hand_tracking"];
@@ -300,6 +535,16 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("waist_smoothing_ms"))
+    {
+        const Json::Value value = root["waist_smoothing_ms"];
+
+        if (value.isDouble())
+        {
+            waist_smoothing_ms_ = clamp(value.asFloat(), 0.0f, 1000.0f);
+        }
+    }
+
     if (root.isMember("enable_swap_thumbsticks"))
     {
         const Json::Value value = root["enable_swap_thumbsticks"];
@@ -310,6 +555,16 @@ bool OKConfig::load()
         }
     }
 
+    if (root.isMember("input_profile"))
+    {
+        const Json::Value value = root["input_profile"];
+
+        if (value.isString())
+        {
+            input_profile_ = value.asString();
+        }
+    }
+
     if (root.isMember("enable_remote_controller_offset"))
     {
         const Json::Value value = root["enable_remote_controller_offset"];
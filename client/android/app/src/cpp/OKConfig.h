@@ -6,12 +6,15 @@
 #define OK_CONFIG_H
 
 #include <string>
+#include <vector>
 #include "GLMPose.h"
 #include "ok_defines.h"
 
 namespace BVR 
 {
 
+bool read_file(const std::string& filename, std::string& file_contents);
+
 class OKConfig 
 {
 public:
@@ -23,13 +26,17 @@ public:
 	bool save();
 
     std::string server_ip_address_ = DEFAULT_SERVER_IP_ADDRESS;
+    std::vector<std::string> server_ip_addresses_; // candidates, the lowest RTT / load one is picked, empty = server_ip_address_
+    uint32_t server_probe_port_ = SERVER_PROBE_PORT;
+    uint32_t server_cache_ttl_s_ = DEFAULT_SERVER_CACHE_TTL_S;
 
     bool enable_auto_connect_ = AUTO_CONNECT_TO_CLOUDXR;
 
     uint32_t per_eye_width_ = DEFAULT_CLOUDXR_PER_EYE_WIDTH;
     uint32_t per_eye_height_ = DEFAULT_CLOUDXR_PER_EYE_HEIGHT;
 
-    uint32_t desired_refresh_rate_ = DEFAULT_CLOUDXR_FRAMERATE;
+    uint32_t desired_refresh_rate_ = DEFAULT_CLOUDXR_FRAMERATE; // 0 = the highest the headset supports
+    uint32_t max_stream_fps_ = DEFAULT_CLOUDXR_MAX_STREAM_FPS;
     uint32_t polling_rate_mult_ = DEFAULT_CLOUDXR_POSE_POLL_FREQUENCY_MULT;
 
     uint32_t foveation_ = DEFAULT_CLOUDXR_FOVEATION;
@@ -38,20 +45,43 @@ public:
     float max_res_factor_ = DEFAULT_CLOUDXR_MAX_RES_FACTOR;
     uint32_t max_bitrate_kbps_ = DEFAULT_CLOUDXR_MAX_BITRATE_KBPS;
 
+    bool enable_qos_ = ENABLE_QOS_BY_DEFAULT;
+    bool enable_qos_reconnect_ = ENABLE_QOS_RECONNECT;
+    float qos_target_delivery_ms_ = DEFAULT_QOS_TARGET_DELIVERY_MS;
+
     float prediction_offset_ns_ = DEFAULT_CLOUDXR_PREDICTION_OFFSET_NS;
     float pose_time_offset_s_ = DEFAULT_CLOUDXR_POSE_TIME_OFFSET_SECONDS;
     uint32_t latch_timeout_ms_ = DEFAULT_CLOUDXR_LATCH_TIMEOUT_MS;
+    bool enable_adaptive_latch_ = ENABLE_ADAPTIVE_LATCH_TIMEOUT;
+    float latch_render_reserve_ms_ = DEFAULT_LATCH_RENDER_RESERVE_MS;
+
+    bool enable_client_prediction_ = ENABLE_CLIENT_POSE_PREDICTION;
+    float client_prediction_ms_ = DEFAULT_CLIENT_PREDICTION_MS;
+    float client_prediction_damping_ = DEFAULT_CLIENT_PREDICTION_DAMPING;
+    float client_prediction_max_ms_ = DEFAULT_CLIENT_PREDICTION_MAX_MS;
+
+    bool enable_telemetry_ = ENABLE_TELEMETRY;
+    bool enable_telemetry_trace_ = ENABLE_TELEMETRY_TRACE;
+    uint32_t telemetry_stats_interval_ms_ = DEFAULT_TELEMETRY_STATS_INTERVAL_MS;
+    bool enable_startup_trace_ = ENABLE_STARTUP_TRACE;
 
     bool enable_audio_playback_ = ENABLE_CLOUDXR_AUDIO_PLAYBACK;
     bool enable_audio_recording_ = ENABLE_CLOUDXR_AUDIO_RECORDING;
+    float audio_target_latency_ms_ = AUDIO_JITTER_TARGET_MS;
+    bool enable_audio_vad_ = ENABLE_AUDIO_VAD;
 
     bool enable_eye_tracking_ = ENABLE_EYE_TRACKING;
+    bool enable_gaze_foveation_ = ENABLE_GAZE_FOVEATION;
     bool enable_face_tracking_ = ENABLE_FACE_TRACKING;
+    float face_tracking_hz_ = FACE_TRACKING_HZ;
+    uint32_t face_expression_threshold_ = FACE_EXPRESSION_THRESHOLD;
     bool enable_hand_tracking_ = ENABLE_HAND_TRACKING;
     bool enable_body_tracking_ = ENABLE_BODY_TRACKING;
 
     bool enable_waist_loco_ = ENABLE_WAIST_LOCO;
+    float waist_smoothing_ms_ = WAIST_SMOOTHING_MS;
     bool enable_swap_thumbsticks_ = ENABLE_SWAP_THUMBSTICKS;
+    std::string input_profile_; // name in OK_INPUT_PROFILES_FILENAME, empty = built-in layout
 
     bool enable_remote_controller_offset_ = ENABLE_CLOUDXR_CONTROLLER_FIX;
     GLMPose remote_controller_offset_ = {{CLOUDXR_CONTROLLER_OFFSET_X, CLOUDXR_CONTROLLER_OFFSET_Y, CLOUDXR_CONTROLLER_OFFSET_Z},
@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKConnectionManager.h"
+
+#if ENABLE_CLOUDXR
+
+#include <algorithm>
+
+namespace BVR
+{
+
+OKConnectionManager::OKConnectionManager(const uint32_t random_seed)
+    : rng_(random_seed)
+{
+}
+
+void OKConnectionManager::request_connect(const uint64_t now_time_ns)
+{
+    if (state_ != ConnectionState_Idle)
+    {
+        return;
+    }
+
+    state_ = ConnectionState_Waiting;
+    retry_time_ns_ = now_time_ns;
+    outage_start_time_ns_ = now_time_ns;
+    stats_.consecutive_failure_count_ = 0;
+}
+
+void OKConnectionManager::request_disconnect()
+{
+    state_ = ConnectionState_Idle;
+    outage_start_time_ns_ = 0;
+}
+
+bool OKConnectionManager::has_attempt_timed_out(const uint64_t now_time_ns) const
+{
+    return (state_ == ConnectionState_Connecting) && (now_time_ns > (attempt_start_time_ns_ + (uint64_t)CONNECT_ATTEMPT_TIMEOUT_MS * 1000000ULL));
+}
+
+void OKConnectionManager::on_attempt(const uint64_t now_time_ns)
+{
+    state_ = ConnectionState_Connecting;
+    attempt_start_time_ns_ = now_time_ns;
+    stats_.attempt_count_++;
+}
+
+void OKConnectionManager::on_streaming(const uint64_t now_time_ns)
+{
+    state_ = ConnectionState_Streaming;
+    stats_.consecutive_failure_count_ = 0;
+    stats_.last_connect_ms_ = (float)((double)(now_time_ns - attempt_start_time_ns_) / 1000000.0);
+}
+
+void OKConnectionManager::on_attempt_failed(const uint64_t now_time_ns)
+{
+    if (state_ == ConnectionState_Idle)
+    {
+        return;
+    }
+
+    stats_.failure_count_++;
+    stats_.consecutive_failure_count_++;
+
+    const uint32_t doubling_count = std::min(stats_.consecutive_failure_count_ - 1, 16u);
+    const float delay_ms = std::min(CONNECT_RETRY_BASE_MS * (float)(1u << doubling_count), CONNECT_RETRY_MAX_MS);
+
+    std::uniform_real_distribution<float> jitter_dist(1.0f - CONNECT_RETRY_JITTER, 1.0f);
+    stats_.last_retry_delay_ms_ = delay_ms * jitter_dist(rng_);
+
+    state_ = ConnectionState_Waiting;
+    retry_time_ns_ = now_time_ns + (uint64_t)(stats_.last_retry_delay_ms_ * 1000000.0f);
+}
+
+void OKConnectionManager::on_session_lost(const uint64_t now_time_ns)
+{
+    if (state_ == ConnectionState_Idle)
+    {
+        return;
+    }
+
+    stats_.disconnect_count_++;
+    stats_.consecutive_failure_count_ = 0;
+    stats_.last_retry_delay_ms_ = 0.0f;
+
+    state_ = ConnectionState_Waiting;
+    retry_time_ns_ = now_time_ns;
+
+    if (outage_start_time_ns_ == 0)
+    {
+        outage_start_time_ns_ = now_time_ns;
+    }
+}
+
+void OKConnectionManager::on_renegotiate(const uint64_t now_time_ns)
+{
+    if (state_ != ConnectionState_Streaming)
+    {
+        return;
+    }
+
+    stats_.renegotiation_count_++;
+    stats_.last_retry_delay_ms_ = 0.0f;
+
+    state_ = ConnectionState_Waiting;
+    retry_time_ns_ = now_time_ns;
+    outage_start_time_ns_ = now_time_ns;
+}
+
+void OKConnectionManager::on_first_frame(const uint64_t now_time_ns)
+{
+    if ((state_ != ConnectionState_Streaming) || (outage_start_time_ns_ == 0))
+    {
+        return;
+    }
+
+    stats_.last_time_to_first_frame_ms_ = (float)((double)(now_time_ns - outage_start_time_ns_) / 1000000.0);
+    outage_start_time_ns_ = 0;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
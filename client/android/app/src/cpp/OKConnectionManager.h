@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_CONNECTION_MANAGER_H
+#define OK_CONNECTION_MANAGER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <cstdint>
+#include <random>
+
+namespace BVR
+{
+
+typedef enum
+{
+    ConnectionState_Idle,       // no connection wanted
+    ConnectionState_Waiting,    // wanted, next attempt at get_retry_time_ns()
+    ConnectionState_Connecting,
+    ConnectionState_Streaming,
+} OKConnectionState;
+
+struct OKConnectionStats
+{
+    uint32_t attempt_count_ = 0;
+    uint32_t failure_count_ = 0;             // attempts that failed or timed out
+    uint32_t disconnect_count_ = 0;          // sessions lost while streaming
+    uint32_t renegotiation_count_ = 0;       // streams torn down on purpose to reconnect with new caps
+    uint32_t consecutive_failure_count_ = 0;
+    float last_retry_delay_ms_ = 0.0f;
+    float last_connect_ms_ = 0.0f;           // attempt start to StreamingSessionInProgress
+    float last_time_to_first_frame_ms_ = 0.0f; // connect request or lost session to the first latched frame
+};
+
+// When to call cxrConnect. The owner reports what the receiver does and asks should_attempt()
+// once per frame. A failed attempt retries after CONNECT_RETRY_BASE_MS, doubling up to
+// CONNECT_RETRY_MAX_MS, each wait shortened by a random CONNECT_RETRY_JITTER so a room of
+// clients doesn't hammer a restarting server in step. A session lost while streaming retries
+// at once, a Wi-Fi blip is usually over by the time a new receiver is up.
+class OKConnectionManager
+{
+public:
+    explicit OKConnectionManager(const uint32_t random_seed = 1);
+
+    // Keep a connection up from now on, the first attempt is due right away
+    void request_connect(const uint64_t now_time_ns);
+
+    // Stop retrying, the owner tears the receiver down
+    void request_disconnect();
+
+    bool should_attempt(const uint64_t now_time_ns) const
+    {
+        return (state_ == ConnectionState_Waiting) && (now_time_ns >= retry_time_ns_);
+    }
+
+    bool has_attempt_timed_out(const uint64_t now_time_ns) const;
+
+    void on_attempt(const uint64_t now_time_ns);
+    void on_streaming(const uint64_t now_time_ns);
+    void on_attempt_failed(const uint64_t now_time_ns);
+    void on_session_lost(const uint64_t now_time_ns);
+
+    // The owner tore a healthy stream down to recreate the receiver, reconnect at once
+    void on_renegotiate(const uint64_t now_time_ns);
+
+    // Only the first frame after each connect request or lost session counts
+    void on_first_frame(const uint64_t now_time_ns);
+
+    OKConnectionState get_state() const
+    {
+        return state_;
+    }
+
+    uint64_t get_retry_time_ns() const
+    {
+        return retry_time_ns_;
+    }
+
+    const OKConnectionStats& get_stats() const
+    {
+        return stats_;
+    }
+
+private:
+    OKConnectionState state_ = ConnectionState_Idle;
+    uint64_t retry_time_ns_ = 0;
+    uint64_t attempt_start_time_ns_ = 0;
+    uint64_t outage_start_time_ns_ = 0; // 0 once the first frame arrived
+    OKConnectionStats stats_;
+
+    std::mt19937 rng_;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_CONNECTION_MANAGER_H
@@ -61,6 +61,10 @@ struct OKOpenXRControllerActions
 
     XrAction trackpadXAction{ XR_NULL_HANDLE };
     XrAction trackpadYAction{ XR_NULL_HANDLE };
+
+    // XR_EXT_eye_gaze_interaction, null when the runtime doesn't support it
+    XrAction eyeGazeAction{ XR_NULL_HANDLE };
+    XrSpace eyeGazeSpace{ XR_NULL_HANDLE };
 };
 
 class OKPlayerState;
@@ -109,18 +113,6 @@ typedef enum
     ANALOG_AXIS_COUNT
 } AnalogAxisID;
 
-struct DigitalButtonToCloudXR_Map
-{
-    DigitalButtonID digital_button_id_;
-    int cloudxr_path_id_;
-};
-
-struct AnalogAxisToCloudXRMap
-{
-    AnalogAxisID analog_axis_id_;
-    int cloudxr_path_id_;
-};
-
 class OKController 
 {
 	public:
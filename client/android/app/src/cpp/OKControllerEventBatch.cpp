@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKControllerEventBatch.h"
+
+#include <math.h>
+
+namespace BVR
+{
+
+static_assert(MAX_CLOUDXR_INPUT_PATHS <= 64, "OKControllerEventBatch tracks paths in 64-bit masks");
+
+OKControllerEventBatch::OKControllerEventBatch()
+{
+}
+
+void OKControllerEventBatch::reset()
+{
+    sent_boolean_values_ = 0;
+
+    for (int path_id = 0; path_id < MAX_CLOUDXR_INPUT_PATHS; path_id++)
+    {
+        sent_float_values_[path_id] = 0.0f;
+    }
+
+    dirty_mask_ = used_mask_;
+    last_keyframe_time_ns_ = 0;
+}
+
+void OKControllerEventBatch::set_boolean(const int path_id, const bool value)
+{
+    if ((path_id < 0) || (path_id >= MAX_CLOUDXR_INPUT_PATHS))
+    {
+        return;
+    }
+
+    const uint64_t path_bit = (1ULL << path_id);
+
+    used_mask_ |= path_bit;
+    float_mask_ &= ~path_bit;
+
+    boolean_values_ = value ? (boolean_values_ | path_bit) : (boolean_values_ & ~path_bit);
+
+    const bool was_changed = ((boolean_values_ ^ sent_boolean_values_) & path_bit) != 0;
+    dirty_mask_ = was_changed ? (dirty_mask_ | path_bit) : (dirty_mask_ & ~path_bit);
+}
+
+void OKControllerEventBatch::set_float(const int path_id, const float value)
+{
+    if ((path_id < 0) || (path_id >= MAX_CLOUDXR_INPUT_PATHS))
+    {
+        return;
+    }
+
+    const uint64_t path_bit = (1ULL << path_id);
+
+    used_mask_ |= path_bit;
+    float_mask_ |= path_bit;
+
+    float_values_[path_id] = value;
+
+    const bool was_changed = (fabsf(value - sent_float_values_[path_id]) > CONTROLLER_ANALOG_EVENT_EPSILON);
+    dirty_mask_ = was_changed ? (dirty_mask_ | path_bit) : (dirty_mask_ & ~path_bit);
+}
+
+uint32_t OKControllerEventBatch::build(const uint64_t event_time_ns, const uint64_t now_time_ns, const bool force_keyframe)
+{
+    const uint64_t keyframe_interval_ns = (uint64_t)CONTROLLER_EVENT_KEYFRAME_MS * 1000000ULL;
+    const bool keyframe = force_keyframe || (last_keyframe_time_ns_ == 0) || ((now_time_ns - last_keyframe_time_ns_) >= keyframe_interval_ns);
+
+    uint64_t send_mask = keyframe ? used_mask_ : dirty_mask_;
+    uint32_t event_count = 0;
+
+    while (send_mask)
+    {
+        const int path_id = __builtin_ctzll(send_mask);
+        const uint64_t path_bit = (1ULL << path_id);
+        send_mask &= (send_mask - 1);
+
+        cxrControllerEvent& event = events_[event_count++];
+        event.clientTimeNS = event_time_ns;
+        event.clientInputIndex = (uint16_t)path_id;
+
+        if (float_mask_ & path_bit)
+        {
+            event.inputValue.valueType = cxrInputValueType_float32;
+            event.inputValue.vF32 = float_values_[path_id];
+            sent_float_values_[path_id] = float_values_[path_id];
+        }
+        else
+        {
+            event.inputValue.valueType = cxrInputValueType_boolean;
+            event.inputValue.vBool = (boolean_values_ & path_bit) ? cxrTrue : cxrFalse;
+        }
+    }
+
+    sent_boolean_values_ = boolean_values_;
+    dirty_mask_ = 0;
+
+    if (keyframe)
+    {
+        last_keyframe_time_ns_ = now_time_ns;
+    }
+
+    return event_count;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
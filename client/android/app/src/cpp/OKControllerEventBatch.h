@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_CONTROLLER_EVENT_BATCH_H
+#define OK_CONTROLLER_EVENT_BATCH_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <CloudXRCommon.h>
+
+namespace BVR
+{
+
+// Per-controller input state indexed by CloudXR input path, with a dirty bit per path.
+// Only paths whose value differs from what was last sent are turned into events, plus a full
+// keyframe every so often in case the server ever dropped one. Events are written into a
+// buffer owned by the batch, so nothing is allocated or cleared per poll.
+class OKControllerEventBatch
+{
+public:
+    OKControllerEventBatch();
+
+    // Forget what was sent, the next build() is a keyframe
+    void reset();
+
+    void set_boolean(const int path_id, const bool value);
+    void set_float(const int path_id, const float value);
+
+    // Returns the number of events written to get_events(). Every CONTROLLER_EVENT_KEYFRAME_MS
+    // (of now_time_ns) or when forced, all inputs are sent instead of only the dirty ones.
+    uint32_t build(const uint64_t event_time_ns, const uint64_t now_time_ns, const bool force_keyframe);
+
+    const cxrControllerEvent* get_events() const
+    {
+        return events_;
+    }
+
+private:
+    uint64_t used_mask_ = 0;    // paths that have been set at least once
+    uint64_t float_mask_ = 0;   // paths carrying float32 values, the rest are booleans
+    uint64_t dirty_mask_ = 0;   // paths whose current value differs from the last sent one
+
+    uint64_t boolean_values_ = 0;
+    uint64_t sent_boolean_values_ = 0;
+
+    float float_values_[MAX_CLOUDXR_INPUT_PATHS] = {};
+    float sent_float_values_[MAX_CLOUDXR_INPUT_PATHS] = {};
+
+    uint64_t last_keyframe_time_ns_ = 0;
+
+    cxrControllerEvent events_[MAX_CLOUDXR_INPUT_PATHS];
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_CONTROLLER_EVENT_BATCH_H
+
@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_EYE_TRACKING
+
+#include "OKEyeGazeCodec.h"
+
+#include <math.h>
+
+namespace BVR
+{
+
+const float OCTAHEDRAL_STEPS = 32767.0f;
+
+namespace
+{
+
+float sign_not_zero(const float value)
+{
+    return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+int16_t quantize_unit(const float value)
+{
+    const float clamped = fminf(fmaxf(value, -1.0f), 1.0f);
+    return (int16_t)lroundf(clamped * OCTAHEDRAL_STEPS);
+}
+
+void write_bytes(uint8_t*& cursor, const uint64_t value, const int byte_count)
+{
+    for (int byte_id = 0; byte_id < byte_count; byte_id++)
+    {
+        *cursor++ = (uint8_t)(value >> (8 * byte_id));
+    }
+}
+
+uint64_t read_bytes(const uint8_t*& cursor, const int byte_count)
+{
+    uint64_t value = 0;
+
+    for (int byte_id = 0; byte_id < byte_count; byte_id++)
+    {
+        value |= (uint64_t)(*cursor++) << (8 * byte_id);
+    }
+
+    return value;
+}
+
+} // namespace
+
+void encode_octahedral(const glm::vec3& direction, int16_t& x, int16_t& y)
+{
+    const float l1_norm = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+
+    if (l1_norm <= 0.0f)
+    {
+        x = 0;
+        y = 0;
+        return;
+    }
+
+    float u = direction.x / l1_norm;
+    float v = direction.y / l1_norm;
+
+    // The lower hemisphere folds over the diagonals
+    if (direction.z < 0.0f)
+    {
+        const float folded_u = (1.0f - fabsf(v)) * sign_not_zero(u);
+        const float folded_v = (1.0f - fabsf(u)) * sign_not_zero(v);
+        u = folded_u;
+        v = folded_v;
+    }
+
+    x = quantize_unit(u);
+    y = quantize_unit(v);
+}
+
+glm::vec3 decode_octahedral(const int16_t x, const int16_t y)
+{
+    const float u = (float)x / OCTAHEDRAL_STEPS;
+    const float v = (float)y / OCTAHEDRAL_STEPS;
+
+    glm::vec3 direction(u, v, 1.0f - fabsf(u) - fabsf(v));
+
+    if (direction.z < 0.0f)
+    {
+        direction.x = (1.0f - fabsf(v)) * sign_not_zero(u);
+        direction.y = (1.0f - fabsf(u)) * sign_not_zero(v);
+    }
+
+    return glm::normalize(direction);
+}
+
+OKEyeGazeEncoder::OKEyeGazeEncoder()
+{
+}
+
+void OKEyeGazeEncoder::reset()
+{
+    sent_flags_ = 0;
+    sent_x_ = 0;
+    sent_y_ = 0;
+    last_send_time_ns_ = 0;
+    is_keyframe_pending_ = true;
+}
+
+uint32_t OKEyeGazeEncoder::build(const OKEyeGazeSample& sample, const uint64_t now_time_ns)
+{
+    int16_t x = 0;
+    int16_t y = 0;
+
+    if (sample.flags_ & EyeGazeFlag_Valid)
+    {
+        encode_octahedral(sample.direction_, x, y);
+    }
+
+    const uint64_t keyframe_interval_ns = (uint64_t)EYE_GAZE_KEYFRAME_MS * 1000000ULL;
+
+    const bool has_changed = (sample.flags_ != sent_flags_) || (x != sent_x_) || (y != sent_y_);
+    const bool is_keyframe = is_keyframe_pending_ || ((now_time_ns - last_send_time_ns_) >= keyframe_interval_ns);
+
+    if (!has_changed && !is_keyframe)
+    {
+        return 0;
+    }
+
+    uint8_t* cursor = packet_;
+    write_bytes(cursor, OK_EYE_GAZE_PACKET_TYPE, 1);
+    write_bytes(cursor, OK_EYE_GAZE_PACKET_VERSION, 1);
+    write_bytes(cursor, sample.flags_, 1);
+    write_bytes(cursor, 0, 1);
+    write_bytes(cursor, sample.time_ns_, sizeof(uint64_t));
+    write_bytes(cursor, (uint16_t)x, sizeof(int16_t));
+    write_bytes(cursor, (uint16_t)y, sizeof(int16_t));
+
+    sent_flags_ = sample.flags_;
+    sent_x_ = x;
+    sent_y_ = y;
+    last_send_time_ns_ = now_time_ns;
+    is_keyframe_pending_ = false;
+
+    return EYE_GAZE_PACKET_SIZE;
+}
+
+bool decode_eye_gaze_packet(const uint8_t* packet, const uint32_t packet_size, OKEyeGazeSample& sample)
+{
+    if (!packet || (packet_size != EYE_GAZE_PACKET_SIZE) || (packet[0] != OK_EYE_GAZE_PACKET_TYPE) || (packet[1] != OK_EYE_GAZE_PACKET_VERSION))
+    {
+        return false;
+    }
+
+    const uint8_t* cursor = packet + 2;
+
+    sample.flags_ = (uint8_t)read_bytes(cursor, 1);
+    read_bytes(cursor, 1);
+    sample.time_ns_ = read_bytes(cursor, sizeof(uint64_t));
+
+    const int16_t x = (int16_t)(uint16_t)read_bytes(cursor, sizeof(int16_t));
+    const int16_t y = (int16_t)(uint16_t)read_bytes(cursor, sizeof(int16_t));
+
+    sample.direction_ = (sample.flags_ & EyeGazeFlag_Valid) ? decode_octahedral(x, y) : glm::vec3(0.0f, 0.0f, -1.0f);
+    return true;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_EYE_TRACKING
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_EYE_GAZE_CODEC_H
+#define OK_EYE_GAZE_CODEC_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_EYE_TRACKING
+
+#include "GLMPose.h"
+
+#include <cstdint>
+
+namespace BVR
+{
+
+// The combined gaze as a 16 byte cxrGenericUserInputEvent blob, little endian:
+//
+//   uint8 type ('G'), uint8 version, uint8 flags (EyeGazeFlag_*), uint8 reserved,
+//   uint64 time (ns, the HMD pose's clientTimeNS), int16 x, int16 y
+//
+// x / y are the gaze direction in the head space (-Z forward), octahedral mapped onto [-1, 1]^2,
+// under 0.01 degrees of error. Every packet is absolute, so there's no sequence to lose.
+const uint8_t OK_EYE_GAZE_PACKET_TYPE = 'G';
+const uint8_t OK_EYE_GAZE_PACKET_VERSION = 1;
+const uint32_t EYE_GAZE_PACKET_SIZE = 16;
+
+typedef enum
+{
+    EyeGazeFlag_Valid = (1 << 0),   // x / y hold a direction
+    EyeGazeFlag_Tracked = (1 << 1), // measured this frame, not held or inferred by the runtime
+    EyeGazeFlag_Foveate = (1 << 2), // the client wants the server to foveate around it
+} OKEyeGazeFlags;
+
+struct OKEyeGazeSample
+{
+    uint8_t flags_ = 0;
+    uint64_t time_ns_ = 0;
+    glm::vec3 direction_ = glm::vec3(0.0f, 0.0f, -1.0f);
+};
+
+void encode_octahedral(const glm::vec3& direction, int16_t& x, int16_t& y);
+glm::vec3 decode_octahedral(const int16_t x, const int16_t y);
+
+// Writes a packet only when the quantized gaze or its flags changed, or every EYE_GAZE_KEYFRAME_MS
+// otherwise, into a buffer it owns.
+class OKEyeGazeEncoder
+{
+public:
+    OKEyeGazeEncoder();
+
+    void reset();
+
+    // Returns the size of the packet in get_packet(), 0 when there's nothing to send
+    uint32_t build(const OKEyeGazeSample& sample, const uint64_t now_time_ns);
+
+    const uint8_t* get_packet() const
+    {
+        return packet_;
+    }
+
+private:
+    uint8_t sent_flags_ = 0;
+    int16_t sent_x_ = 0;
+    int16_t sent_y_ = 0;
+
+    uint64_t last_send_time_ns_ = 0;
+    bool is_keyframe_pending_ = true;
+
+    uint8_t packet_[EYE_GAZE_PACKET_SIZE];
+};
+
+// The server side reader, false for anything that isn't a gaze packet
+bool decode_eye_gaze_packet(const uint8_t* packet, const uint32_t packet_size, OKEyeGazeSample& sample);
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_EYE_TRACKING
+
+#endif // OK_EYE_GAZE_CODEC_H
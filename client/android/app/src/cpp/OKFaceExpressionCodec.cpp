@@ -0,0 +1,295 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#include "OKFaceExpressionCodec.h"
+
+#include <cstddef>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace BVR
+{
+
+namespace
+{
+
+void write_bytes(uint8_t*& cursor, const uint64_t value, const int byte_count)
+{
+    for (int byte_id = 0; byte_id < byte_count; byte_id++)
+    {
+        *cursor++ = (uint8_t)(value >> (8 * byte_id));
+    }
+}
+
+uint64_t read_bytes(const uint8_t*& cursor, const int byte_count)
+{
+    uint64_t value = 0;
+
+    for (int byte_id = 0; byte_id < byte_count; byte_id++)
+    {
+        value |= (uint64_t)(*cursor++) << (8 * byte_id);
+    }
+
+    return value;
+}
+
+} // namespace
+
+uint8_t quantize_face_weight(const float weight)
+{
+    const float clamped = fminf(fmaxf(weight, 0.0f), 1.0f);
+    return (uint8_t)(clamped * 255.0f + 0.5f);
+}
+
+OKFaceExpressionEncoder::OKFaceExpressionEncoder()
+{
+    set_threshold((uint8_t)FACE_EXPRESSION_THRESHOLD);
+    reset();
+}
+
+void OKFaceExpressionEncoder::reset()
+{
+    sent_valid_ = false;
+    memset(sent_weights_, 0, sizeof(sent_weights_));
+    last_keyframe_time_ns_ = 0;
+    is_keyframe_pending_ = true;
+}
+
+void OKFaceExpressionEncoder::set_threshold(const uint8_t threshold_steps)
+{
+    memset(thresholds_, (threshold_steps > 0) ? threshold_steps : 1, sizeof(thresholds_));
+}
+
+void OKFaceExpressionEncoder::set_threshold(const int weight_id, const uint8_t threshold_steps)
+{
+    if ((weight_id >= 0) && (weight_id < FACE_EXPRESSION_WEIGHT_COUNT))
+    {
+        thresholds_[weight_id] = (threshold_steps > 0) ? threshold_steps : 1;
+    }
+}
+
+uint32_t OKFaceExpressionEncoder::build(const float* weights, const float* confidences, const uint64_t expression_time_ns, const uint64_t now_time_ns)
+{
+    const bool is_valid = (weights != nullptr) && (confidences != nullptr);
+
+    const uint64_t keyframe_interval_ns = (uint64_t)FACE_EXPRESSION_KEYFRAME_MS * 1000000ULL;
+    const bool is_keyframe = is_keyframe_pending_ || ((now_time_ns - last_keyframe_time_ns_) >= keyframe_interval_ns) || (is_valid && !sent_valid_);
+
+    uint8_t change_mask[FACE_EXPRESSION_MASK_SIZE] = {};
+    int change_count = 0;
+
+    if (is_valid)
+    {
+        for (int weight_id = 0; weight_id < FACE_EXPRESSION_WEIGHT_COUNT; weight_id++)
+        {
+            const uint8_t value = quantize_face_weight(weights[weight_id]);
+            current_weights_[weight_id] = value;
+
+            const uint8_t sent_value = sent_weights_[weight_id];
+            const int difference = abs((int)value - (int)sent_value);
+
+            const bool reached_end = (value != sent_value) && ((value == 0) || (value == 255));
+
+            if ((difference >= thresholds_[weight_id]) || reached_end)
+            {
+                change_mask[weight_id >> 3] |= (uint8_t)(1 << (weight_id & 7));
+                change_count++;
+            }
+        }
+    }
+
+    if (!is_keyframe && (is_valid == sent_valid_) && (change_count == 0))
+    {
+        return 0;
+    }
+
+    uint8_t* cursor = packet_;
+    write_bytes(cursor, OK_FACE_EXPRESSION_PACKET_TYPE, 1);
+    write_bytes(cursor, OK_FACE_EXPRESSION_PACKET_VERSION, 1);
+    write_bytes(cursor, sequence_++, sizeof(uint16_t));
+    write_bytes(cursor, expression_time_ns, sizeof(uint64_t));
+    write_bytes(cursor, (is_valid ? FaceFlag_Valid : 0) | (is_keyframe ? FaceFlag_Keyframe : 0), 1);
+
+    if (is_valid)
+    {
+        for (int confidence_id = 0; confidence_id < FACE_EXPRESSION_CONFIDENCE_COUNT; confidence_id++)
+        {
+            write_bytes(cursor, quantize_face_weight(confidences[confidence_id]), 1);
+        }
+
+        if (is_keyframe)
+        {
+            memcpy(cursor, current_weights_, FACE_EXPRESSION_WEIGHT_COUNT);
+            cursor += FACE_EXPRESSION_WEIGHT_COUNT;
+            memcpy(sent_weights_, current_weights_, FACE_EXPRESSION_WEIGHT_COUNT);
+        }
+        else
+        {
+            memcpy(cursor, change_mask, FACE_EXPRESSION_MASK_SIZE);
+            cursor += FACE_EXPRESSION_MASK_SIZE;
+
+            for (int weight_id = 0; weight_id < FACE_EXPRESSION_WEIGHT_COUNT; weight_id++)
+            {
+                if (change_mask[weight_id >> 3] & (1 << (weight_id & 7)))
+                {
+                    *cursor++ = current_weights_[weight_id];
+                    sent_weights_[weight_id] = current_weights_[weight_id];
+                }
+            }
+        }
+    }
+
+    if (is_keyframe)
+    {
+        last_keyframe_time_ns_ = now_time_ns;
+        is_keyframe_pending_ = false;
+    }
+
+    sent_valid_ = is_valid;
+
+    return (uint32_t)(cursor - packet_);
+}
+
+OKFaceExpressionDecoder::OKFaceExpressionDecoder()
+{
+}
+
+void OKFaceExpressionDecoder::reset()
+{
+    has_keyframe_ = false;
+    is_valid_ = false;
+    memset(weights_, 0, sizeof(weights_));
+    memset(confidences_, 0, sizeof(confidences_));
+    last_sequence_ = 0;
+    has_sequence_ = false;
+    lost_count_ = 0;
+    expression_time_ns_ = 0;
+}
+
+bool OKFaceExpressionDecoder::decode(const uint8_t* packet, const uint32_t packet_size)
+{
+    if (!packet || (packet_size < (FACE_EXPRESSION_PACKET_HEADER_SIZE + 1)) ||
+        (packet[0] != OK_FACE_EXPRESSION_PACKET_TYPE) || (packet[1] != OK_FACE_EXPRESSION_PACKET_VERSION))
+    {
+        return false;
+    }
+
+    const uint8_t* cursor = packet + 2;
+    const uint8_t* const packet_end = packet + packet_size;
+
+    const uint16_t sequence = (uint16_t)read_bytes(cursor, sizeof(uint16_t));
+    const uint64_t expression_time_ns = read_bytes(cursor, sizeof(uint64_t));
+    const uint8_t flags = (uint8_t)read_bytes(cursor, 1);
+
+    const bool is_valid = (flags & FaceFlag_Valid);
+    const bool is_keyframe = (flags & FaceFlag_Keyframe);
+
+    if (is_valid && !is_keyframe && !has_keyframe_)
+    {
+        return false;
+    }
+
+    uint8_t confidences[FACE_EXPRESSION_CONFIDENCE_COUNT] = {};
+    uint8_t weights[FACE_EXPRESSION_WEIGHT_COUNT];
+    memcpy(weights, weights_, sizeof(weights));
+
+    if (is_valid)
+    {
+        if ((packet_end - cursor) < FACE_EXPRESSION_CONFIDENCE_COUNT)
+        {
+            return false;
+        }
+
+        memcpy(confidences, cursor, FACE_EXPRESSION_CONFIDENCE_COUNT);
+        cursor += FACE_EXPRESSION_CONFIDENCE_COUNT;
+
+        if (is_keyframe)
+        {
+            if ((packet_end - cursor) != FACE_EXPRESSION_WEIGHT_COUNT)
+            {
+                return false;
+            }
+
+            memcpy(weights, cursor, FACE_EXPRESSION_WEIGHT_COUNT);
+            cursor += FACE_EXPRESSION_WEIGHT_COUNT;
+        }
+        else
+        {
+            if ((packet_end - cursor) < (ptrdiff_t)FACE_EXPRESSION_MASK_SIZE)
+            {
+                return false;
+            }
+
+            const uint8_t* change_mask = cursor;
+            cursor += FACE_EXPRESSION_MASK_SIZE;
+
+            for (int weight_id = 0; weight_id < FACE_EXPRESSION_WEIGHT_COUNT; weight_id++)
+            {
+                if (change_mask[weight_id >> 3] & (1 << (weight_id & 7)))
+                {
+                    if (cursor >= packet_end)
+                    {
+                        return false;
+                    }
+
+                    weights[weight_id] = *cursor++;
+                }
+            }
+        }
+    }
+
+    if (cursor != packet_end)
+    {
+        return false;
+    }
+
+    if (has_sequence_)
+    {
+        lost_count_ += (uint16_t)(sequence - last_sequence_ - 1);
+    }
+
+    last_sequence_ = sequence;
+    has_sequence_ = true;
+    expression_time_ns_ = expression_time_ns;
+
+    is_valid_ = is_valid;
+    has_keyframe_ = has_keyframe_ || (is_valid && is_keyframe);
+
+    if (is_valid)
+    {
+        memcpy(weights_, weights, sizeof(weights_));
+        memcpy(confidences_, confidences, sizeof(confidences_));
+    }
+
+    return true;
+}
+
+float OKFaceExpressionDecoder::get_weight(const int weight_id) const
+{
+    if (!is_valid_ || (weight_id < 0) || (weight_id >= FACE_EXPRESSION_WEIGHT_COUNT))
+    {
+        return 0.0f;
+    }
+
+    return dequantize_face_weight(weights_[weight_id]);
+}
+
+float OKFaceExpressionDecoder::get_confidence(const int confidence_id) const
+{
+    if (!is_valid_ || (confidence_id < 0) || (confidence_id >= FACE_EXPRESSION_CONFIDENCE_COUNT))
+    {
+        return 0.0f;
+    }
+
+    return dequantize_face_weight(confidences_[confidence_id]);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
@@ -0,0 +1,141 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FACE_EXPRESSION_CODEC_H
+#define OK_FACE_EXPRESSION_CODEC_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+
+namespace BVR
+{
+
+// XR_FB_face_tracking2 expression weights as a cxrGenericUserInputEvent blob, little endian:
+//
+//   header   uint8 type ('F'), uint8 version, uint16 sequence, uint64 expression time (ns)
+//   uint8 flags (FaceFlag_*), then when valid uint8 confidences[XR_FACE_CONFIDENCE2_COUNT_FB] and
+//   keyframe   uint8 weights[XR_FACE_EXPRESSION2_COUNT_FB]
+//   delta      a bit per weight (FACE_EXPRESSION_MASK_SIZE bytes), then the set weights' uint8 in order
+//
+// Weights and confidences are [0, 1] in 255 steps. Every value sent is absolute, so a lost packet
+// only leaves weights stale until they change again or the next keyframe, the sequence is only
+// there to count losses.
+const uint8_t OK_FACE_EXPRESSION_PACKET_TYPE = 'F';
+const uint8_t OK_FACE_EXPRESSION_PACKET_VERSION = 1;
+
+const int FACE_EXPRESSION_WEIGHT_COUNT = XR_FACE_EXPRESSION2_COUNT_FB;
+const int FACE_EXPRESSION_CONFIDENCE_COUNT = XR_FACE_CONFIDENCE2_COUNT_FB;
+
+const uint32_t FACE_EXPRESSION_PACKET_HEADER_SIZE = 12;
+const uint32_t FACE_EXPRESSION_MASK_SIZE = (FACE_EXPRESSION_WEIGHT_COUNT + 7) / 8;
+const uint32_t FACE_EXPRESSION_KEYFRAME_SIZE = FACE_EXPRESSION_PACKET_HEADER_SIZE + 1 + FACE_EXPRESSION_CONFIDENCE_COUNT + FACE_EXPRESSION_WEIGHT_COUNT;
+const uint32_t MAX_FACE_EXPRESSION_PACKET_SIZE = FACE_EXPRESSION_KEYFRAME_SIZE + FACE_EXPRESSION_MASK_SIZE;
+
+typedef enum
+{
+    FaceFlag_Valid = (1 << 0),
+    FaceFlag_Keyframe = (1 << 1),
+} OKFaceFlags;
+
+uint8_t quantize_face_weight(const float weight);
+
+inline float dequantize_face_weight(const uint8_t value)
+{
+    return (float)value / 255.0f;
+}
+
+// Quantizes the weights and writes the packet into a buffer it owns. A weight is only resent once
+// it moved by its threshold from the value last sent, or reached 0 / 255 so a closed eye or a
+// neutral face always lands exactly. Nothing is written when no weight qualifies and validity
+// didn't change, apart from a keyframe every FACE_EXPRESSION_KEYFRAME_MS.
+class OKFaceExpressionEncoder
+{
+public:
+    OKFaceExpressionEncoder();
+
+    // Forget what was sent, the next build() is a keyframe. Thresholds are kept.
+    void reset();
+
+    // In 8 bit steps, 1 sends every change
+    void set_threshold(const uint8_t threshold_steps);
+    void set_threshold(const int weight_id, const uint8_t threshold_steps);
+
+    // weights / confidences are XR_FACE_EXPRESSION2_COUNT_FB / XR_FACE_CONFIDENCE2_COUNT_FB values,
+    // or nullptr when the face isn't tracked. Returns the size of the packet in get_packet(), 0 when
+    // there's nothing to send.
+    uint32_t build(const float* weights, const float* confidences, const uint64_t expression_time_ns, const uint64_t now_time_ns);
+
+    const uint8_t* get_packet() const
+    {
+        return packet_;
+    }
+
+private:
+    uint8_t thresholds_[FACE_EXPRESSION_WEIGHT_COUNT];
+
+    bool sent_valid_ = false;
+    uint8_t sent_weights_[FACE_EXPRESSION_WEIGHT_COUNT];
+    uint8_t current_weights_[FACE_EXPRESSION_WEIGHT_COUNT];
+
+    uint16_t sequence_ = 0;
+    uint64_t last_keyframe_time_ns_ = 0;
+    bool is_keyframe_pending_ = true;
+
+    uint8_t packet_[MAX_FACE_EXPRESSION_PACKET_SIZE];
+};
+
+// Reads what OKFaceExpressionEncoder writes, for whatever consumes the generic input events server
+// side (and the host build, to check the round trip).
+class OKFaceExpressionDecoder
+{
+public:
+    OKFaceExpressionDecoder();
+
+    void reset();
+
+    // False for a malformed packet, or a delta before any keyframe (the unsent weights are unknown)
+    bool decode(const uint8_t* packet, const uint32_t packet_size);
+
+    bool is_valid() const
+    {
+        return is_valid_;
+    }
+
+    float get_weight(const int weight_id) const;
+    float get_confidence(const int confidence_id) const;
+
+    uint64_t get_expression_time_ns() const
+    {
+        return expression_time_ns_;
+    }
+
+    // Packets missed, from gaps in the sequence
+    uint32_t get_lost_count() const
+    {
+        return lost_count_;
+    }
+
+private:
+    bool has_keyframe_ = false;
+    bool is_valid_ = false;
+
+    uint8_t weights_[FACE_EXPRESSION_WEIGHT_COUNT] = {};
+    uint8_t confidences_[FACE_EXPRESSION_CONFIDENCE_COUNT] = {};
+
+    uint16_t last_sequence_ = 0;
+    bool has_sequence_ = false;
+    uint32_t lost_count_ = 0;
+    uint64_t expression_time_ns_ = 0;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#endif // OK_FACE_EXPRESSION_CODEC_H
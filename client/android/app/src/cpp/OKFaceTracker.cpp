@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#include "OKFaceTracker.h"
+
+namespace BVR
+{
+
+OKFaceTracker::OKFaceTracker()
+{
+}
+
+OKFaceTracker::~OKFaceTracker()
+{
+    shutdown();
+}
+
+bool OKFaceTracker::init(XrInstance instance, XrSession session)
+{
+    if (is_initialized_)
+    {
+        return true;
+    }
+
+    if ((instance == XR_NULL_HANDLE) || (session == XR_NULL_HANDLE))
+    {
+        return false;
+    }
+
+    XrResult result = xrGetInstanceProcAddr(instance, "xrCreateFaceTracker2FB", (PFN_xrVoidFunction*)&xrCreateFaceTracker2FB_);
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrDestroyFaceTracker2FB", (PFN_xrVoidFunction*)&xrDestroyFaceTracker2FB_);
+    }
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrGetFaceExpressionWeights2FB", (PFN_xrVoidFunction*)&xrGetFaceExpressionWeights2FB_);
+    }
+
+    if (XR_FAILED(result) || !xrCreateFaceTracker2FB_ || !xrDestroyFaceTracker2FB_ || !xrGetFaceExpressionWeights2FB_)
+    {
+        //IGLLog(IGLLogLevel::LOG_INFO, "OKFaceTracker: XR_FB_face_tracking2 not enabled\n");
+        xrCreateFaceTracker2FB_ = nullptr;
+        xrDestroyFaceTracker2FB_ = nullptr;
+        xrGetFaceExpressionWeights2FB_ = nullptr;
+        return false;
+    }
+
+    // Visual only, audio driven lip sync is the server's business
+    XrFaceTrackingDataSource2FB data_source = XR_FACE_TRACKING_DATA_SOURCE2_VISUAL_FB;
+
+    XrFaceTrackerCreateInfo2FB create_info = {};
+    create_info.type = XR_TYPE_FACE_TRACKER_CREATE_INFO2_FB;
+    create_info.faceExpressionSet = XR_FACE_EXPRESSION_SET2_DEFAULT_FB;
+    create_info.requestedDataSourceCount = 1;
+    create_info.requestedDataSources = &data_source;
+
+    result = xrCreateFaceTracker2FB_(session, &create_info, &face_tracker_);
+
+    if (XR_FAILED(result))
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "xrCreateFaceTracker2FB error = %d\n", result);
+        face_tracker_ = XR_NULL_HANDLE;
+        return false;
+    }
+
+    is_initialized_ = true;
+    return is_initialized_;
+}
+
+void OKFaceTracker::shutdown()
+{
+    if (!is_initialized_)
+    {
+        return;
+    }
+
+    if (face_tracker_ != XR_NULL_HANDLE)
+    {
+        xrDestroyFaceTracker2FB_(face_tracker_);
+        face_tracker_ = XR_NULL_HANDLE;
+    }
+
+    is_initialized_ = false;
+}
+
+bool OKFaceTracker::get_expression_weights(const XrTime time, float* weights, float* confidences) const
+{
+    if (!is_initialized_ || !weights || !confidences)
+    {
+        return false;
+    }
+
+    XrFaceExpressionInfo2FB expression_info = {};
+    expression_info.type = XR_TYPE_FACE_EXPRESSION_INFO2_FB;
+    expression_info.time = time;
+
+    XrFaceExpressionWeights2FB expression_weights = {};
+    expression_weights.type = XR_TYPE_FACE_EXPRESSION_WEIGHTS2_FB;
+    expression_weights.weightCount = XR_FACE_EXPRESSION2_COUNT_FB;
+    expression_weights.weights = weights;
+    expression_weights.confidenceCount = XR_FACE_CONFIDENCE2_COUNT_FB;
+    expression_weights.confidences = confidences;
+
+    const XrResult result = xrGetFaceExpressionWeights2FB_(face_tracker_, &expression_info, &expression_weights);
+
+    return (XR_SUCCEEDED(result) && expression_weights.isValid);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
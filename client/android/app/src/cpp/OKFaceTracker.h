@@ -0,0 +1,52 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FACE_TRACKER_H
+#define OK_FACE_TRACKER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#include <openxr/openxr.h>
+
+namespace BVR
+{
+
+// The XR_FB_face_tracking2 tracker, visual data source only. Entry points are fetched with
+// xrGetInstanceProcAddr like OKHandTracker's, init() returns false when XrApp didn't enable the
+// extension and expressions are simply never streamed.
+class OKFaceTracker
+{
+public:
+    OKFaceTracker();
+    ~OKFaceTracker();
+
+    bool init(XrInstance instance, XrSession session);
+    void shutdown();
+
+    bool is_initialized() const
+    {
+        return is_initialized_;
+    }
+
+    // Fills XR_FACE_EXPRESSION2_COUNT_FB weights and XR_FACE_CONFIDENCE2_COUNT_FB confidences,
+    // all in [0, 1]. False when the runtime has no valid expression for that time.
+    bool get_expression_weights(const XrTime time, float* weights, float* confidences) const;
+
+private:
+    bool is_initialized_ = false;
+
+    PFN_xrCreateFaceTracker2FB xrCreateFaceTracker2FB_ = nullptr;
+    PFN_xrDestroyFaceTracker2FB xrDestroyFaceTracker2FB_ = nullptr;
+    PFN_xrGetFaceExpressionWeights2FB xrGetFaceExpressionWeights2FB_ = nullptr;
+
+    XrFaceTracker2FB face_tracker_ = XR_NULL_HANDLE;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_FACE_TRACKING
+
+#endif // OK_FACE_TRACKER_H
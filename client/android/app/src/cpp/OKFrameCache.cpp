@@ -0,0 +1,206 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKFrameCache.h"
+
+#include <algorithm>
+
+namespace BVR
+{
+
+OKFrameCache::OKFrameCache()
+{
+}
+
+OKFrameCache::~OKFrameCache()
+{
+    // GL objects must be released on the GL thread via destroy(), by then this is a no-op
+}
+
+bool OKFrameCache::ensure_storage(OKCachedEye& cached_eye, const GLint width, const GLint height, const GLenum internal_format)
+{
+    if (cached_eye.texture_ && (cached_eye.width_ == width) && (cached_eye.height_ == height) && (cached_eye.internal_format_ == internal_format))
+    {
+        return true;
+    }
+
+    if (!cached_eye.framebuffer_)
+    {
+        glGenFramebuffers(1, &cached_eye.framebuffer_);
+    }
+
+    if (cached_eye.texture_)
+    {
+        glDeleteTextures(1, &cached_eye.texture_);
+        cached_eye.texture_ = 0;
+    }
+
+    GLint previous_texture = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+
+    glGenTextures(1, &cached_eye.texture_);
+    glBindTexture(GL_TEXTURE_2D, cached_eye.texture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)previous_texture);
+
+    GLint previous_read_framebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous_read_framebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, cached_eye.framebuffer_);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cached_eye.texture_, 0);
+    const GLenum status = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous_read_framebuffer);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "OKFrameCache::ensure_storage incomplete framebuffer = 0x%x\n", status);
+        return false;
+    }
+
+    cached_eye.width_ = width;
+    cached_eye.height_ = height;
+    cached_eye.internal_format_ = internal_format;
+
+    return true;
+}
+
+void OKFrameCache::on_latch(const bool is_at_risk)
+{
+    frames_since_risk_ = is_at_risk ? 0 : std::min(frames_since_risk_ + 1, (uint32_t)FRAME_CACHE_RISK_FRAMES);
+
+    for (int view_id = 0; view_id < NUM_EYES; view_id++)
+    {
+        eyes_[view_id].frames_since_capture_++;
+    }
+}
+
+bool OKFrameCache::should_capture(const int view_id) const
+{
+    if (!is_valid(view_id))
+    {
+        return (view_id >= 0) && (view_id < NUM_EYES);
+    }
+
+    return (frames_since_risk_ < FRAME_CACHE_RISK_FRAMES) || (eyes_[view_id].frames_since_capture_ >= FRAME_CACHE_REFRESH_FRAMES);
+}
+
+bool OKFrameCache::capture(const int view_id, const GLMPose& eye_pose)
+{
+    if ((view_id < 0) || (view_id >= NUM_EYES))
+    {
+        return false;
+    }
+
+    OKCachedEye& cached_eye = eyes_[view_id];
+    cached_eye.is_valid_ = false;
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    const GLint width = viewport[2];
+    const GLint height = viewport[3];
+
+    GLint draw_framebuffer = 0;
+    GLint read_framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_framebuffer);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+
+    // Same encoding as the swapchain, an sRGB image squeezed through RGBA8 loses its dark end
+    GLint color_encoding = GL_LINEAR;
+    glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, draw_framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK,
+                                          GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &color_encoding);
+
+    const GLenum internal_format = (color_encoding == GL_SRGB) ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+    if ((width <= 0) || (height <= 0) || !ensure_storage(cached_eye, width, height, internal_format))
+    {
+        return false;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)draw_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cached_eye.framebuffer_);
+
+    glBlitFramebuffer(viewport[0], viewport[1], viewport[0] + width, viewport[1] + height,
+                      0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)draw_framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)read_framebuffer);
+
+    cached_eye.eye_pose_ = eye_pose;
+    cached_eye.frames_since_capture_ = 0;
+    cached_eye.is_valid_ = true;
+
+    capture_count_++;
+    return true;
+}
+
+bool OKFrameCache::present(const int view_id, GLMPose& eye_pose)
+{
+    if (!is_valid(view_id))
+    {
+        return false;
+    }
+
+    const OKCachedEye& cached_eye = eyes_[view_id];
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    GLint read_framebuffer = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, cached_eye.framebuffer_);
+
+    // Scaled if the swapchain was resized since the capture, e.g. after a refresh rate change
+    glBlitFramebuffer(0, 0, cached_eye.width_, cached_eye.height_,
+                      viewport[0], viewport[1], viewport[0] + viewport[2], viewport[1] + viewport[3],
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)read_framebuffer);
+
+    eye_pose = cached_eye.eye_pose_;
+    return true;
+}
+
+void OKFrameCache::invalidate()
+{
+    for (int view_id = 0; view_id < NUM_EYES; view_id++)
+    {
+        eyes_[view_id].is_valid_ = false;
+    }
+
+    // A new stream has no track record
+    frames_since_risk_ = 0;
+}
+
+void OKFrameCache::destroy()
+{
+    for (int view_id = 0; view_id < NUM_EYES; view_id++)
+    {
+        OKCachedEye& cached_eye = eyes_[view_id];
+
+        if (cached_eye.framebuffer_)
+        {
+            glDeleteFramebuffers(1, &cached_eye.framebuffer_);
+        }
+
+        if (cached_eye.texture_)
+        {
+            glDeleteTextures(1, &cached_eye.texture_);
+        }
+
+        cached_eye = OKCachedEye();
+    }
+
+    frames_since_risk_ = 0;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FRAME_CACHE_H
+#define OK_FRAME_CACHE_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "GLMPose.h"
+
+#include <GLES3/gl3.h>
+
+namespace BVR
+{
+
+// Owned GL copy of a recent frame CloudXR blitted for each eye. CloudXR gives the decoder
+// texture back on cxrReleaseFrame, so this is the only way to show a frame again on a miss.
+// The copy is a full-resolution blit per eye, so it's only refreshed every frame while the
+// next latch is at risk, else every FRAME_CACHE_REFRESH_FRAMES. GL thread only.
+class OKFrameCache
+{
+public:
+    OKFrameCache();
+    ~OKFrameCache();
+
+    // Once per latch attempt, is_at_risk when it missed or had no budget left to wait
+    void on_latch(const bool is_at_risk);
+
+    bool should_capture(const int view_id) const;
+
+    // Copy the viewport of the currently bound draw framebuffer, call right after cxrBlitFrame.
+    // eye_pose is the pose the server rendered this eye with. Same format as the swapchain.
+    bool capture(const int view_id, const GLMPose& eye_pose);
+
+    // Blit the cached copy back into the viewport of the currently bound draw framebuffer and
+    // return its render pose, so the compositor can reproject it to the current head pose
+    bool present(const int view_id, GLMPose& eye_pose);
+
+    bool is_valid(const int view_id) const
+    {
+        return ((view_id >= 0) && (view_id < NUM_EYES) && eyes_[view_id].is_valid_);
+    }
+
+    uint64_t get_capture_count() const
+    {
+        return capture_count_;
+    }
+
+    void invalidate();
+    void destroy();
+
+private:
+    struct OKCachedEye
+    {
+        bool is_valid_ = false;
+        GLMPose eye_pose_;
+
+        GLuint texture_ = 0;
+        GLuint framebuffer_ = 0;
+
+        GLint width_ = 0;
+        GLint height_ = 0;
+        GLenum internal_format_ = GL_RGBA8;
+
+        uint32_t frames_since_capture_ = 0;
+    };
+
+    bool ensure_storage(OKCachedEye& cached_eye, const GLint width, const GLint height, const GLenum internal_format);
+
+    OKCachedEye eyes_[NUM_EYES];
+
+    uint32_t frames_since_risk_ = 0;
+    uint64_t capture_count_ = 0;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_FRAME_CACHE_H
+
@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+#include "OKFramePoseHistory.h"
+
+namespace BVR
+{
+
+static_assert((FRAME_POSE_HISTORY_SIZE & (FRAME_POSE_HISTORY_SIZE - 1)) == 0, "FRAME_POSE_HISTORY_SIZE must be a power of two");
+
+OKFramePoseHistory::OKFramePoseHistory()
+{
+}
+
+void OKFramePoseHistory::record(const OKFramePoseRecord& pose_record)
+{
+    records_[pose_record.pose_id_ & (FRAME_POSE_HISTORY_SIZE - 1)].store(pose_record);
+}
+
+bool OKFramePoseHistory::find(const uint64_t pose_id, OKFramePoseRecord& pose_record) const
+{
+    pose_record = records_[pose_id & (FRAME_POSE_HISTORY_SIZE - 1)].load();
+
+    // The slot may hold a newer pose if the frame is older than the whole ring
+    return (pose_record.is_valid_ && (pose_record.pose_id_ == pose_id));
+}
+
+void OKFramePoseHistory::clear()
+{
+    const OKFramePoseRecord invalid_record;
+
+    for (uint32_t slot_id = 0; slot_id < FRAME_POSE_HISTORY_SIZE; slot_id++)
+    {
+        records_[slot_id].store(invalid_record);
+    }
+}
+
+} // namespace BVR
+
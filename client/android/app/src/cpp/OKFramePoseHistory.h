@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FRAME_POSE_HISTORY_H
+#define OK_FRAME_POSE_HISTORY_H
+
+#include "ok_defines.h"
+#include "GLMPose.h"
+#include "OKSeqLock.h"
+
+namespace BVR
+{
+
+// Exactly what was sent to the server for one poseID, i.e. what it rendered the frame with
+struct OKFramePoseRecord
+{
+    bool is_valid_ = false;
+
+    uint64_t pose_id_ = 0;
+    uint64_t pose_time_ns_ = 0; // time the pose was located / predicted for
+    uint64_t send_time_ns_ = 0; // time it was handed to CloudXR
+
+    float ipd_meters_ = DEFAULT_CLOUDXR_IPD_M;
+
+    GLMPose hmd_pose_;
+    GLMPose eye_poses_[NUM_EYES];
+    XrFovf eye_fovs_[NUM_EYES] = {};
+};
+
+// Fixed-size ring indexed by poseID. Written by the CloudXR tracking callback, read by the
+// render thread when a frame carrying that poseID is latched.
+class OKFramePoseHistory
+{
+public:
+    OKFramePoseHistory();
+
+    void record(const OKFramePoseRecord& pose_record);
+    bool find(const uint64_t pose_id, OKFramePoseRecord& pose_record) const;
+
+    void clear();
+
+private:
+    OKSeqLock<OKFramePoseRecord> records_[FRAME_POSE_HISTORY_SIZE];
+};
+
+} // namespace BVR
+
+#endif // OK_FRAME_POSE_HISTORY_H
+
@@ -0,0 +1,626 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#include "OKHandJointCodec.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace BVR
+{
+
+static_assert(XR_HAND_JOINT_COUNT_EXT <= 32, "OKHandJointEncoder sends joints in a 32-bit mask");
+
+// 1 / sqrt(2), the largest the three smaller components of a unit quaternion can be, maps to 2^14 - 1
+const float HAND_JOINT_ROTATION_STEPS = 16383.0f * 1.41421356f;
+const int32_t HAND_JOINT_ROTATION_MAX = 16383;
+
+namespace
+{
+
+int32_t clamp_int(const int32_t value, const int32_t min_value, const int32_t max_value)
+{
+    return (value < min_value) ? min_value : ((value > max_value) ? max_value : value);
+}
+
+void quantize_rotation(const float x, const float y, const float z, const float w, OKQuantizedJoint& joint)
+{
+    const float components[4] = {x, y, z, w};
+
+    uint8_t largest_index = 3;
+    float largest_magnitude = fabsf(w);
+
+    for (uint8_t component_id = 0; component_id < 3; component_id++)
+    {
+        if (fabsf(components[component_id]) > largest_magnitude)
+        {
+            largest_index = component_id;
+            largest_magnitude = fabsf(components[component_id]);
+        }
+    }
+
+    // q and -q are the same rotation, so the dropped component is always rebuilt as positive
+    const float sign = (components[largest_index] < 0.0f) ? -1.0f : 1.0f;
+
+    int output_id = 0;
+
+    for (uint8_t component_id = 0; component_id < 4; component_id++)
+    {
+        if (component_id != largest_index)
+        {
+            const int32_t value = (int32_t)lroundf(components[component_id] * sign * HAND_JOINT_ROTATION_STEPS);
+            joint.rotation_[output_id++] = (int16_t)clamp_int(value, -HAND_JOINT_ROTATION_MAX, HAND_JOINT_ROTATION_MAX);
+        }
+    }
+
+    joint.rotation_index_ = largest_index;
+}
+
+XrQuaternionf dequantize_rotation(const OKQuantizedJoint& joint)
+{
+    float components[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float sum_of_squares = 0.0f;
+    int input_id = 0;
+
+    for (uint8_t component_id = 0; component_id < 4; component_id++)
+    {
+        if (component_id != joint.rotation_index_)
+        {
+            components[component_id] = (float)joint.rotation_[input_id++] / HAND_JOINT_ROTATION_STEPS;
+            sum_of_squares += components[component_id] * components[component_id];
+        }
+    }
+
+    components[joint.rotation_index_] = sqrtf(fmaxf(0.0f, 1.0f - sum_of_squares));
+
+    return {components[0], components[1], components[2], components[3]};
+}
+
+glm::fquat convert_to_glm_rotation(const XrQuaternionf& rotation)
+{
+    return glm::fquat(rotation.w, rotation.x, rotation.y, rotation.z);
+}
+
+void quantize_hand(const OKPoseBatch& joints, OKQuantizedHand& hand)
+{
+    const int wrist_id = XR_HAND_JOINT_WRIST_EXT;
+    OKQuantizedJoint& wrist = hand.joints_[wrist_id];
+
+    wrist.position_[0] = (int32_t)lroundf(joints.position_x_[wrist_id] * HAND_JOINT_POSITION_STEPS_PER_M);
+    wrist.position_[1] = (int32_t)lroundf(joints.position_y_[wrist_id] * HAND_JOINT_POSITION_STEPS_PER_M);
+    wrist.position_[2] = (int32_t)lroundf(joints.position_z_[wrist_id] * HAND_JOINT_POSITION_STEPS_PER_M);
+
+    quantize_rotation(joints.rotation_x_[wrist_id], joints.rotation_y_[wrist_id], joints.rotation_z_[wrist_id], joints.rotation_w_[wrist_id], wrist);
+
+    // The rest go into the frame of the wrist as the receiver will rebuild it, so the only error
+    // is their own rounding, and moving the whole hand only changes the wrist
+    const glm::fquat inverse_wrist_rotation = glm::conjugate(convert_to_glm_rotation(dequantize_rotation(wrist)));
+
+    const glm::vec3 wrist_position((float)wrist.position_[0], (float)wrist.position_[1], (float)wrist.position_[2]);
+
+    for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+    {
+        if (joint_id == wrist_id)
+        {
+            continue;
+        }
+
+        OKQuantizedJoint& joint = hand.joints_[joint_id];
+
+        const glm::vec3 position = glm::vec3(joints.position_x_[joint_id], joints.position_y_[joint_id], joints.position_z_[joint_id]) * HAND_JOINT_POSITION_STEPS_PER_M;
+        const glm::vec3 local_position = inverse_wrist_rotation * (position - wrist_position);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            joint.position_[axis] = clamp_int((int32_t)lroundf(local_position[axis]), INT16_MIN, INT16_MAX);
+        }
+
+        const glm::fquat rotation(joints.rotation_w_[joint_id], joints.rotation_x_[joint_id], joints.rotation_y_[joint_id], joints.rotation_z_[joint_id]);
+        const glm::fquat local_rotation = glm::normalize(inverse_wrist_rotation * rotation);
+
+        quantize_rotation(local_rotation.x, local_rotation.y, local_rotation.z, local_rotation.w, joint);
+    }
+
+    hand.is_tracked_ = true;
+}
+
+bool has_position_changed(const OKQuantizedJoint& joint, const OKQuantizedJoint& sent_joint)
+{
+    return (joint.position_[0] != sent_joint.position_[0]) || (joint.position_[1] != sent_joint.position_[1]) || (joint.position_[2] != sent_joint.position_[2]);
+}
+
+bool has_rotation_changed(const OKQuantizedJoint& joint, const OKQuantizedJoint& sent_joint)
+{
+    return (joint.rotation_index_ != sent_joint.rotation_index_) || (joint.rotation_[0] != sent_joint.rotation_[0]) ||
+           (joint.rotation_[1] != sent_joint.rotation_[1]) || (joint.rotation_[2] != sent_joint.rotation_[2]);
+}
+
+// Differences wrap like the int32 sums the decoder does, so even a full-range wrist jump round trips
+int32_t wrapped_difference(const int32_t value, const int32_t base)
+{
+    return (int32_t)((uint32_t)value - (uint32_t)base);
+}
+
+int32_t wrapped_sum(const int32_t base, const int32_t difference)
+{
+    return (int32_t)((uint32_t)base + (uint32_t)difference);
+}
+
+class OKPacketWriter
+{
+public:
+    explicit OKPacketWriter(uint8_t* cursor) : cursor_(cursor)
+    {
+    }
+
+    uint8_t* get_cursor() const
+    {
+        return cursor_;
+    }
+
+    void set_cursor(uint8_t* cursor)
+    {
+        cursor_ = cursor;
+    }
+
+    void write_u8(const uint8_t value)
+    {
+        *cursor_++ = value;
+    }
+
+    void write_bytes(const uint64_t value, const int byte_count)
+    {
+        for (int byte_id = 0; byte_id < byte_count; byte_id++)
+        {
+            *cursor_++ = (uint8_t)(value >> (8 * byte_id));
+        }
+    }
+
+    void write_varint(const int32_t value)
+    {
+        uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+        while (zigzag >= 0x80)
+        {
+            *cursor_++ = (uint8_t)(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+
+        *cursor_++ = (uint8_t)zigzag;
+    }
+
+    void write_rotation(const OKQuantizedJoint& joint)
+    {
+        const uint64_t packed = (uint64_t)joint.rotation_index_ |
+                                ((uint64_t)((uint16_t)joint.rotation_[0] & 0x7FFF) << 2) |
+                                ((uint64_t)((uint16_t)joint.rotation_[1] & 0x7FFF) << 17) |
+                                ((uint64_t)((uint16_t)joint.rotation_[2] & 0x7FFF) << 32);
+
+        write_bytes(packed, HAND_JOINT_ROTATION_SIZE);
+    }
+
+private:
+    uint8_t* cursor_ = nullptr;
+};
+
+class OKPacketReader
+{
+public:
+    OKPacketReader(const uint8_t* data, const uint32_t size) : cursor_(data), end_(data + size)
+    {
+    }
+
+    bool is_valid() const
+    {
+        return is_valid_;
+    }
+
+    uint64_t read_bytes(const int byte_count)
+    {
+        if ((end_ - cursor_) < byte_count)
+        {
+            is_valid_ = false;
+            cursor_ = end_;
+            return 0;
+        }
+
+        uint64_t value = 0;
+
+        for (int byte_id = 0; byte_id < byte_count; byte_id++)
+        {
+            value |= (uint64_t)(*cursor_++) << (8 * byte_id);
+        }
+
+        return value;
+    }
+
+    int32_t read_varint()
+    {
+        uint32_t zigzag = 0;
+
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            const uint8_t byte = (uint8_t)read_bytes(1);
+            zigzag |= (uint32_t)(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80))
+            {
+                return (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            }
+        }
+
+        is_valid_ = false;
+        return 0;
+    }
+
+    void read_rotation(OKQuantizedJoint& joint)
+    {
+        const uint64_t packed = read_bytes(HAND_JOINT_ROTATION_SIZE);
+
+        joint.rotation_index_ = (uint8_t)(packed & 0x3);
+
+        for (int component_id = 0; component_id < 3; component_id++)
+        {
+            // Sign extend the 15-bit fields
+            const uint16_t bits = (uint16_t)((packed >> (2 + 15 * component_id)) & 0x7FFF);
+            joint.rotation_[component_id] = (int16_t)(uint16_t)(bits << 1) >> 1;
+        }
+    }
+
+private:
+    const uint8_t* cursor_ = nullptr;
+    const uint8_t* end_ = nullptr;
+    bool is_valid_ = true;
+};
+
+void write_keyframe_hand(OKPacketWriter& writer, const OKQuantizedHand& hand)
+{
+    writer.write_u8(HandFlag_Tracked | HandFlag_Keyframe);
+    writer.write_bytes((1ULL << XR_HAND_JOINT_COUNT_EXT) - 1, sizeof(uint32_t));
+
+    for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+    {
+        const OKQuantizedJoint& joint = hand.joints_[joint_id];
+        const int position_size = (joint_id == XR_HAND_JOINT_WRIST_EXT) ? sizeof(int32_t) : sizeof(int16_t);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            writer.write_bytes((uint32_t)joint.position_[axis], position_size);
+        }
+
+        writer.write_rotation(joint);
+    }
+}
+
+// Returns the mask of joints written, 0 when the hand didn't move
+uint32_t write_delta_hand(OKPacketWriter& writer, const OKQuantizedHand& hand, const OKQuantizedHand& sent_hand)
+{
+    writer.write_u8(HandFlag_Tracked);
+
+    uint8_t* mask_cursor = writer.get_cursor();
+    writer.write_bytes(0, sizeof(uint32_t));
+
+    uint32_t joint_mask = 0;
+
+    for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+    {
+        const OKQuantizedJoint& joint = hand.joints_[joint_id];
+        const OKQuantizedJoint& sent_joint = sent_hand.joints_[joint_id];
+
+        const bool position_changed = has_position_changed(joint, sent_joint);
+        const bool rotation_changed = has_rotation_changed(joint, sent_joint);
+
+        if (!position_changed && !rotation_changed)
+        {
+            continue;
+        }
+
+        joint_mask |= (1U << joint_id);
+
+        const bool is_absolute_rotation = (joint.rotation_index_ != sent_joint.rotation_index_);
+
+        uint8_t joint_flags = 0;
+        joint_flags |= position_changed ? JointFlag_Position : 0;
+        joint_flags |= rotation_changed ? JointFlag_Rotation : 0;
+        joint_flags |= is_absolute_rotation ? JointFlag_AbsoluteRotation : 0;
+
+        writer.write_u8(joint_flags);
+
+        if (position_changed)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                writer.write_varint(wrapped_difference(joint.position_[axis], sent_joint.position_[axis]));
+            }
+        }
+
+        if (is_absolute_rotation)
+        {
+            writer.write_rotation(joint);
+        }
+        else if (rotation_changed)
+        {
+            for (int component_id = 0; component_id < 3; component_id++)
+            {
+                writer.write_varint((int32_t)joint.rotation_[component_id] - (int32_t)sent_joint.rotation_[component_id]);
+            }
+        }
+    }
+
+    OKPacketWriter mask_writer(mask_cursor);
+    mask_writer.write_bytes(joint_mask, sizeof(uint32_t));
+
+    return joint_mask;
+}
+
+} // namespace
+
+OKHandJointEncoder::OKHandJointEncoder()
+{
+}
+
+void OKHandJointEncoder::reset()
+{
+    for (int hand_id = 0; hand_id < NUM_HANDS; hand_id++)
+    {
+        sent_hands_[hand_id] = OKQuantizedHand();
+    }
+
+    sequence_ = 0;
+    last_keyframe_time_ns_ = 0;
+    is_keyframe_pending_ = true;
+}
+
+uint32_t OKHandJointEncoder::build(const OKPoseBatch* const hand_joints[NUM_HANDS], const uint64_t joint_time_ns, const uint64_t now_time_ns, const bool force_keyframe)
+{
+    const uint64_t keyframe_interval_ns = (uint64_t)HAND_JOINT_KEYFRAME_MS * 1000000ULL;
+    const bool is_keyframe = force_keyframe || is_keyframe_pending_ || ((now_time_ns - last_keyframe_time_ns_) >= keyframe_interval_ns);
+
+    OKPacketWriter writer(packet_);
+    writer.write_u8(OK_HAND_JOINT_PACKET_TYPE);
+    writer.write_u8(OK_HAND_JOINT_PACKET_VERSION);
+    writer.write_bytes(sequence_, sizeof(uint16_t));
+    writer.write_bytes(joint_time_ns, sizeof(uint64_t));
+
+    bool has_changes = is_keyframe;
+
+    for (int hand_id = 0; hand_id < NUM_HANDS; hand_id++)
+    {
+        const OKPoseBatch* joints = hand_joints[hand_id];
+        OKQuantizedHand& sent_hand = sent_hands_[hand_id];
+
+        if (!joints || (joints->count_ < XR_HAND_JOINT_COUNT_EXT))
+        {
+            writer.write_u8(0);
+            has_changes = has_changes || sent_hand.is_tracked_;
+            sent_hand.is_tracked_ = false;
+            continue;
+        }
+
+        quantize_hand(*joints, current_hand_);
+
+        // A hand that was just (re)acquired has nothing to be relative to
+        bool is_hand_keyframe = (is_keyframe || !sent_hand.is_tracked_);
+
+        if (!is_hand_keyframe)
+        {
+            uint8_t* hand_cursor = writer.get_cursor();
+            const uint32_t joint_mask = write_delta_hand(writer, current_hand_, sent_hand);
+
+            if ((uint32_t)(writer.get_cursor() - hand_cursor) > HAND_JOINT_KEYFRAME_HAND_SIZE)
+            {
+                // Everything moved a lot, absolute values are smaller
+                writer.set_cursor(hand_cursor);
+                is_hand_keyframe = true;
+            }
+            else
+            {
+                has_changes = has_changes || (joint_mask != 0);
+            }
+        }
+
+        if (is_hand_keyframe)
+        {
+            write_keyframe_hand(writer, current_hand_);
+            has_changes = true;
+        }
+
+        sent_hand = current_hand_;
+    }
+
+    if (!has_changes)
+    {
+        return 0;
+    }
+
+    if (is_keyframe)
+    {
+        last_keyframe_time_ns_ = now_time_ns;
+        is_keyframe_pending_ = false;
+    }
+
+    sequence_++;
+
+    return (uint32_t)(writer.get_cursor() - packet_);
+}
+
+OKHandJointDecoder::OKHandJointDecoder()
+{
+}
+
+void OKHandJointDecoder::reset()
+{
+    for (int hand_id = 0; hand_id < NUM_HANDS; hand_id++)
+    {
+        hands_[hand_id] = OKQuantizedHand();
+        has_base_[hand_id] = false;
+    }
+
+    last_sequence_ = 0;
+    has_sequence_ = false;
+    joint_time_ns_ = 0;
+}
+
+bool OKHandJointDecoder::decode(const uint8_t* packet, const uint32_t packet_size)
+{
+    if (!packet)
+    {
+        return false;
+    }
+
+    OKPacketReader reader(packet, packet_size);
+
+    const uint8_t packet_type = (uint8_t)reader.read_bytes(1);
+    const uint8_t packet_version = (uint8_t)reader.read_bytes(1);
+    const uint16_t sequence = (uint16_t)reader.read_bytes(sizeof(uint16_t));
+    const uint64_t joint_time_ns = reader.read_bytes(sizeof(uint64_t));
+
+    if (!reader.is_valid() || (packet_type != OK_HAND_JOINT_PACKET_TYPE) || (packet_version != OK_HAND_JOINT_PACKET_VERSION))
+    {
+        return false;
+    }
+
+    const bool is_in_sequence = has_sequence_ && (sequence == (uint16_t)(last_sequence_ + 1));
+
+    OKQuantizedHand decoded_hands[NUM_HANDS];
+    bool has_decoded_base[NUM_HANDS] = {false, false};
+    bool is_complete = true;
+
+    for (int hand_id = 0; hand_id < NUM_HANDS; hand_id++)
+    {
+        OKQuantizedHand& hand = decoded_hands[hand_id];
+        hand = hands_[hand_id];
+
+        const uint8_t hand_flags = (uint8_t)reader.read_bytes(1);
+
+        if (!(hand_flags & HandFlag_Tracked))
+        {
+            hand.is_tracked_ = false;
+            has_decoded_base[hand_id] = true;
+            continue;
+        }
+
+        const bool is_keyframe = (hand_flags & HandFlag_Keyframe) != 0;
+        const uint32_t joint_mask = (uint32_t)reader.read_bytes(sizeof(uint32_t));
+
+        for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+        {
+            if (!(joint_mask & (1U << joint_id)))
+            {
+                continue;
+            }
+
+            OKQuantizedJoint& joint = hand.joints_[joint_id];
+
+            if (is_keyframe)
+            {
+                const bool is_wrist = (joint_id == XR_HAND_JOINT_WRIST_EXT);
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    joint.position_[axis] = is_wrist ? (int32_t)(uint32_t)reader.read_bytes(sizeof(int32_t)) : (int16_t)(uint16_t)reader.read_bytes(sizeof(int16_t));
+                }
+
+                reader.read_rotation(joint);
+                continue;
+            }
+
+            const uint8_t joint_flags = (uint8_t)reader.read_bytes(1);
+
+            if (joint_flags & JointFlag_Position)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    joint.position_[axis] = wrapped_sum(joint.position_[axis], reader.read_varint());
+                }
+            }
+
+            if (joint_flags & JointFlag_AbsoluteRotation)
+            {
+                reader.read_rotation(joint);
+            }
+            else if (joint_flags & JointFlag_Rotation)
+            {
+                for (int component_id = 0; component_id < 3; component_id++)
+                {
+                    joint.rotation_[component_id] = (int16_t)(joint.rotation_[component_id] + reader.read_varint());
+                }
+            }
+        }
+
+        hand.is_tracked_ = true;
+        has_decoded_base[hand_id] = is_keyframe || (is_in_sequence && has_base_[hand_id] && hands_[hand_id].is_tracked_);
+        is_complete = is_complete && has_decoded_base[hand_id];
+    }
+
+    if (!reader.is_valid())
+    {
+        return false;
+    }
+
+    for (int hand_id = 0; hand_id < NUM_HANDS; hand_id++)
+    {
+        hands_[hand_id] = decoded_hands[hand_id];
+        has_base_[hand_id] = has_decoded_base[hand_id];
+    }
+
+    last_sequence_ = sequence;
+    has_sequence_ = true;
+    joint_time_ns_ = joint_time_ns;
+
+    return is_complete;
+}
+
+bool OKHandJointDecoder::is_tracked(const int hand_id) const
+{
+    if ((hand_id < 0) || (hand_id >= NUM_HANDS))
+    {
+        return false;
+    }
+
+    return has_base_[hand_id] && hands_[hand_id].is_tracked_;
+}
+
+XrPosef OKHandJointDecoder::get_joint_pose(const int hand_id, const int joint_id) const
+{
+    XrPosef pose = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+
+    if (!is_tracked(hand_id) || (joint_id < 0) || (joint_id >= XR_HAND_JOINT_COUNT_EXT))
+    {
+        return pose;
+    }
+
+    const OKQuantizedHand& hand = hands_[hand_id];
+    const OKQuantizedJoint& wrist = hand.joints_[XR_HAND_JOINT_WRIST_EXT];
+
+    const glm::vec3 wrist_position = glm::vec3((float)wrist.position_[0], (float)wrist.position_[1], (float)wrist.position_[2]) / HAND_JOINT_POSITION_STEPS_PER_M;
+    const XrQuaternionf wrist_rotation = dequantize_rotation(wrist);
+
+    if (joint_id == XR_HAND_JOINT_WRIST_EXT)
+    {
+        pose.position = {wrist_position.x, wrist_position.y, wrist_position.z};
+        pose.orientation = wrist_rotation;
+        return pose;
+    }
+
+    const OKQuantizedJoint& joint = hand.joints_[joint_id];
+    const glm::fquat glm_wrist_rotation = convert_to_glm_rotation(wrist_rotation);
+
+    const glm::vec3 local_position = glm::vec3((float)joint.position_[0], (float)joint.position_[1], (float)joint.position_[2]) / HAND_JOINT_POSITION_STEPS_PER_M;
+    const glm::vec3 position = wrist_position + glm_wrist_rotation * local_position;
+    const glm::fquat rotation = glm::normalize(glm_wrist_rotation * convert_to_glm_rotation(dequantize_rotation(joint)));
+
+    pose.position = {position.x, position.y, position.z};
+    pose.orientation = {rotation.x, rotation.y, rotation.z, rotation.w};
+
+    return pose;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
@@ -0,0 +1,141 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_HAND_JOINT_CODEC_H
+#define OK_HAND_JOINT_CODEC_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#include "OKPoseBatch.h"
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+
+namespace BVR
+{
+
+// Both hands' XR_EXT_hand_tracking joints as one cxrGenericUserInputEvent blob, little endian:
+//
+//   header   uint8 type ('H'), uint8 version, uint16 sequence, uint64 joint time (ns)
+//   per hand uint8 flags (HandFlag_*), then when tracked a uint32 mask of the joints that follow
+//
+// The wrist is in the base space, every other joint in the wrist's frame (as rebuilt from its
+// quantized pose), so a hand moving as a whole only changes the wrist. Positions are steps of
+// 1 / HAND_JOINT_POSITION_STEPS_PER_M metres, int32 for the wrist and int16 for the rest.
+// Rotations are smallest-three: the largest component is dropped (and made positive), the other
+// three are 15-bit signed in [-1/sqrt(2), 1/sqrt(2)], packed with the dropped index into 6 bytes.
+//
+// A keyframe hand carries every joint with those absolute values (323 bytes). A delta hand only
+// carries the joints whose quantized values moved since the last packet, each as a JointFlag_*
+// byte, then zigzag varints of the position / rotation differences, or an absolute rotation when
+// the dropped component changed. Deltas apply to the previous packet exactly, so a receiver that
+// sees a gap in the sequence waits for the next keyframe.
+const uint8_t OK_HAND_JOINT_PACKET_TYPE = 'H';
+const uint8_t OK_HAND_JOINT_PACKET_VERSION = 1;
+
+const uint32_t HAND_JOINT_PACKET_HEADER_SIZE = 12;
+const uint32_t HAND_JOINT_ROTATION_SIZE = 6;
+const uint32_t HAND_JOINT_KEYFRAME_HAND_SIZE = 1 + 4 + (3 * sizeof(int32_t) + HAND_JOINT_ROTATION_SIZE) +
+                                               (XR_HAND_JOINT_COUNT_EXT - 1) * (3 * sizeof(int16_t) + HAND_JOINT_ROTATION_SIZE);
+
+// Room for a worst case delta of both hands, before it's swapped for the smaller keyframe
+const uint32_t MAX_HAND_JOINT_DELTA_JOINT_SIZE = 1 + 3 * 5 + 3 * 5;
+const uint32_t MAX_HAND_JOINT_PACKET_SIZE = HAND_JOINT_PACKET_HEADER_SIZE + NUM_HANDS * (1 + 4 + XR_HAND_JOINT_COUNT_EXT * MAX_HAND_JOINT_DELTA_JOINT_SIZE);
+
+typedef enum
+{
+    HandFlag_Tracked = (1 << 0),
+    HandFlag_Keyframe = (1 << 1),
+} OKHandFlags;
+
+typedef enum
+{
+    JointFlag_Position = (1 << 0),
+    JointFlag_Rotation = (1 << 1),
+    JointFlag_AbsoluteRotation = (1 << 2),
+} OKJointFlags;
+
+struct OKQuantizedJoint
+{
+    int32_t position_[3] = {0, 0, 0};
+    int16_t rotation_[3] = {0, 0, 0};
+    uint8_t rotation_index_ = 3; // the dropped component, 3 = w
+};
+
+struct OKQuantizedHand
+{
+    bool is_tracked_ = false;
+    OKQuantizedJoint joints_[XR_HAND_JOINT_COUNT_EXT];
+};
+
+// Quantizes located joints and writes the packet into a buffer it owns, so a poll allocates
+// nothing. Nothing is written when no joint moved by a quantization step since the last packet
+// and no hand started or stopped being tracked, apart from a keyframe every HAND_JOINT_KEYFRAME_MS.
+class OKHandJointEncoder
+{
+public:
+    OKHandJointEncoder();
+
+    // Forget what was sent, the next build() is a keyframe
+    void reset();
+
+    // hand_joints[hand_id] holds XR_HAND_JOINT_COUNT_EXT normalized joint poses in the base space,
+    // in XrHandJointEXT order, or is nullptr when that hand isn't tracked. Returns the size of the
+    // packet in get_packet(), 0 when there's nothing to send.
+    uint32_t build(const OKPoseBatch* const hand_joints[NUM_HANDS], const uint64_t joint_time_ns, const uint64_t now_time_ns, const bool force_keyframe);
+
+    const uint8_t* get_packet() const
+    {
+        return packet_;
+    }
+
+private:
+    OKQuantizedHand sent_hands_[NUM_HANDS];
+    OKQuantizedHand current_hand_;
+
+    uint16_t sequence_ = 0;
+    uint64_t last_keyframe_time_ns_ = 0;
+    bool is_keyframe_pending_ = true;
+
+    uint8_t packet_[MAX_HAND_JOINT_PACKET_SIZE];
+};
+
+// Reads what OKHandJointEncoder writes, for whatever consumes the generic input events server side
+// (and the host build, to check the round trip).
+class OKHandJointDecoder
+{
+public:
+    OKHandJointDecoder();
+
+    void reset();
+
+    // False for a malformed packet, or a delta that can't be applied because the packet it's
+    // relative to was missed; hands stay untracked until their next keyframe then.
+    bool decode(const uint8_t* packet, const uint32_t packet_size);
+
+    bool is_tracked(const int hand_id) const;
+    XrPosef get_joint_pose(const int hand_id, const int joint_id) const;
+
+    uint64_t get_joint_time_ns() const
+    {
+        return joint_time_ns_;
+    }
+
+private:
+    OKQuantizedHand hands_[NUM_HANDS];
+    bool has_base_[NUM_HANDS] = {false, false};
+
+    uint16_t last_sequence_ = 0;
+    bool has_sequence_ = false;
+    uint64_t joint_time_ns_ = 0;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#endif // OK_HAND_JOINT_CODEC_H
@@ -0,0 +1,130 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#include "OKHandTracker.h"
+
+namespace BVR
+{
+
+static_assert(NUM_HANDS == 2, "OKHandTracker creates one tracker for each of XR_HAND_LEFT_EXT / XR_HAND_RIGHT_EXT");
+
+OKHandTracker::OKHandTracker()
+{
+}
+
+OKHandTracker::~OKHandTracker()
+{
+    shutdown();
+}
+
+bool OKHandTracker::init(XrInstance instance, XrSession session)
+{
+    if (is_initialized_)
+    {
+        return true;
+    }
+
+    if ((instance == XR_NULL_HANDLE) || (session == XR_NULL_HANDLE))
+    {
+        return false;
+    }
+
+    XrResult result = xrGetInstanceProcAddr(instance, "xrCreateHandTrackerEXT", (PFN_xrVoidFunction*)&xrCreateHandTrackerEXT_);
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrDestroyHandTrackerEXT", (PFN_xrVoidFunction*)&xrDestroyHandTrackerEXT_);
+    }
+
+    if (XR_SUCCEEDED(result))
+    {
+        result = xrGetInstanceProcAddr(instance, "xrLocateHandJointsEXT", (PFN_xrVoidFunction*)&xrLocateHandJointsEXT_);
+    }
+
+    if (XR_FAILED(result) || !xrCreateHandTrackerEXT_ || !xrDestroyHandTrackerEXT_ || !xrLocateHandJointsEXT_)
+    {
+        //IGLLog(IGLLogLevel::LOG_INFO, "OKHandTracker: XR_EXT_hand_tracking not enabled\n");
+        xrCreateHandTrackerEXT_ = nullptr;
+        xrDestroyHandTrackerEXT_ = nullptr;
+        xrLocateHandJointsEXT_ = nullptr;
+        return false;
+    }
+
+    for (int hand_id = LEFT_HAND; hand_id < NUM_HANDS; hand_id++)
+    {
+        XrHandTrackerCreateInfoEXT create_info = {};
+        create_info.type = XR_TYPE_HAND_TRACKER_CREATE_INFO_EXT;
+        create_info.hand = (hand_id == LEFT_HAND) ? XR_HAND_LEFT_EXT : XR_HAND_RIGHT_EXT;
+        create_info.handJointSet = XR_HAND_JOINT_SET_DEFAULT_EXT;
+
+        result = xrCreateHandTrackerEXT_(session, &create_info, &hand_trackers_[hand_id]);
+
+        if (XR_FAILED(result))
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "xrCreateHandTrackerEXT error = %d\n", result);
+            hand_trackers_[hand_id] = XR_NULL_HANDLE;
+            is_initialized_ = true;
+            shutdown();
+            return false;
+        }
+    }
+
+    is_initialized_ = true;
+    return is_initialized_;
+}
+
+void OKHandTracker::shutdown()
+{
+    if (!is_initialized_)
+    {
+        return;
+    }
+
+    for (int hand_id = LEFT_HAND; hand_id < NUM_HANDS; hand_id++)
+    {
+        if (hand_trackers_[hand_id] != XR_NULL_HANDLE)
+        {
+            xrDestroyHandTrackerEXT_(hand_trackers_[hand_id]);
+            hand_trackers_[hand_id] = XR_NULL_HANDLE;
+        }
+    }
+
+    is_initialized_ = false;
+}
+
+bool OKHandTracker::locate_joints(const int hand_id, const XrSpace base_space, const XrTime time, XrHandJointLocationEXT* joint_locations) const
+{
+    if (!is_initialized_ || (hand_id < LEFT_HAND) || (hand_id >= NUM_HANDS) || !joint_locations)
+    {
+        return false;
+    }
+
+    XrHandJointsLocateInfoEXT locate_info = {};
+    locate_info.type = XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT;
+    locate_info.baseSpace = base_space;
+    locate_info.time = time;
+
+    XrHandJointLocationsEXT locations = {};
+    locations.type = XR_TYPE_HAND_JOINT_LOCATIONS_EXT;
+    locations.jointCount = XR_HAND_JOINT_COUNT_EXT;
+    locations.jointLocations = joint_locations;
+
+    const XrResult result = xrLocateHandJointsEXT_(hand_trackers_[hand_id], &locate_info, &locations);
+
+    if (XR_FAILED(result) || !locations.isActive)
+    {
+        return false;
+    }
+
+    const XrSpaceLocationFlags wrist_valid_flags = (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT);
+    return ((joint_locations[XR_HAND_JOINT_WRIST_EXT].locationFlags & wrist_valid_flags) == wrist_valid_flags);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_HAND_TRACKER_H
+#define OK_HAND_TRACKER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#include <openxr/openxr.h>
+
+namespace BVR
+{
+
+const int LEFT_HAND = 0;
+const int RIGHT_HAND = 1;
+
+// One XR_EXT_hand_tracking tracker per hand. The extension's entry points aren't exported by the
+// loader, they're fetched with xrGetInstanceProcAddr, which fails when XrApp didn't enable the
+// extension on the instance: init() then returns false and hands are simply never streamed.
+class OKHandTracker
+{
+public:
+    OKHandTracker();
+    ~OKHandTracker();
+
+    bool init(XrInstance instance, XrSession session);
+    void shutdown();
+
+    bool is_initialized() const
+    {
+        return is_initialized_;
+    }
+
+    // Fills XR_HAND_JOINT_COUNT_EXT joint locations in base_space. False when that hand isn't
+    // tracked right now, or its wrist pose isn't valid (everything is relative to the wrist).
+    bool locate_joints(const int hand_id, const XrSpace base_space, const XrTime time, XrHandJointLocationEXT* joint_locations) const;
+
+private:
+    bool is_initialized_ = false;
+
+    PFN_xrCreateHandTrackerEXT xrCreateHandTrackerEXT_ = nullptr;
+    PFN_xrDestroyHandTrackerEXT xrDestroyHandTrackerEXT_ = nullptr;
+    PFN_xrLocateHandJointsEXT xrLocateHandJointsEXT_ = nullptr;
+
+    XrHandTrackerEXT hand_trackers_[NUM_HANDS] = {XR_NULL_HANDLE, XR_NULL_HANDLE};
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAND_TRACKING
+
+#endif // OK_HAND_TRACKER_H
@@ -0,0 +1,178 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKHapticsScheduler.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAPTICS
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace BVR
+{
+
+namespace
+{
+
+float sanitize(const float value, const float max_value)
+{
+    return std::isfinite(value) ? std::clamp(value, 0.0f, max_value) : 0.0f;
+}
+
+} // namespace
+
+OKHapticsScheduler::OKHapticsScheduler()
+{
+}
+
+bool OKHapticsScheduler::push(const cxrHapticFeedback& feedback)
+{
+    pulse_count_.fetch_add(1, std::memory_order_relaxed);
+
+    if (feedback.deviceID >= (uint64_t)CXR_NUM_CONTROLLERS)
+    {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    OKHapticPulse pulse;
+    pulse.amplitude_ = sanitize(feedback.amplitude, 1.0f);
+    pulse.frequency_ = sanitize(feedback.frequency, FLT_MAX);
+
+    const float seconds = sanitize(feedback.seconds, (float)HAPTIC_MAX_PULSE_MS / 1000.0f);
+    pulse.duration_ns_ = (uint64_t)((double)seconds * 1e9);
+
+    if (!queues_[feedback.deviceID].push(pulse))
+    {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+void OKHapticsScheduler::update(const uint64_t now_time_ns, OKHapticCommand commands[CXR_NUM_CONTROLLERS])
+{
+    for (int controller_id = 0; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        OKHapticCommand& command = commands[controller_id];
+        command = {};
+
+        OKHapticState& state = states_[controller_id];
+        const bool was_vibrating = (state.end_time_ns_ > now_time_ns);
+
+        bool has_pulse = false;
+        bool has_changed = false;
+        bool has_stopped = false;
+        uint64_t pulse_count = 0;
+
+        OKHapticPulse pulse;
+
+        while (queues_[controller_id].pop(pulse))
+        {
+            pulse_count++;
+
+            // A silent pulse is the server stopping the vibration
+            if (pulse.amplitude_ <= 0.0f)
+            {
+                state = {};
+                has_pulse = false;
+                has_changed = false;
+                has_stopped = true;
+                continue;
+            }
+
+            const uint64_t pulse_end_time_ns = now_time_ns + pulse.duration_ns_;
+
+            if (has_pulse || (state.end_time_ns_ > now_time_ns))
+            {
+                // Overlaps what's playing: the loudest wins, until the last one ends
+                OKHapticState merged_state = state;
+
+                if (pulse.amplitude_ > state.amplitude_)
+                {
+                    merged_state.amplitude_ = pulse.amplitude_;
+                    merged_state.frequency_ = pulse.frequency_;
+                }
+
+                merged_state.end_time_ns_ = std::max(state.end_time_ns_, pulse_end_time_ns);
+
+                if ((merged_state.amplitude_ != state.amplitude_) ||
+                    (merged_state.frequency_ != state.frequency_) ||
+                    (merged_state.end_time_ns_ != state.end_time_ns_))
+                {
+                    has_changed = true;
+                }
+
+                state = merged_state;
+            }
+            else
+            {
+                state.amplitude_ = pulse.amplitude_;
+                state.frequency_ = pulse.frequency_;
+                state.end_time_ns_ = pulse_end_time_ns;
+                has_changed = true;
+            }
+
+            has_pulse = true;
+        }
+
+        if (has_changed)
+        {
+            command.type_ = HapticCommand_Apply;
+            command.pulse_.amplitude_ = state.amplitude_;
+            command.pulse_.frequency_ = state.frequency_;
+            command.pulse_.duration_ns_ = state.end_time_ns_ - now_time_ns;
+        }
+        else if (has_stopped && was_vibrating)
+        {
+            command.type_ = HapticCommand_Stop;
+        }
+
+        if (command.type_ != HapticCommand_None)
+        {
+            command_count_++;
+            pulse_count--;
+        }
+
+        merged_count_ += pulse_count;
+    }
+}
+
+void OKHapticsScheduler::reset(const uint64_t now_time_ns, OKHapticCommand commands[CXR_NUM_CONTROLLERS])
+{
+    for (int controller_id = 0; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+    {
+        OKHapticPulse pulse;
+
+        while (queues_[controller_id].pop(pulse))
+        {
+        }
+
+        commands[controller_id] = {};
+
+        if (is_vibrating(controller_id, now_time_ns))
+        {
+            commands[controller_id].type_ = HapticCommand_Stop;
+            command_count_++;
+        }
+
+        states_[controller_id] = {};
+    }
+}
+
+bool OKHapticsScheduler::is_vibrating(const int controller_id, const uint64_t now_time_ns) const
+{
+    if ((controller_id < 0) || (controller_id >= CXR_NUM_CONTROLLERS))
+    {
+        return false;
+    }
+
+    return (states_[controller_id].end_time_ns_ > now_time_ns);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAPTICS
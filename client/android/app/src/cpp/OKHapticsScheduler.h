@@ -0,0 +1,108 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_HAPTICS_SCHEDULER_H
+#define OK_HAPTICS_SCHEDULER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR && ENABLE_HAPTICS
+
+#include "OKSPSCQueue.h"
+
+#include <CloudXRCommon.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace BVR
+{
+
+// One cxrHapticFeedback, normalized. duration_ns_ 0 is the runtime's shortest pulse.
+struct OKHapticPulse
+{
+    float amplitude_ = 0.0f;
+    float frequency_ = 0.0f; // Hz, 0 = runtime default
+    uint64_t duration_ns_ = 0;
+};
+
+typedef enum
+{
+    HapticCommand_None,
+    HapticCommand_Apply,
+    HapticCommand_Stop,
+} OKHapticCommandType;
+
+// What the consumer has to do to one controller's vibration this update
+struct OKHapticCommand
+{
+    OKHapticCommandType type_ = HapticCommand_None;
+    OKHapticPulse pulse_;
+};
+
+// Takes TriggerHaptic callbacks on the CloudXR thread and hands them to the thread that talks
+// to OpenXR. push() only writes into a preallocated per controller queue, so the network thread
+// never blocks or allocates; update() drains every queue and merges what overlaps with the
+// vibration already playing into one pulse (the loudest amplitude, until the latest end), so a
+// burst of short pulses costs one xrApplyHapticFeedback per controller and frame, not one each.
+class OKHapticsScheduler
+{
+public:
+    OKHapticsScheduler();
+
+    // Producer thread only. deviceID is the cxrControllerDesc id, false if it isn't a controller
+    // or its queue is full (the pulse is dropped and counted).
+    bool push(const cxrHapticFeedback& feedback);
+
+    // Consumer thread only, commands[controller_id] says what to apply now
+    void update(const uint64_t now_time_ns, OKHapticCommand commands[CXR_NUM_CONTROLLERS]);
+
+    // Consumer thread only: forget what's queued, HapticCommand_Stop for what's still vibrating
+    void reset(const uint64_t now_time_ns, OKHapticCommand commands[CXR_NUM_CONTROLLERS]);
+
+    bool is_vibrating(const int controller_id, const uint64_t now_time_ns) const;
+
+    uint64_t get_pulse_count() const
+    {
+        return pulse_count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_dropped_count() const
+    {
+        return dropped_count_.load(std::memory_order_relaxed);
+    }
+
+    // Pulses that didn't need a call of their own
+    uint64_t get_merged_count() const
+    {
+        return merged_count_;
+    }
+
+    uint64_t get_command_count() const
+    {
+        return command_count_;
+    }
+
+private:
+    struct OKHapticState
+    {
+        float amplitude_ = 0.0f;
+        float frequency_ = 0.0f;
+        uint64_t end_time_ns_ = 0;
+    };
+
+    OKSPSCQueue<OKHapticPulse, HAPTIC_QUEUE_SIZE> queues_[CXR_NUM_CONTROLLERS];
+    OKHapticState states_[CXR_NUM_CONTROLLERS];
+
+    std::atomic<uint64_t> pulse_count_ = {0};
+    std::atomic<uint64_t> dropped_count_ = {0};
+    uint64_t merged_count_ = 0;
+    uint64_t command_count_ = 0;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR && ENABLE_HAPTICS
+
+#endif // OK_HAPTICS_SCHEDULER_H
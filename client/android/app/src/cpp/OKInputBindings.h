@@ -0,0 +1,271 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_INPUT_BINDINGS_H
+#define OK_INPUT_BINDINGS_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKController.h"
+
+#include <CloudXRCommon.h>
+
+#include <array>
+#include <cstdint>
+
+namespace BVR
+{
+
+// Built-in controller layout, used when no JSON input profile is selected. One row per CloudXR
+// input path, in path index order. source_ids_ is a DigitalButtonID for boolean paths and an
+// AnalogAxisID for float32 paths, per hand, or INVALID_INDEX when that hand has no such input.
+struct OKInputBinding
+{
+    const char* cxr_path_;
+    cxrInputValueType value_type_;
+    int source_ids_[NUM_CONTROLLERS];
+};
+
+constexpr OKInputBinding input_bindings[] =
+{
+    {"/input/system/click",           cxrInputValueType_boolean, {DigitalButton_ApplicationMenu, INVALID_INDEX}},
+    {"/input/application_menu/click", cxrInputValueType_boolean, {INVALID_INDEX, INVALID_INDEX}},
+    {"/input/trigger/click",          cxrInputValueType_boolean, {DigitalButton_Trigger_Click, DigitalButton_Trigger_Click}},
+    {"/input/trigger/touch",          cxrInputValueType_boolean, {DigitalButton_Trigger_Touch, DigitalButton_Trigger_Touch}},
+    {"/input/trigger/value",          cxrInputValueType_float32, {AnalogAxis_Trigger, AnalogAxis_Trigger}},
+    {"/input/grip/click",             cxrInputValueType_boolean, {DigitalButton_Grip_Click, DigitalButton_Grip_Click}},
+    {"/input/grip/touch",             cxrInputValueType_boolean, {DigitalButton_Grip_Touch, DigitalButton_Grip_Touch}},
+    {"/input/grip/value",             cxrInputValueType_float32, {AnalogAxis_Grip, AnalogAxis_Grip}},
+    {"/input/joystick/click",         cxrInputValueType_boolean, {DigitalButton_Joystick_Click, DigitalButton_Joystick_Click}},
+    {"/input/joystick/touch",         cxrInputValueType_boolean, {DigitalButton_Joystick_Touch, DigitalButton_Joystick_Touch}},
+    {"/input/joystick/x",             cxrInputValueType_float32, {AnalogAxis_JoystickX, AnalogAxis_JoystickX}},
+    {"/input/joystick/y",             cxrInputValueType_float32, {AnalogAxis_JoystickY, AnalogAxis_JoystickY}},
+    {"/input/a/click",                cxrInputValueType_boolean, {INVALID_INDEX, DigitalButton_A_Click}},
+    {"/input/b/click",                cxrInputValueType_boolean, {INVALID_INDEX, DigitalButton_B_Click}},
+    {"/input/x/click",                cxrInputValueType_boolean, {DigitalButton_A_Click, INVALID_INDEX}},
+    {"/input/y/click",                cxrInputValueType_boolean, {DigitalButton_B_Click, INVALID_INDEX}},
+    {"/input/a/touch",                cxrInputValueType_boolean, {INVALID_INDEX, DigitalButton_A_Touch}},
+    {"/input/b/touch",                cxrInputValueType_boolean, {INVALID_INDEX, DigitalButton_B_Touch}},
+    {"/input/x/touch",                cxrInputValueType_boolean, {DigitalButton_A_Touch, INVALID_INDEX}},
+    {"/input/y/touch",                cxrInputValueType_boolean, {DigitalButton_B_Touch, INVALID_INDEX}},
+    {"/input/thumb_rest/touch",       cxrInputValueType_boolean, {DigitalButton_Touchpad_Touch, DigitalButton_Touchpad_Touch}},
+};
+
+constexpr uint32_t NUM_INPUT_BINDINGS = ARRAY_SIZE(input_bindings);
+
+// OpenXR action -> OK input, read every poll. Member pointers so the table itself is constexpr.
+struct OKDigitalActionBinding
+{
+    XrAction OKOpenXRControllerActions::* action_;
+    DigitalButtonID digital_button_id_;
+};
+
+struct OKAnalogActionBinding
+{
+    XrAction OKOpenXRControllerActions::* action_;
+    AnalogAxisID analog_axis_id_;
+};
+
+constexpr OKDigitalActionBinding digital_action_bindings[] =
+{
+    {&OKOpenXRControllerActions::menuClickAction,       DigitalButton_ApplicationMenu},
+    {&OKOpenXRControllerActions::triggerTouchAction,    DigitalButton_Trigger_Touch},
+    {&OKOpenXRControllerActions::triggerClickAction,    DigitalButton_Trigger_Click},
+    //{&OKOpenXRControllerActions::squeezeTouchAction,  DigitalButton_Grip_Touch},
+    {&OKOpenXRControllerActions::squeezeClickAction,    DigitalButton_Grip_Click},
+    {&OKOpenXRControllerActions::thumbstickTouchAction, DigitalButton_Joystick_Touch},
+    {&OKOpenXRControllerActions::thumbstickClickAction, DigitalButton_Joystick_Click},
+    //{&OKOpenXRControllerActions::thumbRestTouchAction, DigitalButton_Touchpad_Touch},
+    //{&OKOpenXRControllerActions::thumbRestClickAction, DigitalButton_Touchpad_Click},
+    {&OKOpenXRControllerActions::buttonAXTouchAction,   DigitalButton_A_Touch},
+    {&OKOpenXRControllerActions::buttonAXClickAction,   DigitalButton_A_Click},
+    {&OKOpenXRControllerActions::buttonBYTouchAction,   DigitalButton_B_Touch},
+    {&OKOpenXRControllerActions::buttonBYClickAction,   DigitalButton_B_Click},
+};
+
+constexpr OKAnalogActionBinding analog_action_bindings[] =
+{
+    {&OKOpenXRControllerActions::triggerValueAction,   AnalogAxis_Trigger},
+    {&OKOpenXRControllerActions::squeezeValueAction,   AnalogAxis_Grip},
+    {&OKOpenXRControllerActions::thumbstickXAction,    AnalogAxis_JoystickX},
+    {&OKOpenXRControllerActions::thumbstickYAction,    AnalogAxis_JoystickY},
+    {&OKOpenXRControllerActions::thumbProximityAction, AnalogAxis_Proximity},
+    {&OKOpenXRControllerActions::thumbRestForceAction, AnalogAxis_Grip_Force},
+    //{&OKOpenXRControllerActions::trackpadXAction,    AnalogAxis_JoystickX},
+    //{&OKOpenXRControllerActions::trackpadYAction,    AnalogAxis_JoystickY},
+};
+
+// Everything below is generated from the tables above at compile time, the built-in profile runs on it
+
+struct OKInputPathOp
+{
+    uint8_t source_id_;
+    uint8_t cxr_path_id_;
+};
+
+// Dense list of the bound paths of one value type for one hand, so the per-poll loops have no skips
+struct OKInputPathOps
+{
+    uint32_t count_ = 0;
+    OKInputPathOp ops_[NUM_INPUT_BINDINGS] = {};
+};
+
+constexpr std::array<const char*, NUM_INPUT_BINDINGS> make_input_paths()
+{
+    std::array<const char*, NUM_INPUT_BINDINGS> input_paths = {};
+
+    for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+    {
+        input_paths[path_id] = input_bindings[path_id].cxr_path_;
+    }
+
+    return input_paths;
+}
+
+constexpr std::array<cxrInputValueType, NUM_INPUT_BINDINGS> make_input_value_types()
+{
+    std::array<cxrInputValueType, NUM_INPUT_BINDINGS> input_value_types = {};
+
+    for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+    {
+        input_value_types[path_id] = input_bindings[path_id].value_type_;
+    }
+
+    return input_value_types;
+}
+
+constexpr OKInputPathOps make_input_path_ops(const int controller_id, const cxrInputValueType value_type)
+{
+    OKInputPathOps path_ops = {};
+
+    for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+    {
+        const OKInputBinding& binding = input_bindings[path_id];
+
+        if ((binding.value_type_ == value_type) && (binding.source_ids_[controller_id] != INVALID_INDEX))
+        {
+            OKInputPathOp& path_op = path_ops.ops_[path_ops.count_++];
+            path_op.source_id_ = (uint8_t)binding.source_ids_[controller_id];
+            path_op.cxr_path_id_ = (uint8_t)path_id;
+        }
+    }
+
+    return path_ops;
+}
+
+inline constexpr std::array<const char*, NUM_INPUT_BINDINGS> cxr_input_paths = make_input_paths();
+inline constexpr std::array<cxrInputValueType, NUM_INPUT_BINDINGS> cxr_input_value_types = make_input_value_types();
+
+inline constexpr OKInputPathOps digital_path_ops[NUM_CONTROLLERS] =
+{
+    make_input_path_ops(LEFT_CONTROLLER, cxrInputValueType_boolean),
+    make_input_path_ops(RIGHT_CONTROLLER, cxrInputValueType_boolean)
+};
+
+inline constexpr OKInputPathOps analog_path_ops[NUM_CONTROLLERS] =
+{
+    make_input_path_ops(LEFT_CONTROLLER, cxrInputValueType_float32),
+    make_input_path_ops(RIGHT_CONTROLLER, cxrInputValueType_float32)
+};
+
+// Compile-time validation of the binding set
+
+constexpr bool are_strings_equal(const char* a, const char* b)
+{
+    while (*a && (*a == *b))
+    {
+        a++;
+        b++;
+    }
+
+    return (*a == *b);
+}
+
+constexpr bool are_input_paths_unique()
+{
+    for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+    {
+        for (uint32_t other_id = path_id + 1; other_id < NUM_INPUT_BINDINGS; other_id++)
+        {
+            if (are_strings_equal(input_bindings[path_id].cxr_path_, input_bindings[other_id].cxr_path_))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+constexpr bool are_input_sources_valid()
+{
+    for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+    {
+        const OKInputBinding& binding = input_bindings[path_id];
+
+        if ((binding.value_type_ != cxrInputValueType_boolean) && (binding.value_type_ != cxrInputValueType_float32))
+        {
+            return false;
+        }
+
+        const int source_count = (binding.value_type_ == cxrInputValueType_boolean) ? (int)DIGITAL_BUTTON_COUNT : (int)ANALOG_AXIS_COUNT;
+
+        for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+        {
+            const int source_id = binding.source_ids_[controller_id];
+
+            if ((source_id != INVALID_INDEX) && ((source_id < 0) || (source_id >= source_count)))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// A source feeding two paths on the same hand would send two events per change
+constexpr bool are_input_sources_unique()
+{
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        for (uint32_t path_id = 0; path_id < NUM_INPUT_BINDINGS; path_id++)
+        {
+            const OKInputBinding& binding = input_bindings[path_id];
+
+            if (binding.source_ids_[controller_id] == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            for (uint32_t other_id = path_id + 1; other_id < NUM_INPUT_BINDINGS; other_id++)
+            {
+                const OKInputBinding& other_binding = input_bindings[other_id];
+
+                if ((other_binding.value_type_ == binding.value_type_) && (other_binding.source_ids_[controller_id] == binding.source_ids_[controller_id]))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static_assert(NUM_INPUT_BINDINGS <= MAX_CLOUDXR_INPUT_PATHS, "Too many CloudXR input paths for OKControllerEventBatch");
+static_assert(NUM_INPUT_BINDINGS <= 256, "CloudXR path ids are stored as uint8_t");
+static_assert(DIGITAL_BUTTON_COUNT <= 256 && ANALOG_AXIS_COUNT <= 256, "Input source ids are stored as uint8_t in OKInputPathOp / OKInputOp");
+static_assert(are_input_paths_unique(), "Duplicate CloudXR input path in input_bindings");
+static_assert(are_input_sources_valid(), "input_bindings has an unsupported value type or out of range source id");
+static_assert(are_input_sources_unique(), "An input source is bound to more than one CloudXR path on the same hand");
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_INPUT_BINDINGS_H
+
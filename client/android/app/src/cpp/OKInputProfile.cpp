@@ -0,0 +1,581 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKInputProfile.h"
+#include "OKInputBindings.h"
+#include "OKConfig.h"
+
+#include <json/json.h>
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <utility>
+
+namespace BVR
+{
+
+static const char* digital_button_names[] =
+{
+    "system",
+    "application_menu",
+    "trigger_touch",
+    "trigger_click",
+    "grip_touch",
+    "grip_click",
+    "touchpad_touch",
+    "touchpad_click",
+    "joystick_touch",
+    "joystick_click",
+    "a_touch",
+    "a_click",
+    "b_touch",
+    "b_click",
+};
+
+static const char* analog_axis_names[] =
+{
+    "trigger",
+    "touchpad_x",
+    "touchpad_y",
+    "joystick_x",
+    "joystick_y",
+    "grip",
+    "grip_force",
+    "proximity",
+};
+
+static_assert(ARRAY_SIZE(digital_button_names) == DIGITAL_BUTTON_COUNT, "digital_button_names out of sync with DigitalButtonID");
+static_assert(ARRAY_SIZE(analog_axis_names) == ANALOG_AXIS_COUNT, "analog_axis_names out of sync with AnalogAxisID");
+
+static int find_name(const char* const* names, const int name_count, const std::string& name)
+{
+    for (int name_id = 0; name_id < name_count; name_id++)
+    {
+        if (name == names[name_id])
+        {
+            return name_id;
+        }
+    }
+
+    return INVALID_INDEX;
+}
+
+static int find_digital_button(const std::string& name)
+{
+    return find_name(digital_button_names, DIGITAL_BUTTON_COUNT, name);
+}
+
+static int find_analog_axis(const std::string& name)
+{
+    return find_name(analog_axis_names, ANALOG_AXIS_COUNT, name);
+}
+
+static int parse_controller_mask(const Json::Value& transform_value)
+{
+    const std::string hands = transform_value.get("hands", "both").asString();
+
+    if (hands == "left")
+    {
+        return (1 << LEFT_CONTROLLER);
+    }
+    else if (hands == "right")
+    {
+        return (1 << RIGHT_CONTROLLER);
+    }
+
+    return (1 << LEFT_CONTROLLER) | (1 << RIGHT_CONTROLLER);
+}
+
+OKInputProfile::OKInputProfile()
+{
+    compile_default(COMBINE_GRIP_FORCE_WITH_GRIP, SIMULATE_GRIP_TOUCH, SIMULATE_THUMB_REST, ENABLE_SWAP_THUMBSTICKS);
+}
+
+void OKInputProfile::reset_sources(OKInputLayout& layout)
+{
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        for (int button_id = 0; button_id < DIGITAL_BUTTON_COUNT; button_id++)
+        {
+            layout.digital_sources_[controller_id][button_id] = {controller_id, button_id};
+        }
+
+        for (int axis_id = 0; axis_id < ANALOG_AXIS_COUNT; axis_id++)
+        {
+            layout.analog_sources_[controller_id][axis_id] = {controller_id, axis_id};
+        }
+    }
+}
+
+void OKInputProfile::swap_sources(OKInputLayout& layout, const bool is_analog, const int a, const int b, const int controller_mask, const bool across_hands)
+{
+    if (across_hands)
+    {
+        OKInputSource* left_sources = is_analog ? layout.analog_sources_[LEFT_CONTROLLER] : layout.digital_sources_[LEFT_CONTROLLER];
+        OKInputSource* right_sources = is_analog ? layout.analog_sources_[RIGHT_CONTROLLER] : layout.digital_sources_[RIGHT_CONTROLLER];
+        std::swap(left_sources[a], right_sources[a]);
+        return;
+    }
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        if (controller_mask & (1 << controller_id))
+        {
+            OKInputSource* sources = is_analog ? layout.analog_sources_[controller_id] : layout.digital_sources_[controller_id];
+            std::swap(sources[a], sources[b]);
+        }
+    }
+}
+
+void OKInputProfile::compile_default(const bool combine_grip_force_with_grip, const bool simulate_grip_touch, const bool simulate_thumb_rest, const bool swap_thumbsticks)
+{
+    // Nothing to compile, the tables are constexpr, the flags are applied as the path ops run
+    is_default_ = true;
+    combine_grip_force_with_grip_ = combine_grip_force_with_grip;
+    simulate_grip_touch_ = simulate_grip_touch;
+    simulate_thumb_rest_ = simulate_thumb_rest;
+    swap_thumbsticks_ = swap_thumbsticks;
+
+    controller_name_ = CLOUDXR_CONTROLLER_NAME;
+    input_paths_.clear();
+    input_path_ptrs_.clear();
+    input_value_types_.clear();
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        ops_[controller_id].clear();
+    }
+}
+
+uint32_t OKInputProfile::get_input_count() const
+{
+    return is_default_ ? NUM_INPUT_BINDINGS : (uint32_t)input_path_ptrs_.size();
+}
+
+const char** OKInputProfile::get_input_paths()
+{
+    return is_default_ ? const_cast<const char**>(cxr_input_paths.data()) : input_path_ptrs_.data();
+}
+
+const cxrInputValueType* OKInputProfile::get_input_value_types() const
+{
+    return is_default_ ? cxr_input_value_types.data() : input_value_types_.data();
+}
+
+bool OKInputProfile::load(const std::string& filename, const std::string& profile_name)
+{
+    std::string profiles_json;
+
+    if (profile_name.empty() || !read_file(filename, profiles_json) || profiles_json.empty())
+    {
+        return false;
+    }
+
+    JSONCPP_STRING err;
+    Json::Value root;
+
+    Json::CharReaderBuilder builder;
+    const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    if (!reader->parse(profiles_json.c_str(), profiles_json.c_str() + profiles_json.size(), &root, &err))
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Error parsing %s: %s\n", filename.c_str(), err.c_str());
+        return false;
+    }
+
+    if (!root.isMember(profile_name))
+    {
+        //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - No profile named %s\n", profile_name.c_str());
+        return false;
+    }
+
+    const Json::Value& profile_value = root[profile_name];
+
+    if (!profile_value.isObject())
+    {
+        return false;
+    }
+
+    OKInputLayout layout;
+    layout.controller_name_ = profile_value.get("controller_name", CLOUDXR_CONTROLLER_NAME).asString();
+
+    const Json::Value& inputs_value = profile_value["inputs"];
+
+    if (!inputs_value.isArray() || (inputs_value.size() == 0))
+    {
+        return false;
+    }
+
+    static const char* hand_keys[NUM_CONTROLLERS] = {"left", "right"};
+
+    for (const Json::Value& input_value : inputs_value)
+    {
+        const std::string type_name = input_value.get("type", "boolean").asString();
+        const bool is_analog = (type_name == "float32");
+
+        const std::string input_path = input_value.get("path", "").asString();
+
+        if (!is_analog && (type_name != "boolean"))
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Unsupported input type %s on %s\n", type_name.c_str(), input_path.c_str());
+            return false;
+        }
+
+        if (input_path.empty())
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Input without a path in %s\n", profile_name.c_str());
+            return false;
+        }
+
+        layout.input_paths_.push_back(input_path);
+        layout.input_value_types_.push_back(is_analog ? cxrInputValueType_float32 : cxrInputValueType_boolean);
+
+        for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+        {
+            // No key or "" leaves the path unbound on that hand, a name that isn't a source is a typo
+            const std::string source_name = input_value.get(hand_keys[controller_id], "").asString();
+            const int source_id = is_analog ? find_analog_axis(source_name) : find_digital_button(source_name);
+
+            if (!source_name.empty() && (source_id == INVALID_INDEX))
+            {
+                //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Unknown %s source %s on %s\n", type_name.c_str(), source_name.c_str(), input_path.c_str());
+                return false;
+            }
+
+            layout.source_ids_[controller_id].push_back(source_id);
+        }
+    }
+
+    reset_sources(layout);
+
+    const Json::Value& transforms_value = profile_value["transforms"];
+
+    if (!transforms_value.isNull() && !transforms_value.isArray())
+    {
+        return false;
+    }
+
+    for (const Json::Value& transform_value : transforms_value)
+    {
+        const std::string op_name = transform_value.get("op", "").asString();
+        const std::string input_name = transform_value.get("input", "").asString();
+        const std::string hands = transform_value.get("hands", "both").asString();
+        const int controller_mask = parse_controller_mask(transform_value);
+
+        const int analog_axis_id = find_analog_axis(input_name);
+        const int digital_button_id = find_digital_button(input_name);
+
+        if ((hands != "both") && (hands != "left") && (hands != "right"))
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Unknown hands %s on %s %s\n", hands.c_str(), op_name.c_str(), input_name.c_str());
+            return false;
+        }
+
+        if (op_name == "swap")
+        {
+            const bool across_hands = transform_value.get("across_hands", 0).asBool();
+            const std::string other_name = transform_value.get("with", input_name).asString();
+
+            const bool is_analog = (analog_axis_id != INVALID_INDEX);
+            const int other_id = is_analog ? find_analog_axis(other_name) : find_digital_button(other_name);
+
+            if (((analog_axis_id == INVALID_INDEX) && (digital_button_id == INVALID_INDEX)) || (other_id == INVALID_INDEX))
+            {
+                //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Can't swap %s with %s\n", input_name.c_str(), other_name.c_str());
+                return false;
+            }
+
+            swap_sources(layout, is_analog, is_analog ? analog_axis_id : digital_button_id, other_id, controller_mask, across_hands);
+            continue;
+        }
+
+        OKInputTransform transform;
+        transform.controller_mask_ = controller_mask;
+        transform.param_ = transform_value.get("value", 0.0f).asFloat();
+
+        if (op_name == "threshold")
+        {
+            transform.op_code_ = InputOp_Threshold;
+            transform.dst_ = digital_button_id;
+            transform.src_ = find_analog_axis(transform_value.get("from", "").asString());
+        }
+        else
+        {
+            transform.dst_ = analog_axis_id;
+            transform.src_ = analog_axis_id;
+
+            if (op_name == "invert")
+            {
+                transform.op_code_ = InputOp_Invert;
+            }
+            else if (op_name == "deadzone")
+            {
+                transform.op_code_ = InputOp_Deadzone;
+                transform.param_ = clamp(transform.param_, 0.0f, 0.99f);
+            }
+            else if (op_name == "curve")
+            {
+                transform.op_code_ = InputOp_Curve;
+                transform.param_ = std::max(transform.param_, 0.01f);
+            }
+            else if (op_name == "combine")
+            {
+                transform.op_code_ = InputOp_Combine;
+                transform.src_ = find_analog_axis(transform_value.get("with", "").asString());
+            }
+        }
+
+        if ((transform.op_code_ == INPUT_OP_COUNT) || (transform.dst_ == INVALID_INDEX) || (transform.src_ == INVALID_INDEX))
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "OKInputProfile::load - Invalid transform %s on %s\n", op_name.c_str(), input_name.c_str());
+            return false;
+        }
+
+        layout.transforms_.push_back(transform);
+    }
+
+    return compile(layout);
+}
+
+bool OKInputProfile::compile(const OKInputLayout& layout)
+{
+    const uint32_t input_count = (uint32_t)layout.input_paths_.size();
+
+    if ((input_count == 0) || (input_count > MAX_CLOUDXR_INPUT_PATHS))
+    {
+        return false;
+    }
+
+    for (const std::string& input_path : layout.input_paths_)
+    {
+        if (input_path.empty())
+        {
+            return false;
+        }
+    }
+
+    std::vector<OKInputOp> ops[NUM_CONTROLLERS];
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        bool digital_used[DIGITAL_BUTTON_COUNT] = {};
+        bool analog_used[ANALOG_AXIS_COUNT] = {};
+
+        for (uint32_t path_id = 0; path_id < input_count; path_id++)
+        {
+            const int source_id = layout.source_ids_[controller_id][path_id];
+
+            if (source_id == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            if (layout.input_value_types_[path_id] == cxrInputValueType_float32)
+            {
+                analog_used[source_id] = true;
+            }
+            else
+            {
+                digital_used[source_id] = true;
+            }
+        }
+
+        for (const OKInputTransform& transform : layout.transforms_)
+        {
+            if (transform.controller_mask_ & (1 << controller_id))
+            {
+                analog_used[transform.src_] = true;
+
+                if (transform.op_code_ != InputOp_Threshold)
+                {
+                    analog_used[transform.dst_] = true;
+                }
+            }
+        }
+
+        // Loads first, so every register a later op touches holds this poll's value
+        for (int button_id = 0; button_id < DIGITAL_BUTTON_COUNT; button_id++)
+        {
+            if (digital_used[button_id])
+            {
+                const OKInputSource& source = layout.digital_sources_[controller_id][button_id];
+                ops[controller_id].push_back({InputOp_LoadDigital, (uint8_t)button_id, (uint8_t)source.source_id_, (uint8_t)source.controller_id_, 0.0f});
+            }
+        }
+
+        for (int axis_id = 0; axis_id < ANALOG_AXIS_COUNT; axis_id++)
+        {
+            if (analog_used[axis_id])
+            {
+                const OKInputSource& source = layout.analog_sources_[controller_id][axis_id];
+                ops[controller_id].push_back({InputOp_LoadAnalog, (uint8_t)axis_id, (uint8_t)source.source_id_, (uint8_t)source.controller_id_, 0.0f});
+            }
+        }
+
+        for (const OKInputTransform& transform : layout.transforms_)
+        {
+            if (transform.controller_mask_ & (1 << controller_id))
+            {
+                ops[controller_id].push_back({(uint8_t)transform.op_code_, (uint8_t)transform.dst_, (uint8_t)transform.src_, (uint8_t)controller_id, transform.param_});
+            }
+        }
+
+        for (uint32_t path_id = 0; path_id < input_count; path_id++)
+        {
+            const int source_id = layout.source_ids_[controller_id][path_id];
+
+            if (source_id == INVALID_INDEX)
+            {
+                continue;
+            }
+
+            const bool is_analog = (layout.input_value_types_[path_id] == cxrInputValueType_float32);
+            ops[controller_id].push_back({(uint8_t)(is_analog ? InputOp_EmitFloat : InputOp_EmitBoolean), (uint8_t)path_id, (uint8_t)source_id, (uint8_t)controller_id, 0.0f});
+        }
+    }
+
+    is_default_ = false;
+    controller_name_ = layout.controller_name_;
+    input_paths_ = layout.input_paths_;
+    input_value_types_ = layout.input_value_types_;
+
+    input_path_ptrs_.clear();
+
+    for (const std::string& input_path : input_paths_)
+    {
+        input_path_ptrs_.push_back(input_path.c_str());
+    }
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        ops_[controller_id].swap(ops[controller_id]);
+    }
+
+    return true;
+}
+
+void OKInputProfile::execute_default(const int controller_id, const OKController* controllers, OKControllerEventBatch& event_batch) const
+{
+    const OKController& controller = controllers[controller_id];
+
+    // Swapped sticks are read from the other hand
+    const OKController& thumbstick_controller = swap_thumbsticks_ ? controllers[(controller_id == LEFT_CONTROLLER) ? RIGHT_CONTROLLER : LEFT_CONTROLLER] : controller;
+
+    const float grip_force = controller.analog_axes_[AnalogAxis_Grip_Force].get_current_value();
+    float grip = controller.analog_axes_[AnalogAxis_Grip].get_current_value();
+
+    if (combine_grip_force_with_grip_)
+    {
+        grip = clamp(grip + grip_force, MIN_ANALOG_AXIS_VALUE, MAX_ANALOG_AXIS_VALUE);
+    }
+
+    const OKInputPathOps& analog_ops = analog_path_ops[controller_id];
+
+    for (uint32_t op_id = 0; op_id < analog_ops.count_; op_id++)
+    {
+        const OKInputPathOp& path_op = analog_ops.ops_[op_id];
+        float value = 0.0f;
+
+        switch (path_op.source_id_)
+        {
+            case AnalogAxis_Grip:
+                value = grip;
+                break;
+            case AnalogAxis_JoystickX:
+            case AnalogAxis_JoystickY:
+                value = thumbstick_controller.analog_axes_[path_op.source_id_].get_current_value();
+                break;
+            default:
+                value = controller.analog_axes_[path_op.source_id_].get_current_value();
+                break;
+        }
+
+        event_batch.set_float(path_op.cxr_path_id_, value);
+    }
+
+    const OKInputPathOps& digital_ops = digital_path_ops[controller_id];
+
+    for (uint32_t op_id = 0; op_id < digital_ops.count_; op_id++)
+    {
+        const OKInputPathOp& path_op = digital_ops.ops_[op_id];
+        bool is_down = false;
+
+        switch (path_op.source_id_)
+        {
+            case DigitalButton_Grip_Touch:
+                is_down = simulate_grip_touch_ ? (grip > 0.0f) : controller.digital_buttons_[path_op.source_id_].is_down();
+                break;
+            case DigitalButton_Touchpad_Touch:
+                is_down = simulate_thumb_rest_ ? (grip_force > 0.0f) : controller.digital_buttons_[path_op.source_id_].is_down();
+                break;
+            case DigitalButton_Joystick_Click:
+            case DigitalButton_Joystick_Touch:
+                is_down = thumbstick_controller.digital_buttons_[path_op.source_id_].is_down();
+                break;
+            default:
+                is_down = controller.digital_buttons_[path_op.source_id_].is_down();
+                break;
+        }
+
+        event_batch.set_boolean(path_op.cxr_path_id_, is_down);
+    }
+}
+
+void OKInputProfile::execute(const int controller_id, const OKController* controllers, OKControllerEventBatch& event_batch) const
+{
+    if (is_default_)
+    {
+        execute_default(controller_id, controllers, event_batch);
+        return;
+    }
+
+    bool digital[DIGITAL_BUTTON_COUNT] = {};
+    float analog[ANALOG_AXIS_COUNT] = {};
+
+    for (const OKInputOp& op : ops_[controller_id])
+    {
+        switch (op.op_code_)
+        {
+            case InputOp_LoadDigital:
+                digital[op.dst_] = controllers[op.src_controller_].digital_buttons_[op.src_].is_down();
+                break;
+            case InputOp_LoadAnalog:
+                analog[op.dst_] = controllers[op.src_controller_].analog_axes_[op.src_].get_current_value();
+                break;
+            case InputOp_Invert:
+                analog[op.dst_] = -analog[op.dst_];
+                break;
+            case InputOp_Deadzone:
+            {
+                const float magnitude = fabsf(analog[op.dst_]);
+                analog[op.dst_] = (magnitude <= op.param_) ? 0.0f : sign(analog[op.dst_]) * (magnitude - op.param_) / (1.0f - op.param_);
+                break;
+            }
+            case InputOp_Curve:
+                analog[op.dst_] = sign(analog[op.dst_]) * powf(fabsf(analog[op.dst_]), op.param_);
+                break;
+            case InputOp_Combine:
+                analog[op.dst_] = clamp(analog[op.dst_] + analog[op.src_], MIN_ANALOG_AXIS_VALUE, MAX_ANALOG_AXIS_VALUE);
+                break;
+            case InputOp_Threshold:
+                digital[op.dst_] = (analog[op.src_] > op.param_);
+                break;
+            case InputOp_EmitBoolean:
+                event_batch.set_boolean(op.dst_, digital[op.src_]);
+                break;
+            case InputOp_EmitFloat:
+                event_batch.set_float(op.dst_, analog[op.src_]);
+                break;
+        }
+    }
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
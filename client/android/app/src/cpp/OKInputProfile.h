@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_INPUT_PROFILE_H
+#define OK_INPUT_PROFILE_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKController.h"
+#include "OKControllerEventBatch.h"
+
+#include <CloudXRCommon.h>
+
+#include <string>
+#include <vector>
+
+namespace BVR
+{
+
+typedef enum
+{
+    InputOp_LoadDigital,   // digital[dst] = controllers[src_controller].digital_buttons_[src]
+    InputOp_LoadAnalog,    // analog[dst] = controllers[src_controller].analog_axes_[src]
+    InputOp_Invert,        // analog[dst] = -analog[dst]
+    InputOp_Deadzone,      // analog[dst] = 0 inside param, rescaled to full range outside
+    InputOp_Curve,         // analog[dst] = sign * |analog[dst]|^param
+    InputOp_Combine,       // analog[dst] = clamp(analog[dst] + analog[src])
+    InputOp_Threshold,     // digital[dst] = analog[src] > param
+    InputOp_EmitBoolean,   // event on path dst = digital[src]
+    InputOp_EmitFloat,     // event on path dst = analog[src]
+
+    INPUT_OP_COUNT
+} OKInputOpCode;
+
+struct OKInputOp
+{
+    uint8_t op_code_ = InputOp_LoadDigital;
+    uint8_t dst_ = 0;
+    uint8_t src_ = 0;
+    uint8_t src_controller_ = 0;
+    float param_ = 0.0f;
+};
+
+// A controller layout plus per-input transforms. The built-in layout runs straight off the
+// constexpr path ops in OKInputBindings.h. JSON profiles are compiled once, at load, into a flat
+// op list per hand, run over a small register file, so remapping costs nothing per poll and no
+// names are looked up after load.
+class OKInputProfile
+{
+public:
+    OKInputProfile();
+
+    // Built-in Oculus Touch layout from OKInputBindings.h, with the transforms the ok_defines / config flags ask for
+    void compile_default(const bool combine_grip_force_with_grip, const bool simulate_grip_touch, const bool simulate_thumb_rest, const bool swap_thumbsticks);
+
+    // Looks up profile_name in a JSON file of named profiles. Any entry it can't use (unknown type,
+    // source, op or hand, empty path) fails the whole load and leaves the current profile untouched.
+    bool load(const std::string& filename, const std::string& profile_name);
+
+    void execute(const int controller_id, const OKController* controllers, OKControllerEventBatch& event_batch) const;
+
+    bool is_default() const
+    {
+        return is_default_;
+    }
+
+    const char* get_controller_name() const
+    {
+        return controller_name_.c_str();
+    }
+
+    uint32_t get_input_count() const;
+    const char** get_input_paths();
+    const cxrInputValueType* get_input_value_types() const;
+
+private:
+    struct OKInputSource
+    {
+        int controller_id_ = 0;
+        int source_id_ = INVALID_INDEX;
+    };
+
+    struct OKInputTransform
+    {
+        OKInputOpCode op_code_ = INPUT_OP_COUNT;
+        int controller_mask_ = 0x3;
+        int dst_ = INVALID_INDEX;
+        int src_ = INVALID_INDEX;
+        float param_ = 0.0f;
+    };
+
+    struct OKInputLayout
+    {
+        std::string controller_name_;
+        std::vector<std::string> input_paths_;
+        std::vector<cxrInputValueType> input_value_types_;
+        std::vector<int> source_ids_[NUM_CONTROLLERS];
+
+        // Where each hand reads each source from, rearranged by swaps
+        OKInputSource digital_sources_[NUM_CONTROLLERS][DIGITAL_BUTTON_COUNT];
+        OKInputSource analog_sources_[NUM_CONTROLLERS][ANALOG_AXIS_COUNT];
+
+        std::vector<OKInputTransform> transforms_;
+    };
+
+    static void reset_sources(OKInputLayout& layout);
+    static void swap_sources(OKInputLayout& layout, const bool is_analog, const int a, const int b, const int controller_mask, const bool across_hands);
+
+    bool compile(const OKInputLayout& layout);
+
+    void execute_default(const int controller_id, const OKController* controllers, OKControllerEventBatch& event_batch) const;
+
+    // Built-in layout
+    bool is_default_ = true;
+    bool combine_grip_force_with_grip_ = COMBINE_GRIP_FORCE_WITH_GRIP;
+    bool simulate_grip_touch_ = SIMULATE_GRIP_TOUCH;
+    bool simulate_thumb_rest_ = SIMULATE_THUMB_REST;
+    bool swap_thumbsticks_ = ENABLE_SWAP_THUMBSTICKS;
+
+    // JSON profile
+    std::string controller_name_;
+    std::vector<std::string> input_paths_;
+    std::vector<const char*> input_path_ptrs_;
+    std::vector<cxrInputValueType> input_value_types_;
+
+    std::vector<OKInputOp> ops_[NUM_CONTROLLERS];
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_INPUT_PROFILE_H
+
@@ -0,0 +1,155 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+#include "OKLatencyHistogram.h"
+
+namespace BVR
+{
+
+OKLatencyHistogram::OKLatencyHistogram()
+{
+    reset();
+}
+
+void OKLatencyHistogram::record(const uint64_t duration_ns)
+{
+    buckets_[get_bucket_id(duration_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+
+    uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+
+    while ((duration_ns > max_ns) && !max_ns_.compare_exchange_weak(max_ns, duration_ns, std::memory_order_relaxed))
+    {
+    }
+}
+
+void OKLatencyHistogram::reset()
+{
+    for (uint32_t bucket_id = 0; bucket_id < NUM_LATENCY_HISTOGRAM_BUCKETS; bucket_id++)
+    {
+        buckets_[bucket_id].store(0, std::memory_order_relaxed);
+    }
+
+    count_.store(0, std::memory_order_relaxed);
+    total_ns_.store(0, std::memory_order_relaxed);
+    max_ns_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t OKLatencyHistogram::get_count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t OKLatencyHistogram::get_max_ns() const
+{
+    return max_ns_.load(std::memory_order_relaxed);
+}
+
+float OKLatencyHistogram::get_mean_ns() const
+{
+    const uint64_t count = get_count();
+
+    if (count == 0)
+    {
+        return 0.0f;
+    }
+
+    return (float)((double)total_ns_.load(std::memory_order_relaxed) / (double)count);
+}
+
+uint64_t OKLatencyHistogram::get_percentile_ns(const float percentile) const
+{
+    const uint64_t count = get_count();
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const float clamped_percentile = (percentile < 0.0f) ? 0.0f : ((percentile > 1.0f) ? 1.0f : percentile);
+    const double target_count = (double)clamped_percentile * (double)count;
+    const uint64_t max_ns = get_max_ns();
+    uint64_t running_count = 0;
+
+    for (uint32_t bucket_id = 0; bucket_id < NUM_LATENCY_HISTOGRAM_BUCKETS; bucket_id++)
+    {
+        const uint64_t bucket_count = get_bucket_count(bucket_id);
+
+        if ((bucket_count == 0) || ((double)(running_count + bucket_count) < target_count))
+        {
+            running_count += bucket_count;
+            continue;
+        }
+
+        // Assume the samples are spread evenly over the bucket
+        const double fraction = (target_count - (double)running_count) / (double)bucket_count;
+        const uint64_t percentile_ns = get_bucket_lower_bound_ns(bucket_id) + (uint64_t)(fraction * (double)get_bucket_width_ns(bucket_id));
+
+        return (percentile_ns < max_ns) ? percentile_ns : max_ns;
+    }
+
+    // Only reachable while another thread is recording, the count ran ahead of the buckets
+    return max_ns;
+}
+
+uint64_t OKLatencyHistogram::get_bucket_count(const uint32_t bucket_id) const
+{
+    if (bucket_id >= NUM_LATENCY_HISTOGRAM_BUCKETS)
+    {
+        return 0;
+    }
+
+    return buckets_[bucket_id].load(std::memory_order_relaxed);
+}
+
+uint32_t OKLatencyHistogram::get_bucket_id(const uint64_t duration_ns)
+{
+    if (duration_ns < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return (uint32_t)duration_ns;
+    }
+
+    const uint32_t msb = 63 - (uint32_t)__builtin_clzll(duration_ns);
+
+    if (msb > LATENCY_HISTOGRAM_MAX_MSB)
+    {
+        return NUM_LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+
+    // Octave msb starts at bucket (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT, the top
+    // SUB_BUCKET_BITS + 1 bits (leading 1 included) pick the sub-bucket
+    const uint32_t shift = msb - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    const uint32_t sub_bucket_id = (uint32_t)(duration_ns >> shift) - LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+    return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket_id;
+}
+
+uint64_t OKLatencyHistogram::get_bucket_lower_bound_ns(const uint32_t bucket_id)
+{
+    if (bucket_id < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return bucket_id;
+    }
+
+    const uint32_t shift = (bucket_id / LATENCY_HISTOGRAM_SUB_BUCKET_COUNT) - 1;
+    const uint64_t sub_bucket_id = bucket_id % LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+    return (LATENCY_HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket_id) << shift;
+}
+
+uint64_t OKLatencyHistogram::get_bucket_width_ns(const uint32_t bucket_id)
+{
+    if (bucket_id < LATENCY_HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return 1;
+    }
+
+    const uint32_t shift = (bucket_id / LATENCY_HISTOGRAM_SUB_BUCKET_COUNT) - 1;
+    return ((uint64_t)1 << shift);
+}
+
+} // namespace BVR
+
@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_LATENCY_HISTOGRAM_H
+#define OK_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace BVR
+{
+
+// Log-linear (HDR style) buckets: every power of two octave is split into 2^SUB_BUCKET_BITS
+// linear sub-buckets, so a bucket is never wider than 1/32 of its value. Durations below 32 ns
+// get one bucket per ns. Octaves up to 2^35 ns (~34 s) are kept, longer ones land in the last bucket.
+const uint32_t LATENCY_HISTOGRAM_SUB_BUCKET_BITS = 5;
+const uint32_t LATENCY_HISTOGRAM_SUB_BUCKET_COUNT = (1 << LATENCY_HISTOGRAM_SUB_BUCKET_BITS);
+const uint32_t LATENCY_HISTOGRAM_MAX_MSB = 35;
+const uint32_t NUM_LATENCY_HISTOGRAM_BUCKETS = (LATENCY_HISTOGRAM_MAX_MSB - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 2) * LATENCY_HISTOGRAM_SUB_BUCKET_COUNT;
+
+// Lock-free, allocation-free histogram, safe to record from any thread
+class OKLatencyHistogram
+{
+public:
+    OKLatencyHistogram();
+
+    void record(const uint64_t duration_ns);
+    void reset();
+
+    uint64_t get_count() const;
+    uint64_t get_max_ns() const;
+    float get_mean_ns() const;
+
+    // percentile in [0, 1], interpolated inside the matching bucket and never above get_max_ns()
+    uint64_t get_percentile_ns(const float percentile) const;
+
+    uint64_t get_bucket_count(const uint32_t bucket_id) const;
+    static uint32_t get_bucket_id(const uint64_t duration_ns);
+    static uint64_t get_bucket_lower_bound_ns(const uint32_t bucket_id);
+    static uint64_t get_bucket_width_ns(const uint32_t bucket_id);
+
+private:
+    std::atomic<uint64_t> buckets_[NUM_LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> count_ = {0};
+    std::atomic<uint64_t> total_ns_ = {0};
+    std::atomic<uint64_t> max_ns_ = {0};
+};
+
+} // namespace BVR
+
+#endif // OK_LATENCY_HISTOGRAM_H
+
@@ -7,28 +7,119 @@
 #include "OKPlayerState.h"
 #include "OKController.h"
 
+#include <math.h>
+
 namespace BVR 
 {
 
+static float wrap_angle_rad(const float angle_rad)
+{
+    return atan2f(sinf(angle_rad), cosf(angle_rad));
+}
+
+// Rotation about world +Y (swing-twist), 0 = facing -Z, positive turning left
+static float get_yaw_rad(const glm::fquat& rotation)
+{
+    return wrap_angle_rad(2.0f * atan2f(rotation.y, rotation.w));
+}
+
 OKPlayerState::OKPlayerState() : controllers_{{*this, LEFT_CONTROLLER}, {*this, RIGHT_CONTROLLER}}
 {
-	
+	hmd_pose_.is_valid_ = false;
+	hips_pose_.is_valid_ = false;
+	waist_pose_.is_valid_ = false;
 }
 
 bool OKPlayerState::init()
 {
+	reset_waist();
 	return true;
 }
 
 void OKPlayerState::shutdown()
 {
-	
+	reset_waist();
 }
 
-bool OKPlayerState::update()
+void OKPlayerState::reset_waist()
 {
+	waist_pose_.is_valid_ = false;
+	is_waist_calibrated_ = false;
+	calibration_start_time_ns_ = 0;
+	calibration_sin_sum_ = 0.0f;
+	calibration_cos_sum_ = 0.0f;
+	last_update_time_ns_ = 0;
+}
+
+bool OKPlayerState::update(const uint64_t time_ns)
+{
+	if (!hips_pose_.is_valid_ || !hmd_pose_.is_valid_)
+	{
+		reset_waist();
+		return false;
+	}
+
+	const float hips_yaw_rad = get_yaw_rad(hips_pose_.rotation_);
+
+	if (!is_waist_calibrated_)
+	{
+		if (calibration_start_time_ns_ == 0)
+		{
+			calibration_start_time_ns_ = time_ns;
+		}
+
+		// Circular mean, the offset can sit on the +-180 degree seam
+		const float offset_rad = get_yaw_rad(hmd_pose_.rotation_) - hips_yaw_rad;
+		calibration_sin_sum_ += sinf(offset_rad);
+		calibration_cos_sum_ += cosf(offset_rad);
+
+		if ((time_ns - calibration_start_time_ns_) < (uint64_t)(WAIST_CALIBRATION_MS * 1000000.0f))
+		{
+			return false;
+		}
+
+		hips_yaw_offset_rad_ = atan2f(calibration_sin_sum_, calibration_cos_sum_);
+		is_waist_calibrated_ = true;
+
+		waist_yaw_rad_ = wrap_angle_rad(hips_yaw_rad + hips_yaw_offset_rad_);
+		waist_pose_.translation_ = hips_pose_.translation_;
+	}
+	else
+	{
+		// Exponential smoothing with a time constant, so it behaves the same at any polling rate
+		const float delta_ms = (time_ns > last_update_time_ns_) ? ((float)(time_ns - last_update_time_ns_) / 1000000.0f) : 0.0f;
+		const float alpha = (waist_smoothing_ms_ > 0.0f) ? (1.0f - expf(-delta_ms / waist_smoothing_ms_)) : 1.0f;
+
+		const float target_yaw_rad = hips_yaw_rad + hips_yaw_offset_rad_;
+		waist_yaw_rad_ = wrap_angle_rad(waist_yaw_rad_ + alpha * wrap_angle_rad(target_yaw_rad - waist_yaw_rad_));
+		waist_pose_.translation_ += alpha * (hips_pose_.translation_ - waist_pose_.translation_);
+	}
+
+	waist_pose_.rotation_ = glm::angleAxis(waist_yaw_rad_, glm::vec3(0.0f, 1.0f, 0.0f));
+	waist_pose_.timestamp_ = time_ns;
+	waist_pose_.is_valid_ = true;
+
+	last_update_time_ns_ = time_ns;
 	return true;
 }
 
-} // namespace BVR
+void OKPlayerState::apply_waist_locomotion(float& x, float& y) const
+{
+	if (!waist_pose_.is_valid_ || !hmd_pose_.is_valid_)
+	{
+		return;
+	}
+
+	// Stick +Y is forward and +X right, a positive yaw turns forward towards -X
+	const float delta_yaw_rad = waist_yaw_rad_ - get_yaw_rad(hmd_pose_.rotation_);
+	const float cos_delta = cosf(delta_yaw_rad);
+	const float sin_delta = sinf(delta_yaw_rad);
+
+	const float waist_x = x * cos_delta - y * sin_delta;
+	const float waist_y = x * sin_delta + y * cos_delta;
 
+	x = clamp(waist_x, MIN_ANALOG_AXIS_VALUE, MAX_ANALOG_AXIS_VALUE);
+	y = clamp(waist_y, MIN_ANALOG_AXIS_VALUE, MAX_ANALOG_AXIS_VALUE);
+}
+
+} // namespace BVR
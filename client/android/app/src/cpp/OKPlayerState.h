@@ -5,6 +5,7 @@
 #ifndef OK_PLAYER_STATE_H
 #define OK_PLAYER_STATE_H
 
+#include "ok_defines.h"
 #include "GLMPose.h"
 #include "OKController.h"
 
@@ -19,15 +20,38 @@ public:
 	bool init();
 	void shutdown();
 	
-	bool update();
+	// Filters hips_pose_ into waist_pose_, both located for time_ns. False while the waist isn't
+	// valid: the body or the HMD isn't tracked, or the hips are still being calibrated.
+	bool update(const uint64_t time_ns);
+
+	// Rotates a thumbstick from the HMD's heading to the waist's, so pushing forward walks where
+	// the hips face rather than where the head looks. Left as is while the waist isn't valid.
+	void apply_waist_locomotion(float& x, float& y) const;
 
     OKController controllers_[NUM_CONTROLLERS];
 
     GLMPose hmd_pose_;
+    GLMPose hips_pose_;
     GLMPose waist_pose_;
+
+    float waist_smoothing_ms_ = WAIST_SMOOTHING_MS;
+
+private:
+	void reset_waist();
+
+	// Body joint frames are runtime specific, so the hips only provide a yaw (their twist about
+	// +Y) and the offset to the HMD's heading is averaged over WAIST_CALIBRATION_MS, with the user
+	// facing forward, each time the body is (re)acquired.
+	bool is_waist_calibrated_ = false;
+	uint64_t calibration_start_time_ns_ = 0;
+	float calibration_sin_sum_ = 0.0f;
+	float calibration_cos_sum_ = 0.0f;
+	float hips_yaw_offset_rad_ = 0.0f;
+
+	float waist_yaw_rad_ = 0.0f;
+	uint64_t last_update_time_ns_ = 0;
 };
 
 } // namespace BVR
 
 #endif // OK_PLAYER_STATE_H
-
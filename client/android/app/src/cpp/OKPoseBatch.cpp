@@ -0,0 +1,494 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKPoseBatch.h"
+
+#include <math.h>
+
+#if ENABLE_SIMD_POSE_BATCH && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define OK_POSE_BATCH_NEON 1
+#elif ENABLE_SIMD_POSE_BATCH && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define OK_POSE_BATCH_SSE 1
+#endif
+
+namespace BVR
+{
+
+static_assert(POSE_BATCH_LANES == 4, "OKPoseBatch kernels are written for 4-wide vectors");
+static_assert((MAX_POSE_BATCH_SIZE % POSE_BATCH_LANES) == 0, "OKPoseBatch arrays must hold whole groups of lanes");
+
+namespace
+{
+
+// Just the handful of 4-wide operations the kernels need, so each kernel is written once
+#if OK_POSE_BATCH_NEON
+typedef float32x4_t float4;
+
+inline float4 load4(const float* ptr) { return vld1q_f32(ptr); }
+inline void store4(float* ptr, const float4 value) { vst1q_f32(ptr, value); }
+inline float4 splat4(const float value) { return vdupq_n_f32(value); }
+inline float4 add4(const float4 a, const float4 b) { return vaddq_f32(a, b); }
+inline float4 sub4(const float4 a, const float4 b) { return vsubq_f32(a, b); }
+inline float4 mul4(const float4 a, const float4 b) { return vmulq_f32(a, b); }
+inline float4 madd4(const float4 a, const float4 b, const float4 c) { return vfmaq_f32(c, a, b); }
+inline float4 div4(const float4 a, const float4 b) { return vdivq_f32(a, b); }
+inline float4 sqrt4(const float4 a) { return vsqrtq_f32(a); }
+inline float4 max4(const float4 a, const float4 b) { return vmaxq_f32(a, b); }
+inline float4 copysign4(const float4 magnitude, const float4 sign) { return vbslq_f32(vdupq_n_u32(0x80000000u), sign, magnitude); }
+#elif OK_POSE_BATCH_SSE
+typedef __m128 float4;
+
+inline float4 load4(const float* ptr) { return _mm_load_ps(ptr); }
+inline void store4(float* ptr, const float4 value) { _mm_store_ps(ptr, value); }
+inline float4 splat4(const float value) { return _mm_set1_ps(value); }
+inline float4 add4(const float4 a, const float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub4(const float4 a, const float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul4(const float4 a, const float4 b) { return _mm_mul_ps(a, b); }
+inline float4 madd4(const float4 a, const float4 b, const float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline float4 div4(const float4 a, const float4 b) { return _mm_div_ps(a, b); }
+inline float4 sqrt4(const float4 a) { return _mm_sqrt_ps(a); }
+inline float4 max4(const float4 a, const float4 b) { return _mm_max_ps(a, b); }
+
+inline float4 copysign4(const float4 magnitude, const float4 sign)
+{
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    return _mm_or_ps(_mm_andnot_ps(sign_mask, magnitude), _mm_and_ps(sign_mask, sign));
+}
+#else
+struct float4
+{
+    float v[POSE_BATCH_LANES];
+};
+
+#define OK_FLOAT4_OP(expression) float4 result; for (int lane = 0; lane < POSE_BATCH_LANES; lane++) { result.v[lane] = (expression); } return result
+
+inline float4 load4(const float* ptr) { OK_FLOAT4_OP(ptr[lane]); }
+inline void store4(float* ptr, const float4 value) { for (int lane = 0; lane < POSE_BATCH_LANES; lane++) { ptr[lane] = value.v[lane]; } }
+inline float4 splat4(const float value) { OK_FLOAT4_OP(value); }
+inline float4 add4(const float4 a, const float4 b) { OK_FLOAT4_OP(a.v[lane] + b.v[lane]); }
+inline float4 sub4(const float4 a, const float4 b) { OK_FLOAT4_OP(a.v[lane] - b.v[lane]); }
+inline float4 mul4(const float4 a, const float4 b) { OK_FLOAT4_OP(a.v[lane] * b.v[lane]); }
+inline float4 madd4(const float4 a, const float4 b, const float4 c) { OK_FLOAT4_OP(a.v[lane] * b.v[lane] + c.v[lane]); }
+inline float4 div4(const float4 a, const float4 b) { OK_FLOAT4_OP(a.v[lane] / b.v[lane]); }
+inline float4 sqrt4(const float4 a) { OK_FLOAT4_OP(sqrtf(a.v[lane])); }
+inline float4 max4(const float4 a, const float4 b) { OK_FLOAT4_OP((a.v[lane] > b.v[lane]) ? a.v[lane] : b.v[lane]); }
+inline float4 copysign4(const float4 magnitude, const float4 sign) { OK_FLOAT4_OP(copysignf(magnitude.v[lane], sign.v[lane])); }
+
+#undef OK_FLOAT4_OP
+#endif
+
+// Keeps a zero quaternion (an invalid pose) from turning into NaNs
+const float MIN_QUATERNION_LENGTH_SQUARED = 1e-24f;
+
+struct OKQuat4
+{
+    float4 x_;
+    float4 y_;
+    float4 z_;
+    float4 w_;
+};
+
+struct OKVec4x3
+{
+    float4 x_;
+    float4 y_;
+    float4 z_;
+};
+
+inline OKQuat4 normalize4(const OKQuat4& q)
+{
+    const float4 length_squared = madd4(q.w_, q.w_, madd4(q.z_, q.z_, madd4(q.y_, q.y_, mul4(q.x_, q.x_))));
+    const float4 inverse_length = div4(splat4(1.0f), sqrt4(max4(length_squared, splat4(MIN_QUATERNION_LENGTH_SQUARED))));
+    return {mul4(q.x_, inverse_length), mul4(q.y_, inverse_length), mul4(q.z_, inverse_length), mul4(q.w_, inverse_length)};
+}
+
+// a * b, glm's convention
+inline OKQuat4 multiply4(const OKQuat4& a, const OKQuat4& b)
+{
+    OKQuat4 result;
+    result.w_ = sub4(sub4(sub4(mul4(a.w_, b.w_), mul4(a.x_, b.x_)), mul4(a.y_, b.y_)), mul4(a.z_, b.z_));
+    result.x_ = sub4(add4(add4(mul4(a.w_, b.x_), mul4(a.x_, b.w_)), mul4(a.y_, b.z_)), mul4(a.z_, b.y_));
+    result.y_ = sub4(add4(add4(mul4(a.w_, b.y_), mul4(a.y_, b.w_)), mul4(a.z_, b.x_)), mul4(a.x_, b.z_));
+    result.z_ = sub4(add4(add4(mul4(a.w_, b.z_), mul4(a.z_, b.w_)), mul4(a.x_, b.y_)), mul4(a.y_, b.x_));
+    return result;
+}
+
+// q * v for unit q: v + 2w (q.xyz x v) + 2 q.xyz x (q.xyz x v)
+inline OKVec4x3 rotate4(const OKQuat4& q, const OKVec4x3& v)
+{
+    const float4 two = splat4(2.0f);
+
+    const float4 tx = mul4(two, sub4(mul4(q.y_, v.z_), mul4(q.z_, v.y_)));
+    const float4 ty = mul4(two, sub4(mul4(q.z_, v.x_), mul4(q.x_, v.z_)));
+    const float4 tz = mul4(two, sub4(mul4(q.x_, v.y_), mul4(q.y_, v.x_)));
+
+    OKVec4x3 result;
+    result.x_ = add4(madd4(q.w_, tx, v.x_), sub4(mul4(q.y_, tz), mul4(q.z_, ty)));
+    result.y_ = add4(madd4(q.w_, ty, v.y_), sub4(mul4(q.z_, tx), mul4(q.x_, tz)));
+    result.z_ = add4(madd4(q.w_, tz, v.z_), sub4(mul4(q.x_, ty), mul4(q.y_, tx)));
+    return result;
+}
+
+inline OKQuat4 load_rotations(const OKPoseBatch& batch, const uint32_t lane)
+{
+    return {load4(&batch.rotation_x_[lane]), load4(&batch.rotation_y_[lane]), load4(&batch.rotation_z_[lane]), load4(&batch.rotation_w_[lane])};
+}
+
+inline void store_rotations(OKPoseBatch& batch, const uint32_t lane, const OKQuat4& q)
+{
+    store4(&batch.rotation_x_[lane], q.x_);
+    store4(&batch.rotation_y_[lane], q.y_);
+    store4(&batch.rotation_z_[lane], q.z_);
+    store4(&batch.rotation_w_[lane], q.w_);
+}
+
+inline OKVec4x3 load_positions(const OKPoseBatch& batch, const uint32_t lane)
+{
+    return {load4(&batch.position_x_[lane]), load4(&batch.position_y_[lane]), load4(&batch.position_z_[lane])};
+}
+
+inline void store_positions(OKPoseBatch& batch, const uint32_t lane, const OKVec4x3& v)
+{
+    store4(&batch.position_x_[lane], v.x_);
+    store4(&batch.position_y_[lane], v.y_);
+    store4(&batch.position_z_[lane], v.z_);
+}
+
+inline void transform_lanes(OKPoseBatch& batch, const uint32_t lane, const OKVec4x3& offset_position, const OKQuat4& offset_rotation)
+{
+    const OKQuat4 rotation = load_rotations(batch, lane);
+    const OKVec4x3 position = load_positions(batch, lane);
+    const OKVec4x3 offset_ws = rotate4(rotation, offset_position);
+
+    store_positions(batch, lane, {add4(position.x_, offset_ws.x_), add4(position.y_, offset_ws.y_), add4(position.z_, offset_ws.z_)});
+    store_rotations(batch, lane, normalize4(multiply4(rotation, offset_rotation)));
+}
+
+inline const XrPosef* advance(const XrPosef* pose, const size_t stride_bytes)
+{
+    return reinterpret_cast<const XrPosef*>(reinterpret_cast<const uint8_t*>(pose) + stride_bytes);
+}
+
+inline cxrTrackedDevicePose* advance(cxrTrackedDevicePose* pose, const size_t stride_bytes)
+{
+    return reinterpret_cast<cxrTrackedDevicePose*>(reinterpret_cast<uint8_t*>(pose) + stride_bytes);
+}
+
+} // namespace
+
+OKPoseBatch::OKPoseBatch()
+{
+    // Every lane starts as an identity pose, after that clear() only touches the used ones
+    count_ = MAX_POSE_BATCH_SIZE;
+    clear();
+}
+
+void OKPoseBatch::clear()
+{
+    const uint32_t padded_count = get_padded_count();
+
+    for (uint32_t index = 0; index < padded_count; index++)
+    {
+        reset_lane((int)index);
+    }
+
+    count_ = 0;
+}
+
+void OKPoseBatch::reset_lane(const int index)
+{
+    position_x_[index] = 0.0f;
+    position_y_[index] = 0.0f;
+    position_z_[index] = 0.0f;
+
+    rotation_x_[index] = 0.0f;
+    rotation_y_[index] = 0.0f;
+    rotation_z_[index] = 0.0f;
+    rotation_w_[index] = 1.0f;
+
+    velocity_x_[index] = 0.0f;
+    velocity_y_[index] = 0.0f;
+    velocity_z_[index] = 0.0f;
+
+    angular_velocity_x_[index] = 0.0f;
+    angular_velocity_y_[index] = 0.0f;
+    angular_velocity_z_[index] = 0.0f;
+}
+
+int OKPoseBatch::add(const XrPosef& pose)
+{
+    if (count_ >= MAX_POSE_BATCH_SIZE)
+    {
+        return INVALID_INDEX;
+    }
+
+    const int index = (int)count_++;
+    set_pose(index, pose);
+    return index;
+}
+
+int OKPoseBatch::add(const GLMPose& pose)
+{
+    if (count_ >= MAX_POSE_BATCH_SIZE)
+    {
+        return INVALID_INDEX;
+    }
+
+    const int index = (int)count_++;
+    set_pose(index, pose);
+    return index;
+}
+
+void OKPoseBatch::set_pose(const int index, const XrPosef& pose)
+{
+    position_x_[index] = pose.position.x;
+    position_y_[index] = pose.position.y;
+    position_z_[index] = pose.position.z;
+
+    rotation_x_[index] = pose.orientation.x;
+    rotation_y_[index] = pose.orientation.y;
+    rotation_z_[index] = pose.orientation.z;
+    rotation_w_[index] = pose.orientation.w;
+}
+
+void OKPoseBatch::set_pose(const int index, const GLMPose& pose)
+{
+    position_x_[index] = pose.translation_.x;
+    position_y_[index] = pose.translation_.y;
+    position_z_[index] = pose.translation_.z;
+
+    rotation_x_[index] = pose.rotation_.x;
+    rotation_y_[index] = pose.rotation_.y;
+    rotation_z_[index] = pose.rotation_.z;
+    rotation_w_[index] = pose.rotation_.w;
+}
+
+void OKPoseBatch::set_velocity(const int index, const XrVector3f& linear_velocity, const XrVector3f& angular_velocity)
+{
+    velocity_x_[index] = linear_velocity.x;
+    velocity_y_[index] = linear_velocity.y;
+    velocity_z_[index] = linear_velocity.z;
+
+    angular_velocity_x_[index] = angular_velocity.x;
+    angular_velocity_y_[index] = angular_velocity.y;
+    angular_velocity_z_[index] = angular_velocity.z;
+}
+
+XrPosef OKPoseBatch::get_xr_pose(const int index) const
+{
+    XrPosef pose;
+    pose.position = {position_x_[index], position_y_[index], position_z_[index]};
+    pose.orientation = {rotation_x_[index], rotation_y_[index], rotation_z_[index], rotation_w_[index]};
+    return pose;
+}
+
+GLMPose OKPoseBatch::get_glm_pose(const int index) const
+{
+    return GLMPose(glm::vec3(position_x_[index], position_y_[index], position_z_[index]),
+                   glm::fquat(rotation_w_[index], rotation_x_[index], rotation_y_[index], rotation_z_[index]));
+}
+
+cxrTrackedDevicePose OKPoseBatch::get_cxr_pose(const int index) const
+{
+    cxrTrackedDevicePose cxr_pose = {};
+
+    cxr_pose.position.v[0] = position_x_[index];
+    cxr_pose.position.v[1] = position_y_[index];
+    cxr_pose.position.v[2] = position_z_[index];
+
+    cxr_pose.rotation.w = rotation_w_[index];
+    cxr_pose.rotation.x = rotation_x_[index];
+    cxr_pose.rotation.y = rotation_y_[index];
+    cxr_pose.rotation.z = rotation_z_[index];
+
+    cxr_pose.velocity.v[0] = velocity_x_[index];
+    cxr_pose.velocity.v[1] = velocity_y_[index];
+    cxr_pose.velocity.v[2] = velocity_z_[index];
+
+    cxr_pose.angularVelocity.v[0] = angular_velocity_x_[index];
+    cxr_pose.angularVelocity.v[1] = angular_velocity_y_[index];
+    cxr_pose.angularVelocity.v[2] = angular_velocity_z_[index];
+
+    cxr_pose.deviceIsConnected = true;
+    cxr_pose.poseIsValid = true;
+    cxr_pose.trackingResult = cxrTrackingResult_Running_OK;
+
+    return cxr_pose;
+}
+
+void load_xr_poses(OKPoseBatch& batch, const XrPosef* poses, const uint32_t count, const size_t stride_bytes)
+{
+    batch.clear();
+
+    const XrPosef* pose = poses;
+
+    for (uint32_t pose_id = 0; (pose_id < count) && (pose_id < MAX_POSE_BATCH_SIZE); pose_id++)
+    {
+        batch.set_pose((int)pose_id, *pose);
+        pose = advance(pose, stride_bytes);
+    }
+
+    batch.count_ = (count < MAX_POSE_BATCH_SIZE) ? count : MAX_POSE_BATCH_SIZE;
+}
+
+void store_cxr_poses(const OKPoseBatch& batch, cxrTrackedDevicePose* poses, const uint32_t count, const size_t stride_bytes)
+{
+    cxrTrackedDevicePose* pose = poses;
+
+    for (uint32_t pose_id = 0; (pose_id < count) && (pose_id < batch.count_); pose_id++)
+    {
+        *pose = batch.get_cxr_pose((int)pose_id);
+        pose = advance(pose, stride_bytes);
+    }
+}
+
+void transform_by_offsets(OKPoseBatch& batch, const OKPoseBatch& offsets)
+{
+    const uint32_t padded_count = batch.get_padded_count();
+
+    for (uint32_t lane = 0; lane < padded_count; lane += POSE_BATCH_LANES)
+    {
+        transform_lanes(batch, lane, load_positions(offsets, lane), load_rotations(offsets, lane));
+    }
+}
+
+void transform_by_offset(OKPoseBatch& batch, const GLMPose& offset)
+{
+    const OKVec4x3 offset_position = {splat4(offset.translation_.x), splat4(offset.translation_.y), splat4(offset.translation_.z)};
+    const OKQuat4 offset_rotation = {splat4(offset.rotation_.x), splat4(offset.rotation_.y), splat4(offset.rotation_.z), splat4(offset.rotation_.w)};
+
+    const uint32_t padded_count = batch.get_padded_count();
+
+    for (uint32_t lane = 0; lane < padded_count; lane += POSE_BATCH_LANES)
+    {
+        transform_lanes(batch, lane, offset_position, offset_rotation);
+    }
+}
+
+void normalize_rotations(OKPoseBatch& batch)
+{
+    const uint32_t padded_count = batch.get_padded_count();
+
+    for (uint32_t lane = 0; lane < padded_count; lane += POSE_BATCH_LANES)
+    {
+        store_rotations(batch, lane, normalize4(load_rotations(batch, lane)));
+    }
+}
+
+void convert_to_matrices(const OKPoseBatch& batch, cxrMatrix34* matrices)
+{
+    const uint32_t padded_count = batch.get_padded_count();
+    const float4 one = splat4(1.0f);
+    const float4 two = splat4(2.0f);
+
+    for (uint32_t lane = 0; lane < padded_count; lane += POSE_BATCH_LANES)
+    {
+        const OKQuat4 q = load_rotations(batch, lane);
+
+        const float4 xx = mul4(q.x_, q.x_);
+        const float4 yy = mul4(q.y_, q.y_);
+        const float4 zz = mul4(q.z_, q.z_);
+        const float4 xy = mul4(q.x_, q.y_);
+        const float4 xz = mul4(q.x_, q.z_);
+        const float4 yz = mul4(q.y_, q.z_);
+        const float4 wx = mul4(q.w_, q.x_);
+        const float4 wy = mul4(q.w_, q.y_);
+        const float4 wz = mul4(q.w_, q.z_);
+
+        // Row major, one float4 per matrix element across the four lanes
+        alignas(16) float elements[3][4][POSE_BATCH_LANES];
+
+        store4(elements[0][0], sub4(one, mul4(two, add4(yy, zz))));
+        store4(elements[0][1], mul4(two, sub4(xy, wz)));
+        store4(elements[0][2], mul4(two, add4(xz, wy)));
+        store4(elements[0][3], load4(&batch.position_x_[lane]));
+
+        store4(elements[1][0], mul4(two, add4(xy, wz)));
+        store4(elements[1][1], sub4(one, mul4(two, add4(xx, zz))));
+        store4(elements[1][2], mul4(two, sub4(yz, wx)));
+        store4(elements[1][3], load4(&batch.position_y_[lane]));
+
+        store4(elements[2][0], mul4(two, sub4(xz, wy)));
+        store4(elements[2][1], mul4(two, add4(yz, wx)));
+        store4(elements[2][2], sub4(one, mul4(two, add4(xx, yy))));
+        store4(elements[2][3], load4(&batch.position_z_[lane]));
+
+        for (uint32_t lane_id = 0; (lane_id < POSE_BATCH_LANES) && ((lane + lane_id) < batch.count_); lane_id++)
+        {
+            cxrMatrix34& matrix = matrices[lane + lane_id];
+
+            for (int row = 0; row < 3; row++)
+            {
+                for (int column = 0; column < 4; column++)
+                {
+                    matrix.m[row][column] = elements[row][column][lane_id];
+                }
+            }
+        }
+    }
+}
+
+void convert_from_matrices(OKPoseBatch& batch, const cxrMatrix34* matrices, const uint32_t count)
+{
+    batch.clear();
+    batch.count_ = (count < MAX_POSE_BATCH_SIZE) ? count : MAX_POSE_BATCH_SIZE;
+
+    const uint32_t padded_count = batch.get_padded_count();
+    const float4 zero = splat4(0.0f);
+    const float4 one = splat4(1.0f);
+    const float4 half = splat4(0.5f);
+
+    for (uint32_t lane = 0; lane < padded_count; lane += POSE_BATCH_LANES)
+    {
+        // Transpose four matrices into one float4 per element, identity in the padding lanes
+        alignas(16) float elements[3][4][POSE_BATCH_LANES];
+
+        for (uint32_t lane_id = 0; lane_id < POSE_BATCH_LANES; lane_id++)
+        {
+            const bool is_used = ((lane + lane_id) < batch.count_);
+
+            for (int row = 0; row < 3; row++)
+            {
+                for (int column = 0; column < 4; column++)
+                {
+                    elements[row][column][lane_id] = is_used ? matrices[lane + lane_id].m[row][column] : ((row == column) ? 1.0f : 0.0f);
+                }
+            }
+        }
+
+        const float4 m00 = load4(elements[0][0]);
+        const float4 m01 = load4(elements[0][1]);
+        const float4 m02 = load4(elements[0][2]);
+        const float4 m10 = load4(elements[1][0]);
+        const float4 m11 = load4(elements[1][1]);
+        const float4 m12 = load4(elements[1][2]);
+        const float4 m20 = load4(elements[2][0]);
+        const float4 m21 = load4(elements[2][1]);
+        const float4 m22 = load4(elements[2][2]);
+
+        // Branchless: each component's magnitude from the diagonal, its sign from the off-diagonal
+        // differences, then renormalized. Same result as the trace / largest-diagonal switch.
+        OKQuat4 q;
+        q.w_ = mul4(half, sqrt4(max4(zero, add4(add4(add4(one, m00), m11), m22))));
+        q.x_ = copysign4(mul4(half, sqrt4(max4(zero, sub4(sub4(add4(one, m00), m11), m22)))), sub4(m21, m12));
+        q.y_ = copysign4(mul4(half, sqrt4(max4(zero, sub4(add4(sub4(one, m00), m11), m22)))), sub4(m02, m20));
+        q.z_ = copysign4(mul4(half, sqrt4(max4(zero, add4(sub4(sub4(one, m00), m11), m22)))), sub4(m10, m01));
+
+        store_rotations(batch, lane, normalize4(q));
+
+        store4(&batch.position_x_[lane], load4(elements[0][3]));
+        store4(&batch.position_y_[lane], load4(elements[1][3]));
+        store4(&batch.position_z_[lane], load4(elements[2][3]));
+    }
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
@@ -0,0 +1,98 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_POSE_BATCH_H
+#define OK_POSE_BATCH_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "GLMPose.h"
+
+#include <CloudXRCommon.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BVR
+{
+
+// Poses stored as structure-of-arrays so the per-poll conversions run four lanes at a time
+// (SSE / NEON, scalar elsewhere): HMD, controllers and hand / body joints go through one kernel
+// call each instead of one GLMPose round trip per pose. Only what the tracking path needs is kept,
+// no scale, Euler angles or timestamps. Lanes past count_ are kept as identity poses so every
+// kernel can run over whole groups of POSE_BATCH_LANES without a scalar tail.
+struct alignas(16) OKPoseBatch
+{
+    float position_x_[MAX_POSE_BATCH_SIZE];
+    float position_y_[MAX_POSE_BATCH_SIZE];
+    float position_z_[MAX_POSE_BATCH_SIZE];
+
+    float rotation_x_[MAX_POSE_BATCH_SIZE];
+    float rotation_y_[MAX_POSE_BATCH_SIZE];
+    float rotation_z_[MAX_POSE_BATCH_SIZE];
+    float rotation_w_[MAX_POSE_BATCH_SIZE];
+
+    float velocity_x_[MAX_POSE_BATCH_SIZE];
+    float velocity_y_[MAX_POSE_BATCH_SIZE];
+    float velocity_z_[MAX_POSE_BATCH_SIZE];
+
+    float angular_velocity_x_[MAX_POSE_BATCH_SIZE];
+    float angular_velocity_y_[MAX_POSE_BATCH_SIZE];
+    float angular_velocity_z_[MAX_POSE_BATCH_SIZE];
+
+    uint32_t count_ = 0;
+
+    OKPoseBatch();
+
+    void clear();
+
+    // Index of the new pose, INVALID_INDEX when full. Velocities start at zero.
+    int add(const XrPosef& pose);
+    int add(const GLMPose& pose);
+
+    void set_pose(const int index, const XrPosef& pose);
+    void set_pose(const int index, const GLMPose& pose);
+    void set_velocity(const int index, const XrVector3f& linear_velocity, const XrVector3f& angular_velocity);
+
+    XrPosef get_xr_pose(const int index) const;
+    GLMPose get_glm_pose(const int index) const;
+
+    // Same fields convert_glm_to_cxr_pose fills, plus both velocities
+    cxrTrackedDevicePose get_cxr_pose(const int index) const;
+
+    uint32_t get_padded_count() const
+    {
+        return (count_ + POSE_BATCH_LANES - 1) & ~(uint32_t)(POSE_BATCH_LANES - 1);
+    }
+
+private:
+    void reset_lane(const int index);
+};
+
+// Gathers count poses spaced stride_bytes apart, e.g. the pose of each XrHandJointLocationEXT in place
+void load_xr_poses(OKPoseBatch& batch, const XrPosef* poses, const uint32_t count, const size_t stride_bytes = sizeof(XrPosef));
+
+// Scatters the batch into count cxrTrackedDevicePose spaced stride_bytes apart
+void store_cxr_poses(const OKPoseBatch& batch, cxrTrackedDevicePose* poses, const uint32_t count, const size_t stride_bytes = sizeof(cxrTrackedDevicePose));
+
+// Applies each lane of offsets in that lane's local space: position += rotation * offset position,
+// rotation = normalize(rotation * offset rotation). The batch version of GLMPose::transform.
+void transform_by_offsets(OKPoseBatch& batch, const OKPoseBatch& offsets);
+
+// Same offset for every lane
+void transform_by_offset(OKPoseBatch& batch, const GLMPose& offset);
+
+void normalize_rotations(OKPoseBatch& batch);
+
+// cxrMatrix34 is row major 3x4, the translation in column 3 (cxrMatrixToVecQuat's layout)
+void convert_to_matrices(const OKPoseBatch& batch, cxrMatrix34* matrices);
+void convert_from_matrices(OKPoseBatch& batch, const cxrMatrix34* matrices, const uint32_t count);
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_POSE_BATCH_H
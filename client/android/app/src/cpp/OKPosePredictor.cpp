@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+#include "OKPosePredictor.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace BVR
+{
+
+glm::fquat integrate_angular_velocity(const glm::fquat& rotation, const glm::vec3& angular_velocity, const float dt_s)
+{
+    const float angular_speed = glm::length(angular_velocity);
+    const float angle = angular_speed * dt_s;
+
+    if (angle < 1e-6f)
+    {
+        return rotation;
+    }
+
+    // World-space angular velocity, so the delta is applied on the left
+    const glm::vec3 axis = angular_velocity / angular_speed;
+    const glm::fquat delta_rotation = glm::angleAxis(angle, axis);
+
+    return glm::normalize(delta_rotation * rotation);
+}
+
+OKPosePredictor::OKPosePredictor()
+{
+}
+
+void OKPosePredictor::configure(const bool enabled, const float damping, const float max_prediction_ms)
+{
+    is_enabled_ = enabled;
+    damping_ = std::max(damping, 0.0f);
+    max_prediction_s_ = std::max(max_prediction_ms, 0.0f) * 0.001f;
+}
+
+float OKPosePredictor::get_effective_dt(const float dt_s) const
+{
+    const float clamped_dt_s = clamp(dt_s, 0.0f, max_prediction_s_);
+
+    if (damping_ <= 0.0f)
+    {
+        return clamped_dt_s;
+    }
+
+    // Integral of exp(-damping * t) over [0, dt]: velocity decays instead of running away
+    return (1.0f - expf(-damping_ * clamped_dt_s)) / damping_;
+}
+
+OKPoseState OKPosePredictor::predict(const OKPoseState& pose_state, const uint64_t target_time_ns) const
+{
+    if (!is_enabled_ || !pose_state.pose_.is_valid_ || (target_time_ns <= pose_state.timestamp_ns_))
+    {
+        return pose_state;
+    }
+
+    const float dt_s = (float)(target_time_ns - pose_state.timestamp_ns_) * NS_TO_SEC;
+    const float effective_dt_s = get_effective_dt(dt_s);
+
+    OKPoseState predicted_state = pose_state;
+    predicted_state.timestamp_ns_ = target_time_ns;
+
+    if (pose_state.has_linear_velocity_)
+    {
+        predicted_state.pose_.translation_ += pose_state.linear_velocity_ * effective_dt_s;
+    }
+
+    if (pose_state.has_angular_velocity_)
+    {
+        predicted_state.pose_.rotation_ = integrate_angular_velocity(pose_state.pose_.rotation_, pose_state.angular_velocity_, effective_dt_s);
+    }
+
+    return predicted_state;
+}
+
+OKPredictionError OKPosePredictor::evaluate_trace(const OKPoseState* trace, const size_t trace_size, const uint64_t horizon_ns) const
+{
+    OKPredictionError prediction_error;
+
+    if (!trace || (trace_size < 2))
+    {
+        return prediction_error;
+    }
+
+    double total_position_error_m = 0.0;
+    double total_rotation_error_deg = 0.0;
+
+    size_t truth_id = 0;
+
+    for (size_t sample_id = 0; sample_id < trace_size; sample_id++)
+    {
+        const uint64_t target_time_ns = trace[sample_id].timestamp_ns_ + horizon_ns;
+
+        while (((truth_id + 1) < trace_size) && (trace[truth_id + 1].timestamp_ns_ <= target_time_ns))
+        {
+            truth_id++;
+        }
+
+        if ((truth_id + 1) >= trace_size)
+        {
+            break;
+        }
+
+        const OKPoseState& before = trace[truth_id];
+        const OKPoseState& after = trace[truth_id + 1];
+
+        const uint64_t span_ns = after.timestamp_ns_ - before.timestamp_ns_;
+        const float t = (span_ns > 0) ? (float)(target_time_ns - before.timestamp_ns_) / (float)span_ns : 0.0f;
+
+        const glm::vec3 true_position = glm::mix(before.pose_.translation_, after.pose_.translation_, t);
+        const glm::fquat true_rotation = glm::slerp(before.pose_.rotation_, after.pose_.rotation_, t);
+
+        const OKPoseState predicted_state = predict(trace[sample_id], target_time_ns);
+
+        const float position_error_m = glm::length(predicted_state.pose_.translation_ - true_position);
+
+        const float cos_half_angle = clamp(fabsf(glm::dot(predicted_state.pose_.rotation_, true_rotation)), 0.0f, 1.0f);
+        const float rotation_error_deg = 2.0f * acosf(cos_half_angle) * (180.0f / (float)M_PI);
+
+        total_position_error_m += position_error_m;
+        total_rotation_error_deg += rotation_error_deg;
+
+        prediction_error.max_position_error_m_ = std::max(prediction_error.max_position_error_m_, position_error_m);
+        prediction_error.max_rotation_error_deg_ = std::max(prediction_error.max_rotation_error_deg_, rotation_error_deg);
+        prediction_error.sample_count_++;
+    }
+
+    if (prediction_error.sample_count_ > 0)
+    {
+        prediction_error.mean_position_error_m_ = (float)(total_position_error_m / prediction_error.sample_count_);
+        prediction_error.mean_rotation_error_deg_ = (float)(total_rotation_error_deg / prediction_error.sample_count_);
+    }
+
+    return prediction_error;
+}
+
+} // namespace BVR
+
@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_POSE_PREDICTOR_H
+#define OK_POSE_PREDICTOR_H
+
+#include "ok_defines.h"
+#include "GLMPose.h"
+
+#include <cstddef>
+
+namespace BVR
+{
+
+struct OKPoseState
+{
+    GLMPose pose_;
+
+    glm::vec3 linear_velocity_ = glm::vec3(0.0f, 0.0f, 0.0f);  // m/s, base space
+    glm::vec3 angular_velocity_ = glm::vec3(0.0f, 0.0f, 0.0f); // rad/s, base space
+
+    bool has_linear_velocity_ = false;
+    bool has_angular_velocity_ = false;
+
+    uint64_t timestamp_ns_ = 0;
+};
+
+struct OKPredictionError
+{
+    uint32_t sample_count_ = 0;
+
+    float mean_position_error_m_ = 0.0f;
+    float max_position_error_m_ = 0.0f;
+
+    float mean_rotation_error_deg_ = 0.0f;
+    float max_rotation_error_deg_ = 0.0f;
+};
+
+// Constant-velocity extrapolation with optional exponential velocity damping.
+// Rotation is integrated on the quaternion (exp map of the angular velocity), not Euler angles.
+class OKPosePredictor
+{
+public:
+    OKPosePredictor();
+
+    void configure(const bool enabled, const float damping, const float max_prediction_ms);
+
+    bool is_enabled() const
+    {
+        return is_enabled_;
+    }
+
+    OKPoseState predict(const OKPoseState& pose_state, const uint64_t target_time_ns) const;
+
+    // Offline accuracy check over a recorded trace sorted by timestamp: predict every sample
+    // horizon_ns ahead and compare against the trace itself, interpolated at that time.
+    OKPredictionError evaluate_trace(const OKPoseState* trace, const size_t trace_size, const uint64_t horizon_ns) const;
+
+private:
+    float get_effective_dt(const float dt_s) const;
+
+    bool is_enabled_ = ENABLE_CLIENT_POSE_PREDICTION;
+    float damping_ = DEFAULT_CLIENT_PREDICTION_DAMPING;
+    float max_prediction_s_ = DEFAULT_CLIENT_PREDICTION_MAX_MS * 0.001f;
+};
+
+glm::fquat integrate_angular_velocity(const glm::fquat& rotation, const glm::vec3& angular_velocity, const float dt_s);
+
+} // namespace BVR
+
+#endif // OK_POSE_PREDICTOR_H
+
@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKPoseSampler.h"
+#include "OKClock.h"
+
+#include <chrono>
+
+namespace BVR
+{
+
+OKPoseSampler::OKPoseSampler()
+{
+}
+
+OKPoseSampler::~OKPoseSampler()
+{
+    stop();
+}
+
+bool OKPoseSampler::start(const uint32_t polling_rate_hz, OKPoseSampleFunc sample_func)
+{
+    if (is_running() || (polling_rate_hz == 0) || !sample_func)
+    {
+        return false;
+    }
+
+    polling_rate_hz_ = polling_rate_hz;
+    sample_func_ = sample_func;
+    sample_count_.store(0, std::memory_order_release);
+    should_stop_.store(false, std::memory_order_release);
+
+    is_running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&OKPoseSampler::run, this);
+
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKPoseSampler::start at %u Hz\n", polling_rate_hz_);
+    return true;
+}
+
+void OKPoseSampler::stop()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+
+    should_stop_.store(true, std::memory_order_release);
+    thread_.join();
+
+    is_running_.store(false, std::memory_order_release);
+}
+
+bool OKPoseSampler::get_latest_sample(OKPoseSample& pose_sample) const
+{
+    // The writer may lap the slot we picked while we read it, so retry against the new head
+    while (true)
+    {
+        const uint64_t sample_count = sample_count_.load(std::memory_order_acquire);
+
+        if (sample_count == 0)
+        {
+            return false;
+        }
+
+        const uint64_t slot_id = (sample_count - 1) % POSE_SAMPLER_RING_SIZE;
+
+        if (samples_[slot_id].try_load(pose_sample))
+        {
+            return true;
+        }
+    }
+}
+
+void OKPoseSampler::run()
+{
+    const std::chrono::nanoseconds period(1000000000ULL / polling_rate_hz_);
+    std::chrono::steady_clock::time_point next_sample_time = std::chrono::steady_clock::now();
+
+    OKPoseSample pose_sample;
+
+    while (!should_stop_.load(std::memory_order_acquire))
+    {
+        pose_sample = {};
+        pose_sample.sample_time_ns_ = get_monotonic_time_ns();
+        sample_func_(pose_sample);
+
+        const uint64_t sample_count = sample_count_.load(std::memory_order_relaxed);
+        samples_[sample_count % POSE_SAMPLER_RING_SIZE].store(pose_sample);
+        sample_count_.store(sample_count + 1, std::memory_order_release);
+
+        next_sample_time += period;
+
+        const std::chrono::steady_clock::time_point now_time = std::chrono::steady_clock::now();
+
+        // Fell behind (e.g. descheduled), don't burst to catch up, just resync
+        if (next_sample_time < now_time)
+        {
+            next_sample_time = now_time + period;
+        }
+
+        std::this_thread::sleep_until(next_sample_time);
+    }
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
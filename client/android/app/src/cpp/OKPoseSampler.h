@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_POSE_SAMPLER_H
+#define OK_POSE_SAMPLER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKSeqLock.h"
+
+#include <CloudXRClient.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace BVR
+{
+
+struct OKPoseSample
+{
+    uint64_t sample_time_ns_ = 0;
+    cxrVRTrackingState tracking_state_ = {};
+};
+
+typedef std::function<void(OKPoseSample& pose_sample)> OKPoseSampleFunc;
+
+// Samples HMD and controller poses on its own thread at a fixed rate, decoupled from
+// CloudXR's GetTrackingState cadence. The callback just copies the newest sample out.
+class OKPoseSampler
+{
+public:
+    OKPoseSampler();
+    ~OKPoseSampler();
+
+    bool start(const uint32_t polling_rate_hz, OKPoseSampleFunc sample_func);
+    void stop();
+
+    bool is_running() const
+    {
+        return is_running_.load(std::memory_order_acquire);
+    }
+
+    uint32_t get_polling_rate_hz() const
+    {
+        return polling_rate_hz_;
+    }
+
+    // Any thread, returns false until the first sample has been published
+    bool get_latest_sample(OKPoseSample& pose_sample) const;
+
+    uint64_t get_sample_count() const
+    {
+        return sample_count_.load(std::memory_order_acquire);
+    }
+
+private:
+    void run();
+
+    std::thread thread_;
+    std::atomic<bool> is_running_ = {false};
+    std::atomic<bool> should_stop_ = {false};
+
+    uint32_t polling_rate_hz_ = 0;
+    OKPoseSampleFunc sample_func_;
+
+    OKSeqLock<OKPoseSample> samples_[POSE_SAMPLER_RING_SIZE];
+    std::atomic<uint64_t> sample_count_ = {0};
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_POSE_SAMPLER_H
+
@@ -0,0 +1,254 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKQosController.h"
+
+#if ENABLE_CLOUDXR
+
+#include <algorithm>
+
+namespace BVR
+{
+
+namespace
+{
+
+struct OKQosLevel
+{
+    float res_scale_;       // of the config's max_res_factor
+    uint32_t foveation_;    // foveatedScaleFactor, or the config's when that's already tighter
+};
+
+// Resolution first, it's the largest saving, foveation keeps the centre sharp as it goes down
+const OKQosLevel qos_levels[QOS_LEVEL_COUNT] =
+{
+    {1.0f, 0},
+    {0.9f, 75},
+    {0.8f, 60},
+    {0.7f, 50},
+    {0.6f, 40},
+};
+
+const uint64_t NS_PER_MS = 1000000ULL;
+
+} // namespace
+
+void OKQosController::configure(const OKQosSettings& settings)
+{
+    settings_ = settings;
+    settings_.max_res_factor_ = std::clamp(settings_.max_res_factor_, MIN_CLOUDXR_RES_FACTOR, MAX_CLOUDXR_RES_FACTOR);
+
+    bandwidth_cap_kbps_ = 0;
+    upgrade_hold_ms_ = QOS_UPGRADE_HOLD_MS;
+    is_probing_ = false;
+    level_change_count_ = 0;
+    set_level(0);
+
+    applied_decision_ = decision_;
+    applied_time_ns_ = 0;
+
+    smoothed_delivery_ms_ = 0.0f;
+    smoothed_bandwidth_kbps_ = 0.0f;
+    last_bandwidth_kbps_ = 0.0f;
+    reset_session();
+}
+
+void OKQosController::reset_session()
+{
+    condition_ = QosCondition_Unknown;
+    condition_start_time_ns_ = 0;
+    packet_loss_percent_ = 0.0f;
+    has_packet_totals_ = false;
+}
+
+bool OKQosController::update(const cxrConnectionStats& stats, const uint64_t now_time_ns)
+{
+    // Loss since the previous sample, the totals are cumulative per session
+    if (has_packet_totals_ && (stats.totalPacketsReceived >= last_packets_received_) && (stats.totalPacketsLost >= last_packets_lost_))
+    {
+        const uint32_t received_count = stats.totalPacketsReceived - last_packets_received_;
+        const uint32_t lost_count = stats.totalPacketsLost - last_packets_lost_;
+        const uint32_t sent_count = received_count + lost_count;
+
+        packet_loss_percent_ = (sent_count > 0) ? (100.0f * (float)lost_count / (float)sent_count) : 0.0f;
+    }
+
+    last_packets_received_ = stats.totalPacketsReceived;
+    last_packets_lost_ = stats.totalPacketsLost;
+    has_packet_totals_ = true;
+
+    // Nothing delivered, nothing to judge
+    if ((stats.frameDeliveryTimeMs <= 0.0f) || (stats.framesPerSecond <= 0.0f))
+    {
+        return false;
+    }
+
+    smoothed_delivery_ms_ = (smoothed_delivery_ms_ > 0.0f) ?
+        (smoothed_delivery_ms_ + QOS_DELIVERY_SMOOTHING * (stats.frameDeliveryTimeMs - smoothed_delivery_ms_)) : stats.frameDeliveryTimeMs;
+
+    if (stats.bandwidthAvailableKbps > 0)
+    {
+        smoothed_bandwidth_kbps_ = (smoothed_bandwidth_kbps_ > 0.0f) ?
+            (smoothed_bandwidth_kbps_ + QOS_DELIVERY_SMOOTHING * ((float)stats.bandwidthAvailableKbps - smoothed_bandwidth_kbps_)) : (float)stats.bandwidthAvailableKbps;
+
+        last_bandwidth_kbps_ = (float)stats.bandwidthAvailableKbps;
+    }
+
+    // A step up that held this long was right, the next one can come at the normal pace
+    if (is_probing_ && (((now_time_ns - probe_start_time_ns_) / NS_PER_MS) >= upgrade_hold_ms_))
+    {
+        is_probing_ = false;
+        upgrade_hold_ms_ = QOS_UPGRADE_HOLD_MS;
+    }
+
+    const OKQosCondition condition = classify(stats);
+
+    if (condition != condition_)
+    {
+        condition_ = condition;
+        condition_start_time_ns_ = now_time_ns;
+        return false;
+    }
+
+    if (decision_ != applied_decision_)
+    {
+        return false;
+    }
+
+    // The lower of the two, a link that just collapsed shows in the last sample first
+    const float bandwidth_kbps = (last_bandwidth_kbps_ > 0.0f) ? std::min(smoothed_bandwidth_kbps_, last_bandwidth_kbps_) : 0.0f;
+    const uint32_t link_cap_kbps = (bandwidth_kbps > 0.0f) ? std::max((uint32_t)(bandwidth_kbps * QOS_BANDWIDTH_HEADROOM), (uint32_t)MIN_QOS_BITRATE_KBPS) : 0;
+
+    const uint64_t condition_ms = (now_time_ns - condition_start_time_ns_) / NS_PER_MS;
+
+    if ((condition_ == QosCondition_Congested) && (condition_ms >= QOS_DOWNGRADE_HOLD_MS))
+    {
+        // The bitrate cap follows the link even on the last level
+        const bool is_lower_cap = (link_cap_kbps > 0) && ((bandwidth_cap_kbps_ == 0) || (link_cap_kbps < bandwidth_cap_kbps_));
+
+        if ((decision_.level_ + 1 >= QOS_LEVEL_COUNT) && !is_lower_cap)
+        {
+            return false;
+        }
+
+        if (is_lower_cap)
+        {
+            bandwidth_cap_kbps_ = link_cap_kbps;
+        }
+
+        if (is_probing_)
+        {
+            upgrade_hold_ms_ = std::min(upgrade_hold_ms_ * 2, (uint32_t)MAX_QOS_UPGRADE_HOLD_MS);
+            is_probing_ = false;
+        }
+
+        set_level(std::min(decision_.level_ + 1, QOS_LEVEL_COUNT - 1));
+        condition_start_time_ns_ = now_time_ns;
+        return true;
+    }
+
+    if ((condition_ == QosCondition_Headroom) && (condition_ms >= upgrade_hold_ms_) && (decision_.level_ > 0))
+    {
+        // Back at the top there's no cap beyond the config's, else it rises with the link
+        if (decision_.level_ == 1)
+        {
+            bandwidth_cap_kbps_ = 0;
+        }
+        else if (link_cap_kbps > bandwidth_cap_kbps_)
+        {
+            bandwidth_cap_kbps_ = link_cap_kbps;
+        }
+
+        is_probing_ = true;
+        probe_start_time_ns_ = now_time_ns;
+
+        set_level(decision_.level_ - 1);
+        condition_start_time_ns_ = now_time_ns;
+        return true;
+    }
+
+    return false;
+}
+
+void OKQosController::on_applied(const uint64_t now_time_ns)
+{
+    applied_decision_ = decision_;
+    applied_time_ns_ = now_time_ns;
+}
+
+bool OKQosController::should_reconnect(const uint64_t now_time_ns) const
+{
+    if (!settings_.enable_reconnect_ || (decision_ == applied_decision_))
+    {
+        return false;
+    }
+
+    return ((now_time_ns - applied_time_ns_) / NS_PER_MS) >= QOS_RECONNECT_MIN_MS;
+}
+
+OKQosCondition OKQosController::classify(const cxrConnectionStats& stats) const
+{
+    const bool is_estimating = (stats.quality == cxrConnectionQuality_Unstable) && (stats.qualityReasons == cxrConnectionQualityReason_EstimatingQuality);
+
+    if (is_estimating)
+    {
+        return QosCondition_Unknown;
+    }
+
+    // HighLatency alone is the round trip, fewer bits won't shorten it, the delivery time covers the rest
+    const uint32_t congestion_reasons = cxrConnectionQualityReason_LowBandwidth | cxrConnectionQualityReason_HighPacketLoss;
+    const bool is_reported_congested = (stats.quality <= cxrConnectionQuality_Fair) && ((stats.qualityReasons & congestion_reasons) != 0);
+
+    const float target_ms = settings_.target_delivery_ms_;
+
+    if (is_reported_congested || (smoothed_delivery_ms_ > target_ms * (1.0f + QOS_DELIVERY_MARGIN)) ||
+        (packet_loss_percent_ > QOS_PACKET_LOSS_PERCENT) || (stats.bandwidthUtilizationPercent >= QOS_HIGH_UTILIZATION_PERCENT))
+    {
+        return QosCondition_Congested;
+    }
+
+    if ((stats.quality >= cxrConnectionQuality_Good) && (smoothed_delivery_ms_ < target_ms * (1.0f - QOS_DELIVERY_MARGIN)) &&
+        (packet_loss_percent_ <= QOS_PACKET_LOSS_PERCENT * 0.25f) && (stats.bandwidthUtilizationPercent < QOS_LOW_UTILIZATION_PERCENT))
+    {
+        return QosCondition_Headroom;
+    }
+
+    return QosCondition_Steady;
+}
+
+void OKQosController::set_level(const uint32_t level)
+{
+    const OKQosLevel& qos_level = qos_levels[level];
+
+    if (level != decision_.level_)
+    {
+        level_change_count_++;
+    }
+
+    decision_.level_ = level;
+    decision_.max_res_factor_ = std::max(settings_.max_res_factor_ * qos_level.res_scale_, MIN_CLOUDXR_RES_FACTOR);
+
+    // 0 is off, the widest, any other value the tighter of the two wins
+    if (qos_level.foveation_ == 0)
+    {
+        decision_.foveation_ = settings_.foveation_;
+    }
+    else
+    {
+        decision_.foveation_ = (settings_.foveation_ == 0) ? qos_level.foveation_ : std::min(settings_.foveation_, qos_level.foveation_);
+    }
+
+    if (bandwidth_cap_kbps_ == 0)
+    {
+        decision_.max_bitrate_kbps_ = settings_.max_bitrate_kbps_;
+    }
+    else
+    {
+        decision_.max_bitrate_kbps_ = (settings_.max_bitrate_kbps_ == 0) ? bandwidth_cap_kbps_ : std::min(settings_.max_bitrate_kbps_, bandwidth_cap_kbps_);
+    }
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_QOS_CONTROLLER_H
+#define OK_QOS_CONTROLLER_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <CloudXRClient.h>
+
+#include <cstdint>
+
+namespace BVR
+{
+
+const uint32_t QOS_LEVEL_COUNT = 5;
+
+typedef enum
+{
+    QosCondition_Unknown,       // no usable sample yet, or CloudXR still estimating
+    QosCondition_Congested,     // delivery over target, loss, or the link is full
+    QosCondition_Steady,
+    QosCondition_Headroom,      // delivery well under target on an idle link
+} OKQosCondition;
+
+// The config's caps, level 0 is exactly these
+struct OKQosSettings
+{
+    float target_delivery_ms_ = DEFAULT_QOS_TARGET_DELIVERY_MS;
+    uint32_t max_bitrate_kbps_ = DEFAULT_CLOUDXR_MAX_BITRATE_KBPS; // 0 = unlimited
+    float max_res_factor_ = DEFAULT_CLOUDXR_MAX_RES_FACTOR;
+    uint32_t foveation_ = DEFAULT_CLOUDXR_FOVEATION;               // 0 = off
+    bool enable_reconnect_ = ENABLE_QOS_RECONNECT;
+};
+
+// What the next receiver is created with
+struct OKQosDecision
+{
+    uint32_t level_ = 0;
+    uint32_t max_bitrate_kbps_ = 0;
+    float max_res_factor_ = DEFAULT_CLOUDXR_MAX_RES_FACTOR;
+    uint32_t foveation_ = 0;
+
+    bool operator==(const OKQosDecision& other) const
+    {
+        return (level_ == other.level_) && (max_bitrate_kbps_ == other.max_bitrate_kbps_) &&
+               (max_res_factor_ == other.max_res_factor_) && (foveation_ == other.foveation_);
+    }
+
+    bool operator!=(const OKQosDecision& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Closed loop over cxrConnectionStats, holding frameDeliveryTimeMs near a target. CloudXR only
+// takes the bitrate cap, resolution factor and foveation when a receiver is created, so each
+// step down the ladder (lower res factor, tighter foveation, bitrate under the measured
+// bandwidth) applies to the next receiver: on the next reconnect, or on one made for it once
+// the old level has run QOS_RECONNECT_MIN_MS. Stepping down takes QOS_DOWNGRADE_HOLD_MS of
+// congestion, stepping back up QOS_UPGRADE_HOLD_MS of headroom, doubled each time a step up
+// had to be taken back. Only one step is pending at a time, stats from a stream still on the
+// old level say nothing about the new one.
+//
+// No CloudXR calls and no clock of its own: update() takes the stats and the time, so a
+// recorded stats trace replays offline through the same decisions (see ok_qos_replay).
+class OKQosController
+{
+public:
+    void configure(const OKQosSettings& settings);
+
+    // New receiver, the cumulative packet counters start over. The level carries over.
+    void reset_session();
+
+    // One cxrGetConnectionStats sample, true when the decision changed
+    bool update(const cxrConnectionStats& stats, const uint64_t now_time_ns);
+
+    const OKQosDecision& get_decision() const
+    {
+        return decision_;
+    }
+
+    // The receiver was created with get_decision()
+    void on_applied(const uint64_t now_time_ns);
+
+    const OKQosDecision& get_applied_decision() const
+    {
+        return applied_decision_;
+    }
+
+    // Worth tearing the stream down to apply the decision now rather than on the next reconnect
+    bool should_reconnect(const uint64_t now_time_ns) const;
+
+    OKQosCondition get_condition() const
+    {
+        return condition_;
+    }
+
+    float get_smoothed_delivery_ms() const
+    {
+        return smoothed_delivery_ms_;
+    }
+
+    float get_packet_loss_percent() const
+    {
+        return packet_loss_percent_;
+    }
+
+    uint32_t get_level_change_count() const
+    {
+        return level_change_count_;
+    }
+
+private:
+    OKQosCondition classify(const cxrConnectionStats& stats) const;
+    void set_level(const uint32_t level);
+
+    OKQosSettings settings_;
+    OKQosDecision decision_;
+    OKQosDecision applied_decision_;
+    uint64_t applied_time_ns_ = 0;
+
+    OKQosCondition condition_ = QosCondition_Unknown;
+    uint64_t condition_start_time_ns_ = 0;
+
+    float smoothed_delivery_ms_ = 0.0f;
+    float smoothed_bandwidth_kbps_ = 0.0f;
+    float last_bandwidth_kbps_ = 0.0f;
+    float packet_loss_percent_ = 0.0f;
+    uint32_t bandwidth_cap_kbps_ = 0;   // from the bandwidth at the last step, 0 = none
+
+    uint32_t upgrade_hold_ms_ = QOS_UPGRADE_HOLD_MS;
+    bool is_probing_ = false;           // stepped up, not yet held for upgrade_hold_ms_
+    uint64_t probe_start_time_ns_ = 0;
+
+    uint32_t last_packets_received_ = 0;
+    uint32_t last_packets_lost_ = 0;
+    bool has_packet_totals_ = false;
+
+    uint32_t level_change_count_ = 0;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_QOS_CONTROLLER_H
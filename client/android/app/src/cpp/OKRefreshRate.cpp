@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKRefreshRate.h"
+
+#if ENABLE_CLOUDXR
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace BVR
+{
+
+bool is_same_refresh_rate(const float rate_a, const float rate_b)
+{
+    return (fabsf(rate_a - rate_b) <= REFRESH_RATE_TOLERANCE_HZ);
+}
+
+float choose_display_refresh_rate(const std::vector<float>& supported_rates, const float desired_rate, const float current_rate)
+{
+    float best_rate = 0.0f;
+    float best_distance = 0.0f;
+
+    for (const float rate : supported_rates)
+    {
+        if (rate <= 0.0f)
+        {
+            continue;
+        }
+
+        if (desired_rate <= 0.0f)
+        {
+            best_rate = std::max(best_rate, rate);
+            continue;
+        }
+
+        const float distance = fabsf(rate - desired_rate);
+
+        if ((best_rate == 0.0f) || (distance < best_distance) || ((distance == best_distance) && (rate > best_rate)))
+        {
+            best_rate = rate;
+            best_distance = distance;
+        }
+    }
+
+    return (best_rate > 0.0f) ? best_rate : current_rate;
+}
+
+float choose_stream_fps(const float display_rate, const float max_stream_fps)
+{
+    if ((display_rate <= 0.0f) || (max_stream_fps <= 0.0f) || (display_rate <= max_stream_fps + REFRESH_RATE_TOLERANCE_HZ))
+    {
+        return display_rate;
+    }
+
+    // Half of 90 Hz is 45, a third of 120 Hz is 40, never below MIN_CLOUDXR_STREAM_FPS unless the display is
+    uint32_t divisor = (uint32_t)ceilf((display_rate - REFRESH_RATE_TOLERANCE_HZ) / max_stream_fps);
+
+    while ((divisor > 1) && ((display_rate / (float)divisor) < MIN_CLOUDXR_STREAM_FPS))
+    {
+        divisor--;
+    }
+
+    return display_rate / (float)divisor;
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
@@ -0,0 +1,32 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_REFRESH_RATE_H
+#define OK_REFRESH_RATE_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <vector>
+
+namespace BVR
+{
+
+// Runtimes report 72 Hz as 72.0 or 71.99, anything this close is the same rate
+bool is_same_refresh_rate(const float rate_a, const float rate_b);
+
+// Display rate to switch the headset to: the desired one when it's supported, else the nearest
+// supported, the higher on a tie. 0 desired = the highest. No list = stay on the current rate.
+float choose_display_refresh_rate(const std::vector<float>& supported_rates, const float desired_rate, const float current_rate);
+
+// The display rate, or its largest integer divisor that fits under max_stream_fps, so every
+// streamed frame lands on the same number of vsyncs. 0 max = the display rate.
+float choose_stream_fps(const float display_rate, const float max_stream_fps);
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_REFRESH_RATE_H
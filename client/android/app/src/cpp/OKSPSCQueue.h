@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_SPSC_QUEUE_H
+#define OK_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace BVR
+{
+
+// Bounded single-producer / single-consumer queue, preallocated, wait-free on both ends.
+// push() fails instead of blocking when full, so a slow consumer can never stall the producer.
+template<typename T, uint32_t CAPACITY>
+class OKSPSCQueue
+{
+public:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "OKSPSCQueue capacity must be a power of two");
+
+    // Producer thread only
+    bool push(const T& item)
+    {
+        const uint32_t write_index = write_index_.load(std::memory_order_relaxed);
+        const uint32_t read_index = read_index_.load(std::memory_order_acquire);
+
+        if ((write_index - read_index) >= CAPACITY)
+        {
+            return false;
+        }
+
+        items_[write_index & (CAPACITY - 1)] = item;
+        write_index_.store(write_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only
+    bool pop(T& item)
+    {
+        const uint32_t read_index = read_index_.load(std::memory_order_relaxed);
+        const uint32_t write_index = write_index_.load(std::memory_order_acquire);
+
+        if (read_index == write_index)
+        {
+            return false;
+        }
+
+        item = items_[read_index & (CAPACITY - 1)];
+        read_index_.store(read_index + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t size() const
+    {
+        return write_index_.load(std::memory_order_acquire) - read_index_.load(std::memory_order_acquire);
+    }
+
+    bool is_empty() const
+    {
+        return (size() == 0);
+    }
+
+    static uint32_t capacity()
+    {
+        return CAPACITY;
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> write_index_ = {0};
+    alignas(64) std::atomic<uint32_t> read_index_ = {0};
+    T items_[CAPACITY];
+};
+
+} // namespace BVR
+
+#endif // OK_SPSC_QUEUE_H
+
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_SEQ_LOCK_H
+#define OK_SEQ_LOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace BVR
+{
+
+// Single-writer / multi-reader sequence lock. The writer never blocks, readers retry if
+// they raced a store, so neither side can stall the other or observe a half-written value.
+// The payload lives in relaxed atomic words, so there is no data race in the C++ sense.
+template<typename T>
+class OKSeqLock
+{
+public:
+    static_assert(std::is_trivially_copyable<T>::value, "OKSeqLock payload must be trivially copyable");
+
+    OKSeqLock()
+    {
+        const T default_value = {};
+        write_words(default_value);
+    }
+
+    // Writer thread only
+    void store(const T& value)
+    {
+        const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        write_words(value);
+
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Returns false if a store was in progress, value is left untouched in that case
+    bool try_load(T& value) const
+    {
+        const uint32_t sequence_before = sequence_.load(std::memory_order_acquire);
+
+        if (sequence_before & 1)
+        {
+            return false;
+        }
+
+        uint64_t buffer[NUM_WORDS];
+
+        for (size_t word_id = 0; word_id < NUM_WORDS; word_id++)
+        {
+            buffer[word_id] = words_[word_id].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        const uint32_t sequence_after = sequence_.load(std::memory_order_relaxed);
+
+        if (sequence_before != sequence_after)
+        {
+            return false;
+        }
+
+        std::memcpy(&value, buffer, sizeof(T));
+        return true;
+    }
+
+    T load() const
+    {
+        T value;
+
+        while (!try_load(value))
+        {
+        }
+
+        return value;
+    }
+
+    // Number of completed stores, 0 means the default value was never overwritten
+    uint32_t get_version() const
+    {
+        return sequence_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    static const size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void write_words(const T& value)
+    {
+        uint64_t buffer[NUM_WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        for (size_t word_id = 0; word_id < NUM_WORDS; word_id++)
+        {
+            words_[word_id].store(buffer[word_id], std::memory_order_relaxed);
+        }
+    }
+
+    alignas(64) std::atomic<uint32_t> sequence_ = {0};
+    std::atomic<uint64_t> words_[NUM_WORDS];
+};
+
+}  // namespace BVR
+
+#endif  // OK_SEQ_LOCK_H
+
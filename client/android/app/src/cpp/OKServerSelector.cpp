@@ -0,0 +1,521 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKServerSelector.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKClock.h"
+#include "OKConfig.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace BVR
+{
+
+namespace
+{
+
+struct OKServerProbeState
+{
+    sockaddr_storage address_ = {};
+    socklen_t address_size_ = 0;
+    int udp_socket_ = -1;
+    int tcp_socket_ = -1;
+    uint32_t reply_count_ = 0;
+    uint32_t load_percent_ = SERVER_LOAD_UNKNOWN;
+    bool is_udp_refused_ = false;
+    bool is_tcp_done_ = false;
+    bool is_tcp_connected_ = false;
+    float udp_rtt_ms_ = 0.0f;
+    float tcp_rtt_ms_ = 0.0f;
+
+    bool is_done() const
+    {
+        return (reply_count_ >= SERVER_PROBE_COUNT) || (is_udp_refused_ && is_tcp_done_);
+    }
+};
+
+bool resolve_address(const std::string& address, const uint16_t port, OKServerProbeState& state)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    addrinfo* address_info = nullptr;
+    const std::string port_string = std::to_string(port);
+
+    if ((getaddrinfo(address.c_str(), port_string.c_str(), &hints, &address_info) != 0) || !address_info)
+    {
+        return false;
+    }
+
+    memcpy(&state.address_, address_info->ai_addr, address_info->ai_addrlen);
+    state.address_size_ = (socklen_t)address_info->ai_addrlen;
+
+    freeaddrinfo(address_info);
+    return true;
+}
+
+void set_port(sockaddr_storage& address, const uint16_t port)
+{
+    if (address.ss_family == AF_INET)
+    {
+        ((sockaddr_in&)address).sin_port = htons(port);
+    }
+    else if (address.ss_family == AF_INET6)
+    {
+        ((sockaddr_in6&)address).sin6_port = htons(port);
+    }
+}
+
+int open_socket(const sockaddr_storage& address, const int type)
+{
+    const int socket_fd = socket(address.ss_family, type, 0);
+
+    if (socket_fd >= 0)
+    {
+        fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    return socket_fd;
+}
+
+void close_socket(int& socket_fd)
+{
+    if (socket_fd >= 0)
+    {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+}
+
+float get_elapsed_ms(const uint64_t start_time_ns, const uint64_t end_time_ns)
+{
+    return (end_time_ns > start_time_ns) ? (float)((double)(end_time_ns - start_time_ns) / 1000000.0) : 0.0f;
+}
+
+void open_probe_sockets(OKServerProbeState& state)
+{
+    // Connected, so only this server's replies come in and a closed port reads as ECONNREFUSED
+    state.udp_socket_ = open_socket(state.address_, SOCK_DGRAM);
+
+    if ((state.udp_socket_ < 0) || (connect(state.udp_socket_, (const sockaddr*)&state.address_, state.address_size_) != 0))
+    {
+        close_socket(state.udp_socket_);
+        state.is_udp_refused_ = true;
+    }
+
+    sockaddr_storage tcp_address = state.address_;
+    set_port(tcp_address, CLOUDXR_SERVER_TCP_PORT);
+    state.tcp_socket_ = open_socket(tcp_address, SOCK_STREAM);
+
+    if ((state.tcp_socket_ < 0) || ((connect(state.tcp_socket_, (const sockaddr*)&tcp_address, state.address_size_) != 0) && (errno != EINPROGRESS)))
+    {
+        close_socket(state.tcp_socket_);
+        state.is_tcp_done_ = true;
+    }
+}
+
+void receive_probe_replies(OKServerProbeState& state, const uint32_t sent_probe_count, const uint64_t now_time_ns)
+{
+    OKServerProbePacket packet;
+    ssize_t received_size = 0;
+
+    while ((received_size = recv(state.udp_socket_, &packet, sizeof(packet), 0)) >= 0)
+    {
+        if ((received_size != (ssize_t)sizeof(packet)) || (packet.magic_ != SERVER_PROBE_MAGIC) || (packet.sequence_ >= sent_probe_count))
+        {
+            continue;
+        }
+
+        const float rtt_ms = get_elapsed_ms(packet.send_time_ns_, now_time_ns);
+        state.udp_rtt_ms_ = (state.reply_count_ == 0) ? rtt_ms : std::min(state.udp_rtt_ms_, rtt_ms);
+        state.reply_count_++;
+
+        if (packet.load_percent_ <= 100)
+        {
+            state.load_percent_ = packet.load_percent_;
+        }
+    }
+
+    // ICMP port unreachable: the host is up but nothing answers probes there
+    if ((errno == ECONNREFUSED) && (state.reply_count_ == 0))
+    {
+        state.is_udp_refused_ = true;
+    }
+}
+
+void finish_tcp_connect(OKServerProbeState& state, const uint64_t start_time_ns, const uint64_t now_time_ns)
+{
+    int socket_error = 0;
+    socklen_t socket_error_size = sizeof(socket_error);
+    getsockopt(state.tcp_socket_, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_size);
+
+    state.is_tcp_done_ = true;
+    state.is_tcp_connected_ = (socket_error == 0);
+    state.tcp_rtt_ms_ = get_elapsed_ms(start_time_ns, now_time_ns);
+    close_socket(state.tcp_socket_);
+}
+
+} // namespace
+
+std::vector<OKServerProbeResult> probe_servers(const std::vector<std::string>& addresses, const uint16_t probe_port, const uint32_t timeout_ms)
+{
+    const uint64_t start_time_ns = get_monotonic_time_ns();
+    const uint64_t deadline_ns = start_time_ns + (uint64_t)timeout_ms * 1000000ULL;
+
+    std::vector<OKServerProbeState> states(addresses.size());
+
+    for (size_t server_id = 0; server_id < addresses.size(); server_id++)
+    {
+        OKServerProbeState& state = states[server_id];
+
+        if (resolve_address(addresses[server_id], probe_port, state))
+        {
+            open_probe_sockets(state);
+        }
+        else
+        {
+            state.is_udp_refused_ = true;
+            state.is_tcp_done_ = true;
+        }
+    }
+
+    uint32_t sent_probe_count = 0;
+    uint64_t next_send_time_ns = start_time_ns;
+
+    std::vector<pollfd> poll_fds;
+    std::vector<size_t> poll_server_ids;
+
+    while (true)
+    {
+        uint64_t now_time_ns = get_monotonic_time_ns();
+
+        const bool are_all_done = std::all_of(states.begin(), states.end(), [](const OKServerProbeState& state) { return state.is_done(); });
+
+        if (are_all_done || (now_time_ns >= deadline_ns))
+        {
+            break;
+        }
+
+        if ((sent_probe_count < SERVER_PROBE_COUNT) && (now_time_ns >= next_send_time_ns))
+        {
+            for (OKServerProbeState& state : states)
+            {
+                if ((state.udp_socket_ >= 0) && !state.is_udp_refused_)
+                {
+                    OKServerProbePacket packet;
+                    packet.sequence_ = sent_probe_count;
+                    packet.send_time_ns_ = get_monotonic_time_ns();
+                    send(state.udp_socket_, &packet, sizeof(packet), 0);
+                }
+            }
+
+            sent_probe_count++;
+            next_send_time_ns += (uint64_t)SERVER_PROBE_INTERVAL_MS * 1000000ULL;
+        }
+
+        poll_fds.clear();
+        poll_server_ids.clear();
+
+        for (size_t server_id = 0; server_id < states.size(); server_id++)
+        {
+            const OKServerProbeState& state = states[server_id];
+
+            if ((state.udp_socket_ >= 0) && !state.is_udp_refused_ && (state.reply_count_ < SERVER_PROBE_COUNT))
+            {
+                poll_fds.push_back({state.udp_socket_, POLLIN, 0});
+                poll_server_ids.push_back(server_id);
+            }
+
+            if ((state.tcp_socket_ >= 0) && !state.is_tcp_done_)
+            {
+                poll_fds.push_back({state.tcp_socket_, POLLOUT, 0});
+                poll_server_ids.push_back(server_id);
+            }
+        }
+
+        const uint64_t wake_time_ns = (sent_probe_count < SERVER_PROBE_COUNT) ? std::min(next_send_time_ns, deadline_ns) : deadline_ns;
+        const int wait_ms = (int)((std::max(wake_time_ns, now_time_ns) - now_time_ns + 999999ULL) / 1000000ULL);
+
+        if (poll(poll_fds.data(), (nfds_t)poll_fds.size(), wait_ms) <= 0)
+        {
+            continue;
+        }
+
+        now_time_ns = get_monotonic_time_ns();
+
+        for (size_t poll_id = 0; poll_id < poll_fds.size(); poll_id++)
+        {
+            const pollfd& poll_fd = poll_fds[poll_id];
+            OKServerProbeState& state = states[poll_server_ids[poll_id]];
+
+            if (poll_fd.revents == 0)
+            {
+                continue;
+            }
+
+            if (poll_fd.fd == state.udp_socket_)
+            {
+                receive_probe_replies(state, sent_probe_count, now_time_ns);
+            }
+            else
+            {
+                finish_tcp_connect(state, start_time_ns, now_time_ns);
+            }
+        }
+    }
+
+    std::vector<OKServerProbeResult> results(addresses.size());
+    const uint64_t probe_time_s = (uint64_t)time(nullptr);
+
+    for (size_t server_id = 0; server_id < addresses.size(); server_id++)
+    {
+        OKServerProbeState& state = states[server_id];
+        OKServerProbeResult& result = results[server_id];
+
+        result.address_ = addresses[server_id];
+        result.has_responder_ = (state.reply_count_ > 0);
+        result.is_reachable_ = result.has_responder_ || state.is_tcp_connected_;
+        result.rtt_ms_ = result.has_responder_ ? state.udp_rtt_ms_ : (state.is_tcp_connected_ ? state.tcp_rtt_ms_ : 0.0f);
+        result.load_percent_ = state.load_percent_;
+        result.probe_time_s_ = probe_time_s;
+
+        close_socket(state.udp_socket_);
+        close_socket(state.tcp_socket_);
+    }
+
+    return results;
+}
+
+void rank_servers(std::vector<OKServerProbeResult>& results)
+{
+    std::stable_sort(results.begin(), results.end(), [](const OKServerProbeResult& a, const OKServerProbeResult& b)
+    {
+        if (a.is_reachable_ != b.is_reachable_)
+        {
+            return a.is_reachable_;
+        }
+
+        return (a.get_score_ms() < b.get_score_ms());
+    });
+}
+
+bool load_server_cache(const std::string& path, const std::vector<std::string>& candidates, const uint32_t ttl_s,
+                       std::vector<OKServerProbeResult>& results)
+{
+    results.clear();
+
+    std::string cache_json;
+
+    if (!read_file(path, cache_json) || cache_json.empty())
+    {
+        return false;
+    }
+
+    JSONCPP_STRING err;
+    Json::Value root;
+
+    Json::CharReaderBuilder builder;
+    const std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+
+    if (!reader->parse(cache_json.c_str(), cache_json.c_str() + cache_json.size(), &root, &err) || !root["servers"].isArray())
+    {
+        return false;
+    }
+
+    const uint64_t now_s = (uint64_t)time(nullptr);
+
+    for (const Json::Value& server_value : root["servers"])
+    {
+        OKServerProbeResult result;
+        result.address_ = server_value["address"].asString();
+        result.is_reachable_ = server_value["is_reachable"].asBool();
+        result.has_responder_ = server_value["has_responder"].asBool();
+        result.rtt_ms_ = server_value["rtt_ms"].asFloat();
+        result.load_percent_ = server_value["load_percent"].isUInt() ? server_value["load_percent"].asUInt() : SERVER_LOAD_UNKNOWN;
+        result.probe_time_s_ = server_value["probe_time_s"].asUInt64();
+
+        const bool is_candidate = (std::find(candidates.begin(), candidates.end(), result.address_) != candidates.end());
+        const bool is_fresh = (result.probe_time_s_ <= now_s) && ((now_s - result.probe_time_s_) < ttl_s);
+
+        if (is_candidate && is_fresh && result.is_reachable_)
+        {
+            results.push_back(result);
+        }
+    }
+
+    rank_servers(results);
+    return !results.empty();
+}
+
+bool save_server_cache(const std::string& path, const std::vector<OKServerProbeResult>& results)
+{
+    Json::Value root;
+    Json::Value& servers_value = root["servers"];
+    servers_value = Json::Value(Json::arrayValue);
+
+    for (const OKServerProbeResult& result : results)
+    {
+        Json::Value server_value;
+        server_value["address"] = result.address_;
+        server_value["is_reachable"] = result.is_reachable_;
+        server_value["has_responder"] = result.has_responder_;
+        server_value["rtt_ms"] = result.rtt_ms_;
+
+        if (result.load_percent_ <= 100)
+        {
+            server_value["load_percent"] = result.load_percent_;
+        }
+
+        server_value["probe_time_s"] = (Json::UInt64)result.probe_time_s_;
+        servers_value.append(server_value);
+    }
+
+    Json::StreamWriterBuilder builder;
+    const std::string cache_json = Json::writeString(builder, root);
+
+    FILE* file = fopen(path.c_str(), "w");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    const bool write_ok = (fwrite(cache_json.data(), 1, cache_json.size(), file) == cache_json.size());
+    fclose(file);
+    return write_ok;
+}
+
+OKServerSelector::~OKServerSelector()
+{
+    stop();
+}
+
+void OKServerSelector::start(const std::vector<std::string>& candidates, const uint16_t probe_port, const std::string& cache_path, const uint32_t cache_ttl_s)
+{
+    stop();
+
+    candidates_ = candidates;
+    probe_port_ = probe_port;
+    cache_path_ = cache_path;
+    is_cache_hit_ = false;
+    is_ready_.store(false, std::memory_order_release);
+    probe_ms_.store(0.0f, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ranking_.clear();
+        server_address_ = candidates.empty() ? std::string() : candidates[0];
+    }
+
+    if (candidates.size() <= 1)
+    {
+        is_ready_.store(true, std::memory_order_release);
+        return;
+    }
+
+    std::vector<OKServerProbeResult> cached_results;
+
+    if ((cache_ttl_s > 0) && load_server_cache(cache_path_, candidates_, cache_ttl_s, cached_results))
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ranking_ = cached_results;
+        server_address_ = ranking_[0].address_;
+        is_cache_hit_ = true;
+        is_ready_.store(true, std::memory_order_release);
+    }
+
+    thread_ = std::thread(&OKServerSelector::run, this);
+}
+
+void OKServerSelector::stop()
+{
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+std::string OKServerSelector::get_server() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return server_address_;
+}
+
+void OKServerSelector::fail_over()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Unprobed candidates go after the ranked ones
+    std::vector<std::string> order;
+
+    for (const OKServerProbeResult& result : ranking_)
+    {
+        order.push_back(result.address_);
+    }
+
+    for (const std::string& candidate : candidates_)
+    {
+        if (std::find(order.begin(), order.end(), candidate) == order.end())
+        {
+            order.push_back(candidate);
+        }
+    }
+
+    if (order.size() <= 1)
+    {
+        return;
+    }
+
+    const size_t current_id = std::find(order.begin(), order.end(), server_address_) - order.begin();
+    server_address_ = order[(current_id + 1) % order.size()];
+}
+
+std::vector<OKServerProbeResult> OKServerSelector::get_ranking() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ranking_;
+}
+
+void OKServerSelector::run()
+{
+    const uint64_t probe_start_time_ns = get_monotonic_time_ns();
+
+    std::vector<OKServerProbeResult> results = probe_servers(candidates_, probe_port_, SERVER_PROBE_TIMEOUT_MS);
+    rank_servers(results);
+
+    probe_ms_.store((float)((double)(get_monotonic_time_ns() - probe_start_time_ns) / 1000000.0), std::memory_order_release);
+
+    save_server_cache(cache_path_, results);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ranking_ = results;
+
+    // A cache hit already picked one and may be connected to it, the fresh ranking only matters
+    // for the next start and for fail_over
+    if (!is_cache_hit_ && !results.empty())
+    {
+        server_address_ = results[0].address_;
+    }
+
+    is_ready_.store(true, std::memory_order_release);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
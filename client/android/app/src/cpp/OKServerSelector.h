@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_SERVER_SELECTOR_H
+#define OK_SERVER_SELECTOR_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BVR
+{
+
+const uint32_t SERVER_PROBE_MAGIC = 0x50534B4F; // 'OKSP'
+const uint32_t SERVER_LOAD_UNKNOWN = UINT32_MAX;
+
+// UDP probe and its echo. The responder sends the request back as is, with load_percent_ set.
+struct OKServerProbePacket
+{
+    uint32_t magic_ = SERVER_PROBE_MAGIC;
+    uint32_t sequence_ = 0;
+    uint64_t send_time_ns_ = 0;                 // client clock, only the client reads it
+    uint32_t load_percent_ = SERVER_LOAD_UNKNOWN; // 0 - 100, GPU / session load of the server
+    uint32_t reserved_ = 0;
+};
+
+static_assert(sizeof(OKServerProbePacket) == 24, "OKServerProbePacket is sent as is");
+
+struct OKServerProbeResult
+{
+    std::string address_;
+    bool is_reachable_ = false;
+    bool has_responder_ = false;    // answered the UDP probe, else the RTT is the TCP connect time
+    float rtt_ms_ = 0.0f;
+    uint32_t load_percent_ = SERVER_LOAD_UNKNOWN;
+    uint64_t probe_time_s_ = 0;     // wall clock, for the cache TTL
+
+    float get_score_ms() const
+    {
+        const uint32_t load_percent = (load_percent_ <= 100) ? load_percent_ : SERVER_UNKNOWN_LOAD_PERCENT;
+        return rtt_ms_ + (SERVER_LOAD_PENALTY_MS * (float)load_percent);
+    }
+};
+
+// Probes every address at once from the calling thread: SERVER_PROBE_COUNT UDP probes to
+// probe_port each, the fastest echo counts, plus a non-blocking TCP connect to
+// CLOUDXR_SERVER_TCP_PORT for servers without a responder. Returns within timeout_ms.
+std::vector<OKServerProbeResult> probe_servers(const std::vector<std::string>& addresses, const uint16_t probe_port, const uint32_t timeout_ms);
+
+// Reachable servers first, lowest score first
+void rank_servers(std::vector<OKServerProbeResult>& results);
+
+// Fresh (probed less than ttl_s ago) reachable entries for the given candidates, ranked
+bool load_server_cache(const std::string& path, const std::vector<std::string>& candidates, const uint32_t ttl_s,
+                       std::vector<OKServerProbeResult>& results);
+bool save_server_cache(const std::string& path, const std::vector<OKServerProbeResult>& results);
+
+// Which server to connect to. A single candidate is picked at once. Otherwise a fresh cache
+// picks the best cached server at once and the probe only refreshes the cache in the background,
+// so a restart reconnects to the fastest host without waiting; without one, the pick is ready
+// once the probe is done (SERVER_PROBE_TIMEOUT_MS at most).
+class OKServerSelector
+{
+public:
+    ~OKServerSelector();
+
+    void start(const std::vector<std::string>& candidates, const uint16_t probe_port, const std::string& cache_path, const uint32_t cache_ttl_s);
+    void stop();
+
+    bool is_ready() const
+    {
+        return is_ready_.load(std::memory_order_acquire);
+    }
+
+    bool is_cache_hit() const
+    {
+        return is_cache_hit_;
+    }
+
+    std::string get_server() const;
+
+    // The next server in the ranking, after the current one kept failing
+    void fail_over();
+
+    std::vector<OKServerProbeResult> get_ranking() const;
+
+    // Time the probe took, 0 until it's done
+    float get_probe_ms() const
+    {
+        return probe_ms_.load(std::memory_order_acquire);
+    }
+
+private:
+    void run();
+
+    std::vector<std::string> candidates_;
+    uint16_t probe_port_ = SERVER_PROBE_PORT;
+    std::string cache_path_;
+    bool is_cache_hit_ = false;
+
+    mutable std::mutex mutex_;
+    std::vector<OKServerProbeResult> ranking_;
+    std::string server_address_;
+
+    std::thread thread_;
+    std::atomic<bool> is_ready_ = {false};
+    std::atomic<float> probe_ms_ = {0.0f};
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_SERVER_SELECTOR_H
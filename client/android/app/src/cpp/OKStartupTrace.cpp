@@ -0,0 +1,126 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKStartupTrace.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKClock.h"
+
+#include <stdio.h>
+
+namespace BVR
+{
+
+void OKStartupTrace::reset(const uint64_t origin_time_ns)
+{
+    origin_time_ns_ = origin_time_ns;
+
+    for (int phase_id = 0; phase_id < STARTUP_PHASE_COUNT; phase_id++)
+    {
+        start_times_ns_[phase_id].store(0, std::memory_order_relaxed);
+        end_times_ns_[phase_id].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool OKStartupTrace::begin(const OKStartupPhase phase)
+{
+    uint64_t expected_time_ns = 0;
+    return start_times_ns_[phase].compare_exchange_strong(expected_time_ns, get_monotonic_time_ns(), std::memory_order_acq_rel);
+}
+
+bool OKStartupTrace::end(const OKStartupPhase phase)
+{
+    // Ends only the run that began it
+    if (start_times_ns_[phase].load(std::memory_order_acquire) == 0)
+    {
+        return false;
+    }
+
+    uint64_t expected_time_ns = 0;
+    return end_times_ns_[phase].compare_exchange_strong(expected_time_ns, get_monotonic_time_ns(), std::memory_order_acq_rel);
+}
+
+bool OKStartupTrace::mark(const OKStartupPhase phase)
+{
+    return begin(phase) && end(phase);
+}
+
+bool OKStartupTrace::has_phase(const OKStartupPhase phase) const
+{
+    return (end_times_ns_[phase].load(std::memory_order_acquire) != 0);
+}
+
+float OKStartupTrace::get_start_ms(const OKStartupPhase phase) const
+{
+    return convert_to_ms(start_times_ns_[phase].load(std::memory_order_acquire));
+}
+
+float OKStartupTrace::get_end_ms(const OKStartupPhase phase) const
+{
+    return convert_to_ms(end_times_ns_[phase].load(std::memory_order_acquire));
+}
+
+const char* OKStartupTrace::get_phase_name(const OKStartupPhase phase)
+{
+    static const char* phase_names[STARTUP_PHASE_COUNT] =
+    {
+        "init",
+        "config_load",
+        "input_profile",
+        "audio_open",
+        "receiver_desc",
+        "server_select",
+        "create_receiver",
+        "connect",
+        "add_controllers",
+        "first_frame",
+    };
+
+    return ((phase >= 0) && (phase < STARTUP_PHASE_COUNT)) ? phase_names[phase] : "unknown";
+}
+
+bool OKStartupTrace::write(const std::string& path) const
+{
+    FILE* file = fopen(path.c_str(), "w");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    fprintf(file, "phase,start_ms,end_ms,duration_ms\n");
+
+    for (int phase_id = 0; phase_id < STARTUP_PHASE_COUNT; phase_id++)
+    {
+        const OKStartupPhase phase = (OKStartupPhase)phase_id;
+
+        if (!has_phase(phase))
+        {
+            continue;
+        }
+
+        const float start_ms = get_start_ms(phase);
+        const float end_ms = get_end_ms(phase);
+
+        fprintf(file, "%s,%.3f,%.3f,%.3f\n", get_phase_name(phase), start_ms, end_ms, end_ms - start_ms);
+    }
+
+    fclose(file);
+    return true;
+}
+
+float OKStartupTrace::convert_to_ms(const uint64_t time_ns) const
+{
+    if ((time_ns == 0) || (time_ns < origin_time_ns_))
+    {
+        return -1.0f;
+    }
+
+    return (float)((double)(time_ns - origin_time_ns_) / 1000000.0);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
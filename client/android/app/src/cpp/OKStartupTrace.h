@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_STARTUP_TRACE_H
+#define OK_STARTUP_TRACE_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace BVR
+{
+
+typedef enum
+{
+    StartupPhase_Init,              // init_android_gles, from the first frame the session renders
+    StartupPhase_ConfigLoad,
+    StartupPhase_InputProfile,
+    StartupPhase_AudioOpen,         // Oboe streams, on a worker thread
+    StartupPhase_ReceiverDesc,
+    StartupPhase_ServerSelect,      // until a server is picked, cache or probe
+    StartupPhase_CreateReceiver,
+    StartupPhase_Connect,           // cxrConnect until the stream is up
+    StartupPhase_AddControllers,    // from the tracking callback, once streaming
+    StartupPhase_FirstFrame,
+
+    STARTUP_PHASE_COUNT
+} OKStartupPhase;
+
+// Start and end of each cold start phase, relative to the client's construction. Only the
+// first time a phase runs is kept, reconnects don't overwrite it. Lock-free, any thread.
+class OKStartupTrace
+{
+public:
+    void reset(const uint64_t origin_time_ns);
+
+    // True when this call recorded it, false when the phase already has its time
+    bool begin(const OKStartupPhase phase);
+    bool end(const OKStartupPhase phase);
+    bool mark(const OKStartupPhase phase);
+
+    bool has_phase(const OKStartupPhase phase) const;
+
+    // Milliseconds since the origin, -1 when the phase hasn't started (or ended) yet
+    float get_start_ms(const OKStartupPhase phase) const;
+    float get_end_ms(const OKStartupPhase phase) const;
+
+    static const char* get_phase_name(const OKStartupPhase phase);
+
+    // CSV, one line per phase that ran: phase,start_ms,end_ms,duration_ms
+    bool write(const std::string& path) const;
+
+private:
+    float convert_to_ms(const uint64_t time_ns) const;
+
+    uint64_t origin_time_ns_ = 0;
+    std::atomic<uint64_t> start_times_ns_[STARTUP_PHASE_COUNT] = {};
+    std::atomic<uint64_t> end_times_ns_[STARTUP_PHASE_COUNT] = {};
+};
+
+class OKStartupScope
+{
+public:
+    OKStartupScope(OKStartupTrace& trace, const OKStartupPhase phase) : trace_(trace), phase_(phase)
+    {
+        trace_.begin(phase_);
+    }
+
+    ~OKStartupScope()
+    {
+        trace_.end(phase_);
+    }
+
+private:
+    OKStartupTrace& trace_;
+    const OKStartupPhase phase_;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_STARTUP_TRACE_H
@@ -0,0 +1,325 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKTelemetry.h"
+#include "OKClock.h"
+
+#include <chrono>
+
+namespace BVR
+{
+
+static float convert_ns_to_ms(const uint64_t duration_ns)
+{
+    return (float)((double)duration_ns / 1000000.0);
+}
+
+OKTelemetry::OKTelemetry()
+{
+}
+
+OKTelemetry::~OKTelemetry()
+{
+    stop();
+}
+
+bool OKTelemetry::start(const std::string& trace_path)
+{
+    if (is_running())
+    {
+        return true;
+    }
+
+    if (!trace_path.empty())
+    {
+        const bool is_new_trace = (trace_path != trace_path_);
+        trace_file_ = fopen(trace_path.c_str(), is_new_trace ? "wb" : "ab");
+
+        if (trace_file_)
+        {
+            if (is_new_trace)
+            {
+                trace_path_ = trace_path;
+                trace_session_count_ = 0;
+            }
+
+            OKTelemetryTraceHeader trace_header;
+            trace_header.start_time_ns_ = get_monotonic_time_ns();
+            trace_header.session_id_ = trace_session_count_++;
+            fwrite(&trace_header, sizeof(trace_header), 1, trace_file_);
+        }
+        else
+        {
+            //IGLLog(IGLLogLevel::LOG_ERROR, "OKTelemetry::start - could not open trace file %s\n", trace_path.c_str());
+        }
+    }
+
+    for (uint32_t event_id = 0; event_id < TelemetryEvent_ConnectionStats; event_id++)
+    {
+        histograms_[event_id].reset();
+    }
+
+    dropped_record_count_.store(0, std::memory_order_relaxed);
+
+    for (uint32_t result_id = 0; result_id < LATCH_RESULT_COUNT; result_id++)
+    {
+        latch_result_counts_[result_id].store(0, std::memory_order_relaxed);
+    }
+
+    repeated_frame_count_.store(0, std::memory_order_relaxed);
+
+    has_packet_totals_ = false;
+    window_packets_received_ = 0;
+    window_packets_lost_ = 0;
+
+    should_stop_.store(false, std::memory_order_release);
+
+    is_running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&OKTelemetry::run, this);
+
+    return true;
+}
+
+void OKTelemetry::stop()
+{
+    if (!thread_.joinable())
+    {
+        return;
+    }
+
+    should_stop_.store(true, std::memory_order_release);
+    thread_.join();
+
+    is_running_.store(false, std::memory_order_release);
+
+    if (trace_file_)
+    {
+        fclose(trace_file_);
+        trace_file_ = nullptr;
+    }
+}
+
+void OKTelemetry::record_frame_event(const OKTelemetryEventType type, const uint64_t start_time_ns, const uint64_t end_time_ns, const int32_t result)
+{
+    if (!is_running())
+    {
+        return;
+    }
+
+    OKTelemetryRecord record;
+    record.type_ = type;
+    record.result_ = result;
+    record.timestamp_ns_ = start_time_ns;
+    record.duration_ns_ = (end_time_ns > start_time_ns) ? (end_time_ns - start_time_ns) : 0;
+
+    if (!queue_.push(record))
+    {
+        dropped_record_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void OKTelemetry::record_connection_stats(const cxrConnectionStats& stats, const uint64_t timestamp_ns)
+{
+    if (!is_running())
+    {
+        return;
+    }
+
+    OKTelemetryStatsRecord stats_record;
+    stats_record.timestamp_ns_ = timestamp_ns;
+    stats_record.stats_ = stats;
+
+    if (!stats_queue_.push(stats_record))
+    {
+        dropped_record_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void OKTelemetry::record_latch_result(const OKLatchResult latch_result)
+{
+    if (!is_running() || (latch_result >= LATCH_RESULT_COUNT))
+    {
+        return;
+    }
+
+    latch_result_counts_[latch_result].fetch_add(1, std::memory_order_relaxed);
+}
+
+void OKTelemetry::record_repeated_frame()
+{
+    if (!is_running())
+    {
+        return;
+    }
+
+    repeated_frame_count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OKTelemetry::run()
+{
+    const std::chrono::milliseconds drain_period(TELEMETRY_DRAIN_PERIOD_MS);
+    uint64_t window_start_time_ns = get_monotonic_time_ns();
+
+    while (!should_stop_.load(std::memory_order_acquire))
+    {
+        std::this_thread::sleep_for(drain_period);
+        drain();
+
+        const uint64_t now_time_ns = get_monotonic_time_ns();
+
+        if ((now_time_ns - window_start_time_ns) >= (TELEMETRY_WINDOW_MS * 1000000ULL))
+        {
+            publish_summary(window_start_time_ns, now_time_ns);
+            window_start_time_ns = now_time_ns;
+        }
+    }
+
+    drain();
+
+    if (trace_file_)
+    {
+        fflush(trace_file_);
+    }
+}
+
+void OKTelemetry::drain()
+{
+    OKTelemetryStatsRecord stats_record;
+    bool has_stats_record = stats_queue_.pop(stats_record);
+
+    OKTelemetryRecord record;
+
+    while (queue_.pop(record))
+    {
+        // Both rings are filled by the render thread, merge them back into time order for the trace
+        while (has_stats_record && (stats_record.timestamp_ns_ <= record.timestamp_ns_))
+        {
+            handle_stats_record(stats_record);
+            has_stats_record = stats_queue_.pop(stats_record);
+        }
+
+        if (record.type_ < TelemetryEvent_ConnectionStats)
+        {
+            histograms_[record.type_].record(record.duration_ns_);
+        }
+
+        write_record(record);
+    }
+
+    while (has_stats_record)
+    {
+        handle_stats_record(stats_record);
+        has_stats_record = stats_queue_.pop(stats_record);
+    }
+}
+
+void OKTelemetry::handle_stats_record(const OKTelemetryStatsRecord& stats_record)
+{
+    const cxrConnectionStats& stats = stats_record.stats_;
+
+    // The totals are cumulative per receiver, fold the deltas into the window as OKQosController::update does
+    if (has_packet_totals_)
+    {
+        const bool has_restarted = (stats.totalPacketsReceived < last_stats_.totalPacketsReceived) || (stats.totalPacketsLost < last_stats_.totalPacketsLost);
+
+        // A new receiver counts from 0
+        window_packets_received_ += has_restarted ? stats.totalPacketsReceived : (stats.totalPacketsReceived - last_stats_.totalPacketsReceived);
+        window_packets_lost_ += has_restarted ? stats.totalPacketsLost : (stats.totalPacketsLost - last_stats_.totalPacketsLost);
+    }
+
+    last_stats_ = stats;
+    has_packet_totals_ = true;
+
+    write_stats_record(stats_record);
+}
+
+void OKTelemetry::publish_summary(const uint64_t window_start_time_ns, const uint64_t now_time_ns)
+{
+    OKTelemetrySummary summary;
+    summary.window_end_time_ns_ = now_time_ns;
+
+    for (uint32_t event_id = 0; event_id < TelemetryEvent_ConnectionStats; event_id++)
+    {
+        OKLatencyHistogram& histogram = histograms_[event_id];
+        OKTelemetryPercentiles& percentiles = summary.frame_events_[event_id];
+
+        percentiles.count_ = histogram.get_count();
+        percentiles.p50_ms_ = convert_ns_to_ms(histogram.get_percentile_ns(0.50f));
+        percentiles.p95_ms_ = convert_ns_to_ms(histogram.get_percentile_ns(0.95f));
+        percentiles.p99_ms_ = convert_ns_to_ms(histogram.get_percentile_ns(0.99f));
+        percentiles.max_ms_ = convert_ns_to_ms(histogram.get_max_ns());
+
+        histogram.reset();
+    }
+
+    for (uint32_t result_id = 0; result_id < LATCH_RESULT_COUNT; result_id++)
+    {
+        summary.latch_results_[result_id] = latch_result_counts_[result_id].exchange(0, std::memory_order_relaxed);
+    }
+
+    const uint32_t repeated_frame_count = repeated_frame_count_.exchange(0, std::memory_order_relaxed);
+    const float window_s = (float)(now_time_ns - window_start_time_ns) * NS_TO_SEC;
+
+    if (window_s > 0.0f)
+    {
+        summary.repeated_frames_per_second_ = (float)repeated_frame_count / window_s;
+    }
+
+    summary.last_stats_ = last_stats_;
+
+    const uint32_t window_packets = window_packets_received_ + window_packets_lost_;
+
+    if (window_packets > 0)
+    {
+        summary.packet_loss_percent_ = 100.0f * (float)window_packets_lost_ / (float)window_packets;
+    }
+
+    window_packets_received_ = 0;
+    window_packets_lost_ = 0;
+
+    summary.dropped_record_count_ = dropped_record_count_.load(std::memory_order_relaxed);
+
+    summary_.store(summary);
+
+    //IGLLog(IGLLogLevel::LOG_INFO, "OKTelemetry latch p50/p95/p99 = %.2f / %.2f / %.2f ms, delivery = %.2f ms, jitter = %u us, loss = %.2f%%\n",
+    //       summary.frame_events_[TelemetryEvent_LatchFrame].p50_ms_, summary.frame_events_[TelemetryEvent_LatchFrame].p95_ms_,
+    //       summary.frame_events_[TelemetryEvent_LatchFrame].p99_ms_, last_stats_.frameDeliveryTimeMs, last_stats_.jitterUs, summary.packet_loss_percent_);
+}
+
+void OKTelemetry::write_record(const OKTelemetryRecord& record)
+{
+    if (!trace_file_)
+    {
+        return;
+    }
+
+    OKTelemetryTraceFrameEvent frame_event;
+    frame_event.type_ = (uint8_t)record.type_;
+    frame_event.result_ = record.result_;
+    frame_event.timestamp_ns_ = record.timestamp_ns_;
+    frame_event.duration_ns_ = (record.duration_ns_ > UINT32_MAX) ? UINT32_MAX : (uint32_t)record.duration_ns_;
+    fwrite(&frame_event, sizeof(frame_event), 1, trace_file_);
+}
+
+void OKTelemetry::write_stats_record(const OKTelemetryStatsRecord& stats_record)
+{
+    if (!trace_file_)
+    {
+        return;
+    }
+
+    OKTelemetryTraceStatsEvent stats_event;
+    stats_event.timestamp_ns_ = stats_record.timestamp_ns_;
+    stats_event.stats_ = stats_record.stats_;
+    fwrite(&stats_event, sizeof(stats_event), 1, trace_file_);
+}
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
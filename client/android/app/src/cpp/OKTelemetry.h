@@ -0,0 +1,184 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_TELEMETRY_H
+#define OK_TELEMETRY_H
+
+#include "ok_defines.h"
+
+#if ENABLE_CLOUDXR
+
+#include "OKLatencyHistogram.h"
+#include "OKSeqLock.h"
+#include "OKSPSCQueue.h"
+
+#include <CloudXRClient.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+namespace BVR
+{
+
+typedef enum
+{
+    TelemetryEvent_LatchFrame,
+    TelemetryEvent_BlitFrame,
+    TelemetryEvent_ReleaseFrame,
+    TelemetryEvent_ConnectionStats,
+
+    TELEMETRY_EVENT_COUNT
+} OKTelemetryEventType;
+
+typedef enum
+{
+    LatchResult_Waited,  // latched within the remaining frame budget
+    LatchResult_Polled,  // no budget left, latched on a 0 ms poll
+    LatchResult_Missed,  // nothing decoded in time, last good frame re-presented
+    LatchResult_Error,
+
+    LATCH_RESULT_COUNT
+} OKLatchResult;
+
+// Frame events, several per frame, kept small so the ring stays a few cache lines per frame
+struct OKTelemetryRecord
+{
+    uint32_t type_ = TelemetryEvent_LatchFrame;
+    int32_t result_ = 0;
+    uint64_t timestamp_ns_ = 0;
+    uint64_t duration_ns_ = 0;
+};
+
+// Connection stats samples, once per telemetry_stats_interval_ms, in their own ring
+struct OKTelemetryStatsRecord
+{
+    uint64_t timestamp_ns_ = 0;
+    cxrConnectionStats stats_ = {};
+};
+
+struct OKTelemetryPercentiles
+{
+    uint64_t count_ = 0;
+    float p50_ms_ = 0.0f;
+    float p95_ms_ = 0.0f;
+    float p99_ms_ = 0.0f;
+    float max_ms_ = 0.0f;
+};
+
+// Rolling summary over the last TELEMETRY_WINDOW_MS, republished once per window
+struct OKTelemetrySummary
+{
+    uint64_t window_end_time_ns_ = 0;
+
+    OKTelemetryPercentiles frame_events_[TelemetryEvent_ConnectionStats];
+
+    uint32_t latch_results_[LATCH_RESULT_COUNT] = {};
+    float repeated_frames_per_second_ = 0.0f;
+
+    cxrConnectionStats last_stats_ = {};
+    float packet_loss_percent_ = 0.0f; // over this window, not since connect
+
+    uint64_t dropped_record_count_ = 0;
+};
+
+// Binary trace layout: one segment per session (start / stop), each an OKTelemetryTraceHeader then a
+// stream of records starting with a type byte. The magic's first byte is never a record type, so a
+// reader tells the next session's header from a record by that byte.
+#pragma pack(push, 1)
+struct OKTelemetryTraceHeader
+{
+    uint32_t magic_ = TELEMETRY_TRACE_MAGIC;
+    uint32_t version_ = TELEMETRY_TRACE_VERSION;
+    uint64_t start_time_ns_ = 0;
+    uint32_t session_id_ = 0; // 0 for the first session in the file
+};
+
+struct OKTelemetryTraceFrameEvent
+{
+    uint8_t type_ = 0;
+    int32_t result_ = 0;
+    uint64_t timestamp_ns_ = 0;
+    uint32_t duration_ns_ = 0;
+};
+
+struct OKTelemetryTraceStatsEvent
+{
+    uint8_t type_ = TelemetryEvent_ConnectionStats;
+    uint64_t timestamp_ns_ = 0;
+    cxrConnectionStats stats_ = {};
+};
+#pragma pack(pop)
+
+static_assert((TELEMETRY_TRACE_MAGIC & 0xFF) >= TELEMETRY_EVENT_COUNT, "a session header must not read as a record type");
+
+// Producer side (record_*) is the render thread and never blocks or allocates. A low-priority
+// worker drains the ring, folds durations into the histograms and appends to the trace file.
+class OKTelemetry
+{
+public:
+    OKTelemetry();
+    ~OKTelemetry();
+
+    bool start(const std::string& trace_path);
+    void stop();
+
+    bool is_running() const
+    {
+        return is_running_.load(std::memory_order_acquire);
+    }
+
+    void record_frame_event(const OKTelemetryEventType type, const uint64_t start_time_ns, const uint64_t end_time_ns, const int32_t result);
+    void record_connection_stats(const cxrConnectionStats& stats, const uint64_t timestamp_ns);
+    void record_latch_result(const OKLatchResult latch_result);
+    void record_repeated_frame();
+
+    OKTelemetrySummary get_summary() const
+    {
+        return summary_.load();
+    }
+
+private:
+    void run();
+    void drain();
+    void publish_summary(const uint64_t window_start_time_ns, const uint64_t now_time_ns);
+
+    void handle_stats_record(const OKTelemetryStatsRecord& stats_record);
+
+    void write_record(const OKTelemetryRecord& record);
+    void write_stats_record(const OKTelemetryStatsRecord& stats_record);
+
+    std::thread thread_;
+    std::atomic<bool> is_running_ = {false};
+    std::atomic<bool> should_stop_ = {false};
+
+    OKSPSCQueue<OKTelemetryRecord, TELEMETRY_RING_SIZE> queue_;
+    OKSPSCQueue<OKTelemetryStatsRecord, TELEMETRY_STATS_RING_SIZE> stats_queue_;
+    std::atomic<uint64_t> dropped_record_count_ = {0};
+    std::atomic<uint32_t> latch_result_counts_[LATCH_RESULT_COUNT] = {};
+    std::atomic<uint32_t> repeated_frame_count_ = {0};
+
+    // Truncated on the first start of the process, appended to by every later one, so a reconnect
+    // keeps the trace of the session before it
+    std::string trace_path_;
+    uint32_t trace_session_count_ = 0;
+
+    // Consumer thread only
+    FILE* trace_file_ = nullptr;
+    OKLatencyHistogram histograms_[TelemetryEvent_ConnectionStats];
+    cxrConnectionStats last_stats_ = {};
+    bool has_packet_totals_ = false;
+    uint32_t window_packets_received_ = 0;
+    uint32_t window_packets_lost_ = 0;
+
+    OKSeqLock<OKTelemetrySummary> summary_;
+};
+
+} // namespace BVR
+
+#endif // ENABLE_CLOUDXR
+
+#endif // OK_TELEMETRY_H
+
@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_TRACKING_SNAPSHOT_H
+#define OK_TRACKING_SNAPSHOT_H
+
+#include "ok_defines.h"
+#include "GLMPose.h"
+#include "OKController.h"
+#include "OKSeqLock.h"
+
+namespace BVR
+{
+
+// Published by the one thread that samples tracking for the current receiver (the pose sampler when it
+// runs, else the CloudXR callback, see attempt_connect), read by the render thread
+struct OKTrackingSnapshot
+{
+    uint64_t predicted_display_time_ns_ = 0;
+
+    float ipd_meters_ = DEFAULT_CLOUDXR_IPD_M;
+
+    GLMPose hmd_pose_;
+    GLMPose controller_poses_[NUM_CONTROLLERS];
+};
+
+// Published by the render thread every frame, read by the CloudXR tracking thread
+struct OKViewSnapshot
+{
+    bool is_valid_ = false;
+
+    XrPosef eye_poses_[NUM_EYES] = {};
+    XrFovf eye_fovs_[NUM_EYES] = {};
+};
+
+typedef OKSeqLock<OKTrackingSnapshot> OKTrackingSnapshotLock;
+typedef OKSeqLock<OKViewSnapshot> OKViewSnapshotLock;
+
+} // namespace BVR
+
+#endif // OK_TRACKING_SNAPSHOT_H
+
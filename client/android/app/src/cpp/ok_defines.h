@@ -27,6 +27,17 @@
 
 #define DEFAULT_SERVER_IP_ADDRESS "192.168.2.38"
 
+#define SERVER_PROBE_PORT 48099 // UDP, answered by an OKServerProbePacket responder next to the server
+#define CLOUDXR_SERVER_TCP_PORT 48010 // RTSP, its connect time is the RTT of servers without a responder
+#define SERVER_PROBE_COUNT 3 // per server, the fastest reply counts
+#define SERVER_PROBE_INTERVAL_MS 10
+#define SERVER_PROBE_TIMEOUT_MS 300
+#define SERVER_LOAD_PENALTY_MS 0.2f // ranking cost per load percent, a 50% busier server has to be 10 ms closer
+#define SERVER_UNKNOWN_LOAD_PERCENT 50 // servers that don't report their load
+#define SERVER_FAILOVER_FAILURES 2 // consecutive failed attempts before trying the next best server
+#define SERVER_CACHE_FILENAME "ok_server_cache.json"
+#define DEFAULT_SERVER_CACHE_TTL_S 600 // a fresh cache connects to its best server at once, no probing first
+
 #ifndef USE_ADVANCED_IMAGE_READER_DECODER
 #define USE_ADVANCED_IMAGE_READER_DECODER 1
 #endif
@@ -42,23 +53,62 @@
 #define DEFAULT_CLOUDXR_MAX_BITRATE_KBPS 50000 // 0 = unlimited
 
 #define DEFAULT_CLOUDXR_FOVEATION 0 // 0=100, 0=OFF. 25-50 is ok.
+#define MIN_CLOUDXR_RES_FACTOR 0.5f
+#define MAX_CLOUDXR_RES_FACTOR 2.0f
+
+#define ENABLE_QOS 1 // caps bitrate, resolution and foveation from the connection stats, on the next receiver
+#define ENABLE_QOS_BY_DEFAULT 0 // the config's enable_qos, off: with reconnects off a new level waits for a drop, and the controller stops deciding until it's applied
+#define ENABLE_QOS_RECONNECT 0 // 1 = reconnect to apply a new level, 0 = it waits for the next natural reconnect
+#define DEFAULT_QOS_TARGET_DELIVERY_MS 40.0f // frameDeliveryTimeMs to hold, it includes the pose latency
+#define QOS_DELIVERY_SMOOTHING 0.3f // weight of each stats sample in the smoothed delivery time
+#define QOS_DELIVERY_MARGIN 0.15f // around the target, inside it the level holds
+#define QOS_PACKET_LOSS_PERCENT 1.0f // lost between two samples, above it the link is congested
+#define QOS_HIGH_UTILIZATION_PERCENT 90
+#define QOS_LOW_UTILIZATION_PERCENT 60
+#define QOS_BANDWIDTH_HEADROOM 0.8f // bitrate cap as a fraction of the available bandwidth when stepping down
+#define MIN_QOS_BITRATE_KBPS 10000
+#define QOS_DOWNGRADE_HOLD_MS 3000 // congested this long before stepping down
+#define QOS_UPGRADE_HOLD_MS 30000 // headroom this long before stepping back up, much slower so it doesn't oscillate
+#define MAX_QOS_UPGRADE_HOLD_MS 240000 // doubled after each step up that had to be undone
+#define QOS_RECONNECT_MIN_MS 10000 // between a receiver's creation and a reconnect to change its level
 
 #define DEFAULT_CLOUDXR_PREDICTION_OFFSET_NS 0.0f
 #define USE_FRAME_PERIOD_AS_POSE_PREDICTION_OFFSET 0
 
+#define ENABLE_CLIENT_POSE_PREDICTION 0
+#define DEFAULT_CLIENT_PREDICTION_MS 0.0f // extra lookahead on top of the measured pose to photon time
+#define DEFAULT_CLIENT_PREDICTION_DAMPING 0.0f // 1/s, 0 = pure constant velocity
+#define DEFAULT_CLIENT_PREDICTION_MAX_MS 50.0f
+#define POSE_TO_PHOTON_SMOOTHING 0.1f // weight of each measurement in the prediction horizon
+
 #define DEFAULT_CLOUDXR_POSE_POLL_FREQUENCY_MULT 0
 #define MIN_CLOUDXR_POSE_POLLING_HZ 0
 #define MAX_CLOUDXR_POSE_POLLING_HZ 1000
 
+#define ENABLE_POSE_SAMPLER_THREAD 1
+#define POSE_SAMPLER_RING_SIZE 16
+
 #define DEFAULT_CLOUDXR_POSE_TIME_OFFSET_SECONDS 0.0f//(0.02f)
-#define DEFAULT_CLOUDXR_LATCH_TIMEOUT_MS 500
+#define DEFAULT_CLOUDXR_LATCH_TIMEOUT_MS 500 // upper bound, the adaptive budget is normally far below it
+#define ENABLE_ADAPTIVE_LATCH_TIMEOUT 1
+#define DEFAULT_LATCH_RENDER_RESERVE_MS 3.0f // kept back from the frame budget for blit + submit
+#define ENABLE_LAST_FRAME_RETENTION 1
+#define FRAME_CACHE_REFRESH_FRAMES 8 // healthy stream: copy every Nth frame, the copy is only there for a miss
+#define FRAME_CACHE_RISK_FRAMES 90 // copy every frame for this long after a latch that missed or had no budget left
 
 #define DEFAULT_CLOUDXR_PER_EYE_WIDTH 1920
 #define DEFAULT_CLOUDXR_PER_EYE_HEIGHT 1920
 #define DEFAULT_CLOUDXR_FRAMERATE 72.0f
+#define DEFAULT_CLOUDXR_MAX_STREAM_FPS 0 // 0 = stream at the display rate, else at its largest integer divisor under this
+#define MIN_CLOUDXR_STREAM_FPS 30.0f // a divisor never takes the stream below this
+#define REFRESH_RATE_TOLERANCE_HZ 0.5f
 
 #define RECOMPUTE_IPD_EVERY_FRAME 1
 
+#define ENABLE_SIMD_POSE_BATCH 1 // SSE / NEON kernels in OKPoseBatch, 0 = scalar lanes
+#define POSE_BATCH_LANES 4
+#define MAX_POSE_BATCH_SIZE 128 // multiple of POSE_BATCH_LANES, HMD + controllers + 2 x 26 hand joints + body joints
+
 #define ENABLE_CLOUDXR_POSE_PREDICTION 1 // disable this at your own peril! bleh
 #define ANGULAR_VELOCITY_IN_DEVICE_SPACE 0
 
@@ -71,7 +121,25 @@
 #define DEFAULT_CLOUDXR_IPD_M (DEFAULT_CLOUDXR_IPD_MM * METERS_PER_MILLIMETER)
 
 #define AUTO_CONNECT_TO_CLOUDXR 1
+#define CONNECT_RETRY_BASE_MS 250.0f // wait after the first failed attempt, doubled with each one after
+#define CONNECT_RETRY_MAX_MS 8000.0f
+#define CONNECT_RETRY_JITTER 0.5f // each wait is shortened by up to this fraction, so clients don't retry in lockstep
+#define CONNECT_ATTEMPT_TIMEOUT_MS 10000 // an attempt still in progress after this is abandoned and retried
 #define USE_CLOUDXR_POSE_ID 1
+#define FRAME_POSE_HISTORY_SIZE 256 // power of two, ~250 ms of poses at 1 kHz polling
+
+#define ENABLE_TELEMETRY 1
+#define ENABLE_TELEMETRY_TRACE 0
+#define DEFAULT_TELEMETRY_STATS_INTERVAL_MS 1000
+#define TELEMETRY_RING_SIZE 1024 // power of two
+#define TELEMETRY_STATS_RING_SIZE 16 // power of two
+#define TELEMETRY_DRAIN_PERIOD_MS 50
+#define TELEMETRY_WINDOW_MS 1000
+#define TELEMETRY_TRACE_FILENAME "ok_telemetry.bin" // per process, each session appends its own header and records
+#define TELEMETRY_TRACE_MAGIC 0x52544B4F // 'OKTR'
+#define TELEMETRY_TRACE_VERSION 2
+#define ENABLE_STARTUP_TRACE 1
+#define STARTUP_TRACE_FILENAME "ok_startup_trace.csv" // written once, at the first frame
 #define ENABLE_CLOUDXR_LOGGING 1
 
 #define ENABLE_CLOUDXR_LOGGING_VERBOSE (ENABLE_CLOUDXR_LOGGING && 0)
@@ -85,16 +153,22 @@
 #define ENABLE_CLOUDXR_HMD 1
 #define ENABLE_CLOUDXR_CONTROLLERS (ENABLE_CLOUDXR_HMD && 1)
 #define ENABLE_HAPTICS (ENABLE_CLOUDXR_CONTROLLERS && 1)
+#define HAPTIC_QUEUE_SIZE 32 // pulses per controller between two render frames, power of two
+#define HAPTIC_MAX_PULSE_MS 2000 // longer requests are cut short, a lost stop can't buzz forever
 
 #define INVALID_INDEX -1
-#define MAX_CLOUDXR_CONTROLLER_EVENTS 256
-#define SEND_ALL_DIGITAL_EVENTS_EVERY_FRAME 1
-#define SEND_ALL_ANALOG_EVENTS_EVERY_FRAME 1
+#define MAX_CLOUDXR_INPUT_PATHS 64 // per controller, one bit each in OKControllerEventBatch
+#define SEND_ALL_CONTROLLER_EVENTS_EVERY_FRAME 0 // debug only, every poll becomes a keyframe
+#define CONTROLLER_EVENT_KEYFRAME_MS 500 // full resend of all inputs, in case an event was lost
+#define CONTROLLER_ANALOG_EVENT_EPSILON (1.0f / 1024.0f)
 
 #define COMBINE_GRIP_FORCE_WITH_GRIP 1
 #define SIMULATE_GRIP_TOUCH 1
 #define SIMULATE_THUMB_REST 0
 
+#define CLOUDXR_CONTROLLER_NAME "Oculus Touch"
+#define OK_INPUT_PROFILES_FILENAME "ok_input_profiles.json"
+
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
 #endif
@@ -102,6 +176,27 @@
 #define ENABLE_CLOUDXR_AUDIO_PLAYBACK (ENABLE_OBOE && 0)
 #define ENABLE_CLOUDXR_AUDIO_RECORDING (ENABLE_OBOE && 0)
 
+#define AUDIO_PLAYBACK_BURSTS 2 // Oboe buffer size in bursts, the jitter buffer absorbs the network
+#define AUDIO_JITTER_BUFFER_FRAMES 8192 // ring capacity, ~170 ms at 48 kHz, power of two
+#define AUDIO_JITTER_TARGET_MS 15.0f // starting target, raised on underruns and lowered while there's slack
+#define AUDIO_JITTER_MIN_MS 6.0f
+#define AUDIO_JITTER_MAX_MS 80.0f
+#define AUDIO_JITTER_STEP_MS 5.0f // target raise per underrun
+#define AUDIO_JITTER_WINDOW_MS 2000 // underrun free time with slack to spare before the target drops 1 ms
+#define AUDIO_JITTER_HYSTERESIS_MS 1.0f // level error tolerated before a frame is dropped or inserted
+#define AUDIO_JITTER_SMOOTHING_MS 200.0f // time constant of the buffered level
+#define AUDIO_FADE_FRAMES 48 // 1 ms ramp into and out of silence
+
+#define AUDIO_UPLINK_QUEUE_SIZE 32 // CXR_AUDIO_FRAME_LENGTH_MS frames between capture and sender, power of two
+#define AUDIO_UPLINK_DRAIN_PERIOD_MS 2
+#define ENABLE_AUDIO_VAD 1 // don't send the microphone while the user is quiet
+#define AUDIO_VAD_MIN_DB -55.0f // never voice below this level (dBFS)
+#define AUDIO_VAD_MARGIN_DB 9.0f // voice = this far above the tracked noise floor
+#define AUDIO_VAD_NOISE_RISE_DB_PER_S 3.0f // the floor drops to quiet frames at once, rises this slowly
+#define AUDIO_VAD_VOICE_RISE_DB_PER_S 0.3f // and slower still under voice, so long talk isn't mistaken for noise
+#define AUDIO_VAD_HANGOVER_MS 300 // keep sending through pauses between words
+#define AUDIO_VAD_PREROLL_MS 20 // quiet audio sent ahead of voice, so onsets aren't clipped
+
 #define ENABLE_CLOUDXR_CONTROLLER_FIX (ENABLE_CLOUDXR_CONTROLLERS && 1)
 
 #define CLOUDXR_CONTROLLER_OFFSET_X -0.007f
@@ -116,15 +211,28 @@
 
 #define ENABLE_CLOUDXR_LINK_SHARPENING 0
 
-#define ENABLE_EYE_TRACKING 0
-#define ENABLE_FACE_TRACKING 0
-#define ENABLE_HAND_TRACKING 0
-#define ENABLE_BODY_TRACKING 0
-#define ENABLE_WAIST_LOCO (ENABLE_BODY_TRACKING && 0)
+#define ENABLE_EYE_TRACKING (ENABLE_CLOUDXR_CONTROLLERS && 1) // the gaze action is synced with the controllers' action set
+#define ENABLE_FACE_TRACKING (ENABLE_CLOUDXR_HMD && 1)
+#define ENABLE_HAND_TRACKING (ENABLE_CLOUDXR_HMD && 1)
+#define ENABLE_BODY_TRACKING (ENABLE_CLOUDXR_CONTROLLERS && 1) // the waist steers the controllers' thumbstick
+#define ENABLE_WAIST_LOCO (ENABLE_BODY_TRACKING && 1)
 
-#define ENABLE_SWAP_THUMBSTICKS 0
+#define NUM_HANDS 2
+#define HAND_JOINT_KEYFRAME_MS 500 // full resend of both hands, in case a delta was lost
+#define HAND_JOINT_POSITION_STEPS_PER_M 100000.0f // 10 um, +-32 cm from the wrist in 16 bits
+
+#define XR_INPUTS_HAVE_EYE_GAZE 0 // XrApp's XrInputState creates eyeGazeAction / eyeGazeSpace (XR_EXT_eye_gaze_interaction)
+#define EYE_GAZE_KEYFRAME_MS 250 // resend of an unchanged gaze
+#define ENABLE_GAZE_FOVEATION 0 // flags the streamed gaze for server-side foveation, CloudXR's fixed foveation stays as configured
+#define MIN_CLOUDXR_FOVEATION 25 // foveatedScaleFactor is 0 (off) or [25, 100]
+
+#define FACE_TRACKING_HZ 30.0f // expression weights sampling rate, well under the pose rate
+#define FACE_EXPRESSION_THRESHOLD 2 // 8 bit steps a weight must move before it's resent
+#define FACE_EXPRESSION_KEYFRAME_MS 500 // full resend of every weight
 
-#define WAIT_TO_CONNECT 1
-#define WAIT_TO_CONNECT_MS 5000.0f
+#define WAIST_SMOOTHING_MS 80.0f // time constant of the hips filter, 0 = raw
+#define WAIST_CALIBRATION_MS 500.0f // hips to HMD heading offset, averaged when the body is acquired
+
+#define ENABLE_SWAP_THUMBSTICKS 0
 
 #endif // OK_DEFINES_H
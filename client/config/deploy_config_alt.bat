@@ -1 +1,2 @@
-adb.exe push ok_cloud_streamer_config.json /sdcard/Android/data/com.battleaxevr.ok_cloud_streamer.opengles/files/ok_cloud_streamer_config.json
\ No newline at end of file
+adb.exe push ok_cloud_streamer_config.json /sdcard/Android/data/com.battleaxevr.ok_cloud_streamer.opengles/files/ok_cloud_streamer_config.json
+adb.exe push ok_input_profiles.json /sdcard/Android/data/com.battleaxevr.ok_cloud_streamer.opengles/files/ok_input_profiles.json
\ No newline at end of file
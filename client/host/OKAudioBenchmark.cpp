@@ -0,0 +1,445 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Simulated playback through OKAudioJitterBuffer: a server streaming a sine wave in CloudXR sized
+// packets that arrive with network jitter and occasional spikes, on a clock drifting against the
+// output's, which pulls fixed bursts. Runs in virtual time, so minutes of audio take a moment.
+// Reports the latency the buffer held, underruns, drift corrections, clicks in the output and
+// what each write / read call costs.
+//
+// Then the other direction through OKAudioUplink: a microphone picking up background noise and
+// talk spurts, captured in the same bursts. Reports how much of it VAD kept off the network, any
+// speech it cut, and what each write / process call costs.
+//
+// Usage: ok_audio_benchmark [key=value ...], see print_usage for the keys.
+
+#include "OKAudioJitterBuffer.h"
+#include "OKAudioUplink.h"
+#include "OKClock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKAudioBenchmarkOptions
+{
+    float seconds_ = 60.0f;
+    float packet_ms_ = (float)CXR_AUDIO_FRAME_LENGTH_MS * 2.0f; // received audio is 5 or 10 ms
+    float jitter_ms_ = 2.0f;            // uniform extra delay per packet
+    float spike_percent_ = 0.5f;        // packets held up by a spike
+    float spike_ms_ = 25.0f;
+    float drift_ppm_ = 200.0f;          // server clock against the output's
+    uint32_t burst_frames_ = 192;       // output callback size, 4 ms
+    float target_ms_ = AUDIO_JITTER_TARGET_MS;
+    uint32_t random_seed_ = 1;
+
+    // Uplink
+    float noise_db_ = -60.0f;           // background, dBFS
+    float speech_db_ = -24.0f;
+    float talk_percent_ = 40.0f;        // of the time
+    bool enable_vad_ = ENABLE_AUDIO_VAD;
+};
+
+void print_usage()
+{
+    printf("ok_audio_benchmark [key=value ...]\n"
+           "  seconds=60         simulated run time\n"
+           "  packet_ms=10       audio per RenderAudio call\n"
+           "  jitter_ms=2        uniform network jitter\n"
+           "  spike_percent=0.5  packets delayed by a spike\n"
+           "  spike_ms=25\n"
+           "  drift_ppm=200      server clock drift, negative = slower than the output\n"
+           "  burst=192          frames per output callback\n"
+           "  target_ms=15       starting target latency\n"
+           "  seed=1\n"
+           "  noise_db=-60       microphone background level\n"
+           "  speech_db=-24      microphone speech level\n"
+           "  talk_percent=40    time spent talking\n"
+           "  vad=1              suppress silence on the uplink\n");
+}
+
+bool parse_options(int argc, char** argv, OKAudioBenchmarkOptions& options)
+{
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        const char* arg = argv[arg_id];
+        const char* separator = strchr(arg, '=');
+
+        if (!separator)
+        {
+            return false;
+        }
+
+        const std::string key(arg, separator - arg);
+        const char* value = separator + 1;
+
+        const float float_value = (float)atof(value);
+        const uint32_t uint_value = (uint32_t)strtoul(value, nullptr, 0);
+
+        if (key == "seconds") options.seconds_ = float_value;
+        else if (key == "packet_ms") options.packet_ms_ = float_value;
+        else if (key == "jitter_ms") options.jitter_ms_ = float_value;
+        else if (key == "spike_percent") options.spike_percent_ = float_value;
+        else if (key == "spike_ms") options.spike_ms_ = float_value;
+        else if (key == "drift_ppm") options.drift_ppm_ = float_value;
+        else if (key == "burst") options.burst_frames_ = uint_value;
+        else if (key == "target_ms") options.target_ms_ = float_value;
+        else if (key == "seed") options.random_seed_ = uint_value;
+        else if (key == "noise_db") options.noise_db_ = float_value;
+        else if (key == "speech_db") options.speech_db_ = float_value;
+        else if (key == "talk_percent") options.talk_percent_ = float_value;
+        else if (key == "vad") options.enable_vad_ = (uint_value != 0);
+        else return false;
+    }
+
+    return (options.seconds_ > 0.0f) && (options.packet_ms_ > 0.0f) && (options.burst_frames_ > 1) &&
+           (options.burst_frames_ <= (AUDIO_JITTER_BUFFER_FRAMES / 4)) &&
+           (options.talk_percent_ >= 0.0f) && (options.talk_percent_ <= 100.0f);
+}
+
+struct OKTimingStats
+{
+    std::vector<uint64_t> durations_ns_;
+
+    void print(const char* name)
+    {
+        if (durations_ns_.empty())
+        {
+            return;
+        }
+
+        std::sort(durations_ns_.begin(), durations_ns_.end());
+
+        double total_ns = 0.0;
+
+        for (const uint64_t duration_ns : durations_ns_)
+        {
+            total_ns += (double)duration_ns;
+        }
+
+        printf("  %-8s n=%-8zu mean=%7.0f p50=%7llu p99=%7llu max=%7llu ns\n", name, durations_ns_.size(),
+               total_ns / (double)durations_ns_.size(),
+               (unsigned long long)durations_ns_[durations_ns_.size() / 2],
+               (unsigned long long)durations_ns_[(durations_ns_.size() * 99) / 100],
+               (unsigned long long)durations_ns_.back());
+    }
+};
+
+// Everything the microphone produced, in order, so each packet the uplink sends can be matched
+// back to the one it was captured as
+struct OKUplinkCapture
+{
+    std::vector<OKAudioUplinkPacket> packets_;
+    std::vector<bool> is_speech_;
+    std::vector<bool> is_sent_;
+    size_t next_packet_id_ = 0;
+    uint64_t unmatched_count_ = 0;
+
+    static bool send(void* context, const cxrAudioFrame* audio_frame)
+    {
+        OKUplinkCapture* capture = (OKUplinkCapture*)context;
+        const size_t packet_size = sizeof(OKAudioUplinkPacket);
+
+        if (audio_frame->streamSizeBytes != packet_size)
+        {
+            capture->unmatched_count_++;
+            return false;
+        }
+
+        // Sent packets are a subsequence of the captured ones
+        for (size_t packet_id = capture->next_packet_id_; packet_id < capture->packets_.size(); packet_id++)
+        {
+            if (memcmp(capture->packets_[packet_id].samples_, audio_frame->streamBuffer, packet_size) == 0)
+            {
+                capture->is_sent_[packet_id] = true;
+                capture->next_packet_id_ = packet_id + 1;
+                return true;
+            }
+        }
+
+        capture->unmatched_count_++;
+        return true;
+    }
+};
+
+void run_uplink(const OKAudioBenchmarkOptions& options)
+{
+    const double sample_rate = (double)CXR_AUDIO_SAMPLING_RATE;
+    const uint64_t total_frame_count = (uint64_t)((double)options.seconds_ * sample_rate);
+
+    std::mt19937 rng(options.random_seed_ + 1);
+    std::normal_distribution<double> noise_dist(0.0, 32768.0 * pow(10.0, (double)options.noise_db_ / 20.0));
+    std::uniform_real_distribution<double> spurt_dist(0.5, 3.0);
+
+    // A 150 Hz voice with a few harmonics, its loudness rising and falling with the syllables
+    const double speech_amplitude = 32768.0 * pow(10.0, (double)options.speech_db_ / 20.0);
+    const double talk_fraction = (double)options.talk_percent_ / 100.0;
+
+    OKUplinkCapture capture;
+    OKAudioUplink* uplink = new OKAudioUplink();
+    uplink->configure(&OKUplinkCapture::send, &capture, options.enable_vad_);
+
+    std::vector<int16_t> burst(options.burst_frames_ * CXR_AUDIO_CHANNEL_COUNT);
+    OKAudioUplinkPacket packet = {};
+    uint32_t packet_frame_count = 0;
+    bool is_packet_speech = false;
+
+    OKTimingStats write_timings;
+    OKTimingStats process_timings;
+
+    bool is_talking = false;
+    double spurt_end_time = 0.0;
+    uint64_t frame_id = 0;
+
+    while (frame_id < total_frame_count)
+    {
+        for (uint32_t burst_frame_id = 0; burst_frame_id < options.burst_frames_; burst_frame_id++, frame_id++)
+        {
+            const double t = (double)frame_id / sample_rate;
+
+            if (t >= spurt_end_time)
+            {
+                // Alternating spurts and pauses, the pauses scaled so talking takes talk_fraction of the time
+                is_talking = (talk_fraction >= 1.0) || (!is_talking && (talk_fraction > 0.0));
+
+                const double spurt_s = spurt_dist(rng);
+                spurt_end_time = t + (is_talking ? spurt_s : ((talk_fraction > 0.0) ? spurt_s * (1.0 - talk_fraction) / talk_fraction : 1e9));
+            }
+
+            double sample = noise_dist(rng);
+
+            if (is_talking)
+            {
+                const double envelope = 0.5 + 0.5 * fabs(sin(M_PI * 4.0 * t));
+
+                for (uint32_t harmonic_id = 1; harmonic_id <= 4; harmonic_id++)
+                {
+                    sample += speech_amplitude * envelope * sin(2.0 * M_PI * 150.0 * harmonic_id * t) / (double)harmonic_id;
+                }
+            }
+
+            const int16_t sample_int = (int16_t)std::clamp(sample, -32768.0, 32767.0);
+
+            for (uint32_t channel_id = 0; channel_id < CXR_AUDIO_CHANNEL_COUNT; channel_id++)
+            {
+                burst[(burst_frame_id * CXR_AUDIO_CHANNEL_COUNT) + channel_id] = sample_int;
+                packet.samples_[(packet_frame_count * CXR_AUDIO_CHANNEL_COUNT) + channel_id] = sample_int;
+            }
+
+            // Ground truth, a packet with any speech in it should go out
+            is_packet_speech = is_packet_speech || is_talking;
+
+            if (++packet_frame_count == AUDIO_UPLINK_FRAME_COUNT)
+            {
+                capture.packets_.push_back(packet);
+                capture.is_speech_.push_back(is_packet_speech);
+                capture.is_sent_.push_back(false);
+                packet_frame_count = 0;
+                is_packet_speech = false;
+            }
+        }
+
+        const uint64_t write_start_time_ns = get_monotonic_time_ns();
+        uplink->write(burst.data(), options.burst_frames_);
+        write_timings.durations_ns_.push_back(get_monotonic_time_ns() - write_start_time_ns);
+
+        // Synchronous stand-in for the sender thread
+        const uint64_t process_start_time_ns = get_monotonic_time_ns();
+        uplink->process();
+        process_timings.durations_ns_.push_back(get_monotonic_time_ns() - process_start_time_ns);
+    }
+
+    const OKAudioUplinkStats stats = uplink->get_stats();
+
+    uint64_t speech_packet_count = 0;
+    uint64_t missed_speech_packet_count = 0;
+
+    for (size_t packet_id = 0; packet_id < capture.packets_.size(); packet_id++)
+    {
+        speech_packet_count += capture.is_speech_[packet_id] ? 1 : 0;
+        missed_speech_packet_count += (capture.is_speech_[packet_id] && !capture.is_sent_[packet_id]) ? 1 : 0;
+    }
+
+    const double packet_kbits = (double)(sizeof(OKAudioUplinkPacket) * 8) / 1000.0;
+    const double raw_kbps = packet_kbits * 1000.0 / (double)CXR_AUDIO_FRAME_LENGTH_MS;
+
+    printf("\nuplink %.0f s: %.0f dBFS noise, %.0f dBFS speech %.0f%% of the time, VAD %s, %u frame bursts\n",
+           options.seconds_, options.noise_db_, options.speech_db_, options.talk_percent_, options.enable_vad_ ? "on" : "off", options.burst_frames_);
+    printf("packets: %llu captured, %llu sent, %llu suppressed, %llu dropped, %llu send errors, %llu unmatched\n",
+           (unsigned long long)stats.packets_captured_, (unsigned long long)stats.packets_sent_, (unsigned long long)stats.packets_suppressed_,
+           (unsigned long long)stats.packets_dropped_, (unsigned long long)stats.send_errors_, (unsigned long long)capture.unmatched_count_);
+    printf("bandwidth: %.0f kbps of %.0f raw\n", (double)stats.packets_sent_ * packet_kbits / (double)options.seconds_, raw_kbps);
+    printf("speech packets missed: %llu of %llu, final noise floor %.1f dBFS\n", (unsigned long long)missed_speech_packet_count,
+           (unsigned long long)speech_packet_count, stats.noise_floor_db_);
+    printf("cost per call:\n");
+    write_timings.print("write");
+    process_timings.print("process");
+
+    delete uplink;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    OKAudioBenchmarkOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    const double sample_rate = (double)CXR_AUDIO_SAMPLING_RATE;
+    const double server_rate = sample_rate * (1.0 + (double)options.drift_ppm_ * 1e-6);
+    const uint32_t packet_frame_count = std::max((uint32_t)(options.packet_ms_ * (float)sample_rate / 1000.0f), 1u);
+
+    // A 440 Hz tone at half scale moves at most ~1900 per sample, a jump well past that is a click
+    const double tone_hz = 440.0;
+    const double tone_amplitude = 16384.0;
+    const double max_tone_step = tone_amplitude * 2.0 * M_PI * tone_hz / sample_rate;
+    const double click_threshold = max_tone_step * 3.0;
+
+    std::mt19937 rng(options.random_seed_);
+    std::uniform_real_distribution<double> jitter_dist(0.0, (double)options.jitter_ms_ * 1e-3);
+    std::uniform_real_distribution<double> percent_dist(0.0, 100.0);
+
+    OKAudioJitterBuffer* jitter_buffer = new OKAudioJitterBuffer();
+    jitter_buffer->reset(options.target_ms_);
+
+    std::vector<int16_t> packet(packet_frame_count * CXR_AUDIO_CHANNEL_COUNT);
+    std::vector<int16_t> burst(options.burst_frames_ * CXR_AUDIO_CHANNEL_COUNT);
+
+    OKTimingStats write_timings;
+    OKTimingStats read_timings;
+    std::vector<float> level_samples_ms;
+
+    uint64_t packet_id = 0;
+    uint64_t burst_id = 0;
+    double last_arrival_time = 0.0;
+    double spike_end_time = 0.0;
+    uint64_t click_count = 0;
+    uint64_t silent_burst_count = 0;
+    bool has_last_sample = false;
+    int16_t last_sample = 0;
+
+    while (true)
+    {
+        // Packets leave the server on its own clock and arrive in order, delayed by the network
+        const double send_time = (double)(packet_id * packet_frame_count) / server_rate;
+        double arrival_time = send_time + jitter_dist(rng);
+
+        if (percent_dist(rng) < (double)options.spike_percent_)
+        {
+            spike_end_time = send_time + (double)options.spike_ms_ * 1e-3;
+        }
+
+        arrival_time = std::max({arrival_time, spike_end_time, last_arrival_time});
+
+        const double burst_time = (double)(burst_id * options.burst_frames_) / sample_rate;
+
+        if (std::min(arrival_time, burst_time) > (double)options.seconds_)
+        {
+            break;
+        }
+
+        if (arrival_time <= burst_time)
+        {
+            for (uint32_t frame_id = 0; frame_id < packet_frame_count; frame_id++)
+            {
+                const double t = (double)(packet_id * packet_frame_count + frame_id) / sample_rate; // server sample time
+                const int16_t sample = (int16_t)(tone_amplitude * sin(2.0 * M_PI * tone_hz * t));
+
+                for (uint32_t channel_id = 0; channel_id < CXR_AUDIO_CHANNEL_COUNT; channel_id++)
+                {
+                    packet[(frame_id * CXR_AUDIO_CHANNEL_COUNT) + channel_id] = sample;
+                }
+            }
+
+            const uint64_t write_start_time_ns = get_monotonic_time_ns();
+            jitter_buffer->write(packet.data(), packet_frame_count);
+            write_timings.durations_ns_.push_back(get_monotonic_time_ns() - write_start_time_ns);
+
+            last_arrival_time = arrival_time;
+            packet_id++;
+            continue;
+        }
+
+        const uint64_t read_start_time_ns = get_monotonic_time_ns();
+        jitter_buffer->read(burst.data(), options.burst_frames_);
+        read_timings.durations_ns_.push_back(get_monotonic_time_ns() - read_start_time_ns);
+
+        const OKAudioJitterStats stats = jitter_buffer->get_stats();
+        level_samples_ms.push_back(stats.level_ms_);
+
+        bool is_silent = true;
+
+        for (uint32_t frame_id = 0; frame_id < options.burst_frames_; frame_id++)
+        {
+            const int16_t sample = burst[frame_id * CXR_AUDIO_CHANNEL_COUNT];
+
+            if (has_last_sample && (fabs((double)sample - (double)last_sample) > click_threshold))
+            {
+                click_count++;
+            }
+
+            is_silent = is_silent && (sample == 0);
+            last_sample = sample;
+            has_last_sample = true;
+        }
+
+        silent_burst_count += is_silent ? 1 : 0;
+        burst_id++;
+    }
+
+    const OKAudioJitterStats stats = jitter_buffer->get_stats();
+
+    std::vector<float> sorted_levels_ms = level_samples_ms;
+    std::sort(sorted_levels_ms.begin(), sorted_levels_ms.end());
+
+    double total_level_ms = 0.0;
+
+    for (const float level_ms : sorted_levels_ms)
+    {
+        total_level_ms += (double)level_ms;
+    }
+
+    printf("simulated %.0f s: %u frame packets, %.1f ms jitter, %.1f%% spikes of %.0f ms, %+.0f ppm drift, %u frame bursts\n",
+           options.seconds_, packet_frame_count, options.jitter_ms_, options.spike_percent_, options.spike_ms_, options.drift_ppm_, options.burst_frames_);
+
+    if (!sorted_levels_ms.empty())
+    {
+        printf("buffered latency: mean=%.2f p50=%.2f p99=%.2f max=%.2f ms, final target %.1f ms\n",
+               total_level_ms / (double)sorted_levels_ms.size(),
+               sorted_levels_ms[sorted_levels_ms.size() / 2],
+               sorted_levels_ms[(sorted_levels_ms.size() * 99) / 100],
+               sorted_levels_ms.back(), stats.target_ms_);
+    }
+
+    printf("underruns: %llu, silent bursts: %llu, overflow frames: %llu\n", (unsigned long long)stats.underrun_count_,
+           (unsigned long long)silent_burst_count, (unsigned long long)stats.overflow_frames_);
+    printf("drift correction: %llu frames dropped, %llu inserted (%.0f ppm of output)\n",
+           (unsigned long long)stats.dropped_frames_, (unsigned long long)stats.inserted_frames_,
+           1e6 * ((double)stats.dropped_frames_ - (double)stats.inserted_frames_) / (double)std::max(stats.frames_read_, (uint64_t)1));
+    printf("clicks: %llu\n", (unsigned long long)click_count);
+    printf("cost per call:\n");
+    write_timings.print("write");
+    read_timings.print("read");
+
+    delete jitter_buffer;
+
+    run_uplink(options);
+    return 0;
+}
@@ -0,0 +1,926 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// In-process stand-in for the CloudXR client library. A "server" thread polls GetTrackingState
+// like the real receiver does, turns the newest pose into a frame every frame period, and makes
+// it latchable once the scripted server latency has passed. Frames carry no pixels, blits only
+// cost what the script says, so the client side is all that gets measured.
+
+#include "OKFakeCloudXR.h"
+#include "OKClock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace BVR;
+
+namespace
+{
+
+const uint32_t MAX_PENDING_FRAMES = 8;
+const uint32_t PACKETS_PER_FRAME = 64;
+
+struct OKFakeFrame
+{
+    uint64_t produced_time_ns_ = 0;
+    uint64_t ready_time_ns_ = 0;
+    uint64_t pose_id_ = 0;
+    cxrMatrix34 pose_matrix_ = {};
+};
+
+struct OKFakeController
+{
+    bool is_used_ = false;
+    uint64_t id_ = 0;
+    std::vector<cxrInputValueType> input_value_types_;
+};
+
+std::mutex script_mutex;
+OKFakeCloudXRScript current_script;
+std::atomic<uint32_t> connect_count{0};
+
+std::chrono::steady_clock::time_point to_time_point(const uint64_t time_ns)
+{
+    // CLOCK_MONOTONIC, same as get_monotonic_time_ns
+    return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time_ns));
+}
+
+void busy_wait_ns(const uint64_t duration_ns)
+{
+    const uint64_t end_time_ns = get_monotonic_time_ns() + duration_ns;
+
+    while (get_monotonic_time_ns() < end_time_ns)
+    {
+    }
+}
+
+void pose_to_matrix(const cxrTrackedDevicePose& pose, cxrMatrix34& matrix)
+{
+    const float w = pose.rotation.w;
+    const float x = pose.rotation.x;
+    const float y = pose.rotation.y;
+    const float z = pose.rotation.z;
+
+    matrix.m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    matrix.m[0][1] = 2.0f * (x * y - w * z);
+    matrix.m[0][2] = 2.0f * (x * z + w * y);
+    matrix.m[0][3] = pose.position.v[0];
+
+    matrix.m[1][0] = 2.0f * (x * y + w * z);
+    matrix.m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    matrix.m[1][2] = 2.0f * (y * z - w * x);
+    matrix.m[1][3] = pose.position.v[1];
+
+    matrix.m[2][0] = 2.0f * (x * z - w * y);
+    matrix.m[2][1] = 2.0f * (y * z + w * x);
+    matrix.m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+    matrix.m[2][3] = pose.position.v[2];
+}
+
+} // namespace
+
+struct cxrReceiver
+{
+    cxrReceiverDesc desc_ = {};
+    OKFakeCloudXRScript script_;
+
+    std::mutex mutex_;
+    std::condition_variable frame_cv_;
+    std::condition_variable stop_cv_;
+
+    std::thread server_thread_;
+    bool should_stop_ = false;
+    std::atomic<bool> is_streaming_{false};
+
+    std::deque<OKFakeFrame> pending_frames_;
+    bool is_latched_ = false;
+
+    OKFakeController controllers_[CXR_NUM_CONTROLLERS];
+
+    // Connection stats are per call, the same as the real receiver's averages over its window
+    uint64_t last_stats_time_ns_ = 0;
+    uint64_t last_stats_frames_latched_ = 0;
+    uint64_t latch_wait_ns_ = 0;
+    uint64_t latch_wait_count_ = 0;
+    uint64_t delivery_time_ns_ = 0;
+    uint64_t delivery_count_ = 0;
+
+    std::atomic<uint64_t> tracking_polls_{0};
+    std::atomic<uint64_t> frames_produced_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint64_t> frames_skipped_{0};
+    std::atomic<uint64_t> frames_latched_{0};
+    std::atomic<uint64_t> latch_timeouts_{0};
+    std::atomic<uint64_t> frames_blitted_{0};
+    std::atomic<uint64_t> frames_released_{0};
+    std::atomic<uint64_t> controller_events_{0};
+    std::atomic<uint64_t> controller_event_batches_{0};
+    std::atomic<uint64_t> input_events_{0};
+    std::atomic<uint64_t> input_event_bytes_{0};
+    std::atomic<uint64_t> audio_frames_sent_{0};
+    std::atomic<uint64_t> haptic_pulses_{0};
+    std::atomic<uint64_t> refresh_changes_{0};
+    std::atomic<float> frame_rate_{0.0f};
+
+    void set_state(const cxrClientState state, const cxrError error)
+    {
+        is_streaming_ = (state == cxrClientState_StreamingSessionInProgress);
+
+        if (desc_.clientCallbacks.UpdateClientState)
+        {
+            desc_.clientCallbacks.UpdateClientState(desc_.clientCallbacks.clientContext, state, error);
+        }
+    }
+
+    // false once asked to stop
+    bool sleep_until(const uint64_t wake_time_ns)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return !stop_cv_.wait_until(lock, to_time_point(wake_time_ns), [this] { return should_stop_; });
+    }
+
+    void run_server();
+    void trigger_haptic(const uint64_t pulse_id);
+};
+
+void cxrReceiver::trigger_haptic(const uint64_t pulse_id)
+{
+    if (!desc_.clientCallbacks.TriggerHaptic)
+    {
+        return;
+    }
+
+    cxrHapticFeedback haptic = {};
+    bool has_controller = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const OKFakeController& fake_controller = controllers_[pulse_id % CXR_NUM_CONTROLLERS];
+
+        has_controller = fake_controller.is_used_;
+        haptic.deviceID = fake_controller.id_;
+    }
+
+    if (!has_controller)
+    {
+        return;
+    }
+
+    // Ramps up and down over 8 pulses, so merging has louder and quieter overlaps to deal with
+    const float ramp = (float)((pulse_id / CXR_NUM_CONTROLLERS) % 8) / 7.0f;
+
+    haptic.amplitude = script_.haptic_amplitude_ * (0.5f + 0.5f * ramp);
+    haptic.seconds = script_.haptic_seconds_;
+    haptic.frequency = 160.0f;
+
+    desc_.clientCallbacks.TriggerHaptic(desc_.clientCallbacks.clientContext, &haptic);
+    haptic_pulses_++;
+}
+
+void cxrReceiver::run_server()
+{
+    // Like the real receiver, every state change comes from its own thread, after cxrConnect has returned
+    set_state(cxrClientState_ConnectionAttemptInProgress, cxrError_Success);
+
+    const uint64_t connect_time_ns = get_monotonic_time_ns();
+
+    if (!sleep_until(connect_time_ns + (uint64_t)script_.connect_delay_ms_ * 1000000ULL))
+    {
+        return;
+    }
+
+    if (script_.connect_error_ != cxrError_Success)
+    {
+        set_state(cxrClientState_ConnectionAttemptFailed, script_.connect_error_);
+        return;
+    }
+
+    set_state(cxrClientState_StreamingSessionInProgress, cxrError_Success);
+
+    const cxrDeviceDesc& device_desc = desc_.deviceDesc;
+    const float stream_fps = (device_desc.numVideoStreamDescs > 0) ? device_desc.videoStreamDescs[0].fps : CXR_DEFAULT_VIDEO_STREAM_FPS;
+    const float frame_rate = (script_.frame_rate_ > 0.0f) ? script_.frame_rate_ : stream_fps;
+    const uint32_t poll_hz = (script_.pose_poll_hz_ > 0) ? script_.pose_poll_hz_ : (device_desc.posePollFreq > 0) ? device_desc.posePollFreq : (uint32_t)frame_rate;
+
+    frame_rate_ = frame_rate;
+    uint64_t frame_period_ns = (uint64_t)(1000000000.0 / std::max(frame_rate, 1.0f));
+    const uint64_t poll_period_ns = 1000000000ULL / std::max(poll_hz, 1u);
+
+    std::mt19937 rng(script_.random_seed_);
+    std::uniform_real_distribution<float> percent_dist(0.0f, 100.0f);
+    std::uniform_real_distribution<float> jitter_dist(-script_.latency_jitter_ms_, script_.latency_jitter_ms_);
+
+    const uint64_t stream_start_time_ns = get_monotonic_time_ns();
+    const uint64_t disconnect_time_ns = (script_.disconnect_after_ms_ > 0) ? (stream_start_time_ns + (uint64_t)script_.disconnect_after_ms_ * 1000000ULL) : UINT64_MAX;
+
+    uint64_t next_poll_time_ns = stream_start_time_ns;
+    uint64_t next_frame_time_ns = stream_start_time_ns + frame_period_ns;
+
+    const uint64_t haptic_period_ns = (script_.haptic_hz_ > 0.0f) ? (uint64_t)(1000000000.0 / script_.haptic_hz_) : 0;
+    uint64_t next_haptic_time_ns = (haptic_period_ns > 0) ? stream_start_time_ns : UINT64_MAX;
+    uint64_t haptic_pulse_id = 0;
+
+    cxrVRTrackingState tracking_state = {};
+
+    while (true)
+    {
+        const uint64_t now_time_ns = get_monotonic_time_ns();
+
+        if (now_time_ns >= disconnect_time_ns)
+        {
+            set_state(cxrClientState_Disconnected, cxrError_Server_Initiated_Disconnect);
+            return;
+        }
+
+        if (now_time_ns >= next_poll_time_ns)
+        {
+            if (script_.poll_tracking_ && desc_.clientCallbacks.GetTrackingState)
+            {
+                desc_.clientCallbacks.GetTrackingState(desc_.clientCallbacks.clientContext, &tracking_state);
+                tracking_polls_++;
+
+                // As the server does, the stream follows the client's display rate unless the script pins it
+                if ((tracking_state.hmd.flags & cxrHmdTrackingFlags_HasRefresh) && (tracking_state.hmd.displayRefresh > 0.0f))
+                {
+                    refresh_changes_++;
+
+                    if (script_.frame_rate_ <= 0.0f)
+                    {
+                        frame_rate_ = tracking_state.hmd.displayRefresh;
+                        frame_period_ns = (uint64_t)(1000000000.0 / std::max(tracking_state.hmd.displayRefresh, 1.0f));
+                        next_frame_time_ns = std::min(next_frame_time_ns, now_time_ns + frame_period_ns);
+                    }
+                }
+            }
+
+            next_poll_time_ns += poll_period_ns;
+        }
+
+        if (now_time_ns >= next_haptic_time_ns)
+        {
+            trigger_haptic(haptic_pulse_id++);
+            next_haptic_time_ns += haptic_period_ns;
+        }
+
+        if (now_time_ns >= next_frame_time_ns)
+        {
+            next_frame_time_ns += frame_period_ns;
+            frames_produced_++;
+
+            if (percent_dist(rng) < script_.frame_drop_percent_)
+            {
+                frames_dropped_++;
+            }
+            else
+            {
+                const float latency_ms = std::max(script_.server_latency_ms_ + jitter_dist(rng), 0.0f);
+
+                OKFakeFrame frame;
+                frame.produced_time_ns_ = now_time_ns;
+                frame.ready_time_ns_ = now_time_ns + (uint64_t)(latency_ms * 1000000.0f);
+                frame.pose_id_ = (tracking_state.hmd.flags & cxrHmdTrackingFlags_HasPoseID) ? tracking_state.hmd.poseID : 0;
+                pose_to_matrix(tracking_state.hmd.pose, frame.pose_matrix_);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if (pending_frames_.size() >= MAX_PENDING_FRAMES)
+                {
+                    pending_frames_.pop_front();
+                    frames_skipped_++;
+                }
+
+                pending_frames_.push_back(frame);
+                frame_cv_.notify_all();
+            }
+        }
+
+        if (!sleep_until(std::min({next_poll_time_ns, next_frame_time_ns, next_haptic_time_ns, disconnect_time_ns})))
+        {
+            return;
+        }
+    }
+}
+
+namespace BVR
+{
+
+void set_fake_cloudxr_script(const OKFakeCloudXRScript& script)
+{
+    std::lock_guard<std::mutex> lock(script_mutex);
+    current_script = script;
+    connect_count = 0;
+}
+
+OKFakeCloudXRScript get_fake_cloudxr_script()
+{
+    std::lock_guard<std::mutex> lock(script_mutex);
+    return current_script;
+}
+
+uint32_t get_fake_cloudxr_connect_count()
+{
+    return connect_count.load();
+}
+
+OKFakeCloudXRCounters get_fake_cloudxr_counters(cxrReceiverHandle receiver)
+{
+    OKFakeCloudXRCounters counters;
+
+    if (!receiver)
+    {
+        return counters;
+    }
+
+    counters.tracking_polls_ = receiver->tracking_polls_;
+    counters.frames_produced_ = receiver->frames_produced_;
+    counters.frames_dropped_ = receiver->frames_dropped_;
+    counters.frames_skipped_ = receiver->frames_skipped_;
+    counters.frames_latched_ = receiver->frames_latched_;
+    counters.latch_timeouts_ = receiver->latch_timeouts_;
+    counters.frames_blitted_ = receiver->frames_blitted_;
+    counters.frames_released_ = receiver->frames_released_;
+    counters.controller_events_ = receiver->controller_events_;
+    counters.controller_event_batches_ = receiver->controller_event_batches_;
+    counters.input_events_ = receiver->input_events_;
+    counters.input_event_bytes_ = receiver->input_event_bytes_;
+    counters.audio_frames_sent_ = receiver->audio_frames_sent_;
+    counters.haptic_pulses_ = receiver->haptic_pulses_;
+    counters.refresh_changes_ = receiver->refresh_changes_;
+    counters.frame_rate_ = receiver->frame_rate_;
+    return counters;
+}
+
+} // namespace BVR
+
+CLOUDXR_PUBLIC_API cxrError cxrCreateReceiver(const cxrReceiverDesc* description, cxrReceiverHandle* receiver)
+{
+    if (!description || !receiver)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (description->requestedVersion != CLOUDXR_VERSION_DWORD)
+    {
+        return cxrError_Invalid_API_Version;
+    }
+
+    const cxrDeviceDesc& device_desc = description->deviceDesc;
+
+    if ((device_desc.numVideoStreamDescs == 0) || (device_desc.numVideoStreamDescs > CXR_MAX_NUM_VIDEO_STREAMS))
+    {
+        return cxrError_Invalid_Number_Of_Streams;
+    }
+
+    for (uint32_t stream_index = 0; stream_index < device_desc.numVideoStreamDescs; stream_index++)
+    {
+        const cxrClientVideoStreamDesc& stream_desc = device_desc.videoStreamDescs[stream_index];
+
+        if ((stream_desc.width == 0) || (stream_desc.width > CXR_MAX_VIDEO_STREAM_WIDTH))
+        {
+            return cxrError_Invalid_Video_Width;
+        }
+
+        if ((stream_desc.height == 0) || (stream_desc.height > CXR_MAX_VIDEO_STREAM_HEIGHT))
+        {
+            return cxrError_Invalid_Video_Height;
+        }
+
+        if ((stream_desc.fps <= 0.0f) || (stream_desc.fps > CXR_MAX_VIDEO_STREAM_FPS))
+        {
+            return cxrError_Invalid_Video_Fps;
+        }
+    }
+
+    if (!description->shareContext)
+    {
+        return cxrError_Invalid_Graphics_Context;
+    }
+
+    cxrReceiver* new_receiver = new cxrReceiver();
+    new_receiver->desc_ = *description;
+    *receiver = new_receiver;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrConnect(cxrReceiverHandle receiver, const char* serverAddr, cxrConnectionDesc* description)
+{
+    if (!receiver || !serverAddr)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (receiver->server_thread_.joinable())
+    {
+        return cxrError_Not_Connected;
+    }
+
+    receiver->script_ = get_fake_cloudxr_script();
+
+    if (connect_count++ < receiver->script_.failed_attempt_count_)
+    {
+        receiver->script_.connect_error_ = cxrError_Server_Handshake_Failed;
+    }
+    receiver->server_thread_ = std::thread(&cxrReceiver::run_server, receiver);
+
+    const bool is_async = description && description->async;
+
+    if (!is_async)
+    {
+        const uint64_t deadline_ns = get_monotonic_time_ns() + (uint64_t)receiver->script_.connect_delay_ms_ * 1000000ULL + 1000000000ULL;
+
+        while (!receiver->is_streaming_ && (get_monotonic_time_ns() < deadline_ns))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return receiver->is_streaming_ ? cxrError_Success : receiver->script_.connect_error_;
+    }
+
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API void cxrDestroyReceiver(cxrReceiverHandle receiver)
+{
+    if (!receiver)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(receiver->mutex_);
+        receiver->should_stop_ = true;
+        receiver->stop_cv_.notify_all();
+        receiver->frame_cv_.notify_all();
+    }
+
+    if (receiver->server_thread_.joinable())
+    {
+        receiver->server_thread_.join();
+    }
+
+    delete receiver;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrLatchFrame(cxrReceiverHandle receiver, cxrFramesLatched* framesLatched, uint32_t frameMask, uint32_t timeoutMs)
+{
+    if (!receiver || !framesLatched)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (frameMask == 0)
+    {
+        return cxrError_Invalid_Frame_Mask;
+    }
+
+    if (!receiver->is_streaming_)
+    {
+        return cxrError_Not_Streaming;
+    }
+
+    const uint64_t start_time_ns = get_monotonic_time_ns();
+    const uint64_t deadline_ns = start_time_ns + (uint64_t)timeoutMs * 1000000ULL;
+
+    std::unique_lock<std::mutex> lock(receiver->mutex_);
+
+    if (receiver->is_latched_)
+    {
+        return cxrError_Frame_Not_Released;
+    }
+
+    while (true)
+    {
+        const uint64_t now_time_ns = get_monotonic_time_ns();
+
+        // Like the decoder queue, only the newest ready frame is handed out
+        int ready_count = 0;
+
+        for (const OKFakeFrame& frame : receiver->pending_frames_)
+        {
+            if (frame.ready_time_ns_ > now_time_ns)
+            {
+                break;
+            }
+
+            ready_count++;
+        }
+
+        if (ready_count > 0)
+        {
+            for (int skip_id = 0; skip_id < (ready_count - 1); skip_id++)
+            {
+                receiver->pending_frames_.pop_front();
+                receiver->frames_skipped_++;
+            }
+
+            const OKFakeFrame frame = receiver->pending_frames_.front();
+            receiver->pending_frames_.pop_front();
+
+            memset(framesLatched, 0, sizeof(*framesLatched));
+
+            const cxrDeviceDesc& device_desc = receiver->desc_.deviceDesc;
+            framesLatched->count = device_desc.numVideoStreamDescs;
+
+            for (uint32_t stream_index = 0; stream_index < device_desc.numVideoStreamDescs; stream_index++)
+            {
+                cxrVideoFrame& video_frame = framesLatched->frames[stream_index];
+                video_frame.width = device_desc.videoStreamDescs[stream_index].width;
+                video_frame.height = device_desc.videoStreamDescs[stream_index].height;
+                video_frame.pitch = video_frame.width * 4;
+                video_frame.widthFinal = video_frame.width;
+                video_frame.heightFinal = video_frame.height;
+                video_frame.streamIdx = stream_index;
+                video_frame.timeStamp = frame.produced_time_ns_;
+            }
+
+            framesLatched->poseMatrix = frame.pose_matrix_;
+            framesLatched->poseID = frame.pose_id_;
+
+            receiver->is_latched_ = true;
+            receiver->frames_latched_++;
+            receiver->latch_wait_ns_ += (now_time_ns - start_time_ns);
+            receiver->latch_wait_count_++;
+            receiver->delivery_time_ns_ += (now_time_ns - frame.produced_time_ns_);
+            receiver->delivery_count_++;
+            return cxrError_Success;
+        }
+
+        if ((now_time_ns >= deadline_ns) || receiver->should_stop_ || !receiver->is_streaming_)
+        {
+            receiver->latch_timeouts_++;
+            return cxrError_Frame_Not_Ready;
+        }
+
+        const uint64_t wake_time_ns = receiver->pending_frames_.empty() ? deadline_ns : std::min(deadline_ns, receiver->pending_frames_.front().ready_time_ns_);
+        receiver->frame_cv_.wait_until(lock, to_time_point(wake_time_ns));
+    }
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrBlitFrame(cxrReceiverHandle receiver, cxrFramesLatched* framesLatched, uint32_t frameMask)
+{
+    if (!receiver || !framesLatched)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (frameMask == 0)
+    {
+        return cxrError_Invalid_Frame_Mask;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(receiver->mutex_);
+
+        if (!receiver->is_latched_)
+        {
+            return cxrError_Frame_Not_Latched;
+        }
+    }
+
+    busy_wait_ns((uint64_t)receiver->script_.blit_cost_us_ * 1000ULL);
+    receiver->frames_blitted_++;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrReleaseFrame(cxrReceiverHandle receiver, cxrFramesLatched* framesLatched)
+{
+    if (!receiver || !framesLatched)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    std::lock_guard<std::mutex> lock(receiver->mutex_);
+
+    if (!receiver->is_latched_)
+    {
+        return cxrError_Frame_Not_Latched;
+    }
+
+    receiver->is_latched_ = false;
+    receiver->frames_released_++;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrAddController(cxrReceiverHandle receiver, const cxrControllerDesc* desc, cxrControllerHandle* outHandle)
+{
+    if (!receiver || !desc || !outHandle || !desc->role || !desc->controllerName)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if ((strlen(desc->role) > CXR_MAX_CONTROLLER_ROLE))
+    {
+        return cxrError_Role_Too_Long;
+    }
+
+    if ((strlen(desc->controllerName) > CXR_MAX_CONTROLLER_NAME))
+    {
+        return cxrError_Name_Too_Long;
+    }
+
+    if (desc->inputCount > CXR_MAX_CONTROLLER_INPUT_COUNT)
+    {
+        return cxrError_Too_Many_Inputs;
+    }
+
+    if ((desc->inputCount > 0) && (!desc->inputPaths || !desc->inputValueTypes))
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    for (uint32_t input_id = 0; input_id < desc->inputCount; input_id++)
+    {
+        if (!desc->inputPaths[input_id] || (strlen(desc->inputPaths[input_id]) > CXR_MAX_INPUT_PATH_LENGTH))
+        {
+            return cxrError_Name_Too_Long;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(receiver->mutex_);
+
+    OKFakeController* free_controller = nullptr;
+
+    for (OKFakeController& controller : receiver->controllers_)
+    {
+        if (controller.is_used_ && (controller.id_ == desc->id))
+        {
+            return cxrError_Controller_Id_In_Use;
+        }
+
+        if (!controller.is_used_ && !free_controller)
+        {
+            free_controller = &controller;
+        }
+    }
+
+    if (!free_controller)
+    {
+        return cxrError_Failed;
+    }
+
+    free_controller->is_used_ = true;
+    free_controller->id_ = desc->id;
+    free_controller->input_value_types_.assign(desc->inputValueTypes, desc->inputValueTypes + desc->inputCount);
+
+    *outHandle = free_controller;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSendControllerPoses(cxrReceiverHandle receiver, uint32_t poseCount, const cxrControllerHandle* controllerHandles, const cxrControllerTrackingState* const* states)
+{
+    if (!receiver || ((poseCount > 0) && (!controllerHandles || !states)))
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    return receiver->is_streaming_ ? cxrError_Success : cxrError_Not_Streaming;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrFireControllerEvents(cxrReceiverHandle receiver, cxrControllerHandle controller, const cxrControllerEvent* events, uint32_t eventCount)
+{
+    if (!receiver || !controller || ((eventCount > 0) && !events))
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (!receiver->is_streaming_)
+    {
+        return cxrError_Not_Streaming;
+    }
+
+    // Controllers are only added or removed on the thread that fires their events
+    const OKFakeController* fake_controller = (const OKFakeController*)controller;
+
+    if (!fake_controller->is_used_)
+    {
+        return cxrError_Failed;
+    }
+
+    for (uint32_t event_id = 0; event_id < eventCount; event_id++)
+    {
+        const cxrControllerEvent& event = events[event_id];
+
+        if ((event.clientInputIndex >= fake_controller->input_value_types_.size()) ||
+            (event.inputValue.valueType != fake_controller->input_value_types_[event.clientInputIndex]))
+        {
+            return cxrError_Failed;
+        }
+    }
+
+    receiver->controller_events_ += eventCount;
+    receiver->controller_event_batches_++;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrRemoveController(cxrReceiverHandle receiver, cxrControllerHandle handle)
+{
+    if (!receiver || !handle)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    std::lock_guard<std::mutex> lock(receiver->mutex_);
+
+    OKFakeController* fake_controller = (OKFakeController*)handle;
+
+    if (!fake_controller->is_used_)
+    {
+        return cxrError_Failed;
+    }
+
+    fake_controller->is_used_ = false;
+    fake_controller->input_value_types_.clear();
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSendLightProperties(cxrReceiverHandle receiver, const cxrLightProperties* lightProps)
+{
+    if (!receiver || !lightProps)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    return receiver->is_streaming_ ? cxrError_Success : cxrError_Not_Streaming;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSendInputEvent(cxrReceiverHandle receiver, const cxrInputEvent* inputEvent)
+{
+    if (!receiver || !inputEvent)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (!receiver->is_streaming_)
+    {
+        return cxrError_Not_Streaming;
+    }
+
+    if (inputEvent->type == cxrInputEventType_Generic)
+    {
+        if (!inputEvent->event.genericInputEvent.data || (inputEvent->event.genericInputEvent.sizeInBytes == 0))
+        {
+            return cxrError_Required_Parameter;
+        }
+
+        receiver->input_event_bytes_ += inputEvent->event.genericInputEvent.sizeInBytes;
+    }
+
+    receiver->input_events_++;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API void cxrTraceEvent(char* name, uint32_t eventId, cxrBool begin)
+{
+    (void)name;
+    (void)eventId;
+    (void)begin;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSendAudio(cxrReceiverHandle receiver, const cxrAudioFrame* audioFrame)
+{
+    if (!receiver || !audioFrame)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (!receiver->is_streaming_)
+    {
+        return cxrError_Not_Streaming;
+    }
+
+    receiver->audio_frames_sent_++;
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSetAuthorizationHeader(cxrReceiverHandle receiver, const char* header)
+{
+    return (receiver && header) ? cxrError_Success : cxrError_Required_Parameter;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrSendPose(cxrReceiverHandle receiver, const cxrVRTrackingState* trackingState)
+{
+    if (!receiver || !trackingState)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (receiver->desc_.clientCallbacks.GetTrackingState)
+    {
+        return cxrError_Pose_Callback_Provided;
+    }
+
+    return receiver->is_streaming_ ? cxrError_Success : cxrError_Not_Streaming;
+}
+
+CLOUDXR_PUBLIC_API cxrError cxrGetConnectionStats(cxrReceiverHandle receiver, cxrConnectionStats* stats)
+{
+    if (!receiver || !stats)
+    {
+        return cxrError_Required_Parameter;
+    }
+
+    if (!receiver->is_streaming_)
+    {
+        return cxrError_Not_Streaming;
+    }
+
+    const OKFakeCloudXRScript& script = receiver->script_;
+    const uint64_t now_time_ns = get_monotonic_time_ns();
+    const uint64_t frames_latched = receiver->frames_latched_;
+
+    std::lock_guard<std::mutex> lock(receiver->mutex_);
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (receiver->last_stats_time_ns_ > 0)
+    {
+        const double elapsed_s = (double)(now_time_ns - receiver->last_stats_time_ns_) / 1000000000.0;
+        stats->framesPerSecond = (elapsed_s > 0.0) ? (float)((double)(frames_latched - receiver->last_stats_frames_latched_) / elapsed_s) : 0.0f;
+    }
+
+    stats->frameDeliveryTimeMs = (receiver->delivery_count_ > 0) ? ((float)receiver->delivery_time_ns_ / (float)receiver->delivery_count_) / 1000000.0f : 0.0f;
+    stats->frameLatchTimeMs = (receiver->latch_wait_count_ > 0) ? ((float)receiver->latch_wait_ns_ / (float)receiver->latch_wait_count_) / 1000000.0f : 0.0f;
+    stats->frameQueueTimeMs = 0.0f;
+
+    receiver->last_stats_time_ns_ = now_time_ns;
+    receiver->last_stats_frames_latched_ = frames_latched;
+    receiver->latch_wait_ns_ = 0;
+    receiver->latch_wait_count_ = 0;
+    receiver->delivery_time_ns_ = 0;
+    receiver->delivery_count_ = 0;
+
+    stats->bandwidthAvailableKbps = script.bandwidth_available_kbps_;
+    stats->bandwidthUtilizationKbps = script.bandwidth_utilization_kbps_;
+    stats->bandwidthUtilizationPercent = (script.bandwidth_available_kbps_ > 0) ? (uint32_t)((100ULL * script.bandwidth_utilization_kbps_) / script.bandwidth_available_kbps_) : 0;
+    stats->roundTripDelayMs = script.round_trip_delay_ms_;
+    stats->jitterUs = script.jitter_us_;
+
+    const uint64_t total_packets = receiver->frames_produced_ * PACKETS_PER_FRAME;
+    const uint64_t lost_packets = (uint64_t)((double)total_packets * (double)script.packet_loss_percent_ / 100.0);
+    stats->totalPacketsReceived = (uint32_t)(total_packets - lost_packets);
+    stats->totalPacketsLost = (uint32_t)lost_packets;
+    stats->totalPacketsDropped = (uint32_t)((receiver->frames_dropped_ + receiver->frames_skipped_) * PACKETS_PER_FRAME);
+
+    stats->qualityReasons = 0;
+
+    if (stats->bandwidthUtilizationPercent > 90)
+    {
+        stats->qualityReasons |= cxrConnectionQualityReason_LowBandwidth;
+    }
+
+    if (script.round_trip_delay_ms_ > 40)
+    {
+        stats->qualityReasons |= cxrConnectionQualityReason_HighLatency;
+    }
+
+    if (script.packet_loss_percent_ > 1.0f)
+    {
+        stats->qualityReasons |= cxrConnectionQualityReason_HighPacketLoss;
+    }
+
+    const int reason_count = __builtin_popcount(stats->qualityReasons);
+    stats->quality = (reason_count == 0) ? cxrConnectionQuality_Excellent : (reason_count == 1) ? cxrConnectionQuality_Fair : cxrConnectionQuality_Poor;
+
+    return cxrError_Success;
+}
+
+CLOUDXR_PUBLIC_API const char* cxrErrorString(cxrError E)
+{
+    switch (E)
+    {
+        case cxrError_Success: return "Success";
+        case cxrError_Failed: return "Failed";
+        case cxrError_Timeout: return "Timeout";
+        case cxrError_Not_Connected: return "Not connected";
+        case cxrError_Not_Streaming: return "Not streaming";
+        case cxrError_Not_Implemented: return "Not implemented";
+        case cxrError_Required_Parameter: return "Required parameter missing";
+        case cxrError_Invalid_API_Version: return "Invalid API version";
+        case cxrError_Invalid_Number_Of_Streams: return "Invalid number of streams";
+        case cxrError_Invalid_Graphics_Context: return "Invalid graphics context";
+        case cxrError_Invalid_Video_Width: return "Invalid video width";
+        case cxrError_Invalid_Video_Height: return "Invalid video height";
+        case cxrError_Invalid_Video_Fps: return "Invalid video fps";
+        case cxrError_Invalid_Frame_Mask: return "Invalid frame mask";
+        case cxrError_Server_Initiated_Disconnect: return "Server initiated disconnect";
+        case cxrError_Server_Handshake_Failed: return "Server handshake failed";
+        case cxrError_Frame_Not_Released: return "Frame not released";
+        case cxrError_Frame_Not_Latched: return "Frame not latched";
+        case cxrError_Frame_Not_Ready: return "Frame not ready";
+        case cxrError_Pose_Callback_Provided: return "Pose callback provided";
+        case cxrError_Name_Too_Long: return "Name too long";
+        case cxrError_Too_Many_Inputs: return "Too many inputs";
+        case cxrError_Controller_Id_In_Use: return "Controller ID in use";
+        case cxrError_Role_Too_Long: return "Role too long";
+        default: return "Unknown error";
+    }
+}
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FAKE_CLOUDXR_H
+#define OK_FAKE_CLOUDXR_H
+
+#include <CloudXRClient.h>
+
+#include <cstdint>
+
+namespace BVR
+{
+
+// What the in-process "server" does. Set before cxrConnect, the receiver copies it on connect.
+struct OKFakeCloudXRScript
+{
+    uint32_t connect_delay_ms_ = 50;
+    cxrError connect_error_ = cxrError_Success;     // anything else fails the attempt after the delay
+    uint32_t failed_attempt_count_ = 0;             // the first cxrConnect calls fail anyway, with cxrError_Server_Handshake_Failed
+    uint32_t disconnect_after_ms_ = 0;              // 0 = stream until destroyed
+
+    float frame_rate_ = 0.0f;                       // 0 = fps from the receiver's video stream desc
+    uint32_t pose_poll_hz_ = 0;                     // 0 = posePollFreq from the device desc, else the frame rate
+    bool poll_tracking_ = true;                     // false = never call GetTrackingState, the caller drives it (benchmarks)
+    float server_latency_ms_ = 20.0f;               // pose poll to frame ready on the client (render + encode + network + decode)
+    float latency_jitter_ms_ = 2.0f;
+    float frame_drop_percent_ = 0.0f;               // frames that never arrive
+
+    uint32_t blit_cost_us_ = 0;                     // spent inside cxrBlitFrame per eye
+
+    uint32_t round_trip_delay_ms_ = 10;
+    uint32_t jitter_us_ = 500;
+    uint32_t bandwidth_available_kbps_ = 200000;
+    uint32_t bandwidth_utilization_kbps_ = 50000;
+    float packet_loss_percent_ = 0.0f;
+
+    float haptic_hz_ = 0.0f;                        // TriggerHaptic calls per second, alternating controllers, 0 = none
+    float haptic_seconds_ = 0.02f;                  // each pulse's length, overlapping when longer than the period
+    float haptic_amplitude_ = 0.5f;
+
+    uint32_t random_seed_ = 1;
+};
+
+// Running totals, readable at any time from any thread
+struct OKFakeCloudXRCounters
+{
+    uint64_t tracking_polls_ = 0;
+    uint64_t frames_produced_ = 0;
+    uint64_t frames_dropped_ = 0;       // by frame_drop_percent_
+    uint64_t frames_skipped_ = 0;       // ready but superseded by a newer one before being latched
+    uint64_t frames_latched_ = 0;
+    uint64_t latch_timeouts_ = 0;
+    uint64_t frames_blitted_ = 0;
+    uint64_t frames_released_ = 0;
+    uint64_t controller_events_ = 0;
+    uint64_t controller_event_batches_ = 0;
+    uint64_t input_events_ = 0;
+    uint64_t input_event_bytes_ = 0;    // generic events' payloads
+    uint64_t audio_frames_sent_ = 0;
+    uint64_t haptic_pulses_ = 0;
+    uint64_t refresh_changes_ = 0;      // HasRefresh tracking states, each repacing the stream
+    float frame_rate_ = 0.0f;           // the stream's current pace
+};
+
+void set_fake_cloudxr_script(const OKFakeCloudXRScript& script);
+OKFakeCloudXRScript get_fake_cloudxr_script();
+
+// cxrConnect calls since the script was set, across receivers
+uint32_t get_fake_cloudxr_connect_count();
+
+// Zeroed counters for a null receiver
+OKFakeCloudXRCounters get_fake_cloudxr_counters(cxrReceiverHandle receiver);
+
+} // namespace BVR
+
+#endif // OK_FAKE_CLOUDXR_H
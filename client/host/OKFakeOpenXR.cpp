@@ -0,0 +1,1124 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKFakeOpenXR.h"
+#include "OKClock.h"
+
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <string.h>
+
+#ifndef deg2rad
+#define deg2rad(a)  ((a)*(M_PI/180))
+#endif
+
+namespace BVR
+{
+
+namespace
+{
+
+// Fake handles are small integers, nothing is ever dereferenced
+enum
+{
+    FakeSpace_Base = 1,
+    FakeSpace_Head,
+    FakeSpace_LeftAim,
+    FakeSpace_RightAim,
+    FakeSpace_LeftGrip,
+    FakeSpace_RightGrip,
+    FakeSpace_EyeGaze,
+};
+
+const uintptr_t FAKE_INSTANCE_HANDLE = 1;
+const uintptr_t FAKE_SESSION_HANDLE = 1;
+const uintptr_t FAKE_ACTION_SET_HANDLE = 1;
+const uintptr_t FAKE_ACTION_HANDLE_BASE = 100;
+const uintptr_t FAKE_HAND_TRACKER_HANDLE_BASE = 200; // + XrHandEXT
+const uintptr_t FAKE_BODY_TRACKER_HANDLE = 300;
+const uintptr_t FAKE_FACE_TRACKER_HANDLE = 400;
+const XrPath FAKE_HAND_PATHS[NUM_CONTROLLERS] = {1, 2};
+
+const float TWO_PI = 6.28318530718f;
+const XrTime VELOCITY_DELTA_NS = 1000000; // central difference step for the reported velocities
+
+const int FAKE_FINGER_COUNT = 5;
+const float FAKE_FINGER_SEGMENT_M = 0.03f;
+const float FAKE_FINGER_CURL_DEG = 35.0f; // per segment, fully curled
+
+const float FAKE_HIPS_HEIGHT_M = 0.95f;
+const int FAKE_SPINE_JOINT_COUNT = XR_BODY_JOINT_HEAD_FB - XR_BODY_JOINT_HIPS_FB; // hips to head
+const int FAKE_ARM_JOINT_COUNT = 5;        // shoulder, scapula, upper, lower, wrist twist
+const int FAKE_BODY_HAND_JOINT_BASE = 18;  // XR_BODY_JOINT_LEFT_HAND_PALM_FB, right hand follows
+
+// Body joint frames aren't OpenXR's -Z forward, the hips are Z up here so only their twist about
+// +Y gives a heading, like on device
+const glm::fquat FAKE_HIPS_LOCAL_FRAME = glm::angleAxis(1.57079632679f, glm::vec3(1.0f, 0.0f, 0.0f));
+
+const uint64_t FAKE_BLINK_MS = 150;
+
+const char* const BODY_TRACE_MAGIC = "ok_body_trace";
+const int BODY_TRACE_VERSION = 1;
+
+XrAction OKOpenXRControllerActions::* const fake_actions[] =
+{
+    &OKOpenXRControllerActions::grabAction,
+    &OKOpenXRControllerActions::vibrateAction,
+    &OKOpenXRControllerActions::gripPoseAction,
+    &OKOpenXRControllerActions::aimPoseAction,
+    &OKOpenXRControllerActions::menuClickAction,
+    &OKOpenXRControllerActions::triggerClickAction,
+    &OKOpenXRControllerActions::triggerTouchAction,
+    &OKOpenXRControllerActions::triggerValueAction,
+    &OKOpenXRControllerActions::squeezeClickAction,
+    &OKOpenXRControllerActions::squeezeTouchAction,
+    &OKOpenXRControllerActions::squeezeValueAction,
+    &OKOpenXRControllerActions::thumbstickTouchAction,
+    &OKOpenXRControllerActions::thumbstickClickAction,
+    &OKOpenXRControllerActions::thumbstickXAction,
+    &OKOpenXRControllerActions::thumbstickYAction,
+    &OKOpenXRControllerActions::thumbRestTouchAction,
+    &OKOpenXRControllerActions::thumbRestClickAction,
+    &OKOpenXRControllerActions::thumbRestForceAction,
+    &OKOpenXRControllerActions::thumbProximityAction,
+    &OKOpenXRControllerActions::pinchValueAction,
+    &OKOpenXRControllerActions::pinchForceAction,
+    &OKOpenXRControllerActions::buttonAXClickAction,
+    &OKOpenXRControllerActions::buttonAXTouchAction,
+    &OKOpenXRControllerActions::buttonBYClickAction,
+    &OKOpenXRControllerActions::buttonBYTouchAction,
+    &OKOpenXRControllerActions::trackpadXAction,
+    &OKOpenXRControllerActions::trackpadYAction,
+    &OKOpenXRControllerActions::eyeGazeAction,
+};
+
+const int NUM_FAKE_ACTIONS = (int)ARRAY_SIZE(fake_actions);
+
+template<typename T> T make_handle(const uintptr_t value)
+{
+    return reinterpret_cast<T>(value);
+}
+
+XrSpace make_space(const int space_id)
+{
+    return make_handle<XrSpace>((uintptr_t)space_id);
+}
+
+OKFakeOpenXR* active_fake_openxr = nullptr;
+
+} // namespace
+
+OKFakeOpenXR::OKFakeOpenXR(const OKFakeOpenXRScript& script) : script_(script)
+{
+    active_fake_openxr = this;
+
+    start_time_ns_ = (XrTime)get_monotonic_time_ns();
+    predicted_display_time_ns_ = start_time_ns_;
+
+    actions_.actionSet = make_handle<XrActionSet>(FAKE_ACTION_SET_HANDLE);
+
+    for (int action_id = 0; action_id < NUM_FAKE_ACTIONS; action_id++)
+    {
+        actions_.*fake_actions[action_id] = make_handle<XrAction>(FAKE_ACTION_HANDLE_BASE + action_id);
+    }
+
+    for (int controller_id = LEFT_CONTROLLER; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        actions_.handSubactionPath[controller_id] = FAKE_HAND_PATHS[controller_id];
+        actions_.aimSpace[controller_id] = make_space(FakeSpace_LeftAim + controller_id);
+        actions_.gripSpace[controller_id] = make_space(FakeSpace_LeftGrip + controller_id);
+    }
+
+    if (!script_.eye_gaze_supported_)
+    {
+        actions_.eyeGazeAction = XR_NULL_HANDLE;
+    }
+
+    actions_.eyeGazeSpace = script_.eye_gaze_supported_ ? make_space(FakeSpace_EyeGaze) : XR_NULL_HANDLE;
+
+    if (!script_.body_trace_path_.empty())
+    {
+        load_body_trace(script_.body_trace_path_);
+    }
+}
+
+OKFakeOpenXR::~OKFakeOpenXR()
+{
+    if (active_fake_openxr == this)
+    {
+        active_fake_openxr = nullptr;
+    }
+}
+
+void OKFakeOpenXR::begin_frame(const XrTime predicted_display_time_ns)
+{
+    predicted_display_time_ns_ = predicted_display_time_ns;
+}
+
+XrInstance OKFakeOpenXR::get_instance()
+{
+    return make_handle<XrInstance>(FAKE_INSTANCE_HANDLE);
+}
+
+XrSession OKFakeOpenXR::get_session()
+{
+    return make_handle<XrSession>(FAKE_SESSION_HANDLE);
+}
+
+OKOpenXRControllerActions& OKFakeOpenXR::get_actions()
+{
+    return actions_;
+}
+
+const OKOpenXRControllerActions& OKFakeOpenXR::get_actions() const
+{
+    return actions_;
+}
+
+XrTime OKFakeOpenXR::get_predicted_display_time_ns()
+{
+    return predicted_display_time_ns_;
+}
+
+XrTime OKFakeOpenXR::get_frame_display_time_ns()
+{
+    return predicted_display_time_ns_;
+}
+
+float OKFakeOpenXR::get_current_refresh_rate()
+{
+    return script_.refresh_rate_;
+}
+
+void OKFakeOpenXR::query_refresh_rates()
+{
+}
+
+const std::vector<float>& OKFakeOpenXR::get_supported_refresh_rates()
+{
+    return script_.supported_refresh_rates_;
+}
+
+bool OKFakeOpenXR::set_refresh_rate(const float refresh_rate)
+{
+    if (refresh_rate <= 0.0f)
+    {
+        return false;
+    }
+
+    // xrRequestDisplayRefreshRateFB fails with XR_ERROR_DISPLAY_REFRESH_RATE_UNSUPPORTED_FB, or isn't there at all
+    const std::vector<float>& supported_rates = script_.supported_refresh_rates_;
+
+    if (std::find(supported_rates.begin(), supported_rates.end(), refresh_rate) == supported_rates.end())
+    {
+        return false;
+    }
+
+    script_.refresh_rate_ = refresh_rate;
+    return true;
+}
+
+#if ENABLE_CLOUDXR_LINK_SHARPENING
+void OKFakeOpenXR::set_sharpening_enabled(const bool enabled)
+{
+    (void)enabled;
+}
+#endif
+
+void OKFakeOpenXR::handle_stream_connected()
+{
+    is_stream_connected_ = true;
+}
+
+void OKFakeOpenXR::handle_stream_disconnected()
+{
+    is_stream_connected_ = false;
+}
+
+const XrView OKFakeOpenXR::get_view(const int view_id)
+{
+    const GLMPose head_pose = get_head_pose(predicted_display_time_ns_);
+
+    const float half_ipd = script_.ipd_m_ * 0.5f;
+    const float ipd_offset = (view_id == LEFT_EYE) ? -half_ipd : half_ipd;
+
+    GLMPose eye_pose = head_pose;
+    eye_pose.translation_ += head_pose.rotation_ * glm::vec3(ipd_offset, 0.0f, 0.0f);
+
+    const float half_fov_rad = deg2rad(script_.half_fov_deg_);
+
+    XrView view = {};
+    view.type = XR_TYPE_VIEW;
+    view.pose = convert_to_xr_pose(eye_pose);
+    view.fov.angleLeft = -half_fov_rad;
+    view.fov.angleRight = half_fov_rad;
+    view.fov.angleDown = -half_fov_rad;
+    view.fov.angleUp = half_fov_rad;
+    return view;
+}
+
+void OKFakeOpenXR::poll_actions(const bool main_thread)
+{
+    (void)main_thread;
+    action_poll_count_++;
+}
+
+XrSpace OKFakeOpenXR::get_base_space()
+{
+    return make_space(FakeSpace_Base);
+}
+
+XrSpace OKFakeOpenXR::get_head_space()
+{
+    return make_space(FakeSpace_Head);
+}
+
+float OKFakeOpenXR::get_time_s(const XrTime time) const
+{
+    return (float)((double)(time - start_time_ns_) / 1000000000.0);
+}
+
+GLMPose OKFakeOpenXR::get_head_pose(const XrTime time) const
+{
+    const float phase = TWO_PI * script_.motion_hz_ * get_time_s(time);
+
+    const float yaw_rad = deg2rad(script_.head_yaw_deg_) * sinf(phase);
+    const float pitch_rad = deg2rad(script_.head_pitch_deg_) * sinf(phase * 1.7f);
+
+    const glm::fquat yaw = glm::angleAxis(yaw_rad, glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::fquat pitch = glm::angleAxis(pitch_rad, glm::vec3(1.0f, 0.0f, 0.0f));
+
+    const glm::vec3 translation(script_.head_sway_m_ * sinf(phase * 0.5f),
+                                script_.head_height_m_ + (0.2f * script_.head_sway_m_ * sinf(phase * 2.0f)),
+                                0.5f * script_.head_sway_m_ * cosf(phase * 0.5f));
+
+    return GLMPose(translation, glm::normalize(yaw * pitch));
+}
+
+GLMPose OKFakeOpenXR::get_controller_pose(const int controller_id, const XrTime time) const
+{
+    const GLMPose head_pose = get_head_pose(time);
+    const float phase = TWO_PI * script_.motion_hz_ * get_time_s(time);
+
+    // Hands follow the head's heading but not its pitch, roughly where they'd rest holding controllers
+    const glm::vec3 head_forward = head_pose.rotation_ * glm::vec3(0.0f, 0.0f, -1.0f);
+    const float heading_rad = atan2f(-head_forward.x, -head_forward.z);
+    const glm::fquat heading = glm::angleAxis(heading_rad, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const float side = (controller_id == LEFT_CONTROLLER) ? -1.0f : 1.0f;
+    const glm::vec3 offset(side * 0.2f, -0.35f + 0.05f * sinf(phase * 3.0f + side), -script_.controller_reach_m_);
+
+    const glm::fquat wrist = glm::angleAxis(deg2rad(20.0f) * sinf(phase * 2.0f + side), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    return GLMPose(head_pose.translation_ + heading * offset, glm::normalize(heading * wrist));
+}
+
+GLMPose OKFakeOpenXR::get_eye_gaze_pose(const XrTime time) const
+{
+    const GLMPose head_pose = get_head_pose(time);
+
+    // Fixations at pseudo random targets, jumping to the next one every saccade period
+    const uint64_t elapsed_ms = (uint64_t)std::max<XrTime>(time - start_time_ns_, 0) / 1000000;
+    const uint64_t fixation_id = elapsed_ms / std::max<uint32_t>(script_.saccade_period_ms_, 1);
+
+    const float yaw_rad = deg2rad(script_.gaze_yaw_deg_) * sinf(2.3f * (float)fixation_id);
+    const float pitch_rad = deg2rad(script_.gaze_pitch_deg_) * sinf(1.7f * (float)fixation_id + 0.5f);
+
+    const glm::fquat gaze = glm::angleAxis(yaw_rad, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(pitch_rad, glm::vec3(1.0f, 0.0f, 0.0f));
+
+    return GLMPose(head_pose.translation_, glm::normalize(head_pose.rotation_ * gaze));
+}
+
+bool OKFakeOpenXR::get_space_pose(const XrSpace space, const XrTime time, GLMPose& pose) const
+{
+    switch ((int)reinterpret_cast<uintptr_t>(space))
+    {
+        case FakeSpace_Base:
+            pose = GLMPose();
+            return true;
+        case FakeSpace_Head:
+            pose = get_head_pose(time);
+            return true;
+        case FakeSpace_LeftAim:
+        case FakeSpace_LeftGrip:
+            pose = get_controller_pose(LEFT_CONTROLLER, time);
+            return script_.controllers_active_;
+        case FakeSpace_RightAim:
+        case FakeSpace_RightGrip:
+            pose = get_controller_pose(RIGHT_CONTROLLER, time);
+            return script_.controllers_active_;
+        case FakeSpace_EyeGaze:
+            pose = get_eye_gaze_pose(time);
+            return script_.eye_gaze_active_;
+        default:
+            return false;
+    }
+}
+
+bool OKFakeOpenXR::get_relative_pose(const XrSpace space, const XrSpace base_space, const XrTime time, GLMPose& pose) const
+{
+    if (!get_space_pose(space, time, pose))
+    {
+        return false;
+    }
+
+    GLMPose base_pose;
+
+    if (!get_space_pose(base_space, time, base_pose))
+    {
+        return false;
+    }
+
+    const glm::fquat inverse_base_rotation = glm::inverse(base_pose.rotation_);
+    pose = GLMPose(inverse_base_rotation * (pose.translation_ - base_pose.translation_), glm::normalize(inverse_base_rotation * pose.rotation_));
+
+    return true;
+}
+
+int OKFakeOpenXR::get_controller_id(const XrPath subaction_path) const
+{
+    for (int controller_id = LEFT_CONTROLLER; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        if (subaction_path == FAKE_HAND_PATHS[controller_id])
+        {
+            return controller_id;
+        }
+    }
+
+    return INVALID_INDEX;
+}
+
+int OKFakeOpenXR::get_action_id(const XrAction action) const
+{
+    const uintptr_t handle = reinterpret_cast<uintptr_t>(action);
+
+    if ((handle < FAKE_ACTION_HANDLE_BASE) || (handle >= (FAKE_ACTION_HANDLE_BASE + NUM_FAKE_ACTIONS)))
+    {
+        return INVALID_INDEX;
+    }
+
+    return (int)(handle - FAKE_ACTION_HANDLE_BASE);
+}
+
+XrResult OKFakeOpenXR::locate_space(const XrSpace space, const XrSpace base_space, const XrTime time, XrSpaceLocation* location) const
+{
+    if (!location || (location->type != XR_TYPE_SPACE_LOCATION))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    location->locationFlags = 0;
+
+    // Everything is located relative to the base space or the head
+    if ((base_space != make_space(FakeSpace_Base)) && (base_space != make_space(FakeSpace_Head)))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    GLMPose pose;
+
+    if (!get_relative_pose(space, base_space, time, pose))
+    {
+        return XR_SUCCESS;
+    }
+
+    location->pose = convert_to_xr_pose(pose);
+    location->locationFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                              XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+
+    XrSpaceVelocity* velocity = (XrSpaceVelocity*)location->next;
+
+    if (velocity && (velocity->type == XR_TYPE_SPACE_VELOCITY))
+    {
+        GLMPose previous_pose;
+        GLMPose next_pose;
+        get_relative_pose(space, base_space, time - VELOCITY_DELTA_NS, previous_pose);
+        get_relative_pose(space, base_space, time + VELOCITY_DELTA_NS, next_pose);
+
+        const float delta_s = 2.0f * (float)VELOCITY_DELTA_NS / 1000000000.0f;
+
+        const glm::vec3 linear_velocity = (next_pose.translation_ - previous_pose.translation_) / delta_s;
+
+        // World space angular velocity from the rotation taken over the step
+        glm::fquat delta_rotation = glm::normalize(next_pose.rotation_ * glm::inverse(previous_pose.rotation_));
+
+        if (delta_rotation.w < 0.0f)
+        {
+            delta_rotation = -delta_rotation;
+        }
+
+        const float angle = 2.0f * acosf(glm::clamp(delta_rotation.w, -1.0f, 1.0f));
+        const float sin_half_angle = sqrtf(std::max(1.0f - (delta_rotation.w * delta_rotation.w), 0.0f));
+        const glm::vec3 axis = (sin_half_angle > 0.000001f) ? (glm::vec3(delta_rotation.x, delta_rotation.y, delta_rotation.z) / sin_half_angle) : glm::vec3(0.0f);
+
+        velocity->linearVelocity = convert_to_xr(linear_velocity);
+        velocity->angularVelocity = convert_to_xr(axis * (angle / delta_s));
+        velocity->velocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT | XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+    }
+
+    return XR_SUCCESS;
+}
+
+void OKFakeOpenXR::get_hand_joint_poses(const int hand_id, const XrTime time, GLMPose* joint_poses) const
+{
+    const GLMPose wrist_pose = get_controller_pose(hand_id, time);
+    const float phase = TWO_PI * script_.finger_curl_hz_ * get_time_s(time);
+    const float side = (hand_id == LEFT_CONTROLLER) ? -1.0f : 1.0f;
+
+    joint_poses[XR_HAND_JOINT_WRIST_EXT] = wrist_pose;
+    joint_poses[XR_HAND_JOINT_PALM_EXT] = GLMPose(wrist_pose.translation_ + wrist_pose.rotation_ * glm::vec3(0.0f, 0.0f, -0.05f), wrist_pose.rotation_);
+
+    // Thumb (4 joints) then index / middle / ring / little (5 each), each a chain of segments curling at its own phase
+    int joint_id = XR_HAND_JOINT_THUMB_METACARPAL_EXT;
+
+    for (int finger_id = 0; finger_id < FAKE_FINGER_COUNT; finger_id++)
+    {
+        const int finger_joint_count = (finger_id == 0) ? 4 : 5;
+
+        const float curl_rad = deg2rad(FAKE_FINGER_CURL_DEG) * (0.5f + 0.5f * sinf(phase + 0.7f * (float)finger_id));
+        const glm::fquat curl = glm::angleAxis(curl_rad, glm::vec3(1.0f, 0.0f, 0.0f));
+
+        glm::vec3 position = wrist_pose.translation_ + wrist_pose.rotation_ * glm::vec3(-side * (0.03f - 0.015f * (float)finger_id), 0.0f, -0.03f);
+        glm::fquat rotation = wrist_pose.rotation_;
+
+        for (int segment_id = 0; segment_id < finger_joint_count; segment_id++, joint_id++)
+        {
+            joint_poses[joint_id] = GLMPose(position, rotation);
+
+            rotation = glm::normalize(rotation * curl);
+            position += rotation * glm::vec3(0.0f, 0.0f, -FAKE_FINGER_SEGMENT_M);
+        }
+    }
+}
+
+XrResult OKFakeOpenXR::create_hand_tracker(const XrHandTrackerCreateInfoEXT* create_info, XrHandTrackerEXT* hand_tracker)
+{
+    if (!create_info || !hand_tracker || (create_info->type != XR_TYPE_HAND_TRACKER_CREATE_INFO_EXT) ||
+        ((create_info->hand != XR_HAND_LEFT_EXT) && (create_info->hand != XR_HAND_RIGHT_EXT)))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    *hand_tracker = make_handle<XrHandTrackerEXT>(FAKE_HAND_TRACKER_HANDLE_BASE + create_info->hand);
+    hand_tracker_count_++;
+
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::destroy_hand_tracker(const XrHandTrackerEXT hand_tracker)
+{
+    if (hand_tracker == XR_NULL_HANDLE)
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    hand_tracker_count_--;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::locate_hand_joints(const XrHandTrackerEXT hand_tracker, const XrHandJointsLocateInfoEXT* locate_info, XrHandJointLocationsEXT* locations) const
+{
+    if (!locate_info || !locations || (locate_info->type != XR_TYPE_HAND_JOINTS_LOCATE_INFO_EXT) || (locations->type != XR_TYPE_HAND_JOINT_LOCATIONS_EXT) ||
+        (locations->jointCount != XR_HAND_JOINT_COUNT_EXT) || !locations->jointLocations)
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if (locate_info->baseSpace != make_space(FakeSpace_Base))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    const uintptr_t handle = reinterpret_cast<uintptr_t>(hand_tracker);
+    const int hand_id = (handle == (FAKE_HAND_TRACKER_HANDLE_BASE + XR_HAND_LEFT_EXT)) ? LEFT_CONTROLLER :
+                        (handle == (FAKE_HAND_TRACKER_HANDLE_BASE + XR_HAND_RIGHT_EXT)) ? RIGHT_CONTROLLER : INVALID_INDEX;
+
+    if (hand_id == INVALID_INDEX)
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    locations->isActive = script_.hands_active_ ? XR_TRUE : XR_FALSE;
+
+    GLMPose joint_poses[XR_HAND_JOINT_COUNT_EXT];
+    get_hand_joint_poses(hand_id, locate_info->time, joint_poses);
+
+    for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+    {
+        XrHandJointLocationEXT& joint_location = locations->jointLocations[joint_id];
+
+        joint_location.locationFlags = script_.hands_active_ ? (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                                                                XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT) : 0;
+        joint_location.pose = convert_to_xr_pose(joint_poses[joint_id]);
+        joint_location.radius = 0.01f;
+    }
+
+    return XR_SUCCESS;
+}
+
+GLMPose OKFakeOpenXR::get_hips_pose(const XrTime time) const
+{
+    const GLMPose head_pose = get_head_pose(time);
+    const float phase = TWO_PI * script_.torso_hz_ * get_time_s(time);
+
+    // Under the head, turning on its own slower cycle
+    const float yaw_rad = deg2rad(script_.torso_yaw_deg_) * sinf(phase + 1.0f);
+    const glm::fquat yaw = glm::angleAxis(yaw_rad, glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const glm::vec3 translation(head_pose.translation_.x, FAKE_HIPS_HEIGHT_M, head_pose.translation_.z + 0.05f);
+
+    return GLMPose(translation, glm::normalize(yaw * FAKE_HIPS_LOCAL_FRAME));
+}
+
+void OKFakeOpenXR::get_body_joint_poses(const XrTime time, XrPosef* joint_poses) const
+{
+    if (!body_trace_.empty())
+    {
+        // Latest frame at or before the looped trace time
+        const XrTime trace_duration_ns = std::max<XrTime>(body_trace_.back().time_ns_, 1);
+        const XrTime trace_time_ns = std::max<XrTime>(time - start_time_ns_, 0) % trace_duration_ns;
+
+        auto frame = std::upper_bound(body_trace_.begin(), body_trace_.end(), trace_time_ns,
+                                      [](const XrTime value, const OKFakeBodyFrame& body_frame) { return value < body_frame.time_ns_; });
+
+        if (frame != body_trace_.begin())
+        {
+            --frame;
+        }
+
+        memcpy(joint_poses, frame->joint_poses_, sizeof(frame->joint_poses_));
+        return;
+    }
+
+    const GLMPose head_pose = get_head_pose(time);
+    const GLMPose hips_pose = get_hips_pose(time);
+
+    joint_poses[XR_BODY_JOINT_ROOT_FB] = convert_to_xr_pose(GLMPose(glm::vec3(hips_pose.translation_.x, 0.0f, hips_pose.translation_.z), default_rotation));
+    joint_poses[XR_BODY_JOINT_HIPS_FB] = convert_to_xr_pose(hips_pose);
+
+    // Spine up to the head, blending from the hips' heading to the head's
+    for (int spine_id = 1; spine_id <= FAKE_SPINE_JOINT_COUNT; spine_id++)
+    {
+        const float blend = (float)spine_id / (float)FAKE_SPINE_JOINT_COUNT;
+        const glm::vec3 position = glm::mix(hips_pose.translation_, head_pose.translation_, blend);
+        const glm::fquat rotation = glm::slerp(hips_pose.rotation_, head_pose.rotation_, blend);
+
+        joint_poses[XR_BODY_JOINT_HIPS_FB + spine_id] = convert_to_xr_pose(GLMPose(position, rotation));
+    }
+
+    // Shoulders to the controllers' wrists, then the same hand joints xrLocateHandJointsEXT reports
+    for (int hand_id = LEFT_CONTROLLER; hand_id < NUM_CONTROLLERS; hand_id++)
+    {
+        const GLMPose wrist_pose = get_controller_pose(hand_id, time);
+        const float side = (hand_id == LEFT_CONTROLLER) ? -1.0f : 1.0f;
+        const glm::vec3 shoulder = head_pose.translation_ + glm::vec3(side * 0.18f, -0.25f, 0.05f);
+
+        const int arm_joint_base = XR_BODY_JOINT_LEFT_SHOULDER_FB + hand_id * FAKE_ARM_JOINT_COUNT;
+
+        for (int arm_id = 0; arm_id < FAKE_ARM_JOINT_COUNT; arm_id++)
+        {
+            const float blend = (float)arm_id / (float)(FAKE_ARM_JOINT_COUNT - 1);
+            joint_poses[arm_joint_base + arm_id] = convert_to_xr_pose(GLMPose(glm::mix(shoulder, wrist_pose.translation_, blend), wrist_pose.rotation_));
+        }
+
+        GLMPose hand_joint_poses[XR_HAND_JOINT_COUNT_EXT];
+        get_hand_joint_poses(hand_id, time, hand_joint_poses);
+
+        for (int joint_id = 0; joint_id < XR_HAND_JOINT_COUNT_EXT; joint_id++)
+        {
+            joint_poses[FAKE_BODY_HAND_JOINT_BASE + hand_id * XR_HAND_JOINT_COUNT_EXT + joint_id] = convert_to_xr_pose(hand_joint_poses[joint_id]);
+        }
+    }
+}
+
+bool OKFakeOpenXR::load_body_trace(const std::string& path)
+{
+    std::ifstream trace_file(path);
+
+    std::string magic;
+    int version = 0;
+    int joint_count = 0;
+
+    if (!(trace_file >> magic >> version >> joint_count) || (magic != BODY_TRACE_MAGIC) || (version != BODY_TRACE_VERSION) || (joint_count != XR_BODY_JOINT_COUNT_FB))
+    {
+        return false;
+    }
+
+    std::vector<OKFakeBodyFrame> body_trace;
+    OKFakeBodyFrame body_frame;
+    double time_ms = 0.0;
+
+    while (trace_file >> time_ms)
+    {
+        body_frame.time_ns_ = (XrTime)(time_ms * 1000000.0);
+
+        for (XrPosef& joint_pose : body_frame.joint_poses_)
+        {
+            trace_file >> joint_pose.position.x >> joint_pose.position.y >> joint_pose.position.z
+                       >> joint_pose.orientation.x >> joint_pose.orientation.y >> joint_pose.orientation.z >> joint_pose.orientation.w;
+        }
+
+        if (!trace_file || (!body_trace.empty() && (body_frame.time_ns_ < body_trace.back().time_ns_)))
+        {
+            return false;
+        }
+
+        body_trace.push_back(body_frame);
+    }
+
+    if (body_trace.empty())
+    {
+        return false;
+    }
+
+    body_trace_.swap(body_trace);
+    return true;
+}
+
+bool OKFakeOpenXR::save_body_trace(const std::string& path, const float seconds, const float rate_hz) const
+{
+    std::ofstream trace_file(path);
+
+    if (!trace_file || (seconds <= 0.0f) || (rate_hz <= 0.0f))
+    {
+        return false;
+    }
+
+    trace_file << BODY_TRACE_MAGIC << " " << BODY_TRACE_VERSION << " " << XR_BODY_JOINT_COUNT_FB << "\n";
+    trace_file.precision(7);
+
+    const XrTime frame_period_ns = (XrTime)(1000000000.0 / rate_hz);
+    const XrTime duration_ns = (XrTime)((double)seconds * 1000000000.0);
+
+    XrPosef joint_poses[XR_BODY_JOINT_COUNT_FB];
+
+    for (XrTime time_ns = 0; time_ns <= duration_ns; time_ns += frame_period_ns)
+    {
+        get_body_joint_poses(start_time_ns_ + time_ns, joint_poses);
+
+        trace_file << ((double)time_ns / 1000000.0);
+
+        for (const XrPosef& joint_pose : joint_poses)
+        {
+            trace_file << " " << joint_pose.position.x << " " << joint_pose.position.y << " " << joint_pose.position.z
+                       << " " << joint_pose.orientation.x << " " << joint_pose.orientation.y << " " << joint_pose.orientation.z << " " << joint_pose.orientation.w;
+        }
+
+        trace_file << "\n";
+    }
+
+    return (bool)trace_file;
+}
+
+XrResult OKFakeOpenXR::create_body_tracker(const XrBodyTrackerCreateInfoFB* create_info, XrBodyTrackerFB* body_tracker)
+{
+    if (!create_info || !body_tracker || (create_info->type != XR_TYPE_BODY_TRACKER_CREATE_INFO_FB) || (create_info->bodyJointSet != XR_BODY_JOINT_SET_DEFAULT_FB))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    *body_tracker = make_handle<XrBodyTrackerFB>(FAKE_BODY_TRACKER_HANDLE);
+    body_tracker_count_++;
+
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::destroy_body_tracker(const XrBodyTrackerFB body_tracker)
+{
+    if (body_tracker != make_handle<XrBodyTrackerFB>(FAKE_BODY_TRACKER_HANDLE))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    body_tracker_count_--;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::locate_body_joints(const XrBodyTrackerFB body_tracker, const XrBodyJointsLocateInfoFB* locate_info, XrBodyJointLocationsFB* locations) const
+{
+    if (!locate_info || !locations || (locate_info->type != XR_TYPE_BODY_JOINTS_LOCATE_INFO_FB) || (locations->type != XR_TYPE_BODY_JOINT_LOCATIONS_FB) ||
+        (locations->jointCount != XR_BODY_JOINT_COUNT_FB) || !locations->jointLocations)
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if ((body_tracker != make_handle<XrBodyTrackerFB>(FAKE_BODY_TRACKER_HANDLE)) || (locate_info->baseSpace != make_space(FakeSpace_Base)))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    locations->isActive = script_.body_active_ ? XR_TRUE : XR_FALSE;
+    locations->confidence = script_.body_active_ ? 1.0f : 0.0f;
+    locations->skeletonChangedCount = 0;
+    locations->time = locate_info->time;
+
+    XrPosef joint_poses[XR_BODY_JOINT_COUNT_FB];
+    get_body_joint_poses(locate_info->time, joint_poses);
+
+    for (int joint_id = 0; joint_id < XR_BODY_JOINT_COUNT_FB; joint_id++)
+    {
+        XrBodyJointLocationFB& joint_location = locations->jointLocations[joint_id];
+
+        joint_location.locationFlags = script_.body_active_ ? (XR_SPACE_LOCATION_POSITION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_VALID_BIT |
+                                                               XR_SPACE_LOCATION_POSITION_TRACKED_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT) : 0;
+        joint_location.pose = joint_poses[joint_id];
+    }
+
+    return XR_SUCCESS;
+}
+
+void OKFakeOpenXR::get_face_expression_weights(const XrTime time, float* weights) const
+{
+    const float phase = TWO_PI * script_.expression_hz_ * get_time_s(time);
+
+    for (int weight_id = 0; weight_id < XR_FACE_EXPRESSION2_COUNT_FB; weight_id++)
+    {
+        // Each animating weight on its own frequency, resting at 0 half the time like a real face
+        const float wave = sinf(phase * (1.0f + 0.13f * (float)weight_id) + (float)weight_id);
+        weights[weight_id] = ((weight_id % 4) == 0) ? std::max(wave, 0.0f) : 0.0f;
+    }
+
+    const uint64_t elapsed_ms = (uint64_t)std::max<XrTime>(time - start_time_ns_, 0) / 1000000;
+    const float eyes_closed = ((elapsed_ms % std::max<uint32_t>(script_.blink_period_ms_, 1)) < FAKE_BLINK_MS) ? 1.0f : 0.0f;
+
+    weights[XR_FACE_EXPRESSION2_EYES_CLOSED_L_FB] = eyes_closed;
+    weights[XR_FACE_EXPRESSION2_EYES_CLOSED_R_FB] = eyes_closed;
+}
+
+XrResult OKFakeOpenXR::create_face_tracker(const XrFaceTrackerCreateInfo2FB* create_info, XrFaceTracker2FB* face_tracker)
+{
+    if (!create_info || !face_tracker || (create_info->type != XR_TYPE_FACE_TRACKER_CREATE_INFO2_FB) ||
+        (create_info->faceExpressionSet != XR_FACE_EXPRESSION_SET2_DEFAULT_FB) ||
+        ((create_info->requestedDataSourceCount > 0) && !create_info->requestedDataSources))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    *face_tracker = make_handle<XrFaceTracker2FB>(FAKE_FACE_TRACKER_HANDLE);
+    face_tracker_count_++;
+
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::destroy_face_tracker(const XrFaceTracker2FB face_tracker)
+{
+    if (face_tracker != make_handle<XrFaceTracker2FB>(FAKE_FACE_TRACKER_HANDLE))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    face_tracker_count_--;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::get_face_expression_weights(const XrFaceTracker2FB face_tracker, const XrFaceExpressionInfo2FB* expression_info, XrFaceExpressionWeights2FB* expression_weights) const
+{
+    if (!expression_info || !expression_weights || (expression_info->type != XR_TYPE_FACE_EXPRESSION_INFO2_FB) ||
+        (expression_weights->type != XR_TYPE_FACE_EXPRESSION_WEIGHTS2_FB) ||
+        (expression_weights->weightCount != XR_FACE_EXPRESSION2_COUNT_FB) || !expression_weights->weights ||
+        (expression_weights->confidenceCount != XR_FACE_CONFIDENCE2_COUNT_FB) || !expression_weights->confidences)
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if (face_tracker != make_handle<XrFaceTracker2FB>(FAKE_FACE_TRACKER_HANDLE))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    expression_weights->isValid = script_.face_active_ ? XR_TRUE : XR_FALSE;
+    expression_weights->isEyeFollowingBlendshapesValid = XR_FALSE;
+    expression_weights->dataSource = XR_FACE_TRACKING_DATA_SOURCE2_VISUAL_FB;
+    expression_weights->time = expression_info->time;
+
+    get_face_expression_weights(expression_info->time, expression_weights->weights);
+
+    for (uint32_t confidence_id = 0; confidence_id < expression_weights->confidenceCount; confidence_id++)
+    {
+        expression_weights->confidences[confidence_id] = script_.face_active_ ? 0.9f : 0.0f;
+    }
+
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::get_action_state_boolean(const XrActionStateGetInfo* get_info, XrActionStateBoolean* state) const
+{
+    if (!get_info || !state || (state->type != XR_TYPE_ACTION_STATE_BOOLEAN))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    const int action_id = get_action_id(get_info->action);
+    const int controller_id = get_controller_id(get_info->subactionPath);
+
+    if ((action_id == INVALID_INDEX) || (controller_id == INVALID_INDEX))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    // Each button toggles on its own period, so some change on nearly every frame and most don't
+    const XrTime time = predicted_display_time_ns_;
+    const uint64_t period_ns = (uint64_t)std::max(script_.button_period_ms_, 1u) * 1000000ULL * (uint64_t)(1 + (action_id % 5));
+    const uint64_t phase_ns = (uint64_t)(time - start_time_ns_) + (uint64_t)(action_id + (controller_id * 7)) * 1000000ULL;
+
+    state->isActive = script_.controllers_active_;
+    state->currentState = ((phase_ns / period_ns) & 1) ? XR_TRUE : XR_FALSE;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = time;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::get_action_state_float(const XrActionStateGetInfo* get_info, XrActionStateFloat* state) const
+{
+    if (!get_info || !state || (state->type != XR_TYPE_ACTION_STATE_FLOAT))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    const int action_id = get_action_id(get_info->action);
+    const int controller_id = get_controller_id(get_info->subactionPath);
+
+    if ((action_id == INVALID_INDEX) || (controller_id == INVALID_INDEX))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    const XrTime time = predicted_display_time_ns_;
+    const float phase = TWO_PI * script_.axis_hz_ * get_time_s(time) + (float)action_id + (float)controller_id;
+    const bool is_stick_axis = (get_info->action == actions_.thumbstickXAction) || (get_info->action == actions_.thumbstickYAction);
+
+    state->isActive = script_.controllers_active_;
+    state->currentState = is_stick_axis ? sinf(phase) : (0.5f + 0.5f * sinf(phase));
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = time;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::get_action_state_pose(const XrActionStateGetInfo* get_info, XrActionStatePose* state) const
+{
+    if (!get_info || !state || (state->type != XR_TYPE_ACTION_STATE_POSE))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if (get_action_id(get_info->action) == INVALID_INDEX)
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    // The only action without subaction paths
+    if (get_info->action == actions_.eyeGazeAction)
+    {
+        state->isActive = script_.eye_gaze_active_;
+        return XR_SUCCESS;
+    }
+
+    if (get_controller_id(get_info->subactionPath) == INVALID_INDEX)
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    state->isActive = script_.controllers_active_;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::apply_haptic_feedback(const XrHapticActionInfo* action_info, const XrHapticBaseHeader* feedback)
+{
+    if (!action_info || !feedback || (action_info->type != XR_TYPE_HAPTIC_ACTION_INFO) || (feedback->type != XR_TYPE_HAPTIC_VIBRATION))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if ((action_info->action != actions_.vibrateAction) || (get_controller_id(action_info->subactionPath) == INVALID_INDEX))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    const XrHapticVibration* vibration = (const XrHapticVibration*)feedback;
+
+    if ((vibration->amplitude < 0.0f) || (vibration->amplitude > 1.0f) || (vibration->frequency < 0.0f) ||
+        ((vibration->duration <= 0) && (vibration->duration != XR_MIN_HAPTIC_DURATION)))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    haptic_apply_count_++;
+    return XR_SUCCESS;
+}
+
+XrResult OKFakeOpenXR::stop_haptic_feedback(const XrHapticActionInfo* action_info)
+{
+    if (!action_info || (action_info->type != XR_TYPE_HAPTIC_ACTION_INFO))
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    if ((action_info->action != actions_.vibrateAction) || (get_controller_id(action_info->subactionPath) == INVALID_INDEX))
+    {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+
+    haptic_stop_count_++;
+    return XR_SUCCESS;
+}
+
+} // namespace BVR
+
+using namespace BVR;
+
+namespace
+{
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrCreateHandTrackerEXT(XrSession session, const XrHandTrackerCreateInfoEXT* createInfo, XrHandTrackerEXT* handTracker)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->create_hand_tracker(createInfo, handTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrDestroyHandTrackerEXT(XrHandTrackerEXT handTracker)
+{
+    return active_fake_openxr ? active_fake_openxr->destroy_hand_tracker(handTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrLocateHandJointsEXT(XrHandTrackerEXT handTracker, const XrHandJointsLocateInfoEXT* locateInfo, XrHandJointLocationsEXT* locations)
+{
+    return active_fake_openxr ? active_fake_openxr->locate_hand_joints(handTracker, locateInfo, locations) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrCreateBodyTrackerFB(XrSession session, const XrBodyTrackerCreateInfoFB* createInfo, XrBodyTrackerFB* bodyTracker)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->create_body_tracker(createInfo, bodyTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrDestroyBodyTrackerFB(XrBodyTrackerFB bodyTracker)
+{
+    return active_fake_openxr ? active_fake_openxr->destroy_body_tracker(bodyTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrLocateBodyJointsFB(XrBodyTrackerFB bodyTracker, const XrBodyJointsLocateInfoFB* locateInfo, XrBodyJointLocationsFB* locations)
+{
+    return active_fake_openxr ? active_fake_openxr->locate_body_joints(bodyTracker, locateInfo, locations) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrCreateFaceTracker2FB(XrSession session, const XrFaceTrackerCreateInfo2FB* createInfo, XrFaceTracker2FB* faceTracker)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->create_face_tracker(createInfo, faceTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrDestroyFaceTracker2FB(XrFaceTracker2FB faceTracker)
+{
+    return active_fake_openxr ? active_fake_openxr->destroy_face_tracker(faceTracker) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL fake_xrGetFaceExpressionWeights2FB(XrFaceTracker2FB faceTracker, const XrFaceExpressionInfo2FB* expressionInfo, XrFaceExpressionWeights2FB* expressionWeights)
+{
+    return active_fake_openxr ? active_fake_openxr->get_face_expression_weights(faceTracker, expressionInfo, expressionWeights) : XR_ERROR_INSTANCE_LOST;
+}
+
+} // namespace
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
+{
+    (void)instance;
+
+    if (!name || !function)
+    {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    *function = nullptr;
+
+    if (!active_fake_openxr)
+    {
+        return XR_ERROR_INSTANCE_LOST;
+    }
+
+    if (active_fake_openxr->get_script().hand_tracking_supported_)
+    {
+        if (strcmp(name, "xrCreateHandTrackerEXT") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrCreateHandTrackerEXT;
+        }
+        else if (strcmp(name, "xrDestroyHandTrackerEXT") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrDestroyHandTrackerEXT;
+        }
+        else if (strcmp(name, "xrLocateHandJointsEXT") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrLocateHandJointsEXT;
+        }
+    }
+
+    if (active_fake_openxr->get_script().body_tracking_supported_)
+    {
+        if (strcmp(name, "xrCreateBodyTrackerFB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrCreateBodyTrackerFB;
+        }
+        else if (strcmp(name, "xrDestroyBodyTrackerFB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrDestroyBodyTrackerFB;
+        }
+        else if (strcmp(name, "xrLocateBodyJointsFB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrLocateBodyJointsFB;
+        }
+    }
+
+    if (active_fake_openxr->get_script().face_tracking_supported_)
+    {
+        if (strcmp(name, "xrCreateFaceTracker2FB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrCreateFaceTracker2FB;
+        }
+        else if (strcmp(name, "xrDestroyFaceTracker2FB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrDestroyFaceTracker2FB;
+        }
+        else if (strcmp(name, "xrGetFaceExpressionWeights2FB") == 0)
+        {
+            *function = (PFN_xrVoidFunction)fake_xrGetFaceExpressionWeights2FB;
+        }
+    }
+
+    return *function ? XR_SUCCESS : XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)
+{
+    return active_fake_openxr ? active_fake_openxr->locate_space(space, baseSpace, time, location) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateBoolean* state)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->get_action_state_boolean(getInfo, state) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->get_action_state_float(getInfo, state) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetActionStatePose(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStatePose* state)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->get_action_state_pose(getInfo, state) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrApplyHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo, const XrHapticBaseHeader* hapticFeedback)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->apply_haptic_feedback(hapticActionInfo, hapticFeedback) : XR_ERROR_INSTANCE_LOST;
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL xrStopHapticFeedback(XrSession session, const XrHapticActionInfo* hapticActionInfo)
+{
+    (void)session;
+    return active_fake_openxr ? active_fake_openxr->stop_haptic_feedback(hapticActionInfo) : XR_ERROR_INSTANCE_LOST;
+}
@@ -0,0 +1,207 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FAKE_OPENXR_H
+#define OK_FAKE_OPENXR_H
+
+#include "OKCloudClient.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BVR
+{
+
+// Synthetic user: head looking around and bobbing, hands held out in front following the
+// head's yaw, buttons toggling and axes sweeping. Every value is a function of XrTime alone,
+// so the pose the client sampled for a frame can always be recomputed exactly.
+struct OKFakeOpenXRScript
+{
+    float refresh_rate_ = DEFAULT_CLOUDXR_FRAMERATE;
+    std::vector<float> supported_refresh_rates_ = {72.0f, 80.0f, 90.0f, 120.0f}; // empty = fixed at refresh_rate_, as without XR_FB_display_refresh_rate
+    float ipd_m_ = DEFAULT_CLOUDXR_IPD_M;
+    float half_fov_deg_ = 45.0f;
+
+    float head_height_m_ = 1.6f;
+    float head_sway_m_ = 0.05f;
+    float head_yaw_deg_ = 30.0f;
+    float head_pitch_deg_ = 10.0f;
+    float motion_hz_ = 0.25f;
+
+    bool controllers_active_ = true;
+    float controller_reach_m_ = 0.35f;
+    uint32_t button_period_ms_ = 700;
+    float axis_hz_ = 0.5f;
+
+    bool hand_tracking_supported_ = true;   // false = xrGetInstanceProcAddr fails, as without XR_EXT_hand_tracking
+    bool hands_active_ = true;
+    float finger_curl_hz_ = 0.8f;           // wrists on the grip poses, fingers curling in and out
+
+    bool eye_gaze_supported_ = true;        // false = no eyeGazeAction / eyeGazeSpace, as without XR_EXT_eye_gaze_interaction
+    bool eye_gaze_active_ = true;
+    uint32_t saccade_period_ms_ = 300;
+    float gaze_yaw_deg_ = 20.0f;
+    float gaze_pitch_deg_ = 15.0f;
+
+    bool body_tracking_supported_ = true;   // false = xrGetInstanceProcAddr fails, as without XR_FB_body_tracking
+    bool body_active_ = true;
+    float torso_yaw_deg_ = 35.0f;           // hips turning on their own, out of phase with the head
+    float torso_hz_ = 0.15f;
+    std::string body_trace_path_;           // replay recorded joints instead, see load_body_trace()
+
+    bool face_tracking_supported_ = true;   // false = xrGetInstanceProcAddr fails, as without XR_FB_face_tracking2
+    bool face_active_ = true;
+    float expression_hz_ = 0.4f;            // a quarter of the weights animating, the rest neutral
+    uint32_t blink_period_ms_ = 4000;
+};
+
+// XR_BODY_JOINT_COUNT_FB base space joint poses at one time
+struct OKFakeBodyFrame
+{
+    XrTime time_ns_ = 0; // from the start of the trace
+    XrPosef joint_poses_[XR_BODY_JOINT_COUNT_FB];
+};
+
+// Stands in for OKCloudSession + XrApp, and backs the xr* entry points the client core calls
+// (xrLocateSpace, xrGetActionState*, xrApplyHapticFeedback / xrStopHapticFeedback, the XR_EXT_hand_tracking / XR_FB_body_tracking / XR_FB_face_tracking2 functions). Only one instance may exist at a time.
+class OKFakeOpenXR : public OKOpenXRInterface
+{
+public:
+    explicit OKFakeOpenXR(const OKFakeOpenXRScript& script);
+    virtual ~OKFakeOpenXR();
+
+    // What xrWaitFrame would hand back, call once per frame before pre_render_update
+    void begin_frame(const XrTime predicted_display_time_ns);
+
+    const OKFakeOpenXRScript& get_script() const
+    {
+        return script_;
+    }
+
+    bool is_stream_connected() const
+    {
+        return is_stream_connected_;
+    }
+
+    uint64_t get_action_poll_count() const
+    {
+        return action_poll_count_;
+    }
+
+    int get_hand_tracker_count() const
+    {
+        return hand_tracker_count_;
+    }
+
+    // XR_HAND_JOINT_COUNT_EXT poses in the base space, what xrLocateHandJointsEXT reports
+    void get_hand_joint_poses(const int hand_id, const XrTime time, GLMPose* joint_poses) const;
+
+    // XR_BODY_JOINT_COUNT_FB poses in the base space, what xrLocateBodyJointsFB reports
+    void get_body_joint_poses(const XrTime time, XrPosef* joint_poses) const;
+
+    // Body traces are text: a "ok_body_trace 1 <joint count>" line, then one line per frame of
+    // the time in ms followed by px py pz qx qy qz qw for each joint. A loaded trace loops.
+    bool load_body_trace(const std::string& path);
+    bool save_body_trace(const std::string& path, const float seconds, const float rate_hz) const;
+
+    // XR_FACE_EXPRESSION2_COUNT_FB weights, what xrGetFaceExpressionWeights2FB reports
+    void get_face_expression_weights(const XrTime time, float* weights) const;
+
+    int get_face_tracker_count() const
+    {
+        return face_tracker_count_;
+    }
+
+    int get_body_tracker_count() const
+    {
+        return body_tracker_count_;
+    }
+
+    uint64_t get_haptic_apply_count() const
+    {
+        return haptic_apply_count_;
+    }
+
+    uint64_t get_haptic_stop_count() const
+    {
+        return haptic_stop_count_;
+    }
+
+    virtual XrInstance get_instance() override;
+    virtual XrSession get_session() override;
+
+    virtual OKOpenXRControllerActions& get_actions() override;
+    virtual const OKOpenXRControllerActions& get_actions() const override;
+
+    virtual XrTime get_predicted_display_time_ns() override;
+    virtual XrTime get_frame_display_time_ns() override;
+
+    virtual float get_current_refresh_rate() override;
+    virtual void query_refresh_rates() override;
+    virtual const std::vector<float>& get_supported_refresh_rates() override;
+    virtual bool set_refresh_rate(const float refresh_rate) override;
+
+#if ENABLE_CLOUDXR_LINK_SHARPENING
+    virtual void set_sharpening_enabled(const bool enabled) override;
+#endif
+
+    virtual void handle_stream_connected() override;
+    virtual void handle_stream_disconnected() override;
+
+    virtual const XrView get_view(const int view_id) override;
+
+    virtual void poll_actions(const bool main_thread) override;
+    virtual XrSpace get_base_space() override;
+    virtual XrSpace get_head_space() override;
+
+    // Backing for the fake xr* entry points
+    XrResult locate_space(const XrSpace space, const XrSpace base_space, const XrTime time, XrSpaceLocation* location) const;
+    XrResult get_action_state_boolean(const XrActionStateGetInfo* get_info, XrActionStateBoolean* state) const;
+    XrResult get_action_state_float(const XrActionStateGetInfo* get_info, XrActionStateFloat* state) const;
+    XrResult get_action_state_pose(const XrActionStateGetInfo* get_info, XrActionStatePose* state) const;
+    XrResult create_hand_tracker(const XrHandTrackerCreateInfoEXT* create_info, XrHandTrackerEXT* hand_tracker);
+    XrResult destroy_hand_tracker(const XrHandTrackerEXT hand_tracker);
+    XrResult locate_hand_joints(const XrHandTrackerEXT hand_tracker, const XrHandJointsLocateInfoEXT* locate_info, XrHandJointLocationsEXT* locations) const;
+    XrResult create_body_tracker(const XrBodyTrackerCreateInfoFB* create_info, XrBodyTrackerFB* body_tracker);
+    XrResult destroy_body_tracker(const XrBodyTrackerFB body_tracker);
+    XrResult locate_body_joints(const XrBodyTrackerFB body_tracker, const XrBodyJointsLocateInfoFB* locate_info, XrBodyJointLocationsFB* locations) const;
+    XrResult create_face_tracker(const XrFaceTrackerCreateInfo2FB* create_info, XrFaceTracker2FB* face_tracker);
+    XrResult destroy_face_tracker(const XrFaceTracker2FB face_tracker);
+    XrResult get_face_expression_weights(const XrFaceTracker2FB face_tracker, const XrFaceExpressionInfo2FB* expression_info, XrFaceExpressionWeights2FB* expression_weights) const;
+    XrResult apply_haptic_feedback(const XrHapticActionInfo* action_info, const XrHapticBaseHeader* feedback);
+    XrResult stop_haptic_feedback(const XrHapticActionInfo* action_info);
+
+private:
+    GLMPose get_head_pose(const XrTime time) const;
+    GLMPose get_controller_pose(const int controller_id, const XrTime time) const;
+    GLMPose get_eye_gaze_pose(const XrTime time) const;
+    GLMPose get_hips_pose(const XrTime time) const;
+    bool get_space_pose(const XrSpace space, const XrTime time, GLMPose& pose) const;
+    bool get_relative_pose(const XrSpace space, const XrSpace base_space, const XrTime time, GLMPose& pose) const;
+    int get_controller_id(const XrPath subaction_path) const;
+    int get_action_id(const XrAction action) const;
+    float get_time_s(const XrTime time) const;
+
+    OKFakeOpenXRScript script_;
+    OKOpenXRControllerActions actions_;
+
+    XrTime start_time_ns_ = 0;
+    std::atomic<XrTime> predicted_display_time_ns_{0};
+
+    std::atomic<bool> is_stream_connected_{false};
+    std::atomic<uint64_t> action_poll_count_{0};
+    std::atomic<int> hand_tracker_count_{0};
+    std::atomic<int> body_tracker_count_{0};
+    std::atomic<int> face_tracker_count_{0};
+    std::atomic<uint64_t> haptic_apply_count_{0};
+    std::atomic<uint64_t> haptic_stop_count_{0};
+
+    std::vector<OKFakeBodyFrame> body_trace_;
+};
+
+} // namespace BVR
+
+#endif // OK_FAKE_OPENXR_H
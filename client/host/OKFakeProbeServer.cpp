@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include "OKFakeProbeServer.h"
+#include "OKServerSelector.h"
+#include "OKClock.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+
+namespace BVR
+{
+
+namespace
+{
+
+struct OKPendingReply
+{
+    uint64_t due_time_ns_ = 0;
+    sockaddr_in address_ = {};
+    OKServerProbePacket packet_;
+};
+
+int open_bound_socket(const std::string& address, const uint16_t port, const int type)
+{
+    sockaddr_in bind_address = {};
+    bind_address.sin_family = AF_INET;
+    bind_address.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, address.c_str(), &bind_address.sin_addr) != 1)
+    {
+        return -1;
+    }
+
+    const int socket_fd = socket(AF_INET, type, 0);
+
+    if (socket_fd < 0)
+    {
+        return -1;
+    }
+
+    const int reuse = 1;
+    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    fcntl(socket_fd, F_SETFL, fcntl(socket_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    if ((bind(socket_fd, (const sockaddr*)&bind_address, sizeof(bind_address)) != 0) ||
+        ((type == SOCK_STREAM) && (listen(socket_fd, 4) != 0)))
+    {
+        close(socket_fd);
+        return -1;
+    }
+
+    return socket_fd;
+}
+
+} // namespace
+
+OKFakeProbeServer::~OKFakeProbeServer()
+{
+    stop();
+}
+
+bool OKFakeProbeServer::start(const OKFakeProbeServerScript& script)
+{
+    stop();
+
+    script_ = script;
+    probe_count_.store(0, std::memory_order_relaxed);
+
+    if (script_.has_responder_)
+    {
+        udp_socket_ = open_bound_socket(script_.address_, script_.probe_port_, SOCK_DGRAM);
+
+        if (udp_socket_ < 0)
+        {
+            return false;
+        }
+    }
+
+    if (script_.has_listener_)
+    {
+        tcp_socket_ = open_bound_socket(script_.address_, CLOUDXR_SERVER_TCP_PORT, SOCK_STREAM);
+
+        if (tcp_socket_ < 0)
+        {
+            stop();
+            return false;
+        }
+    }
+
+    should_stop_.store(false, std::memory_order_release);
+    thread_ = std::thread(&OKFakeProbeServer::run, this);
+    return true;
+}
+
+void OKFakeProbeServer::stop()
+{
+    if (thread_.joinable())
+    {
+        should_stop_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+
+    if (udp_socket_ >= 0)
+    {
+        close(udp_socket_);
+        udp_socket_ = -1;
+    }
+
+    if (tcp_socket_ >= 0)
+    {
+        close(tcp_socket_);
+        tcp_socket_ = -1;
+    }
+}
+
+void OKFakeProbeServer::run()
+{
+    std::deque<OKPendingReply> pending_replies;
+
+    while (!should_stop_.load(std::memory_order_acquire))
+    {
+        pollfd poll_fds[2];
+        nfds_t poll_fd_count = 0;
+
+        if (udp_socket_ >= 0)
+        {
+            poll_fds[poll_fd_count++] = {udp_socket_, POLLIN, 0};
+        }
+
+        if (tcp_socket_ >= 0)
+        {
+            poll_fds[poll_fd_count++] = {tcp_socket_, POLLIN, 0};
+        }
+
+        // Wake for the next due reply, else often enough to notice stop
+        int wait_ms = 5;
+
+        if (!pending_replies.empty())
+        {
+            const uint64_t now_time_ns = get_monotonic_time_ns();
+            const uint64_t due_time_ns = pending_replies.front().due_time_ns_;
+            wait_ms = (due_time_ns > now_time_ns) ? std::min(wait_ms, (int)((due_time_ns - now_time_ns + 999999ULL) / 1000000ULL)) : 0;
+        }
+
+        poll(poll_fds, poll_fd_count, wait_ms);
+
+        const uint64_t now_time_ns = get_monotonic_time_ns();
+
+        for (nfds_t poll_id = 0; poll_id < poll_fd_count; poll_id++)
+        {
+            if (!(poll_fds[poll_id].revents & POLLIN))
+            {
+                continue;
+            }
+
+            if (poll_fds[poll_id].fd == tcp_socket_)
+            {
+                // Only the handshake matters to the probe
+                const int client_socket = accept(tcp_socket_, nullptr, nullptr);
+
+                if (client_socket >= 0)
+                {
+                    close(client_socket);
+                }
+
+                continue;
+            }
+
+            OKPendingReply reply;
+            socklen_t address_size = sizeof(reply.address_);
+
+            while (recvfrom(udp_socket_, &reply.packet_, sizeof(reply.packet_), 0, (sockaddr*)&reply.address_, &address_size) == (ssize_t)sizeof(reply.packet_))
+            {
+                if (reply.packet_.magic_ == SERVER_PROBE_MAGIC)
+                {
+                    reply.packet_.load_percent_ = script_.load_percent_;
+                    reply.due_time_ns_ = now_time_ns + (uint64_t)script_.delay_ms_ * 1000000ULL;
+                    pending_replies.push_back(reply);
+                    probe_count_.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                address_size = sizeof(reply.address_);
+            }
+        }
+
+        while (!pending_replies.empty() && (pending_replies.front().due_time_ns_ <= get_monotonic_time_ns()))
+        {
+            const OKPendingReply& reply = pending_replies.front();
+            sendto(udp_socket_, &reply.packet_, sizeof(reply.packet_), 0, (const sockaddr*)&reply.address_, sizeof(reply.address_));
+            pending_replies.pop_front();
+        }
+    }
+}
+
+} // namespace BVR
@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef OK_FAKE_PROBE_SERVER_H
+#define OK_FAKE_PROBE_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace BVR
+{
+
+// What one stand-in server does. Bound to its own loopback address (127.0.0.x), so several
+// can share the probe port like real hosts on the LAN.
+struct OKFakeProbeServerScript
+{
+    std::string address_ = "127.0.0.2";
+    uint16_t probe_port_ = 0;
+    bool has_responder_ = true;     // echo UDP probes, else only the TCP listener answers
+    bool has_listener_ = true;      // accept on CLOUDXR_SERVER_TCP_PORT, false + no responder = server down
+    uint32_t delay_ms_ = 0;         // held this long before the echo goes back, the simulated RTT
+    uint32_t load_percent_ = 0;
+};
+
+// Stand-in for the probe responder running next to a CloudXR server, so OKServerSelector can
+// be exercised without one
+class OKFakeProbeServer
+{
+public:
+    ~OKFakeProbeServer();
+
+    bool start(const OKFakeProbeServerScript& script);
+    void stop();
+
+    const OKFakeProbeServerScript& get_script() const
+    {
+        return script_;
+    }
+
+    uint32_t get_probe_count() const
+    {
+        return probe_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void run();
+
+    OKFakeProbeServerScript script_;
+    int udp_socket_ = -1;
+    int tcp_socket_ = -1;
+
+    std::thread thread_;
+    std::atomic<bool> should_stop_ = {false};
+    std::atomic<uint32_t> probe_count_ = {0};
+};
+
+} // namespace BVR
+
+#endif // OK_FAKE_PROBE_SERVER_H
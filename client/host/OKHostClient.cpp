@@ -0,0 +1,702 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Headless driver for the OK client core: runs the same per-frame sequence as OKCloudSession
+// (pre_render_update, latch on the left eye, blit or re-present per eye, release) against the
+// fake CloudXR receiver and fake OpenXR runtime, then prints where the time went.
+//
+// Usage: ok_host_client [key=value ...], see print_usage for the keys.
+
+#include "OKFakeCloudXR.h"
+#include "OKFakeOpenXR.h"
+#include "OKFakeProbeServer.h"
+#include "OKClock.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKHostOptions
+{
+    float seconds_ = 10.0f;
+    uint32_t frames_ = 0; // 0 = run for seconds_
+    std::string config_directory_ = "./";
+    bool print_per_second_ = false;
+    int eye_size_ = 512; // 0 = no GL context, OKFrameCache can't capture or present
+    std::string record_body_trace_path_; // the fake's body joints over the run, for ok_tracking_benchmark
+    std::vector<OKFakeProbeServerScript> servers_; // stand-in servers to pick from, empty = the configured address
+    int server_cache_ttl_s_ = -1; // -1 = the config's
+    int desired_refresh_rate_ = -1; // -1 = the config's
+    int max_stream_fps_ = -1; // -1 = the config's
+    float refresh_change_s_ = 0.0f; // the system switching the display rate mid-run, 0 = never
+    float refresh_change_rate_ = 90.0f;
+};
+
+// Headless GLES 3 context (Mesa surfaceless) with one render target per eye, so OKFrameCache's
+// capture / present run for real. The fake receiver's cxrBlitFrame doesn't draw anything.
+struct OKHostGLContext
+{
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    GLuint textures_[NUM_EYES] = {};
+    GLuint framebuffers_[NUM_EYES] = {};
+    int eye_size_ = 0;
+
+    bool create(const int eye_size)
+    {
+        // Surfaceless Mesa platform: no window system or pbuffer configs needed
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+        if (!get_platform_display)
+        {
+            return false;
+        }
+
+        display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+        if ((display_ == EGL_NO_DISPLAY) || !eglInitialize(display_, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_ES_API))
+        {
+            return false;
+        }
+
+        const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION_KHR, 3, EGL_NONE};
+        context_ = eglCreateContext(display_, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+
+        if ((context_ == EGL_NO_CONTEXT) || !eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_))
+        {
+            return false;
+        }
+
+        eye_size_ = eye_size;
+
+        glGenTextures(NUM_EYES, textures_);
+        glGenFramebuffers(NUM_EYES, framebuffers_);
+
+        for (int view_id = LEFT_EYE; view_id < NUM_EYES; view_id++)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures_[view_id]);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, eye_size_, eye_size_);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[view_id]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures_[view_id], 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                return false;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return true;
+    }
+
+    // What OKCloudSession does before blitting each eye into its swapchain image
+    void bind_eye(const int view_id)
+    {
+        if (eye_size_ > 0)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[view_id]);
+            glViewport(0, 0, eye_size_, eye_size_);
+        }
+    }
+
+    void finish()
+    {
+        if (eye_size_ > 0)
+        {
+            glFinish();
+        }
+    }
+
+    void destroy()
+    {
+        if (display_ == EGL_NO_DISPLAY)
+        {
+            return;
+        }
+
+        if (eye_size_ > 0)
+        {
+            glDeleteFramebuffers(NUM_EYES, framebuffers_);
+            glDeleteTextures(NUM_EYES, textures_);
+            eye_size_ = 0;
+        }
+
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (context_ != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(display_, context_);
+        }
+
+        eglTerminate(display_);
+        display_ = EGL_NO_DISPLAY;
+    }
+};
+
+void print_usage()
+{
+    printf("ok_host_client [key=value ...]\n"
+           "  seconds=10        run time, ignored when frames is set\n"
+           "  frames=0          frames to render\n"
+           "  fps=72            display refresh rate at startup\n"
+           "  refresh_rates=72,80,90,120  display rates the headset supports, empty = fixed at fps\n"
+           "  desired_fps=      config desired_refresh_rate, 0 = the highest supported\n"
+           "  max_stream_fps=   config max_stream_fps, 0 = the display rate\n"
+           "  refresh_at=0      switch the display rate after this many seconds, 0 = never\n"
+           "  refresh_to=90     the rate it switches to\n"
+           "  config_dir=./     where ok_cloud_streamer_config.json / ok_input_profiles.json are read from\n"
+           "  per_second=0      print the telemetry window every second\n"
+           "  eye_size=512      per eye render target, 0 = no GL context\n"
+           "  stream_fps=0      server frame rate, 0 = the stream's fps\n"
+           "  poll_hz=0         server pose poll rate, 0 = posePollFreq\n"
+           "  latency_ms=20     pose poll to frame ready\n"
+           "  jitter_ms=2\n"
+           "  drop_percent=0    frames that never arrive\n"
+           "  blit_us=0         cost of each cxrBlitFrame\n"
+           "  connect_ms=50     connection delay\n"
+           "  connect_error=0   cxrError to fail the connection with\n"
+           "  fail_attempts=0   connection attempts that fail before one succeeds\n"
+           "  disconnect_ms=0   server disconnect after this long, 0 = never\n"
+           "  rtt_ms=10\n"
+           "  loss_percent=0\n"
+           "  haptic_hz=0       server haptic pulses per second, 0 = none\n"
+           "  haptic_ms=20      each pulse's length\n"
+           "  controllers=1     fake controllers active\n"
+           "  hands=1           fake hand tracking active\n"
+           "  gaze=1            fake eye gaze active\n"
+           "  body=1            fake body tracking active\n"
+           "  face=1            fake face tracking active\n"
+           "  body_trace=       replay recorded body joints\n"
+           "  record_body_trace=  write the body joints of the run to this file\n"
+           "  servers=          candidate servers, address/delay_ms/load,... e.g. 127.0.0.2/20/30,127.0.0.3/5/80\n"
+           "                    delay - = no probe responder (TCP connect only), x = server down\n"
+           "  cache_ttl_s=      server cache TTL, 0 = always probe\n"
+           "  seed=1\n");
+}
+
+// Comma separated
+void parse_refresh_rates(const char* value, std::vector<float>& refresh_rates)
+{
+    refresh_rates.clear();
+
+    for (const char* rate = value; *rate; )
+    {
+        char* end = nullptr;
+        const float refresh_rate = strtof(rate, &end);
+
+        if (end == rate)
+        {
+            break;
+        }
+
+        if (refresh_rate > 0.0f)
+        {
+            refresh_rates.push_back(refresh_rate);
+        }
+
+        rate = (*end == ',') ? (end + 1) : end;
+    }
+}
+
+// address/delay_ms/load, comma separated
+bool parse_servers(const char* value, std::vector<OKFakeProbeServerScript>& servers)
+{
+    servers.clear();
+
+    std::string list = value;
+    size_t start = 0;
+
+    while (start < list.size())
+    {
+        const size_t end = std::min(list.find(',', start), list.size());
+        const std::string entry = list.substr(start, end - start);
+        start = end + 1;
+
+        const size_t delay_separator = entry.find('/');
+
+        if (delay_separator == std::string::npos)
+        {
+            return false;
+        }
+
+        OKFakeProbeServerScript server;
+        server.address_ = entry.substr(0, delay_separator);
+
+        const size_t load_separator = entry.find('/', delay_separator + 1);
+        const std::string delay = entry.substr(delay_separator + 1, load_separator - delay_separator - 1);
+
+        if (delay == "x")
+        {
+            server.has_responder_ = false;
+            server.has_listener_ = false;
+        }
+        else if (delay == "-")
+        {
+            server.has_responder_ = false;
+        }
+        else
+        {
+            server.delay_ms_ = (uint32_t)strtoul(delay.c_str(), nullptr, 0);
+        }
+
+        if (load_separator != std::string::npos)
+        {
+            server.load_percent_ = (uint32_t)strtoul(entry.c_str() + load_separator + 1, nullptr, 0);
+        }
+
+        servers.push_back(server);
+    }
+
+    return !servers.empty();
+}
+
+bool parse_options(int argc, char** argv, OKHostOptions& options, OKFakeCloudXRScript& cxr_script, OKFakeOpenXRScript& xr_script)
+{
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        const char* arg = argv[arg_id];
+        const char* separator = strchr(arg, '=');
+
+        if (!separator)
+        {
+            return false;
+        }
+
+        const std::string key(arg, separator - arg);
+        const char* value = separator + 1;
+
+        const float float_value = (float)atof(value);
+        const uint32_t uint_value = (uint32_t)strtoul(value, nullptr, 0);
+
+        if (key == "seconds") options.seconds_ = float_value;
+        else if (key == "frames") options.frames_ = uint_value;
+        else if (key == "fps") xr_script.refresh_rate_ = float_value;
+        else if (key == "refresh_rates") parse_refresh_rates(value, xr_script.supported_refresh_rates_);
+        else if (key == "desired_fps") options.desired_refresh_rate_ = (int)uint_value;
+        else if (key == "max_stream_fps") options.max_stream_fps_ = (int)uint_value;
+        else if (key == "refresh_at") options.refresh_change_s_ = float_value;
+        else if (key == "refresh_to") options.refresh_change_rate_ = float_value;
+        else if (key == "config_dir") options.config_directory_ = value;
+        else if (key == "per_second") options.print_per_second_ = (uint_value != 0);
+        else if (key == "eye_size") options.eye_size_ = (int)uint_value;
+        else if (key == "stream_fps") cxr_script.frame_rate_ = float_value;
+        else if (key == "poll_hz") cxr_script.pose_poll_hz_ = uint_value;
+        else if (key == "latency_ms") cxr_script.server_latency_ms_ = float_value;
+        else if (key == "jitter_ms") cxr_script.latency_jitter_ms_ = float_value;
+        else if (key == "drop_percent") cxr_script.frame_drop_percent_ = float_value;
+        else if (key == "blit_us") cxr_script.blit_cost_us_ = uint_value;
+        else if (key == "connect_ms") cxr_script.connect_delay_ms_ = uint_value;
+        else if (key == "connect_error") cxr_script.connect_error_ = (cxrError)uint_value;
+        else if (key == "fail_attempts") cxr_script.failed_attempt_count_ = uint_value;
+        else if (key == "disconnect_ms") cxr_script.disconnect_after_ms_ = uint_value;
+        else if (key == "rtt_ms") cxr_script.round_trip_delay_ms_ = uint_value;
+        else if (key == "loss_percent") cxr_script.packet_loss_percent_ = float_value;
+        else if (key == "haptic_hz") cxr_script.haptic_hz_ = float_value;
+        else if (key == "haptic_ms") cxr_script.haptic_seconds_ = float_value / 1000.0f;
+        else if (key == "controllers") xr_script.controllers_active_ = (uint_value != 0);
+        else if (key == "hands") xr_script.hands_active_ = (uint_value != 0);
+        else if (key == "gaze") xr_script.eye_gaze_active_ = (uint_value != 0);
+        else if (key == "body") xr_script.body_active_ = (uint_value != 0);
+        else if (key == "face") xr_script.face_active_ = (uint_value != 0);
+        else if (key == "body_trace") xr_script.body_trace_path_ = value;
+        else if (key == "record_body_trace") options.record_body_trace_path_ = value;
+        else if (key == "servers")
+        {
+            if (!parse_servers(value, options.servers_))
+            {
+                return false;
+            }
+        }
+        else if (key == "cache_ttl_s") options.server_cache_ttl_s_ = (int)uint_value;
+        else if (key == "seed") cxr_script.random_seed_ = uint_value;
+        else return false;
+    }
+
+    return (xr_script.refresh_rate_ > 0.0f);
+}
+
+float convert_ns_to_ms(const uint64_t duration_ns)
+{
+    return (float)((double)duration_ns / 1000000.0);
+}
+
+void print_histogram(const char* name, const OKLatencyHistogram& histogram)
+{
+    printf("  %-24s n=%-8llu mean=%7.3f p50=%7.3f p95=%7.3f p99=%7.3f max=%7.3f ms\n", name,
+           (unsigned long long)histogram.get_count(),
+           histogram.get_mean_ns() / 1000000.0f,
+           convert_ns_to_ms(histogram.get_percentile_ns(0.50f)),
+           convert_ns_to_ms(histogram.get_percentile_ns(0.95f)),
+           convert_ns_to_ms(histogram.get_percentile_ns(0.99f)),
+           convert_ns_to_ms(histogram.get_max_ns()));
+}
+
+#if ENABLE_TELEMETRY
+void print_telemetry_summary(const OKTelemetrySummary& summary)
+{
+    static const char* event_names[] = {"latch", "blit", "release"};
+
+    for (int event_id = 0; event_id < TelemetryEvent_ConnectionStats; event_id++)
+    {
+        const OKTelemetryPercentiles& percentiles = summary.frame_events_[event_id];
+        printf("  %-24s n=%-8llu p50=%7.3f p95=%7.3f p99=%7.3f max=%7.3f ms\n", event_names[event_id], (unsigned long long)percentiles.count_,
+               percentiles.p50_ms_, percentiles.p95_ms_, percentiles.p99_ms_, percentiles.max_ms_);
+    }
+
+    printf("  latch waited=%u polled=%u missed=%u error=%u, repeated=%.1f/s, loss=%.2f%%, fps=%.1f, dropped records=%llu\n",
+           summary.latch_results_[LatchResult_Waited], summary.latch_results_[LatchResult_Polled],
+           summary.latch_results_[LatchResult_Missed], summary.latch_results_[LatchResult_Error],
+           summary.repeated_frames_per_second_, summary.packet_loss_percent_, summary.last_stats_.framesPerSecond,
+           (unsigned long long)summary.dropped_record_count_);
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    OKHostOptions options;
+    OKFakeCloudXRScript cxr_script;
+    OKFakeOpenXRScript xr_script;
+
+    if (!parse_options(argc, argv, options, cxr_script, xr_script))
+    {
+        print_usage();
+        return 1;
+    }
+
+    set_fake_cloudxr_script(cxr_script);
+
+    OKFakeOpenXR fake_openxr(xr_script);
+    OKCloudClient ok_client;
+    ok_client.ok_config_.app_directory_ = options.config_directory_;
+
+    OKHostGLContext gl_context;
+
+    if ((options.eye_size_ > 0) && !gl_context.create(options.eye_size_))
+    {
+        printf("no GLES 3 context, running without one (eye_size=0)\n");
+        gl_context.destroy();
+    }
+
+    // Only checked for null by the fake receiver
+    const EGLDisplay egl_display = (gl_context.display_ != EGL_NO_DISPLAY) ? gl_context.display_ : reinterpret_cast<EGLDisplay>(1);
+    const EGLContext egl_context = (gl_context.context_ != EGL_NO_CONTEXT) ? gl_context.context_ : reinterpret_cast<EGLContext>(1);
+
+    if (!ok_client.init_android_gles(&fake_openxr, egl_display, egl_context))
+    {
+        printf("init_android_gles failed\n");
+        return 1;
+    }
+
+    // Past the config load, the desc is derived again with them
+    if ((options.desired_refresh_rate_ >= 0) || (options.max_stream_fps_ >= 0))
+    {
+        if (options.desired_refresh_rate_ >= 0)
+        {
+            ok_client.ok_config_.desired_refresh_rate_ = (uint32_t)options.desired_refresh_rate_;
+        }
+
+        if (options.max_stream_fps_ >= 0)
+        {
+            ok_client.ok_config_.max_stream_fps_ = (uint32_t)options.max_stream_fps_;
+        }
+
+        ok_client.prepare_receiver_desc();
+    }
+
+    // The config file may not exist on the host, the address only has to be non-empty
+    if (ok_client.ok_config_.server_ip_address_.empty())
+    {
+        ok_client.ok_config_.server_ip_address_ = DEFAULT_SERVER_IP_ADDRESS;
+    }
+
+    std::vector<std::unique_ptr<OKFakeProbeServer>> probe_servers;
+
+    if (!options.servers_.empty())
+    {
+        ok_client.ok_config_.server_ip_addresses_.clear();
+
+        for (OKFakeProbeServerScript& server : options.servers_)
+        {
+            server.probe_port_ = (uint16_t)ok_client.ok_config_.server_probe_port_;
+            ok_client.ok_config_.server_ip_addresses_.push_back(server.address_);
+
+            if (!server.has_responder_ && !server.has_listener_)
+            {
+                continue;
+            }
+
+            probe_servers.emplace_back(new OKFakeProbeServer());
+
+            if (!probe_servers.back()->start(server))
+            {
+                printf("can't bind a stand-in server to %s\n", server.address_.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if (options.server_cache_ttl_s_ >= 0)
+    {
+        ok_client.ok_config_.server_cache_ttl_s_ = (uint32_t)options.server_cache_ttl_s_;
+    }
+
+    const uint64_t connect_start_time_ns = get_monotonic_time_ns();
+
+    if (!ok_client.connect())
+    {
+        printf("connect failed\n");
+        return 1;
+    }
+
+    uint64_t frame_period_ns = (uint64_t)(1000000000.0 / fake_openxr.get_current_refresh_rate());
+    const uint64_t run_time_ns = (uint64_t)(options.seconds_ * 1000000000.0f);
+
+    uint64_t first_frame_time_ns = 0;
+    uint64_t frame_count = 0;
+    uint64_t new_frame_count = 0;
+    uint64_t repeated_frame_count = 0;
+    uint64_t empty_frame_count = 0;
+    uint64_t late_frame_count = 0;
+
+    uint64_t frame_start_time_ns = get_monotonic_time_ns();
+    const uint64_t run_start_time_ns = frame_start_time_ns;
+    uint64_t last_print_time_ns = frame_start_time_ns;
+
+    const uint64_t refresh_change_time_ns = (options.refresh_change_s_ > 0.0f) ? (run_start_time_ns + (uint64_t)(options.refresh_change_s_ * 1000000000.0f)) : UINT64_MAX;
+    bool has_refresh_changed = false;
+
+    while (options.frames_ ? (frame_count < options.frames_) : ((frame_start_time_ns - run_start_time_ns) < run_time_ns))
+    {
+        if (!has_refresh_changed && (frame_start_time_ns >= refresh_change_time_ns))
+        {
+            has_refresh_changed = true;
+
+            if (!fake_openxr.set_refresh_rate(options.refresh_change_rate_))
+            {
+                printf("%.1f Hz isn't supported, staying at %.1f Hz\n", options.refresh_change_rate_, fake_openxr.get_current_refresh_rate());
+            }
+        }
+
+        // Re-read every frame, the rate can change under the app
+        frame_period_ns = (uint64_t)(1000000000.0 / fake_openxr.get_current_refresh_rate());
+
+        // xrWaitFrame: this frame is displayed one period from its start
+        fake_openxr.begin_frame((XrTime)(frame_start_time_ns + frame_period_ns));
+        ok_client.pre_render_update();
+
+        if (ok_client.is_connected())
+        {
+            ok_client.latch_frame();
+
+            bool is_new_frame = true;
+            bool is_repeated_frame = true;
+
+            for (int view_id = LEFT_EYE; view_id < NUM_EYES; view_id++)
+            {
+                GLMPose eye_pose;
+                gl_context.bind_eye(view_id);
+
+                if (ok_client.blit_frame(view_id, eye_pose))
+                {
+                    is_repeated_frame = false;
+                    continue;
+                }
+
+                is_new_frame = false;
+
+#if ENABLE_LAST_FRAME_RETENTION
+                if (ok_client.present_last_frame(view_id, eye_pose))
+                {
+                    continue;
+                }
+#endif
+
+                is_repeated_frame = false;
+            }
+
+            ok_client.release_frame();
+            gl_context.finish();
+
+            if (is_new_frame)
+            {
+                new_frame_count++;
+
+                if (first_frame_time_ns == 0)
+                {
+                    first_frame_time_ns = get_monotonic_time_ns();
+                }
+            }
+            else if (is_repeated_frame)
+            {
+                repeated_frame_count++;
+            }
+            else
+            {
+                empty_frame_count++;
+            }
+        }
+        else
+        {
+            empty_frame_count++;
+        }
+
+        frame_count++;
+
+        const uint64_t frame_end_time_ns = get_monotonic_time_ns();
+
+        if (frame_end_time_ns > (frame_start_time_ns + frame_period_ns))
+        {
+            late_frame_count++;
+        }
+
+#if ENABLE_TELEMETRY
+        if (options.print_per_second_ && ((frame_end_time_ns - last_print_time_ns) >= 1000000000ULL))
+        {
+            last_print_time_ns = frame_end_time_ns;
+            print_telemetry_summary(ok_client.telemetry_.get_summary());
+        }
+#endif
+
+        // Next vsync, or right away when this frame already overran it
+        frame_start_time_ns += frame_period_ns;
+
+        if (frame_start_time_ns > frame_end_time_ns)
+        {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(frame_start_time_ns)));
+        }
+        else
+        {
+            frame_start_time_ns = frame_end_time_ns;
+        }
+    }
+
+    const OKFakeCloudXRCounters counters = get_fake_cloudxr_counters(ok_client.get_receiver());
+
+    printf("frames: %llu total, %llu new, %llu repeated, %llu empty, %llu over budget\n",
+           (unsigned long long)frame_count, (unsigned long long)new_frame_count, (unsigned long long)repeated_frame_count,
+           (unsigned long long)empty_frame_count, (unsigned long long)late_frame_count);
+
+#if ENABLE_LAST_FRAME_RETENTION
+    printf("frame cache: %llu eye copies for %llu new frames\n", (unsigned long long)ok_client.frame_cache_.get_capture_count(),
+           (unsigned long long)new_frame_count);
+#endif
+
+    if (first_frame_time_ns > 0)
+    {
+        printf("connect to first frame: %.3f ms\n", convert_ns_to_ms(first_frame_time_ns - connect_start_time_ns));
+    }
+
+    const OKConnectionStats& connection_stats = ok_client.get_connection_stats();
+
+    printf("connection: %u cxrConnect calls, %u attempts, %u failed, %u sessions lost, last connect %.1f ms, last time to first frame %.1f ms, last retry delay %.1f ms\n",
+           get_fake_cloudxr_connect_count(), connection_stats.attempt_count_, connection_stats.failure_count_, connection_stats.disconnect_count_,
+           connection_stats.last_connect_ms_, connection_stats.last_time_to_first_frame_ms_, connection_stats.last_retry_delay_ms_);
+
+    const OKStartupTrace& startup_trace = ok_client.get_startup_trace();
+
+    printf("startup:");
+
+    for (int phase_id = 0; phase_id < STARTUP_PHASE_COUNT; phase_id++)
+    {
+        const OKStartupPhase phase = (OKStartupPhase)phase_id;
+
+        if (startup_trace.has_phase(phase))
+        {
+            printf(" %s %.1f-%.1f", OKStartupTrace::get_phase_name(phase), startup_trace.get_start_ms(phase), startup_trace.get_end_ms(phase));
+        }
+    }
+
+    printf(" ms\n");
+
+    printf("refresh: display %.1f Hz, stream %.1f fps, server pacing %.1f fps, %llu HasRefresh\n", fake_openxr.get_current_refresh_rate(),
+           ok_client.stream_fps_.load(), counters.frame_rate_, (unsigned long long)counters.refresh_changes_);
+
+    if (!probe_servers.empty())
+    {
+        const OKServerSelector& server_selector = ok_client.get_server_selector();
+
+        printf("server: %s, %s, probe %.1f ms\n", server_selector.get_server().c_str(),
+               server_selector.is_cache_hit() ? "from the cache" : "probed", server_selector.get_probe_ms());
+
+        for (const OKServerProbeResult& result : server_selector.get_ranking())
+        {
+            printf("  %-16s %s rtt=%6.2f ms load=%3d%% score=%6.2f ms%s\n", result.address_.c_str(),
+                   result.is_reachable_ ? "up  " : "down", result.rtt_ms_, (result.load_percent_ <= 100) ? (int)result.load_percent_ : -1,
+                   result.get_score_ms(), result.has_responder_ ? "" : " (TCP connect)");
+        }
+    }
+
+    printf("fake receiver: %llu polls, %llu produced, %llu dropped, %llu skipped, %llu latched, %llu latch timeouts, %llu blits, %llu controller events in %llu batches\n",
+           (unsigned long long)counters.tracking_polls_, (unsigned long long)counters.frames_produced_,
+           (unsigned long long)counters.frames_dropped_, (unsigned long long)counters.frames_skipped_,
+           (unsigned long long)counters.frames_latched_, (unsigned long long)counters.latch_timeouts_,
+           (unsigned long long)counters.frames_blitted_, (unsigned long long)counters.controller_events_,
+           (unsigned long long)counters.controller_event_batches_);
+
+    if (counters.input_events_ > 0)
+    {
+        printf("input events: %llu, %llu bytes, %.1f bytes each\n", (unsigned long long)counters.input_events_,
+               (unsigned long long)counters.input_event_bytes_, (double)counters.input_event_bytes_ / (double)counters.input_events_);
+    }
+
+#if ENABLE_HAPTICS
+    if (counters.haptic_pulses_ > 0)
+    {
+        const OKHapticsScheduler& haptics_scheduler = ok_client.haptics_scheduler_;
+
+        printf("haptics: %llu pulses, %llu dropped, %llu merged, %llu xrApplyHapticFeedback, %llu xrStopHapticFeedback\n",
+               (unsigned long long)haptics_scheduler.get_pulse_count(), (unsigned long long)haptics_scheduler.get_dropped_count(),
+               (unsigned long long)haptics_scheduler.get_merged_count(), (unsigned long long)fake_openxr.get_haptic_apply_count(),
+               (unsigned long long)fake_openxr.get_haptic_stop_count());
+    }
+#endif
+
+    printf("client:\n");
+    print_histogram("tracking callback", ok_client.tracking_callback_histogram_);
+
+#if USE_CLOUDXR_POSE_ID
+    print_histogram("pose to photon", ok_client.pose_to_photon_histogram_);
+#endif
+
+#if ENABLE_TELEMETRY
+    printf("last telemetry window:\n");
+    print_telemetry_summary(ok_client.telemetry_.get_summary());
+#endif
+
+    if (!options.record_body_trace_path_.empty())
+    {
+        const float refresh_rate = fake_openxr.get_current_refresh_rate();
+        const float trace_seconds = options.frames_ ? ((float)options.frames_ / refresh_rate) : options.seconds_;
+
+        if (!fake_openxr.save_body_trace(options.record_body_trace_path_, trace_seconds, refresh_rate))
+        {
+            printf("failed to write %s\n", options.record_body_trace_path_.c_str());
+        }
+    }
+
+    ok_client.destroy_receiver();
+    ok_client.shutdown_cxr();
+    gl_context.destroy();
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// OKPosePredictor offline. Replays a recorded HMD pose trace through evaluate_trace at a set of
+// prediction horizons, and the same trace through a disabled predictor, which is what the
+// server gets without client prediction. Prints the error of both against the trace itself.
+//
+// The trace is a CSV, one sample per line: time_ms,px,py,pz,qx,qy,qz,qw[,vx,vy,vz,wx,wy,wz],
+// positions in m, velocities in m/s and rad/s in base space as XrSpaceVelocity reports them.
+// Without the velocity columns they are estimated from the previous sample. Without a trace,
+// a synthetic head motion is generated (and written out with record=).
+//
+// Usage: ok_pose_replay [key=value ...], see print_usage for the keys.
+
+#include "OKPosePredictor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKPoseReplayOptions
+{
+    std::string trace_path_;            // replay this, else synthesize
+    std::string record_path_;           // write the synthetic trace as CSV
+    std::vector<float> horizons_ms_ = {10.0f, 20.0f, 35.0f, 50.0f};
+    float damping_ = DEFAULT_CLIENT_PREDICTION_DAMPING;
+    float max_prediction_ms_ = 200.0f;  // out of the way of the horizons by default
+    float seconds_ = 60.0f;             // synthetic trace length
+    float hz_ = 500.0f;                 // synthetic sample rate, the pose sampler's
+    float velocity_noise_ = 0.05f;      // synthetic runtime velocity error, fraction of the speed
+    uint32_t random_seed_ = 1;
+};
+
+void print_usage()
+{
+    printf("ok_pose_replay [key=value ...]\n"
+           "  trace=              replay this pose CSV instead of a synthetic head motion\n"
+           "  record=             write the synthetic trace as CSV, replayable with trace=\n"
+           "  horizons=10,20,35,50  prediction horizons, ms\n"
+           "  damping=0           predictor velocity damping, 1/s\n"
+           "  max_ms=200          predictor max_prediction_ms\n"
+           "  seconds=60          synthetic trace length\n"
+           "  hz=500              synthetic sample rate\n"
+           "  noise=0.05          synthetic velocity error, fraction of the speed\n"
+           "  seed=1\n");
+}
+
+bool parse_horizons(const char* value, std::vector<float>& horizons_ms)
+{
+    horizons_ms.clear();
+
+    while (*value)
+    {
+        char* end = nullptr;
+        const float horizon_ms = strtof(value, &end);
+
+        if ((end == value) || (horizon_ms <= 0.0f))
+        {
+            return false;
+        }
+
+        horizons_ms.push_back(horizon_ms);
+        value = (*end == ',') ? (end + 1) : end;
+    }
+
+    return !horizons_ms.empty();
+}
+
+bool parse_options(int argc, char** argv, OKPoseReplayOptions& options)
+{
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        const char* arg = argv[arg_id];
+        const char* separator = strchr(arg, '=');
+
+        if (!separator)
+        {
+            return false;
+        }
+
+        const std::string key(arg, separator - arg);
+        const char* value = separator + 1;
+
+        const float float_value = (float)atof(value);
+        const uint32_t uint_value = (uint32_t)strtoul(value, nullptr, 0);
+
+        if (key == "trace") options.trace_path_ = value;
+        else if (key == "record") options.record_path_ = value;
+        else if (key == "horizons") { if (!parse_horizons(value, options.horizons_ms_)) return false; }
+        else if (key == "damping") options.damping_ = float_value;
+        else if (key == "max_ms") options.max_prediction_ms_ = float_value;
+        else if (key == "seconds") options.seconds_ = float_value;
+        else if (key == "hz") options.hz_ = float_value;
+        else if (key == "noise") options.velocity_noise_ = float_value;
+        else if (key == "seed") options.random_seed_ = uint_value;
+        else return false;
+    }
+
+    return (options.seconds_ > 0.0f) && (options.hz_ > 0.0f) && (options.max_prediction_ms_ > 0.0f);
+}
+
+// World-space angular velocity taking from_rotation to to_rotation in dt_s, the inverse of integrate_angular_velocity
+glm::vec3 get_angular_velocity(const glm::fquat& from_rotation, const glm::fquat& to_rotation, const float dt_s)
+{
+    glm::fquat delta_rotation = to_rotation * glm::inverse(from_rotation);
+
+    if (delta_rotation.w < 0.0f)
+    {
+        delta_rotation = -delta_rotation;
+    }
+
+    const float sin_half_angle = sqrtf(delta_rotation.x * delta_rotation.x + delta_rotation.y * delta_rotation.y + delta_rotation.z * delta_rotation.z);
+
+    if ((sin_half_angle < 1e-9f) || (dt_s <= 0.0f))
+    {
+        return glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+
+    const float angle = 2.0f * atan2f(sin_half_angle, delta_rotation.w);
+    const glm::vec3 axis = glm::vec3(delta_rotation.x, delta_rotation.y, delta_rotation.z) / sin_half_angle;
+
+    return axis * (angle / dt_s);
+}
+
+bool load_csv_trace(const std::string& path, std::vector<OKPoseState>& trace)
+{
+    FILE* file = fopen(path.c_str(), "r");
+
+    if (!file)
+    {
+        printf("can't open %s\n", path.c_str());
+        return false;
+    }
+
+    char line[512];
+    bool is_sorted = true;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        double time_ms = 0.0;
+        glm::vec3 position;
+        glm::fquat rotation;
+        glm::vec3 linear_velocity;
+        glm::vec3 angular_velocity;
+
+        const int field_count = sscanf(line, "%lf,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &time_ms, &position.x, &position.y, &position.z,
+                                       &rotation.x, &rotation.y, &rotation.z, &rotation.w, &linear_velocity.x, &linear_velocity.y,
+                                       &linear_velocity.z, &angular_velocity.x, &angular_velocity.y, &angular_velocity.z);
+
+        // The header, or a line cut short
+        if ((field_count != 8) && (field_count != 14))
+        {
+            continue;
+        }
+
+        OKPoseState pose_state;
+        pose_state.timestamp_ns_ = (uint64_t)(time_ms * 1000000.0);
+        pose_state.pose_.translation_ = position;
+        pose_state.pose_.rotation_ = glm::normalize(rotation);
+        pose_state.pose_.is_valid_ = true;
+
+        if (!trace.empty() && (pose_state.timestamp_ns_ <= trace.back().timestamp_ns_))
+        {
+            is_sorted = false;
+            break;
+        }
+
+        if (field_count == 14)
+        {
+            pose_state.linear_velocity_ = linear_velocity;
+            pose_state.angular_velocity_ = angular_velocity;
+        }
+        else if (!trace.empty())
+        {
+            const OKPoseState& previous_state = trace.back();
+            const float dt_s = (float)(pose_state.timestamp_ns_ - previous_state.timestamp_ns_) * NS_TO_SEC;
+
+            pose_state.linear_velocity_ = (position - previous_state.pose_.translation_) / dt_s;
+            pose_state.angular_velocity_ = get_angular_velocity(previous_state.pose_.rotation_, pose_state.pose_.rotation_, dt_s);
+        }
+
+        pose_state.has_linear_velocity_ = (field_count == 14) || !trace.empty();
+        pose_state.has_angular_velocity_ = pose_state.has_linear_velocity_;
+
+        trace.push_back(pose_state);
+    }
+
+    fclose(file);
+
+    if (!is_sorted)
+    {
+        printf("%s: timestamps must increase\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Seated head motion: slow look-arounds with a faster component on top, a little sway
+GLMPose get_synthetic_head_pose(const double time_s)
+{
+    const double two_pi = 2.0 * M_PI;
+
+    const float yaw = (float)(0.6 * sin(two_pi * 0.25 * time_s) + 0.25 * sin(two_pi * 0.9 * time_s + 1.0));
+    const float pitch = (float)(0.2 * sin(two_pi * 0.4 * time_s + 0.5) + 0.05 * sin(two_pi * 1.7 * time_s));
+
+    GLMPose pose;
+    pose.translation_ = glm::vec3((float)(0.05 * sin(two_pi * 0.3 * time_s)), (float)(1.6 + 0.02 * sin(two_pi * 0.7 * time_s)),
+                                  (float)(0.04 * sin(two_pi * 0.2 * time_s + 2.0)));
+    pose.rotation_ = glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::angleAxis(pitch, glm::vec3(1.0f, 0.0f, 0.0f));
+    pose.is_valid_ = true;
+
+    return pose;
+}
+
+void synthesize_trace(const OKPoseReplayOptions& options, std::vector<OKPoseState>& trace)
+{
+    std::mt19937 rng(options.random_seed_);
+    std::normal_distribution<float> noise_dist(0.0f, options.velocity_noise_);
+
+    const uint32_t sample_count = (uint32_t)(options.seconds_ * options.hz_);
+    const double period_s = 1.0 / options.hz_;
+    const double derivative_step_s = 0.0005;
+
+    for (uint32_t sample_id = 0; sample_id < sample_count; sample_id++)
+    {
+        const double time_s = (double)sample_id * period_s;
+
+        const GLMPose before_pose = get_synthetic_head_pose(time_s - derivative_step_s);
+        const GLMPose after_pose = get_synthetic_head_pose(time_s + derivative_step_s);
+
+        OKPoseState pose_state;
+        pose_state.timestamp_ns_ = (uint64_t)(time_s * 1000000000.0);
+        pose_state.pose_ = get_synthetic_head_pose(time_s);
+
+        // What the runtime would report, the true velocity give or take its error
+        pose_state.linear_velocity_ = (after_pose.translation_ - before_pose.translation_) / (float)(2.0 * derivative_step_s) * (1.0f + noise_dist(rng));
+        pose_state.angular_velocity_ = get_angular_velocity(before_pose.rotation_, after_pose.rotation_, (float)(2.0 * derivative_step_s)) * (1.0f + noise_dist(rng));
+        pose_state.has_linear_velocity_ = true;
+        pose_state.has_angular_velocity_ = true;
+
+        trace.push_back(pose_state);
+    }
+}
+
+bool write_csv_trace(const std::string& path, const std::vector<OKPoseState>& trace)
+{
+    FILE* file = fopen(path.c_str(), "w");
+
+    if (!file)
+    {
+        printf("can't write %s\n", path.c_str());
+        return false;
+    }
+
+    fprintf(file, "time_ms,px,py,pz,qx,qy,qz,qw,vx,vy,vz,wx,wy,wz\n");
+
+    for (const OKPoseState& pose_state : trace)
+    {
+        const glm::vec3& position = pose_state.pose_.translation_;
+        const glm::fquat& rotation = pose_state.pose_.rotation_;
+        const glm::vec3& linear_velocity = pose_state.linear_velocity_;
+        const glm::vec3& angular_velocity = pose_state.angular_velocity_;
+
+        fprintf(file, "%.3f,%.6f,%.6f,%.6f,%.7f,%.7f,%.7f,%.7f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f\n", (double)pose_state.timestamp_ns_ / 1000000.0,
+                position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w, linear_velocity.x, linear_velocity.y,
+                linear_velocity.z, angular_velocity.x, angular_velocity.y, angular_velocity.z);
+    }
+
+    fclose(file);
+    return true;
+}
+
+float get_reduction_percent(const float baseline_error, const float predicted_error)
+{
+    return (baseline_error > 0.0f) ? (100.0f * (1.0f - predicted_error / baseline_error)) : 0.0f;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    OKPoseReplayOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<OKPoseState> trace;
+
+    if (!options.trace_path_.empty())
+    {
+        if (!load_csv_trace(options.trace_path_, trace))
+        {
+            return 1;
+        }
+
+        printf("replaying %zu poses from %s\n", trace.size(), options.trace_path_.c_str());
+    }
+    else
+    {
+        synthesize_trace(options, trace);
+        printf("synthetic head motion: %zu poses at %.0f Hz, velocity noise %.0f%%\n", trace.size(), options.hz_, options.velocity_noise_ * 100.0f);
+
+        if (!options.record_path_.empty() && !write_csv_trace(options.record_path_, trace))
+        {
+            return 1;
+        }
+    }
+
+    if (trace.size() < 2)
+    {
+        printf("not enough poses\n");
+        return 1;
+    }
+
+    OKPosePredictor baseline_predictor;
+    baseline_predictor.configure(false, 0.0f, 0.0f);
+
+    OKPosePredictor pose_predictor;
+    pose_predictor.configure(true, options.damping_, options.max_prediction_ms_);
+
+    printf("damping %.2f/s, max %.0f ms\n", options.damping_, options.max_prediction_ms_);
+    printf("horizon   samples | no prediction: mean / max mm  mean / max deg | predicted: mean / max mm  mean / max deg | reduction mm  deg\n");
+
+    for (const float horizon_ms : options.horizons_ms_)
+    {
+        const uint64_t horizon_ns = (uint64_t)(horizon_ms * 1000000.0f);
+
+        const OKPredictionError baseline_error = baseline_predictor.evaluate_trace(trace.data(), trace.size(), horizon_ns);
+        const OKPredictionError predicted_error = pose_predictor.evaluate_trace(trace.data(), trace.size(), horizon_ns);
+
+        printf("%5.1f ms  %7u | %13.2f / %6.2f  %7.3f / %6.3f  | %9.2f / %6.2f  %7.3f / %6.3f  | %9.1f%% %5.1f%%\n", horizon_ms,
+               predicted_error.sample_count_, baseline_error.mean_position_error_m_ * 1000.0f, baseline_error.max_position_error_m_ * 1000.0f,
+               baseline_error.mean_rotation_error_deg_, baseline_error.max_rotation_error_deg_, predicted_error.mean_position_error_m_ * 1000.0f,
+               predicted_error.max_position_error_m_ * 1000.0f, predicted_error.mean_rotation_error_deg_, predicted_error.max_rotation_error_deg_,
+               get_reduction_percent(baseline_error.mean_position_error_m_, predicted_error.mean_position_error_m_),
+               get_reduction_percent(baseline_error.mean_rotation_error_deg_, predicted_error.mean_rotation_error_deg_));
+    }
+
+    return 0;
+}
@@ -0,0 +1,486 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// OKQosController offline. With trace=, replays recorded cxrConnectionStats through it, either
+// the telemetry trace (ok_telemetry.bin, enable_telemetry_trace) or a CSV with the columns
+// record= writes, and prints every decision it would have taken. The stream can't react to a
+// recording, so each reconnect it asks for is assumed to happen at once.
+//
+// Without a trace, closes the loop on a simulated link instead: a stream whose bitrate follows
+// the applied decision (resolution, foveation, cap) over a link that loses bandwidth partway
+// through and gets it back, with delivery time, loss and CloudXR's quality derived from how
+// full the link is. Shows how fast the controller backs off, whether it settles, and when it
+// steps back up.
+//
+// Usage: ok_qos_replay [key=value ...], see print_usage for the keys.
+
+#include "OKQosController.h"
+#include "OKTelemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKQosReplayOptions
+{
+    std::string trace_path_;            // replay this, else simulate
+    std::string record_path_;           // write the simulated stats as CSV
+    float seconds_ = 300.0f;
+    uint32_t interval_ms_ = DEFAULT_TELEMETRY_STATS_INTERVAL_MS;
+    float bandwidth_kbps_ = 150000.0f;  // link capacity
+    float drop_kbps_ = 40000.0f;        // capacity while degraded
+    float drop_start_s_ = 60.0f;
+    float drop_end_s_ = 180.0f;
+    float demand_kbps_ = 90000.0f;      // what the encoder wants at level 0
+    float base_delivery_ms_ = 30.0f;    // delivery time on an idle link
+    bool enable_reconnect_ = ENABLE_QOS_RECONNECT;
+    OKQosSettings settings_;
+    uint32_t random_seed_ = 1;
+};
+
+struct OKStatsSample
+{
+    uint64_t time_ns_ = 0;
+    cxrConnectionStats stats_ = {};
+};
+
+const char* condition_names[] = {"unknown", "congested", "steady", "headroom"};
+
+void print_usage()
+{
+    printf("ok_qos_replay [key=value ...]\n"
+           "  trace=             replay ok_telemetry.bin or a stats CSV instead of simulating\n"
+           "  record=            write the simulated stats as CSV, replayable with trace=\n"
+           "  target_ms=40       frame delivery time to hold\n"
+           "  max_bitrate=0      config cap, kbps, 0 = unlimited\n"
+           "  max_res=1.0        config max_res_factor\n"
+           "  foveation=0        config foveation, 0 = off\n"
+           "  reconnect=0        reconnect to apply a new level\n"
+           "  seconds=300        simulated run time\n"
+           "  interval_ms=1000   between stats samples\n"
+           "  bandwidth=150000   link capacity, kbps\n"
+           "  drop=40000         capacity while degraded, kbps\n"
+           "  drop_start=60      seconds\n"
+           "  drop_end=180       seconds\n"
+           "  demand=90000       stream bitrate at level 0, kbps\n"
+           "  delivery_ms=30     delivery time on an idle link\n"
+           "  seed=1\n");
+}
+
+bool parse_options(int argc, char** argv, OKQosReplayOptions& options)
+{
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        const char* arg = argv[arg_id];
+        const char* separator = strchr(arg, '=');
+
+        if (!separator)
+        {
+            return false;
+        }
+
+        const std::string key(arg, separator - arg);
+        const char* value = separator + 1;
+
+        const float float_value = (float)atof(value);
+        const uint32_t uint_value = (uint32_t)strtoul(value, nullptr, 0);
+
+        if (key == "trace") options.trace_path_ = value;
+        else if (key == "record") options.record_path_ = value;
+        else if (key == "target_ms") options.settings_.target_delivery_ms_ = float_value;
+        else if (key == "max_bitrate") options.settings_.max_bitrate_kbps_ = uint_value;
+        else if (key == "max_res") options.settings_.max_res_factor_ = float_value;
+        else if (key == "foveation") options.settings_.foveation_ = uint_value;
+        else if (key == "reconnect") options.enable_reconnect_ = (uint_value != 0);
+        else if (key == "seconds") options.seconds_ = float_value;
+        else if (key == "interval_ms") options.interval_ms_ = uint_value;
+        else if (key == "bandwidth") options.bandwidth_kbps_ = float_value;
+        else if (key == "drop") options.drop_kbps_ = float_value;
+        else if (key == "drop_start") options.drop_start_s_ = float_value;
+        else if (key == "drop_end") options.drop_end_s_ = float_value;
+        else if (key == "demand") options.demand_kbps_ = float_value;
+        else if (key == "delivery_ms") options.base_delivery_ms_ = float_value;
+        else if (key == "seed") options.random_seed_ = uint_value;
+        else return false;
+    }
+
+    options.settings_.enable_reconnect_ = options.enable_reconnect_;
+
+    return (options.seconds_ > 0.0f) && (options.interval_ms_ > 0) && (options.bandwidth_kbps_ > 0.0f) &&
+           (options.drop_kbps_ > 0.0f) && (options.settings_.target_delivery_ms_ > 0.0f);
+}
+
+bool load_telemetry_trace(FILE* file, std::vector<OKStatsSample>& samples)
+{
+    OKTelemetryTraceHeader header;
+
+    if ((fread(&header, sizeof(header), 1, file) != 1) || (header.magic_ != TELEMETRY_TRACE_MAGIC) || (header.version_ != TELEMETRY_TRACE_VERSION))
+    {
+        return false;
+    }
+
+    uint8_t type = 0;
+
+    while (fread(&type, 1, 1, file) == 1)
+    {
+        // The next session's header, its samples stay on the first session's timeline
+        if (type == (TELEMETRY_TRACE_MAGIC & 0xFF))
+        {
+            OKTelemetryTraceHeader session_header;
+
+            if ((fread((uint8_t*)&session_header + 1, sizeof(session_header) - 1, 1, file) != 1) ||
+                (session_header.magic_ != TELEMETRY_TRACE_MAGIC) || (session_header.version_ != TELEMETRY_TRACE_VERSION))
+            {
+                break;
+            }
+        }
+        else if (type == TelemetryEvent_ConnectionStats)
+        {
+            OKTelemetryTraceStatsEvent stats_event;
+
+            if (fread((uint8_t*)&stats_event + 1, sizeof(stats_event) - 1, 1, file) != 1)
+            {
+                break;
+            }
+
+            OKStatsSample sample;
+            sample.time_ns_ = stats_event.timestamp_ns_ - header.start_time_ns_;
+            sample.stats_ = stats_event.stats_;
+            samples.push_back(sample);
+        }
+        else if (fseek(file, sizeof(OKTelemetryTraceFrameEvent) - 1, SEEK_CUR) != 0)
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+const char* csv_header = "time_ms,fps,delivery_ms,bandwidth_available_kbps,bandwidth_utilization_kbps,bandwidth_utilization_percent,"
+                         "round_trip_ms,jitter_us,packets_received,packets_lost,quality,quality_reasons";
+
+bool load_csv_trace(FILE* file, std::vector<OKStatsSample>& samples)
+{
+    char line[512];
+
+    while (fgets(line, sizeof(line), file))
+    {
+        double time_ms = 0.0;
+        cxrConnectionStats stats = {};
+        uint32_t quality = 0;
+
+        const int field_count = sscanf(line, "%lf,%f,%f,%u,%u,%u,%u,%u,%u,%u,%u,%u", &time_ms, &stats.framesPerSecond, &stats.frameDeliveryTimeMs,
+                                       &stats.bandwidthAvailableKbps, &stats.bandwidthUtilizationKbps, &stats.bandwidthUtilizationPercent,
+                                       &stats.roundTripDelayMs, &stats.jitterUs, &stats.totalPacketsReceived, &stats.totalPacketsLost,
+                                       &quality, &stats.qualityReasons);
+
+        // The header, or a line cut short
+        if (field_count != 12)
+        {
+            continue;
+        }
+
+        stats.quality = (cxrConnectionQuality)quality;
+
+        OKStatsSample sample;
+        sample.time_ns_ = (uint64_t)(time_ms * 1000000.0);
+        sample.stats_ = stats;
+        samples.push_back(sample);
+    }
+
+    return !samples.empty();
+}
+
+void write_csv_sample(FILE* file, const OKStatsSample& sample)
+{
+    const cxrConnectionStats& stats = sample.stats_;
+
+    fprintf(file, "%.1f,%.2f,%.2f,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", (double)sample.time_ns_ / 1000000.0, stats.framesPerSecond,
+            stats.frameDeliveryTimeMs, stats.bandwidthAvailableKbps, stats.bandwidthUtilizationKbps, stats.bandwidthUtilizationPercent,
+            stats.roundTripDelayMs, stats.jitterUs, stats.totalPacketsReceived, stats.totalPacketsLost, (uint32_t)stats.quality, stats.qualityReasons);
+}
+
+void print_decision(const char* event, const uint64_t time_ns, const OKQosController& controller, const cxrConnectionStats& stats)
+{
+    const OKQosDecision& decision = controller.get_decision();
+
+    printf("  %8.1f s  %-9s level %u  res %.2f  foveation %3u  bitrate cap %6u kbps   (delivery %5.1f ms, link %3u%%, loss %.2f%%)\n",
+           (double)time_ns / 1000000000.0, event, decision.level_, decision.max_res_factor_, decision.foveation_, decision.max_bitrate_kbps_,
+           controller.get_smoothed_delivery_ms(), stats.bandwidthUtilizationPercent, controller.get_packet_loss_percent());
+}
+
+struct OKReplaySummary
+{
+    std::vector<float> delivery_ms_;
+    uint32_t condition_counts_[4] = {};
+    uint32_t over_target_count_ = 0;
+    uint32_t reconnect_count_ = 0;
+
+    void add(const OKQosController& controller, const cxrConnectionStats& stats, const float target_ms)
+    {
+        delivery_ms_.push_back(stats.frameDeliveryTimeMs);
+        condition_counts_[controller.get_condition()]++;
+        over_target_count_ += (stats.frameDeliveryTimeMs > target_ms) ? 1 : 0;
+    }
+
+    void print(const OKQosController& controller)
+    {
+        if (delivery_ms_.empty())
+        {
+            return;
+        }
+
+        std::sort(delivery_ms_.begin(), delivery_ms_.end());
+
+        double total_ms = 0.0;
+
+        for (const float delivery_ms : delivery_ms_)
+        {
+            total_ms += delivery_ms;
+        }
+
+        const size_t sample_count = delivery_ms_.size();
+
+        printf("samples: %zu, delivery mean=%.1f p50=%.1f p95=%.1f max=%.1f ms, over target %.1f%%\n", sample_count,
+               total_ms / (double)sample_count, delivery_ms_[sample_count / 2], delivery_ms_[(sample_count * 95) / 100],
+               delivery_ms_.back(), 100.0 * (double)over_target_count_ / (double)sample_count);
+
+        printf("conditions:");
+
+        for (int condition_id = 0; condition_id < 4; condition_id++)
+        {
+            printf(" %s %.1f%%", condition_names[condition_id], 100.0 * (double)condition_counts_[condition_id] / (double)sample_count);
+        }
+
+        printf("\nlevel changes: %u, reconnects: %u, final level %u\n", controller.get_level_change_count(), reconnect_count_,
+               controller.get_decision().level_);
+    }
+};
+
+int replay(const OKQosReplayOptions& options)
+{
+    FILE* file = fopen(options.trace_path_.c_str(), "rb");
+
+    if (!file)
+    {
+        printf("can't open %s\n", options.trace_path_.c_str());
+        return 1;
+    }
+
+    std::vector<OKStatsSample> samples;
+    const bool is_binary = load_telemetry_trace(file, samples);
+
+    if (!is_binary)
+    {
+        rewind(file);
+        load_csv_trace(file, samples);
+    }
+
+    fclose(file);
+
+    if (samples.empty())
+    {
+        printf("no connection stats in %s\n", options.trace_path_.c_str());
+        return 1;
+    }
+
+    printf("replaying %zu samples from %s (%s)\n", samples.size(), options.trace_path_.c_str(), is_binary ? "telemetry trace" : "CSV");
+
+    OKQosController controller;
+    controller.configure(options.settings_);
+    controller.on_applied(samples[0].time_ns_);
+
+    OKReplaySummary summary;
+
+    for (const OKStatsSample& sample : samples)
+    {
+        if (controller.update(sample.stats_, sample.time_ns_))
+        {
+            print_decision("decide", sample.time_ns_, controller, sample.stats_);
+        }
+
+        if (controller.should_reconnect(sample.time_ns_))
+        {
+            controller.on_applied(sample.time_ns_);
+            summary.reconnect_count_++;
+            print_decision("reconnect", sample.time_ns_, controller, sample.stats_);
+        }
+
+        summary.add(controller, sample.stats_, options.settings_.target_delivery_ms_);
+    }
+
+    summary.print(controller);
+    return 0;
+}
+
+// The stream the applied decision would produce over the link at this point in time
+cxrConnectionStats simulate_stats(const OKQosReplayOptions& options, const OKQosDecision& applied_decision, const double time_s,
+                                  std::mt19937& rng, uint64_t& packets_received, uint64_t& packets_lost)
+{
+    std::uniform_real_distribution<float> noise_dist(-1.0f, 1.0f);
+
+    const bool is_degraded = (time_s >= options.drop_start_s_) && (time_s < options.drop_end_s_);
+    const float bandwidth_kbps = (is_degraded ? options.drop_kbps_ : options.bandwidth_kbps_) * (1.0f + 0.03f * noise_dist(rng));
+
+    // Fewer pixels, fewer bits: resolution by area, foveation roughly by its scale
+    const float res_scale = applied_decision.max_res_factor_ / std::max(options.settings_.max_res_factor_, MIN_CLOUDXR_RES_FACTOR);
+    const float foveation_scale = (applied_decision.foveation_ > 0) ? ((float)applied_decision.foveation_ / 100.0f) : 1.0f;
+
+    float demand_kbps = options.demand_kbps_ * res_scale * res_scale * foveation_scale;
+
+    if (applied_decision.max_bitrate_kbps_ > 0)
+    {
+        demand_kbps = std::min(demand_kbps, (float)applied_decision.max_bitrate_kbps_);
+    }
+
+    // Queueing builds up as the link fills, past full it's loss on top
+    const float load = demand_kbps / bandwidth_kbps;
+    float delivery_ms = options.base_delivery_ms_ + noise_dist(rng);
+
+    if (load > 0.85f)
+    {
+        delivery_ms += 60.0f * (std::min(load, 1.0f) - 0.85f) / 0.15f + 100.0f * std::max(load - 1.0f, 0.0f);
+    }
+
+    const float loss_percent = (load > 1.0f) ? (100.0f * (load - 1.0f) / load) : 0.02f;
+
+    const double interval_s = (double)options.interval_ms_ / 1000.0;
+    const uint64_t packet_count = (uint64_t)((double)demand_kbps * 1000.0 / 8.0 / 1200.0 * interval_s);
+    const uint64_t lost_count = (uint64_t)((double)packet_count * (double)loss_percent / 100.0);
+
+    packets_received += packet_count - lost_count;
+    packets_lost += lost_count;
+
+    cxrConnectionStats stats = {};
+    stats.framesPerSecond = DEFAULT_CLOUDXR_FRAMERATE;
+    stats.frameDeliveryTimeMs = delivery_ms;
+    stats.bandwidthAvailableKbps = (uint32_t)bandwidth_kbps;
+    stats.bandwidthUtilizationKbps = (uint32_t)std::min(demand_kbps, bandwidth_kbps);
+    stats.bandwidthUtilizationPercent = (uint32_t)(100.0f * load);
+    stats.roundTripDelayMs = 5;
+    stats.jitterUs = 500;
+    stats.totalPacketsReceived = (uint32_t)packets_received;
+    stats.totalPacketsLost = (uint32_t)packets_lost;
+
+    if (load < 0.6f)
+    {
+        stats.quality = cxrConnectionQuality_Excellent;
+    }
+    else if (load < 0.8f)
+    {
+        stats.quality = cxrConnectionQuality_Good;
+    }
+    else if (load < 0.95f)
+    {
+        stats.quality = cxrConnectionQuality_Fair;
+        stats.qualityReasons = cxrConnectionQualityReason_LowBandwidth;
+    }
+    else
+    {
+        stats.quality = cxrConnectionQuality_Poor;
+        stats.qualityReasons = cxrConnectionQualityReason_LowBandwidth | ((loss_percent > 1.0f) ? cxrConnectionQualityReason_HighPacketLoss : 0);
+    }
+
+    return stats;
+}
+
+int simulate(const OKQosReplayOptions& options)
+{
+    printf("simulating %.0f s: %.0f kbps link, %.0f kbps from %.0f to %.0f s, stream %.0f kbps at level 0, target %.0f ms\n",
+           options.seconds_, options.bandwidth_kbps_, options.drop_kbps_, options.drop_start_s_, options.drop_end_s_, options.demand_kbps_,
+           options.settings_.target_delivery_ms_);
+
+    FILE* record_file = nullptr;
+
+    if (!options.record_path_.empty())
+    {
+        record_file = fopen(options.record_path_.c_str(), "w");
+
+        if (!record_file)
+        {
+            printf("can't write %s\n", options.record_path_.c_str());
+            return 1;
+        }
+
+        fprintf(record_file, "%s\n", csv_header);
+    }
+
+    std::mt19937 rng(options.random_seed_);
+
+    OKQosController controller;
+    controller.configure(options.settings_);
+    controller.on_applied(0);
+
+    OKReplaySummary summary;
+
+    const uint64_t interval_ns = (uint64_t)options.interval_ms_ * 1000000ULL;
+    const uint64_t run_time_ns = (uint64_t)((double)options.seconds_ * 1000000000.0);
+
+    uint64_t packets_received = 0;
+    uint64_t packets_lost = 0;
+
+    for (uint64_t time_ns = interval_ns; time_ns <= run_time_ns; time_ns += interval_ns)
+    {
+        OKStatsSample sample;
+        sample.time_ns_ = time_ns;
+        sample.stats_ = simulate_stats(options, controller.get_applied_decision(), (double)time_ns / 1000000000.0, rng, packets_received, packets_lost);
+
+        if (record_file)
+        {
+            write_csv_sample(record_file, sample);
+        }
+
+        if (controller.update(sample.stats_, time_ns))
+        {
+            print_decision("decide", time_ns, controller, sample.stats_);
+        }
+
+        summary.add(controller, sample.stats_, options.settings_.target_delivery_ms_);
+
+        if (controller.should_reconnect(time_ns))
+        {
+            // A new receiver, its packet counters start from zero
+            controller.on_applied(time_ns);
+            controller.reset_session();
+            packets_received = 0;
+            packets_lost = 0;
+            summary.reconnect_count_++;
+            print_decision("reconnect", time_ns, controller, sample.stats_);
+        }
+    }
+
+    if (record_file)
+    {
+        fclose(record_file);
+    }
+
+    summary.print(controller);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    OKQosReplayOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    return options.trace_path_.empty() ? simulate(options) : replay(options);
+}
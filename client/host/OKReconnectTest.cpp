@@ -0,0 +1,191 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// The fake server drops the session while the client holds a latched frame, so release_frame
+// skips it. The client has to reconnect on its own and start the new receiver with nothing
+// latched, then latch its frames. Exits non-zero if the old latch survives the reconnect or
+// the new receiver's frames don't latch within the time limit.
+//
+// Usage: ok_reconnect_test [seconds=10]
+
+#include "OKFakeCloudXR.h"
+#include "OKFakeOpenXR.h"
+#include "OKClock.h"
+
+#include <EGL/egl.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+using namespace BVR;
+
+namespace
+{
+
+const uint32_t SESSION_LENGTH_MS = 500;
+const uint32_t MIN_LATCHES_AFTER_RECONNECT = 5;
+
+// One display frame, as OKCloudSession runs it, on_frame latches / releases while connected
+void run_frame(OKFakeOpenXR& fake_openxr, OKCloudClient& ok_client, const std::function<void()>& on_frame)
+{
+    const uint64_t frame_start_time_ns = get_monotonic_time_ns();
+    const uint64_t frame_period_ns = (uint64_t)(1000000000.0 / fake_openxr.get_current_refresh_rate());
+
+    fake_openxr.begin_frame((XrTime)(frame_start_time_ns + frame_period_ns));
+    ok_client.pre_render_update();
+
+    if (ok_client.is_connected())
+    {
+        on_frame();
+    }
+
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(frame_start_time_ns + frame_period_ns)));
+}
+
+// Runs frames until is_done, false on timing out
+bool run_until(OKFakeOpenXR& fake_openxr, OKCloudClient& ok_client, const uint64_t deadline_ns,
+               const std::function<void()>& on_frame, const std::function<bool()>& is_done)
+{
+    while (!is_done())
+    {
+        if (get_monotonic_time_ns() >= deadline_ns)
+        {
+            return false;
+        }
+
+        run_frame(fake_openxr, ok_client, on_frame);
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    float seconds = 10.0f;
+
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        if (strncmp(argv[arg_id], "seconds=", 8) == 0)
+        {
+            seconds = (float)atof(argv[arg_id] + 8);
+        }
+        else
+        {
+            printf("ok_reconnect_test [seconds=10]\n");
+            return 1;
+        }
+    }
+
+    // Every session the fake streams ends by itself
+    OKFakeCloudXRScript cxr_script;
+    cxr_script.connect_delay_ms_ = 20;
+    cxr_script.disconnect_after_ms_ = SESSION_LENGTH_MS;
+    set_fake_cloudxr_script(cxr_script);
+
+    OKFakeOpenXR fake_openxr(OKFakeOpenXRScript{});
+    OKCloudClient ok_client;
+    ok_client.ok_config_.app_directory_ = "./";
+
+    // No GL context, only checked for null by the fake receiver
+    if (!ok_client.init_android_gles(&fake_openxr, reinterpret_cast<EGLDisplay>(1), reinterpret_cast<EGLContext>(1)))
+    {
+        printf("init_android_gles failed\n");
+        return 1;
+    }
+
+    if (ok_client.ok_config_.server_ip_address_.empty())
+    {
+        ok_client.ok_config_.server_ip_address_ = DEFAULT_SERVER_IP_ADDRESS;
+    }
+
+    if (!ok_client.connect())
+    {
+        printf("connect failed\n");
+        return 1;
+    }
+
+    const uint64_t deadline_ns = get_monotonic_time_ns() + (uint64_t)(seconds * 1000000000.0f);
+    bool is_ok = true;
+
+    // First session: latch a frame and hold on to it
+    bool has_latched = false;
+
+    if (!run_until(fake_openxr, ok_client, deadline_ns, [&]()
+    {
+        has_latched = ok_client.latch_frame();
+
+        if (!has_latched)
+        {
+            ok_client.release_frame();
+        }
+    }, [&]() { return has_latched; }))
+    {
+        printf("no frame latched on the first session\n");
+        is_ok = false;
+    }
+
+    // The session drops with the frame still latched, release_frame can't hand it back
+    while (is_ok && ok_client.is_connected())
+    {
+        if (get_monotonic_time_ns() >= deadline_ns)
+        {
+            printf("the session never dropped\n");
+            is_ok = false;
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (is_ok)
+    {
+        ok_client.release_frame();
+        printf("session dropped with a frame latched: %s\n", ok_client.is_latched_ ? "yes" : "no");
+    }
+
+    // The next receiver starts with nothing latched, and its frames latch from the first frame on
+    const uint32_t first_connect_count = get_fake_cloudxr_connect_count();
+    uint32_t stale_latch_count = 0;
+    uint32_t reconnect_latch_count = 0;
+
+    if (is_ok && !run_until(fake_openxr, ok_client, deadline_ns, [&]()
+    {
+        if (get_fake_cloudxr_connect_count() == first_connect_count)
+        {
+            return;
+        }
+
+        if (ok_client.is_latched_)
+        {
+            stale_latch_count++;
+        }
+
+        if (ok_client.latch_frame())
+        {
+            reconnect_latch_count++;
+        }
+
+        ok_client.release_frame();
+    }, [&]() { return (reconnect_latch_count >= MIN_LATCHES_AFTER_RECONNECT); }))
+    {
+        is_ok = false;
+    }
+
+    is_ok &= (stale_latch_count == 0);
+
+    printf("cxrConnect calls: %u, frames latched after the reconnect: %u, frames starting with the old latch: %u  %s\n",
+           get_fake_cloudxr_connect_count(), reconnect_latch_count, stale_latch_count, is_ok ? "ok" : "FAILED");
+
+    ok_client.destroy_receiver();
+    ok_client.shutdown_cxr();
+
+    return is_ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Two-thread stress of OKSeqLock with the payloads the client hands between threads: one
+// writer storing back to back, one reader loading as fast as it can. Every field of a stored
+// snapshot is derived from the same counter, so a load that mixes two stores is caught, as is
+// one that goes back in time. Exits non-zero if any load was torn or out of order.
+//
+// Usage: ok_seqlock_stress [seconds=2]
+
+#include "OKTrackingSnapshot.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKStressResult
+{
+    uint64_t store_count_ = 0;
+    uint64_t load_count_ = 0;
+    uint64_t retry_count_ = 0;      // try_load raced a store
+    uint64_t torn_count_ = 0;
+    uint64_t out_of_order_count_ = 0;
+};
+
+// Small enough that every value is exact as a float
+float get_field_value(const uint64_t counter, const uint32_t field_id)
+{
+    return (float)((counter + field_id) & 0xFFFFF);
+}
+
+void fill_pose(GLMPose& pose, const uint64_t counter, const uint32_t pose_id)
+{
+    const uint32_t field_id = pose_id * 8;
+
+    pose.translation_ = glm::vec3(get_field_value(counter, field_id), get_field_value(counter, field_id + 1), get_field_value(counter, field_id + 2));
+    pose.rotation_ = glm::fquat(get_field_value(counter, field_id + 3), get_field_value(counter, field_id + 4),
+                                get_field_value(counter, field_id + 5), get_field_value(counter, field_id + 6));
+    pose.is_valid_ = ((counter & 1) != 0);
+    pose.timestamp_ = counter;
+}
+
+bool is_same_pose(const GLMPose& pose, const GLMPose& expected_pose)
+{
+    return (pose.translation_ == expected_pose.translation_) && (pose.rotation_ == expected_pose.rotation_) &&
+           (pose.is_valid_ == expected_pose.is_valid_) && (pose.timestamp_ == expected_pose.timestamp_);
+}
+
+void fill_snapshot(OKTrackingSnapshot& snapshot, const uint64_t counter)
+{
+    snapshot.predicted_display_time_ns_ = counter;
+    snapshot.ipd_meters_ = get_field_value(counter, 0);
+    fill_pose(snapshot.hmd_pose_, counter, 1);
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        fill_pose(snapshot.controller_poses_[controller_id], counter, 2 + controller_id);
+    }
+}
+
+uint64_t get_counter(const OKTrackingSnapshot& snapshot)
+{
+    return snapshot.predicted_display_time_ns_;
+}
+
+bool is_consistent(const OKTrackingSnapshot& snapshot)
+{
+    OKTrackingSnapshot expected;
+    fill_snapshot(expected, get_counter(snapshot));
+
+    if ((snapshot.ipd_meters_ != expected.ipd_meters_) || !is_same_pose(snapshot.hmd_pose_, expected.hmd_pose_))
+    {
+        return false;
+    }
+
+    for (int controller_id = 0; controller_id < NUM_CONTROLLERS; controller_id++)
+    {
+        if (!is_same_pose(snapshot.controller_poses_[controller_id], expected.controller_poses_[controller_id]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void fill_snapshot(OKViewSnapshot& snapshot, const uint64_t counter)
+{
+    snapshot.is_valid_ = true;
+
+    for (int view_id = 0; view_id < NUM_EYES; view_id++)
+    {
+        const uint32_t field_id = view_id * 12;
+
+        XrPosef& eye_pose = snapshot.eye_poses_[view_id];
+        eye_pose.position = {get_field_value(counter, field_id), get_field_value(counter, field_id + 1), get_field_value(counter, field_id + 2)};
+        eye_pose.orientation = {get_field_value(counter, field_id + 3), get_field_value(counter, field_id + 4),
+                                get_field_value(counter, field_id + 5), get_field_value(counter, field_id + 6)};
+
+        XrFovf& eye_fov = snapshot.eye_fovs_[view_id];
+        eye_fov.angleLeft = get_field_value(counter, field_id + 7);
+        eye_fov.angleRight = get_field_value(counter, field_id + 8);
+        eye_fov.angleUp = get_field_value(counter, field_id + 9);
+        eye_fov.angleDown = get_field_value(counter, field_id + 10);
+    }
+
+    // The counter itself, a float can't hold all of it
+    memcpy(&snapshot.eye_fovs_[LEFT_EYE].angleDown, &counter, sizeof(uint32_t));
+    memcpy(&snapshot.eye_fovs_[RIGHT_EYE].angleDown, ((const uint8_t*)&counter) + sizeof(uint32_t), sizeof(uint32_t));
+}
+
+uint64_t get_counter(const OKViewSnapshot& snapshot)
+{
+    uint64_t counter = 0;
+    memcpy(&counter, &snapshot.eye_fovs_[LEFT_EYE].angleDown, sizeof(uint32_t));
+    memcpy(((uint8_t*)&counter) + sizeof(uint32_t), &snapshot.eye_fovs_[RIGHT_EYE].angleDown, sizeof(uint32_t));
+    return counter;
+}
+
+bool is_consistent(const OKViewSnapshot& snapshot)
+{
+    if (!snapshot.is_valid_)
+    {
+        // Only the default value is invalid
+        return (get_counter(snapshot) == 0);
+    }
+
+    OKViewSnapshot expected;
+    fill_snapshot(expected, get_counter(snapshot));
+
+    return (memcmp(snapshot.eye_poses_, expected.eye_poses_, sizeof(expected.eye_poses_)) == 0) &&
+           (memcmp(snapshot.eye_fovs_, expected.eye_fovs_, sizeof(expected.eye_fovs_)) == 0);
+}
+
+template<typename T>
+OKStressResult run_stress(const float seconds)
+{
+    OKSeqLock<T> seq_lock;
+    OKStressResult result;
+
+    std::atomic<bool> should_stop = {false};
+
+    std::thread writer_thread([&]()
+    {
+        T snapshot;
+        uint64_t counter = 0;
+
+        while (!should_stop.load(std::memory_order_relaxed))
+        {
+            fill_snapshot(snapshot, ++counter);
+            seq_lock.store(snapshot);
+        }
+
+        result.store_count_ = counter;
+    });
+
+    std::thread reader_thread([&]()
+    {
+        uint64_t last_counter = 0;
+        T snapshot;
+
+        while (!should_stop.load(std::memory_order_relaxed))
+        {
+            if (!seq_lock.try_load(snapshot))
+            {
+                result.retry_count_++;
+                continue;
+            }
+
+            result.load_count_++;
+
+            if (!is_consistent(snapshot))
+            {
+                result.torn_count_++;
+                continue;
+            }
+
+            const uint64_t counter = get_counter(snapshot);
+
+            if (counter < last_counter)
+            {
+                result.out_of_order_count_++;
+            }
+
+            last_counter = counter;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::duration<float>(seconds));
+    should_stop.store(true, std::memory_order_relaxed);
+
+    writer_thread.join();
+    reader_thread.join();
+
+    return result;
+}
+
+bool print_result(const char* name, const size_t payload_size, const OKStressResult& result)
+{
+    const bool is_ok = (result.load_count_ > 0) && (result.store_count_ > 0) && (result.torn_count_ == 0) && (result.out_of_order_count_ == 0);
+
+    printf("%-18s %4zu bytes: %llu stores, %llu loads, %llu retries, %llu torn, %llu out of order  %s\n", name, payload_size,
+           (unsigned long long)result.store_count_, (unsigned long long)result.load_count_, (unsigned long long)result.retry_count_,
+           (unsigned long long)result.torn_count_, (unsigned long long)result.out_of_order_count_, is_ok ? "ok" : "FAILED");
+
+    return is_ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    float seconds = 2.0f;
+
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        if (strncmp(argv[arg_id], "seconds=", 8) == 0)
+        {
+            seconds = (float)atof(argv[arg_id] + 8);
+        }
+        else
+        {
+            printf("ok_seqlock_stress [seconds=2]\n");
+            return 1;
+        }
+    }
+
+    if (std::thread::hardware_concurrency() < 2)
+    {
+        printf("one hardware thread, the writer and reader only interleave\n");
+    }
+
+    bool is_ok = print_result("tracking snapshot", sizeof(OKTrackingSnapshot), run_stress<OKTrackingSnapshot>(seconds));
+    is_ok &= print_result("view snapshot", sizeof(OKViewSnapshot), run_stress<OKViewSnapshot>(seconds));
+
+    return is_ok ? 0 : 1;
+}
@@ -0,0 +1,643 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Microbenchmarks for the GetTrackingState hot path: each stage of OKCloudClient::get_tracking_state,
+// then the whole callback, timed per call at the poll rates CloudXR drives it at (72 / 90 / 120 /
+// 1000 Hz) and back to back. The pose sampler is stopped so the callback samples synchronously,
+// and the fake receiver never polls on its own, so every call is made (and counted) here.
+//
+// Usage: ok_tracking_benchmark [key=value ...], see print_usage for the keys.
+
+#include "OKFakeCloudXR.h"
+#include "OKFakeOpenXR.h"
+#include "OKClock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Heap allocations made by the benchmarking thread, the fake receiver's own thread isn't counted
+namespace
+{
+thread_local uint64_t allocation_count = 0;
+}
+
+void* operator new(size_t size)
+{
+    allocation_count++;
+
+    void* ptr = malloc(size ? size : 1);
+
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    operator delete[](ptr);
+}
+
+using namespace BVR;
+
+namespace
+{
+
+struct OKBenchmarkOptions
+{
+    std::vector<float> loads_hz_ = {72.0f, 90.0f, 120.0f, 1000.0f, 0.0f}; // 0 = back to back
+    float seconds_ = 2.0f;              // per paced load
+    uint32_t iterations_ = 20000;       // back to back
+    std::string config_directory_ = "./";
+    std::string body_trace_path_;       // recorded body joints, see ok_host_client record_body_trace=
+    bool print_csv_ = false;
+};
+
+void print_usage()
+{
+    printf("ok_tracking_benchmark [key=value ...]\n"
+           "  loads=72,90,120,1000,0   poll rates in Hz, 0 = back to back\n"
+           "  seconds=2                run time per paced load\n"
+           "  iterations=20000         calls per stage for the back to back load\n"
+           "  config_dir=./            where ok_cloud_streamer_config.json / ok_input_profiles.json are read from\n"
+           "  body_trace=              replay recorded body joints instead of the synthetic ones\n"
+           "  format=table             table or csv\n");
+}
+
+bool parse_loads(const char* value, std::vector<float>& loads_hz)
+{
+    loads_hz.clear();
+
+    while (*value)
+    {
+        char* end = nullptr;
+        const float load_hz = strtof(value, &end);
+
+        if ((end == value) || (load_hz < 0.0f))
+        {
+            return false;
+        }
+
+        loads_hz.push_back(load_hz);
+        value = (*end == ',') ? (end + 1) : end;
+    }
+
+    return !loads_hz.empty();
+}
+
+bool parse_options(int argc, char** argv, OKBenchmarkOptions& options)
+{
+    for (int arg_id = 1; arg_id < argc; arg_id++)
+    {
+        const char* arg = argv[arg_id];
+        const char* separator = strchr(arg, '=');
+
+        if (!separator)
+        {
+            return false;
+        }
+
+        const std::string key(arg, separator - arg);
+        const char* value = separator + 1;
+
+        if (key == "loads") { if (!parse_loads(value, options.loads_hz_)) return false; }
+        else if (key == "seconds") options.seconds_ = (float)atof(value);
+        else if (key == "iterations") options.iterations_ = (uint32_t)strtoul(value, nullptr, 0);
+        else if (key == "config_dir") options.config_directory_ = value;
+        else if (key == "body_trace") options.body_trace_path_ = value;
+        else if (key == "format") options.print_csv_ = (strcmp(value, "csv") == 0);
+        else return false;
+    }
+
+    return (options.seconds_ > 0.0f) && (options.iterations_ > 0);
+}
+
+// Shared between stages within one poll, in callback order
+struct OKBenchmarkPoll
+{
+    uint64_t predicted_display_time_ns_ = 0;
+
+    XrSpaceVelocity controller_velocities_[CXR_NUM_CONTROLLERS] = {};
+    XrSpaceLocation controller_locations_[CXR_NUM_CONTROLLERS] = {};
+    XrSpaceVelocity hmd_velocity_ = {};
+    XrSpaceLocation hmd_location_ = {};
+
+    GLMPose controller_poses_[CXR_NUM_CONTROLLERS];
+    cxrControllerTrackingState cxr_controllers_[CXR_NUM_CONTROLLERS] = {};
+
+    cxrVRTrackingState cxr_tracking_state_ = {};
+    float ipd_meters_ = 0.0f;
+
+    uint32_t face_packet_size_ = 0;
+};
+
+struct OKBenchmarkStage
+{
+    const char* name_ = nullptr;
+    std::function<void()> run_;
+
+    std::vector<uint64_t> durations_ns_;
+    uint64_t allocation_count_ = 0;
+
+    OKBenchmarkStage(const char* name, std::function<void()> run) : name_(name), run_(std::move(run))
+    {
+    }
+
+    void reset(const size_t call_count)
+    {
+        durations_ns_.clear();
+        durations_ns_.reserve(call_count);
+        allocation_count_ = 0;
+    }
+
+    void run_timed()
+    {
+        const uint64_t start_allocation_count = allocation_count;
+        const uint64_t start_time_ns = get_monotonic_time_ns();
+
+        run_();
+
+        const uint64_t end_time_ns = get_monotonic_time_ns();
+        allocation_count_ += allocation_count - start_allocation_count;
+        durations_ns_.push_back(end_time_ns - start_time_ns);
+    }
+};
+
+struct OKBenchmarkResult
+{
+    double mean_ns_ = 0.0;
+    uint64_t p50_ns_ = 0;
+    uint64_t p99_ns_ = 0;
+    uint64_t max_ns_ = 0;
+    double allocations_per_call_ = 0.0;
+    size_t call_count_ = 0;
+};
+
+OKBenchmarkResult summarize(OKBenchmarkStage& stage)
+{
+    OKBenchmarkResult result;
+    std::vector<uint64_t>& durations_ns = stage.durations_ns_;
+
+    if (durations_ns.empty())
+    {
+        return result;
+    }
+
+    std::sort(durations_ns.begin(), durations_ns.end());
+
+    uint64_t total_ns = 0;
+
+    for (const uint64_t duration_ns : durations_ns)
+    {
+        total_ns += duration_ns;
+    }
+
+    const size_t call_count = durations_ns.size();
+
+    result.call_count_ = call_count;
+    result.mean_ns_ = (double)total_ns / (double)call_count;
+    result.p50_ns_ = durations_ns[(call_count - 1) / 2];
+    result.p99_ns_ = durations_ns[((call_count - 1) * 99) / 100];
+    result.max_ns_ = durations_ns.back();
+    result.allocations_per_call_ = (double)stage.allocation_count_ / (double)call_count;
+    return result;
+}
+
+void print_header(const bool print_csv)
+{
+    if (print_csv)
+    {
+        printf("load_hz,stage,mean_ns,p50_ns,p99_ns,max_ns,allocs_per_call,calls\n");
+        return;
+    }
+
+    printf("%-10s %-36s %12s %10s %10s %10s %12s %8s\n", "Load", "Stage", "Mean ns", "p50 ns", "p99 ns", "Max ns", "Allocs/call", "Calls");
+    printf("---------------------------------------------------------------------------------------------------------------\n");
+}
+
+void print_result(const bool print_csv, const float load_hz, const char* stage_name, const OKBenchmarkResult& result)
+{
+    if (print_csv)
+    {
+        printf("%.0f,%s,%.1f,%llu,%llu,%llu,%.3f,%zu\n", load_hz, stage_name, result.mean_ns_,
+               (unsigned long long)result.p50_ns_, (unsigned long long)result.p99_ns_, (unsigned long long)result.max_ns_,
+               result.allocations_per_call_, result.call_count_);
+        return;
+    }
+
+    char load_name[16];
+
+    if (load_hz > 0.0f)
+    {
+        snprintf(load_name, sizeof(load_name), "%.0f Hz", load_hz);
+    }
+    else
+    {
+        snprintf(load_name, sizeof(load_name), "max");
+    }
+
+    printf("%-10s %-36s %12.1f %10llu %10llu %10llu %12.3f %8zu\n", load_name, stage_name, result.mean_ns_,
+           (unsigned long long)result.p50_ns_, (unsigned long long)result.p99_ns_, (unsigned long long)result.max_ns_,
+           result.allocations_per_call_, result.call_count_);
+}
+
+bool wait_for_connection(OKCloudClient& ok_client)
+{
+    const uint64_t give_up_time_ns = get_monotonic_time_ns() + 5000000000ULL;
+
+    while (!ok_client.is_connected())
+    {
+        if (ok_client.failed_to_connect() || (get_monotonic_time_ns() > give_up_time_ns))
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    OKBenchmarkOptions options;
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    OKFakeCloudXRScript cxr_script;
+    cxr_script.connect_delay_ms_ = 1;
+    cxr_script.poll_tracking_ = false;
+    set_fake_cloudxr_script(cxr_script);
+
+    OKFakeOpenXRScript xr_script;
+    xr_script.body_trace_path_ = options.body_trace_path_;
+    OKFakeOpenXR fake_openxr(xr_script);
+
+    OKCloudClient ok_client;
+    ok_client.ok_config_.app_directory_ = options.config_directory_;
+
+    // Nothing here touches GL, the fake receiver only checks these for null
+    if (!ok_client.init_android_gles(&fake_openxr, reinterpret_cast<EGLDisplay>(1), reinterpret_cast<EGLContext>(1)))
+    {
+        printf("init_android_gles failed\n");
+        return 1;
+    }
+
+    if (ok_client.ok_config_.server_ip_address_.empty())
+    {
+        ok_client.ok_config_.server_ip_address_ = DEFAULT_SERVER_IP_ADDRESS;
+    }
+
+    if (!ok_client.connect() || !wait_for_connection(ok_client))
+    {
+        printf("connect failed\n");
+        return 1;
+    }
+
+#if ENABLE_POSE_SAMPLER_THREAD
+    ok_client.pose_sampler_.stop();
+#endif
+
+    const uint64_t frame_period_ns = (uint64_t)(1000000000.0 / fake_openxr.get_current_refresh_rate());
+
+    fake_openxr.begin_frame((XrTime)(get_monotonic_time_ns() + frame_period_ns));
+    ok_client.pre_render_update();
+
+#if ENABLE_CLOUDXR_CONTROLLERS
+    ok_client.add_controllers();
+#endif
+
+    OKOpenXRControllerActions& ok_inputs = fake_openxr.get_actions();
+    OKBenchmarkPoll poll;
+
+    std::vector<OKBenchmarkStage> stages;
+
+#if ENABLE_BODY_TRACKING
+    stages.push_back({"update_body_tracking", [&]()
+    {
+        if (ok_client.body_tracker_.is_initialized())
+        {
+            ok_client.update_body_tracking(poll.predicted_display_time_ns_);
+        }
+    }});
+#endif
+
+    stages.push_back({"xrLocateSpace x3 (stub)", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            poll.controller_velocities_[controller_id] = {};
+            poll.controller_velocities_[controller_id].type = XR_TYPE_SPACE_VELOCITY;
+            poll.controller_locations_[controller_id] = {};
+            poll.controller_locations_[controller_id].type = XR_TYPE_SPACE_LOCATION;
+            poll.controller_locations_[controller_id].next = &poll.controller_velocities_[controller_id];
+            xrLocateSpace(ok_inputs.aimSpace[controller_id], fake_openxr.get_base_space(), poll.predicted_display_time_ns_, &poll.controller_locations_[controller_id]);
+        }
+
+        poll.hmd_velocity_ = {};
+        poll.hmd_velocity_.type = XR_TYPE_SPACE_VELOCITY;
+        poll.hmd_location_ = {};
+        poll.hmd_location_.type = XR_TYPE_SPACE_LOCATION;
+        poll.hmd_location_.next = &poll.hmd_velocity_;
+        xrLocateSpace(fake_openxr.get_head_space(), fake_openxr.get_base_space(), poll.predicted_display_time_ns_, &poll.hmd_location_);
+    }});
+
+    stages.push_back({"controller pose conversion", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            const XrSpaceVelocity& controller_velocity = poll.controller_velocities_[controller_id];
+            cxrControllerTrackingState& cxr_controller = poll.cxr_controllers_[controller_id];
+
+            poll.controller_poses_[controller_id] = convert_to_glm_pose(poll.controller_locations_[controller_id].pose);
+            cxr_controller.pose = convert_glm_to_cxr_pose(poll.controller_poses_[controller_id]);
+            cxr_controller.pose.velocity = convert_xr_to_cxr_vector3(controller_velocity.linearVelocity);
+            cxr_controller.pose.angularVelocity = convert_xr_to_cxr_vector3(controller_velocity.angularVelocity);
+        }
+    }});
+
+#if ENABLE_CLOUDXR_CONTROLLERS
+    stages.push_back({"apply_remote_controller_offset", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            ok_client.apply_remote_controller_offset(controller_id, poll.controller_poses_[controller_id]);
+        }
+    }});
+
+    stages.push_back({"update_controller_digital_buttons", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            ok_client.update_controller_digital_buttons(controller_id);
+        }
+    }});
+
+    stages.push_back({"update_controller_analog_axes", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            ok_client.update_controller_analog_axes(controller_id);
+        }
+    }});
+
+    stages.push_back({"fire_controller_events", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            ok_client.fire_controller_events(controller_id, poll.predicted_display_time_ns_);
+        }
+    }});
+#endif
+
+#if ENABLE_HAND_TRACKING
+    stages.push_back({"send_hand_joints", [&]()
+    {
+        if (ok_client.hand_tracker_.is_initialized())
+        {
+            ok_client.send_hand_joints(poll.predicted_display_time_ns_);
+        }
+    }});
+#endif
+
+#if ENABLE_EYE_TRACKING
+    stages.push_back({"send_eye_gaze", [&]()
+    {
+        if (ok_client.is_eye_gaze_available())
+        {
+            ok_client.send_eye_gaze(poll.predicted_display_time_ns_);
+        }
+    }});
+#endif
+
+#if ENABLE_FACE_TRACKING
+    // Every poll rather than at face_tracking_hz_, then the codec alone on the weights it sampled
+    OKFaceExpressionEncoder face_expression_encoder;
+    OKFaceExpressionDecoder face_expression_decoder;
+    uint64_t face_packet_count = 0;
+    uint64_t face_packet_bytes = 0;
+    uint64_t face_sample_count = 0;
+
+    stages.push_back({"send_face_expressions", [&]()
+    {
+        if (ok_client.face_tracker_.is_initialized())
+        {
+            ok_client.last_face_sample_time_ns_ = 0;
+            ok_client.send_face_expressions(poll.predicted_display_time_ns_);
+        }
+    }});
+
+    stages.push_back({"face expression encode", [&]()
+    {
+        poll.face_packet_size_ = face_expression_encoder.build(ok_client.face_expression_weights_, ok_client.face_expression_confidences_,
+                                                               poll.predicted_display_time_ns_, poll.predicted_display_time_ns_);
+    }});
+
+    stages.push_back({"face expression decode", [&]()
+    {
+        if (poll.face_packet_size_ > 0)
+        {
+            face_expression_decoder.decode(face_expression_encoder.get_packet(), poll.face_packet_size_);
+        }
+    }});
+#endif
+
+#if ENABLE_HAPTICS
+    // A pulse per controller per poll from the CloudXR side, then the render thread's drain of them
+    uint64_t haptic_pulse_id = 0;
+
+    stages.push_back({"trigger_haptics", [&]()
+    {
+        for (int controller_id = LEFT_CONTROLLER; controller_id < CXR_NUM_CONTROLLERS; controller_id++)
+        {
+            cxrHapticFeedback haptic = {};
+            haptic.deviceID = (uint64_t)controller_id;
+            haptic.amplitude = 0.25f + 0.125f * (float)(haptic_pulse_id++ % 7);
+            haptic.seconds = 0.02f;
+            haptic.frequency = 160.0f;
+
+            ok_client.trigger_haptics(&haptic);
+        }
+    }});
+
+    stages.push_back({"update_haptics", [&]()
+    {
+        ok_client.update_haptics();
+    }});
+#endif
+
+    stages.push_back({"compute_ipd", [&]()
+    {
+        poll.ipd_meters_ = ok_client.compute_ipd();
+    }});
+
+    stages.push_back({"sample_tracking_state", [&]()
+    {
+        ok_client.sample_tracking_state(poll.cxr_tracking_state_);
+    }});
+
+    stages.push_back({"predict_tracking_state", [&]()
+    {
+        ok_client.predict_tracking_state(poll.cxr_tracking_state_, poll.predicted_display_time_ns_ + (uint64_t)(ok_client.ok_config_.client_prediction_ms_ * 1000000.0f));
+    }});
+
+    // Scalar vs OKPoseBatch for a full joint set: HMD, both controllers and 26 joints per hand
+    const uint32_t joint_pose_count = 1 + CXR_NUM_CONTROLLERS + (2 * 26);
+    std::vector<XrPosef> joint_xr_poses(joint_pose_count);
+    std::vector<cxrTrackedDevicePose> joint_cxr_poses(joint_pose_count);
+    std::unique_ptr<OKPoseBatch> joint_pose_batch = std::make_unique<OKPoseBatch>();
+
+    for (uint32_t joint_id = 0; joint_id < joint_pose_count; joint_id++)
+    {
+        const float angle = 0.1f * (float)joint_id;
+        joint_xr_poses[joint_id].position = {0.01f * (float)joint_id, 1.2f, -0.3f};
+        joint_xr_poses[joint_id].orientation = {0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f)};
+    }
+
+    stages.push_back({"55 poses, GLMPose (scalar)", [&]()
+    {
+        for (uint32_t joint_id = 0; joint_id < joint_pose_count; joint_id++)
+        {
+            GLMPose joint_pose = convert_to_glm_pose(joint_xr_poses[joint_id]);
+            joint_pose.transform(ok_client.ok_config_.remote_controller_offset_);
+            joint_cxr_poses[joint_id] = convert_glm_to_cxr_pose(joint_pose);
+        }
+    }});
+
+    stages.push_back({"55 poses, OKPoseBatch", [&]()
+    {
+        load_xr_poses(*joint_pose_batch, joint_xr_poses.data(), joint_pose_count);
+        transform_by_offset(*joint_pose_batch, ok_client.ok_config_.remote_controller_offset_);
+        store_cxr_poses(*joint_pose_batch, joint_cxr_poses.data(), joint_pose_count);
+    }});
+
+    // Last, and half a frame later, so it sees fresh input deltas rather than the ones the stages above already sent
+    stages.push_back({"get_tracking_state (callback)", [&]()
+    {
+        ok_client.get_tracking_state(&poll.cxr_tracking_state_);
+    }});
+
+    const size_t callback_stage_id = stages.size() - 1;
+
+    auto run_poll = [&](const uint64_t poll_time_ns)
+    {
+        poll.predicted_display_time_ns_ = poll_time_ns + frame_period_ns;
+        fake_openxr.begin_frame((XrTime)poll.predicted_display_time_ns_);
+
+        for (size_t stage_id = 0; stage_id < callback_stage_id; stage_id++)
+        {
+            stages[stage_id].run_timed();
+        }
+
+        fake_openxr.begin_frame((XrTime)(poll.predicted_display_time_ns_ + (frame_period_ns / 2)));
+        stages[callback_stage_id].run_timed();
+
+#if ENABLE_FACE_TRACKING
+        face_sample_count++;
+        face_packet_count += (poll.face_packet_size_ > 0) ? 1 : 0;
+        face_packet_bytes += poll.face_packet_size_;
+#endif
+    };
+
+    print_header(options.print_csv_);
+
+    for (const float load_hz : options.loads_hz_)
+    {
+        const bool is_paced = (load_hz > 0.0f);
+        const size_t poll_count = is_paced ? std::max((size_t)(options.seconds_ * load_hz), (size_t)1) : (size_t)options.iterations_;
+
+        for (OKBenchmarkStage& stage : stages)
+        {
+            stage.reset(poll_count);
+        }
+
+#if ENABLE_FACE_TRACKING
+        face_expression_encoder.reset();
+        face_expression_decoder.reset();
+        face_sample_count = 0;
+        face_packet_count = 0;
+        face_packet_bytes = 0;
+#endif
+
+        const uint64_t poll_period_ns = is_paced ? (uint64_t)(1000000000.0 / load_hz) : 0;
+        uint64_t poll_time_ns = get_monotonic_time_ns();
+
+        for (size_t poll_id = 0; poll_id < poll_count; poll_id++)
+        {
+            run_poll(poll_time_ns);
+
+            if (is_paced)
+            {
+                // Idle between polls like the CloudXR pose thread does, caches and branch predictors cool off
+                poll_time_ns += poll_period_ns;
+                std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(poll_time_ns)));
+            }
+            else
+            {
+                poll_time_ns = get_monotonic_time_ns();
+            }
+        }
+
+        for (OKBenchmarkStage& stage : stages)
+        {
+            print_result(options.print_csv_, load_hz, stage.name_, summarize(stage));
+        }
+
+        if (!options.print_csv_)
+        {
+#if ENABLE_FACE_TRACKING
+            // Against every weight and confidence as a raw float each poll
+            const uint64_t raw_face_bytes = face_sample_count * (FACE_EXPRESSION_WEIGHT_COUNT + FACE_EXPRESSION_CONFIDENCE_COUNT) * sizeof(float);
+            printf("face expressions: %llu of %llu polls sent, %.1f bytes each, %.1f%% of raw floats\n",
+                   (unsigned long long)face_packet_count, (unsigned long long)face_sample_count,
+                   face_packet_count ? ((double)face_packet_bytes / (double)face_packet_count) : 0.0,
+                   raw_face_bytes ? (100.0 * (double)face_packet_bytes / (double)raw_face_bytes) : 0.0);
+#endif
+            printf("\n");
+        }
+    }
+
+    ok_client.destroy_receiver();
+    ok_client.shutdown_cxr();
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Host build stand-in for the CloudXRClientOptions.h shipped in CloudXR.aar, only used when
+// OK_CLOUDXR_SDK_INCLUDE_DIR isn't set. The OK client core includes it but uses nothing from it.
+
+#ifndef OK_HOST_CLOUDXR_CLIENT_OPTIONS_H
+#define OK_HOST_CLOUDXR_CLIENT_OPTIONS_H
+
+#include <CloudXRCommon.h>
+
+#endif // OK_HOST_CLOUDXR_CLIENT_OPTIONS_H
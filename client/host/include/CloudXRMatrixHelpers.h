@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------------------
+// Copyright (c) 2024 BattleAxeVR. All rights reserved.
+//--------------------------------------------------------------------------------------
+
+// Host build stand-in for the CloudXRMatrixHelpers.h shipped in CloudXR.aar, only used when
+// OK_CLOUDXR_SDK_INCLUDE_DIR isn't set. Covers what the OK client core calls.
+
+#ifndef OK_HOST_CLOUDXR_MATRIX_HELPERS_H
+#define OK_HOST_CLOUDXR_MATRIX_HELPERS_H
+
+#include <CloudXRCommon.h>
+
+#include <math.h>
+
+static inline void cxrMatrixToVecQuat(const cxrMatrix34* mat, cxrVector3* pos, cxrQuaternion* quat)
+{
+    const float (*m)[4] = mat->m;
+
+    pos->v[0] = m[0][3];
+    pos->v[1] = m[1][3];
+    pos->v[2] = m[2][3];
+
+    const float trace = m[0][0] + m[1][1] + m[2][2];
+
+    if (trace > 0.0f)
+    {
+        const float s = sqrtf(trace + 1.0f) * 2.0f;
+        quat->w = 0.25f * s;
+        quat->x = (m[2][1] - m[1][2]) / s;
+        quat->y = (m[0][2] - m[2][0]) / s;
+        quat->z = (m[1][0] - m[0][1]) / s;
+    }
+    else if ((m[0][0] > m[1][1]) && (m[0][0] > m[2][2]))
+    {
+        const float s = sqrtf(1.0f + m[0][0] - m[1][1] - m[2][2]) * 2.0f;
+        quat->w = (m[2][1] - m[1][2]) / s;
+        quat->x = 0.25f * s;
+        quat->y = (m[0][1] + m[1][0]) / s;
+        quat->z = (m[0][2] + m[2][0]) / s;
+    }
+    else if (m[1][1] > m[2][2])
+    {
+        const float s = sqrtf(1.0f + m[1][1] - m[0][0] - m[2][2]) * 2.0f;
+        quat->w = (m[0][2] - m[2][0]) / s;
+        quat->x = (m[0][1] + m[1][0]) / s;
+        quat->y = 0.25f * s;
+        quat->z = (m[1][2] + m[2][1]) / s;
+    }
+    else
+    {
+        const float s = sqrtf(1.0f + m[2][2] - m[0][0] - m[1][1]) * 2.0f;
+        quat->w = (m[1][0] - m[0][1]) / s;
+        quat->x = (m[0][2] + m[2][0]) / s;
+        quat->y = (m[1][2] + m[2][1]) / s;
+        quat->z = 0.25f * s;
+    }
+}
+
+static inline void cxrQuatToMatrix(const cxrQuaternion* quat, const cxrVector3* pos, cxrMatrix34* mat)
+{
+    const float w = quat->w;
+    const float x = quat->x;
+    const float y = quat->y;
+    const float z = quat->z;
+
+    mat->m[0][0] = 1.0f - 2.0f * (y * y + z * z);
+    mat->m[0][1] = 2.0f * (x * y - w * z);
+    mat->m[0][2] = 2.0f * (x * z + w * y);
+    mat->m[0][3] = pos->v[0];
+
+    mat->m[1][0] = 2.0f * (x * y + w * z);
+    mat->m[1][1] = 1.0f - 2.0f * (x * x + z * z);
+    mat->m[1][2] = 2.0f * (y * z - w * x);
+    mat->m[1][3] = pos->v[1];
+
+    mat->m[2][0] = 2.0f * (x * z - w * y);
+    mat->m[2][1] = 2.0f * (y * z + w * x);
+    mat->m[2][2] = 1.0f - 2.0f * (x * x + y * y);
+    mat->m[2][3] = pos->v[2];
+}
+
+#endif // OK_HOST_CLOUDXR_MATRIX_HELPERS_H